@@ -45,6 +45,12 @@ private Q_SLOTS:
     void compareOverOps();
     void compareOverOpsNoMask();
     void compareRgbF32OverOps();
+    void compareRgb16AlphaDarkenOps();
+    void compareRgb16AlphaDarkenOpsHard();
+    void compareRgb16OverOps();
+    void compareRgb16OverOpsNoMask();
+    void compareRgb16CopyOps();
+    void compareRgb16BehindOps();
 
     void testRgb8CompositeAlphaDarkenLegacy();
     void testRgb8CompositeAlphaDarkenOptimized();
@@ -58,6 +64,18 @@ private Q_SLOTS:
     void testRgbF32CompositeOverLegacy();
     void testRgbF32CompositeOverOptimized();
 
+    void testRgb16CompositeAlphaDarkenLegacy();
+    void testRgb16CompositeAlphaDarkenOptimized();
+
+    void testRgb16CompositeOverLegacy();
+    void testRgb16CompositeOverOptimized();
+
+    void testRgb16CompositeCopyLegacy();
+    void testRgb16CompositeCopyOptimized();
+
+    void testRgb16CompositeBehindLegacy();
+    void testRgb16CompositeBehindOptimized();
+
     void testRgb8CompositeAlphaDarkenReal_Aligned();
     void testRgb8CompositeOverReal_Aligned();
 
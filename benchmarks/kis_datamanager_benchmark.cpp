@@ -28,6 +28,9 @@
 
 void KisDatamanagerBenchmark::initTestCase()
 {
+    // the results depend on the tile size selected with KRITA_TILE_SIZE
+    qDebug() << "Tile size:" << KisTileData::WIDTH << "x" << KisTileData::HEIGHT;
+
     // To make sure all the first-time startup costs are done
     quint8 * p = new quint8[PIXEL_SIZE];
     memset(p, 0, PIXEL_SIZE);
@@ -198,5 +201,29 @@ void KisDatamanagerBenchmark::benchmarkMemCpy()
     delete[] dst;
 }
 
+void KisDatamanagerBenchmark::benchmarkReadBytesSmallRects()
+{
+    // reads small unaligned rects, so the per-tile overhead
+    // (hash table lookups and tile locking) dominates
+
+    quint8 *p = new quint8[PIXEL_SIZE];
+    memset(p, 0, PIXEL_SIZE);
+    KisDataManager dm(PIXEL_SIZE, p);
+
+    const int rectSize = 100;
+    quint8 *bytes = new quint8[PIXEL_SIZE * TEST_IMAGE_WIDTH * TEST_IMAGE_HEIGHT];
+    memset(bytes, 128, PIXEL_SIZE * TEST_IMAGE_WIDTH * TEST_IMAGE_HEIGHT);
+    dm.writeBytes(bytes, 0, 0, TEST_IMAGE_WIDTH, TEST_IMAGE_HEIGHT);
+
+    QBENCHMARK {
+        for (int y = 0; y < TEST_IMAGE_HEIGHT - rectSize; y += rectSize) {
+            for (int x = 0; x < TEST_IMAGE_WIDTH - rectSize; x += rectSize) {
+                dm.readBytes(bytes, x, y, rectSize, rectSize);
+            }
+        }
+    }
+
+    delete[] bytes;
+}
 
 QTEST_MAIN(KisDatamanagerBenchmark)
@@ -36,6 +36,7 @@ private Q_SLOTS:
     void benchmarkExtent();
     void benchmarkClear();
     void benchmarkMemCpy();
+    void benchmarkReadBytesSmallRects();
 };
 
 #endif
@@ -20,6 +20,7 @@
 #include "kis_benchmark_values.h"
 
 #include "kis_paint_device.h"
+#include "tiles3/kis_tile_data_interface.h"
 
 #include <KoColorSpace.h>
 #include <KoColorSpaceRegistry.h>
@@ -31,6 +32,9 @@
 
 void KisHLineIteratorBenchmark::initTestCase()
 {
+    // the results depend on the tile size selected with KRITA_TILE_SIZE
+    qDebug() << "Tile size:" << KisTileData::WIDTH << "x" << KisTileData::HEIGHT;
+
     m_colorSpace = KoColorSpaceRegistry::instance()->rgb8();
     m_device = new KisPaintDevice(m_colorSpace);
     m_color = new KoColor(m_colorSpace);
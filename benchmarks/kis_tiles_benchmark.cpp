@@ -0,0 +1,421 @@
+/*
+ *  Copyright (c) 2020 Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_tiles_benchmark.h"
+
+#include <QTest>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <random>
+
+#include "kis_benchmark_values.h"
+
+#include <KoColorSpaceRegistry.h>
+
+#include "kis_paint_device.h"
+#include "kis_random_accessor_ng.h"
+
+#include "tiles3/kis_tiled_data_manager.h"
+#include "tiles3/kis_tile_data_store.h"
+#include "tiles3/kis_tile_data_pooler.h"
+#include "tiles3/kis_memento.h"
+
+// RGBA
+#define PIXEL_SIZE 4
+
+#define REPETITIONS 5
+#define RANDOM_SEED 4357
+#define NUM_RANDOM_ACCESSES 1000000
+#define SMALL_IMAGE_SIZE 2048
+#define MEMENTO_RECT_SIZE 1024
+
+namespace {
+
+QByteArray generateImageBytes(int width, int height)
+{
+    QByteArray bytes(PIXEL_SIZE * width * height, 0);
+    quint8 *ptr = reinterpret_cast<quint8*>(bytes.data());
+
+    /**
+     * A smooth gradient with some noise, so that the swapping
+     * code would have something to compress
+     */
+    std::mt19937 generator(RANDOM_SEED);
+    std::uniform_int_distribution<int> noise(0, 7);
+
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            ptr[0] = quint8(x + noise(generator));
+            ptr[1] = quint8(y + noise(generator));
+            ptr[2] = quint8(x + y);
+            ptr[3] = 255;
+            ptr += PIXEL_SIZE;
+        }
+    }
+
+    return bytes;
+}
+
+KisTiledDataManager* createFilledDataManager(const QByteArray &bytes, int width, int height)
+{
+    const quint8 defaultPixel[PIXEL_SIZE] = {0, 0, 0, 0};
+    KisTiledDataManager *dm = new KisTiledDataManager(PIXEL_SIZE, defaultPixel);
+    dm->writeBytes(reinterpret_cast<const quint8*>(bytes.constData()), 0, 0, width, height);
+    return dm;
+}
+
+class BenchmarkPooler : public KisTileDataPooler
+{
+public:
+    BenchmarkPooler(KisTileDataStore *store)
+        : KisTileDataPooler(store, 0)
+    {
+    }
+
+    using KisTileDataPooler::cloneTileData;
+};
+
+}
+
+void KisTilesBenchmark::measure(const QString &name, qint64 bytesPerRun,
+                                std::function<void()> prepare,
+                                std::function<void()> body,
+                                std::function<void()> cleanup)
+{
+    Result result;
+    result.name = name;
+    result.bytesPerRun = bytesPerRun;
+
+    for (int i = 0; i < REPETITIONS; i++) {
+        if (prepare) {
+            prepare();
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+        body();
+        result.nsecs.append(timer.nsecsElapsed());
+
+        if (cleanup) {
+            cleanup();
+        }
+    }
+
+    m_results.append(result);
+
+    qDebug() << qPrintable(name) << "min" << *std::min_element(result.nsecs.begin(), result.nsecs.end()) / 1000000.0 << "ms";
+}
+
+void KisTilesBenchmark::initTestCase()
+{
+    /**
+     * The pooler prepares clones in background and would make the
+     * results non-reproducible. Its work is measured separately.
+     */
+    KisTileDataStore::instance()->testingSuspendPooler();
+}
+
+void KisTilesBenchmark::cleanupTestCase()
+{
+    KisTileDataStore::instance()->testingResumePooler();
+
+    QJsonArray results;
+
+    Q_FOREACH (const Result &result, m_results) {
+        QVector<qint64> nsecs = result.nsecs;
+        std::sort(nsecs.begin(), nsecs.end());
+
+        const qint64 minNsecs = nsecs.first();
+        const qint64 medianNsecs = nsecs[nsecs.size() / 2];
+
+        QJsonObject object;
+        object["name"] = result.name;
+        object["repetitions"] = nsecs.size();
+        object["bytes"] = double(result.bytesPerRun);
+        object["min_ms"] = minNsecs / 1e6;
+        object["median_ms"] = medianNsecs / 1e6;
+        object["throughput_mib_s"] =
+            minNsecs > 0 ? result.bytesPerRun / (1024.0 * 1024.0) / (minNsecs / 1e9) : 0.0;
+
+        results.append(object);
+    }
+
+    QJsonObject root;
+    root["benchmark"] = "KisTilesBenchmark";
+    root["qt_version"] = qVersion();
+    root["tile_width"] = KisTileData::WIDTH;
+    root["tile_height"] = KisTileData::HEIGHT;
+    root["pixel_size"] = PIXEL_SIZE;
+    root["ideal_thread_count"] = QThread::idealThreadCount();
+    root["random_seed"] = RANDOM_SEED;
+    root["results"] = results;
+
+    QString fileName = qgetenv("KRITA_BENCHMARK_JSON");
+    if (fileName.isEmpty()) {
+        fileName = "kis_tiles_benchmark.json";
+    }
+
+    QFile file(fileName);
+    if (!file.open(QFile::WriteOnly | QFile::Truncate)) {
+        qWarning() << "Failed to open" << fileName << "for writing";
+        return;
+    }
+
+    file.write(QJsonDocument(root).toJson());
+    qDebug() << "The results are written to" << fileName;
+}
+
+void KisTilesBenchmark::benchmarkSequentialWrite()
+{
+    const quint8 defaultPixel[PIXEL_SIZE] = {0, 0, 0, 0};
+    const QByteArray bytes = generateImageBytes(TEST_IMAGE_WIDTH, TEST_IMAGE_HEIGHT);
+    QScopedPointer<KisTiledDataManager> dm;
+
+    measure("sequential_write", bytes.size(),
+            [&] () {
+                dm.reset(new KisTiledDataManager(PIXEL_SIZE, defaultPixel));
+            },
+            [&] () {
+                dm->writeBytes(reinterpret_cast<const quint8*>(bytes.constData()),
+                               0, 0, TEST_IMAGE_WIDTH, TEST_IMAGE_HEIGHT);
+            },
+            [&] () {
+                dm.reset();
+            });
+}
+
+void KisTilesBenchmark::benchmarkSequentialRead()
+{
+    const QByteArray bytes = generateImageBytes(TEST_IMAGE_WIDTH, TEST_IMAGE_HEIGHT);
+    QScopedPointer<KisTiledDataManager> dm(createFilledDataManager(bytes, TEST_IMAGE_WIDTH, TEST_IMAGE_HEIGHT));
+    QByteArray result(bytes.size(), 0);
+
+    measure("sequential_read", bytes.size(),
+            std::function<void()>(),
+            [&] () {
+                dm->readBytes(reinterpret_cast<quint8*>(result.data()),
+                              0, 0, TEST_IMAGE_WIDTH, TEST_IMAGE_HEIGHT);
+            });
+
+    QVERIFY(result == bytes);
+}
+
+void KisTilesBenchmark::benchmarkRandomReadWrite()
+{
+    const QByteArray bytes = generateImageBytes(TEST_IMAGE_WIDTH, TEST_IMAGE_HEIGHT);
+
+    /**
+     * KisRandomAccessor2 is not exported from the image library,
+     * so the accessor is created through the paint device
+     */
+    KisPaintDeviceSP dev = new KisPaintDevice(KoColorSpaceRegistry::instance()->rgb8());
+    dev->writeBytes(reinterpret_cast<const quint8*>(bytes.constData()), 0, 0, TEST_IMAGE_WIDTH, TEST_IMAGE_HEIGHT);
+
+    measure("random_read_write", qint64(NUM_RANDOM_ACCESSES) * PIXEL_SIZE,
+            std::function<void()>(),
+            [&] () {
+                std::mt19937 generator(RANDOM_SEED);
+                std::uniform_int_distribution<int> xDistribution(0, TEST_IMAGE_WIDTH - 1);
+                std::uniform_int_distribution<int> yDistribution(0, TEST_IMAGE_HEIGHT - 1);
+
+                KisRandomAccessorSP accessor = dev->createRandomAccessorNG(0, 0);
+
+                for (int i = 0; i < NUM_RANDOM_ACCESSES; i++) {
+                    const int x = xDistribution(generator);
+                    const int y = yDistribution(generator);
+
+                    accessor->moveTo(x, y);
+                    quint8 *pixel = accessor->rawData();
+                    pixel[0] = pixel[1] ^ pixel[2];
+                }
+            });
+}
+
+void KisTilesBenchmark::benchmarkConcurrentWriters()
+{
+    const quint8 defaultPixel[PIXEL_SIZE] = {0, 0, 0, 0};
+    const QByteArray bytes = generateImageBytes(TEST_IMAGE_WIDTH, TEST_IMAGE_HEIGHT);
+    QScopedPointer<KisTiledDataManager> dm;
+
+    /**
+     * Every writer gets its own stripe of tiles, so the only
+     * contention is the one inside the tile engine itself
+     */
+    const int numWriters = qMax(2, QThread::idealThreadCount());
+    const int stripeHeight = TEST_IMAGE_HEIGHT / numWriters;
+
+    QVector<int> stripes;
+    for (int i = 0; i < numWriters; i++) {
+        stripes.append(i);
+    }
+
+    measure("concurrent_writers", bytes.size(),
+            [&] () {
+                dm.reset(new KisTiledDataManager(PIXEL_SIZE, defaultPixel));
+            },
+            [&] () {
+                QtConcurrent::blockingMap(stripes,
+                    [&] (int stripe) {
+                        const int y = stripe * stripeHeight;
+                        const int height =
+                            stripe < numWriters - 1 ? stripeHeight : TEST_IMAGE_HEIGHT - y;
+
+                        dm->writeBytes(reinterpret_cast<const quint8*>(bytes.constData()) +
+                                       PIXEL_SIZE * TEST_IMAGE_WIDTH * y,
+                                       0, y, TEST_IMAGE_WIDTH, height);
+                    });
+            },
+            [&] () {
+                dm.reset();
+            });
+}
+
+void KisTilesBenchmark::benchmarkSwapOutIn()
+{
+    KisTileDataStore *store = KisTileDataStore::instance();
+
+    const QByteArray bytes = generateImageBytes(SMALL_IMAGE_SIZE, SMALL_IMAGE_SIZE);
+    QScopedPointer<KisTiledDataManager> dm;
+    QByteArray result(bytes.size(), 0);
+
+    measure("swap_out", bytes.size(),
+            [&] () {
+                dm.reset(createFilledDataManager(bytes, SMALL_IMAGE_SIZE, SMALL_IMAGE_SIZE));
+            },
+            [&] () {
+                store->debugSwapAll();
+            },
+            [&] () {
+                dm.reset();
+            });
+
+    measure("swap_in", bytes.size(),
+            [&] () {
+                dm.reset(createFilledDataManager(bytes, SMALL_IMAGE_SIZE, SMALL_IMAGE_SIZE));
+                store->debugSwapAll();
+            },
+            [&] () {
+                dm->readBytes(reinterpret_cast<quint8*>(result.data()),
+                              0, 0, SMALL_IMAGE_SIZE, SMALL_IMAGE_SIZE);
+            },
+            [&] () {
+                dm.reset();
+            });
+
+    QVERIFY(result == bytes);
+}
+
+void KisTilesBenchmark::benchmarkMementoCommitRollback()
+{
+    const QByteArray bytes = generateImageBytes(SMALL_IMAGE_SIZE, SMALL_IMAGE_SIZE);
+    const QByteArray patch(PIXEL_SIZE * MEMENTO_RECT_SIZE * MEMENTO_RECT_SIZE, 17);
+    QScopedPointer<KisTiledDataManager> dm;
+    KisMementoSP memento;
+
+    auto prepare = [&] () {
+        dm.reset(createFilledDataManager(bytes, SMALL_IMAGE_SIZE, SMALL_IMAGE_SIZE));
+    };
+
+    auto paintAndCommit = [&] () {
+        memento = dm->getMemento();
+        dm->writeBytes(reinterpret_cast<const quint8*>(patch.constData()),
+                       MEMENTO_RECT_SIZE / 2, MEMENTO_RECT_SIZE / 2,
+                       MEMENTO_RECT_SIZE, MEMENTO_RECT_SIZE);
+        dm->commit();
+    };
+
+    auto cleanup = [&] () {
+        memento = 0;
+        dm.reset();
+    };
+
+    measure("memento_commit", patch.size(), prepare, paintAndCommit, cleanup);
+
+    measure("memento_rollback", patch.size(),
+            [&] () {
+                prepare();
+                paintAndCommit();
+            },
+            [&] () {
+                dm->rollback(memento);
+            },
+            cleanup);
+}
+
+void KisTilesBenchmark::benchmarkPoolerCloning()
+{
+    const QByteArray bytes = generateImageBytes(SMALL_IMAGE_SIZE, SMALL_IMAGE_SIZE);
+    QScopedPointer<KisTiledDataManager> dm;
+    QScopedPointer<KisTiledDataManager> copy;
+    BenchmarkPooler pooler(KisTileDataStore::instance());
+
+    const int numCols = SMALL_IMAGE_SIZE / KisTileData::WIDTH;
+    const int numRows = SMALL_IMAGE_SIZE / KisTileData::HEIGHT;
+
+    /**
+     * The copy shares all the tile datas with the original,
+     * so every write into it causes COW
+     */
+    auto prepare = [&] () {
+        dm.reset(createFilledDataManager(bytes, SMALL_IMAGE_SIZE, SMALL_IMAGE_SIZE));
+        copy.reset(new KisTiledDataManager(*dm));
+    };
+
+    auto cloneAll = [&] () {
+        for (int row = 0; row < numRows; row++) {
+            for (int col = 0; col < numCols; col++) {
+                KisTileSP tile = copy->getTile(col, row, false);
+                pooler.cloneTileData(tile->tileData(), 1);
+            }
+        }
+    };
+
+    auto writeAll = [&] () {
+        for (int row = 0; row < numRows; row++) {
+            for (int col = 0; col < numCols; col++) {
+                KisTileSP tile = copy->getTile(col, row, true);
+                tile->lockForWrite();
+                tile->unlockForWrite();
+            }
+        }
+    };
+
+    auto cleanup = [&] () {
+        copy.reset();
+        dm.reset();
+    };
+
+    measure("pooler_cloning", bytes.size(), prepare, cloneAll, cleanup);
+
+    measure("cow_with_pooled_clones", bytes.size(),
+            [&] () {
+                prepare();
+                cloneAll();
+            },
+            writeAll, cleanup);
+
+    measure("cow_without_pooled_clones", bytes.size(), prepare, writeAll, cleanup);
+}
+
+QTEST_MAIN(KisTilesBenchmark)
@@ -0,0 +1,65 @@
+/*
+ *  Copyright (c) 2020 Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KIS_TILES_BENCHMARK_H
+#define KIS_TILES_BENCHMARK_H
+
+#include <QtTest>
+#include <functional>
+
+/**
+ * A consolidated benchmark of the tile engine. Every case is run
+ * a fixed number of times with fixed random seeds, and the results
+ * are written into a JSON file, so that they could be compared
+ * between the versions by a CI system.
+ *
+ * The file is written to the path in KRITA_BENCHMARK_JSON environment
+ * variable or to kis_tiles_benchmark.json in the current directory.
+ */
+class KisTilesBenchmark : public QObject
+{
+    Q_OBJECT
+
+private:
+    struct Result {
+        QString name;
+        qint64 bytesPerRun;
+        QVector<qint64> nsecs;
+    };
+
+    void measure(const QString &name, qint64 bytesPerRun,
+                 std::function<void()> prepare,
+                 std::function<void()> body,
+                 std::function<void()> cleanup = std::function<void()>());
+
+    QVector<Result> m_results;
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void benchmarkSequentialWrite();
+    void benchmarkSequentialRead();
+    void benchmarkRandomReadWrite();
+    void benchmarkConcurrentWriters();
+    void benchmarkSwapOutIn();
+    void benchmarkMementoCommitRollback();
+    void benchmarkPoolerCloning();
+};
+
+#endif /* KIS_TILES_BENCHMARK_H */
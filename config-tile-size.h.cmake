@@ -0,0 +1,4 @@
+/* config-tile-size.h.  Generated by cmake from config-tile-size.h.cmake */
+
+/* The width and the height of the tiles used by the image engine */
+#define KRITA_TILE_SIZE @KRITA_TILE_SIZE@
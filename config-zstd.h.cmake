@@ -0,0 +1,2 @@
+/* Defines if your system has the Zstandard library */
+#cmakedefine HAVE_ZSTD 1
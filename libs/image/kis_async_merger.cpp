@@ -21,6 +21,10 @@
 
 #include <kis_debug.h>
 #include <QBitArray>
+#include <QtConcurrent>
+#include <QSemaphore>
+#include <QSharedPointer>
+#include <atomic>
 
 #include <KoChannelInfo.h>
 #include <KoCompositeOpRegistry.h>
@@ -212,6 +216,54 @@ private:
 };
 
 
+namespace {
+
+/**
+ * Returns the child of \p startLeaf containing \p leaf,
+ * if \p leaf is not a direct child of it
+ */
+KisProjectionLeafSP findSubtreeRoot(KisProjectionLeafSP leaf, KisProjectionLeafSP startLeaf)
+{
+    KisProjectionLeafSP child = leaf;
+    KisProjectionLeafSP parent = leaf->parent();
+
+    while (parent && parent != startLeaf) {
+        child = parent;
+        parent = parent->parent();
+    }
+
+    return parent && child != leaf ? child : KisProjectionLeafSP();
+}
+
+bool isCloneRelated(KisProjectionLeafSP leaf)
+{
+    return leaf->hasClones() || dynamic_cast<KisCloneLayer*>(leaf->node().data());
+}
+
+std::atomic<bool> s_parallelSubtreesEnabled {false};
+
+/**
+ * The subtrees are merged from inside the updater context's jobs,
+ * so they must not take more threads than the context has. The
+ * global pool of QtConcurrent knows nothing about this limit.
+ */
+Q_GLOBAL_STATIC(QThreadPool, s_subtreesThreadPool)
+
+struct SubtreeTask {
+    KisProjectionLeafSP root;
+    QVector<KisBaseRectsWalker::JobItem> items;
+    KisBaseRectsWalker::JobItem rootItem;
+    bool hasRootItem = false;
+};
+
+struct SubtreesMergeState {
+    QVector<SubtreeTask> tasks;
+    std::atomic<int> nextTask {0};
+    QSemaphore tasksDone;
+};
+
+}
+
 /*********************************************************************/
 /*                     KisAsyncMerger                                */
 /*********************************************************************/
@@ -221,106 +273,451 @@ void KisAsyncMerger::startMerge(KisBaseRectsWalker &walker, bool notifyClones) {
 
     const bool useTempProjections = walker.needRectVaries();
 
-    while(!leafStack.isEmpty()) {
-        KisMergeWalker::JobItem item = leafStack.pop();
-        KisProjectionLeafSP currentLeaf = item.m_leaf;
-
+    if (walker.type() == KisBaseRectsWalker::UNSUPPORTED) {
         /**
-         * In some unidentified cases teh nodes might be removed
-         * while the updates are still running. We have no proof
-         * of it yet, so just add a safety assert here.
+         * The subtree walkers don't reach the root, so the
+         * groups above them will not notice the change
          */
-        KIS_SAFE_ASSERT_RECOVER_RETURN(currentLeaf);
-        KIS_SAFE_ASSERT_RECOVER_RETURN(currentLeaf->node());
+        resetSplitCaches(walker.startNode());
+    }
 
-        // All the masks should be filtered by the walkers
-        KIS_SAFE_ASSERT_RECOVER_RETURN(currentLeaf->isLayer());
+    if (s_parallelSubtreesEnabled) {
+        mergeIndependentSubtrees(walker, useTempProjections);
+    }
 
-        QRect applyRect = item.m_applyRect;
+    while(!leafStack.isEmpty()) {
+        KisMergeWalker::JobItem item = leafStack.pop();
 
-        if (currentLeaf->isRoot()) {
-            currentLeaf->projectionPlane()->recalculate(applyRect, walker.startNode());
-            continue;
+        if (!processItem(walker, item, useTempProjections, &leafStack)) {
+            m_precalculatedLeaves.clear();
+            return;
         }
+    }
 
-        if(item.m_position & KisMergeWalker::N_EXTRA) {
-            // The type of layers that will not go to projection.
+    m_precalculatedLeaves.clear();
 
-            DEBUG_NODE_ACTION("Updating", "N_EXTRA", currentLeaf, applyRect);
-            KisUpdateOriginalVisitor originalVisitor(applyRect,
-                                                     m_currentProjection,
-                                                     walker.cropRect());
-            currentLeaf->accept(originalVisitor);
-            currentLeaf->projectionPlane()->recalculate(applyRect, currentLeaf->node());
+    if(notifyClones) {
+        doNotifyClones(walker);
+    }
 
-            continue;
-        }
+    if(m_currentProjection) {
+        warnImage << "BUG: The walker hasn't reached the root layer!";
+        warnImage << "     Start node:" << walker.startNode() << "Requested rect:" << walker.requestedRect();
+        warnImage << "     An inconsistency in the walkers occurred!";
+        warnImage << "     Please report a bug describing how you got this message.";
+        // reset projection to avoid artifacts in next merges and allow people to work further
+        resetProjection();
+    }
+}
 
+bool KisAsyncMerger::processItem(KisBaseRectsWalker &walker,
+                                 const KisBaseRectsWalker::JobItem &item,
+                                 bool useTempProjections,
+                                 const KisBaseRectsWalker::LeafStack *pendingItems)
+{
+    KisProjectionLeafSP currentLeaf = item.m_leaf;
 
-        if (!m_currentProjection) {
-            setupProjection(currentLeaf, applyRect, useTempProjections);
-        }
+    /**
+     * In some unidentified cases teh nodes might be removed
+     * while the updates are still running. We have no proof
+     * of it yet, so just add a safety assert here.
+     */
+    KIS_SAFE_ASSERT_RECOVER_RETURN_VALUE(currentLeaf, false);
+    KIS_SAFE_ASSERT_RECOVER_RETURN_VALUE(currentLeaf->node(), false);
 
+    // All the masks should be filtered by the walkers
+    KIS_SAFE_ASSERT_RECOVER_RETURN_VALUE(currentLeaf->isLayer(), false);
+
+    QRect applyRect = item.m_applyRect;
+
+    if (currentLeaf->isRoot()) {
+        currentLeaf->projectionPlane()->recalculate(applyRect, walker.startNode());
+        return true;
+    }
+
+    if(item.m_position & KisMergeWalker::N_EXTRA) {
+        // The type of layers that will not go to projection.
+
+        DEBUG_NODE_ACTION("Updating", "N_EXTRA", currentLeaf, applyRect);
         KisUpdateOriginalVisitor originalVisitor(applyRect,
                                                  m_currentProjection,
                                                  walker.cropRect());
+        currentLeaf->accept(originalVisitor);
+        currentLeaf->projectionPlane()->recalculate(applyRect, currentLeaf->node());
+
+        return true;
+    }
+
+
+    if (!m_currentProjection) {
+        setupProjection(currentLeaf, applyRect, useTempProjections);
+        setupSplitCache(walker, pendingItems, item, applyRect);
+    }
 
-        if(item.m_position & KisMergeWalker::N_FILTHY) {
-            DEBUG_NODE_ACTION("Updating", "N_FILTHY", currentLeaf, applyRect);
+    if (m_splitCache && processSplitCacheBelow(currentLeaf, applyRect)) {
+        return true;
+    }
+
+    KisUpdateOriginalVisitor originalVisitor(applyRect,
+                                             m_currentProjection,
+                                             walker.cropRect());
+
+    if(item.m_position & KisMergeWalker::N_FILTHY) {
+        DEBUG_NODE_ACTION("Updating", "N_FILTHY", currentLeaf, applyRect);
+        if ((currentLeaf->visible() || currentLeaf->hasClones()) &&
+            !m_precalculatedLeaves.contains(currentLeaf.data())) {
+
+            currentLeaf->accept(originalVisitor);
+            currentLeaf->projectionPlane()->recalculate(applyRect, walker.startNode());
+        }
+    }
+    else if(item.m_position & KisMergeWalker::N_ABOVE_FILTHY) {
+        DEBUG_NODE_ACTION("Updating", "N_ABOVE_FILTHY", currentLeaf, applyRect);
+        if(currentLeaf->dependsOnLowerNodes()) {
             if (currentLeaf->visible() || currentLeaf->hasClones()) {
                 currentLeaf->accept(originalVisitor);
-                currentLeaf->projectionPlane()->recalculate(applyRect, walker.startNode());
+                currentLeaf->projectionPlane()->recalculate(applyRect, currentLeaf->node());
             }
         }
-        else if(item.m_position & KisMergeWalker::N_ABOVE_FILTHY) {
-            DEBUG_NODE_ACTION("Updating", "N_ABOVE_FILTHY", currentLeaf, applyRect);
-            if(currentLeaf->dependsOnLowerNodes()) {
-                if (currentLeaf->visible() || currentLeaf->hasClones()) {
-                    currentLeaf->accept(originalVisitor);
-                    currentLeaf->projectionPlane()->recalculate(applyRect, currentLeaf->node());
-                }
+    }
+    else if(item.m_position & KisMergeWalker::N_FILTHY_PROJECTION) {
+        DEBUG_NODE_ACTION("Updating", "N_FILTHY_PROJECTION", currentLeaf, applyRect);
+        if (currentLeaf->visible() || currentLeaf->hasClones()) {
+            currentLeaf->projectionPlane()->recalculate(applyRect, walker.startNode());
+        }
+    }
+    else /*if(item.m_position & KisMergeWalker::N_BELOW_FILTHY)*/ {
+        DEBUG_NODE_ACTION("Updating", "N_BELOW_FILTHY", currentLeaf, applyRect);
+        /* nothing to do */
+    }
+
+    if (m_splitCache) {
+        compositeWithSplitCache(currentLeaf, applyRect);
+    } else {
+        compositeWithProjection(currentLeaf, applyRect);
+    }
+
+    if(item.m_position & KisMergeWalker::N_TOPMOST) {
+        if (m_splitCache) {
+            finishSplitCache(applyRect);
+        }
+        writeProjection(currentLeaf, useTempProjections, applyRect);
+        resetProjection();
+    }
+
+    // FIXME: remove it from the inner loop and/or change to a warning!
+    Q_ASSERT(currentLeaf->projection()->defaultBounds()->currentLevelOfDetail() ==
+             walker.levelOfDetail());
+
+    return true;
+}
+
+void KisAsyncMerger::mergeIndependentSubtrees(KisBaseRectsWalker &walker, bool useTempProjections)
+{
+    KisMergeWalker::LeafStack &leafStack = walker.leafStack();
+    KisProjectionLeafSP startLeaf = walker.startNode()->projectionLeaf();
+
+    /**
+     * When a group is refreshed, the walker puts the levels of every
+     * child group into a continuous block at the top of the stack,
+     * before the level of the group itself. The blocks of the sibling
+     * groups touch only the devices of their own subtrees, so they can
+     * be merged concurrently. The clones are the only way to look into
+     * a foreign subtree, so we don't parallelize the merge when they
+     * are present.
+     */
+    QVector<SubtreeTask> tasks;
+    int index = leafStack.size() - 1;
+
+    for (; index >= 0; index--) {
+        const KisBaseRectsWalker::JobItem &item = leafStack[index];
+
+        KisProjectionLeafSP root = findSubtreeRoot(item.m_leaf, startLeaf);
+        if (!root) break;
+
+        if (item.m_position & KisMergeWalker::N_EXTRA ||
+            isCloneRelated(item.m_leaf)) {
+
+            return;
+        }
+
+        if (tasks.isEmpty() || tasks.last().root != root) {
+            Q_FOREACH (const SubtreeTask &task, tasks) {
+                if (task.root == root) return;
             }
+
+            if (!tasks.isEmpty() &&
+                !(tasks.last().items.last().m_position & KisMergeWalker::N_TOPMOST)) {
+
+                return;
+            }
+
+            if (!dynamic_cast<KisGroupLayer*>(root->node().data()) ||
+                isCloneRelated(root)) {
+
+                return;
+            }
+
+            SubtreeTask task;
+            task.root = root;
+            tasks.append(task);
         }
-        else if(item.m_position & KisMergeWalker::N_FILTHY_PROJECTION) {
-            DEBUG_NODE_ACTION("Updating", "N_FILTHY_PROJECTION", currentLeaf, applyRect);
-            if (currentLeaf->visible() || currentLeaf->hasClones()) {
-                currentLeaf->projectionPlane()->recalculate(applyRect, walker.startNode());
+
+        tasks.last().items.append(item);
+    }
+
+    if (tasks.size() < 2 ||
+        !(tasks.last().items.last().m_position & KisMergeWalker::N_TOPMOST)) {
+
+        return;
+    }
+
+    /**
+     * The masks and layer styles of the groups themselves are
+     * calculated in the parent's level, but they don't depend on
+     * anything but the group's own original, so we can do that
+     * in the same task
+     */
+    for (int i = 0; i <= index; i++) {
+        const KisBaseRectsWalker::JobItem &item = leafStack[i];
+
+        if (!(item.m_position & KisMergeWalker::N_FILTHY) ||
+            item.m_leaf->dependsOnLowerNodes()) {
+
+            continue;
+        }
+
+        for (auto it = tasks.begin(); it != tasks.end(); ++it) {
+            if (it->root == item.m_leaf) {
+                it->rootItem = item;
+                it->hasRootItem = true;
             }
         }
-        else /*if(item.m_position & KisMergeWalker::N_BELOW_FILTHY)*/ {
-            DEBUG_NODE_ACTION("Updating", "N_BELOW_FILTHY", currentLeaf, applyRect);
-            /* nothing to do */
+    }
+
+    leafStack.resize(index + 1);
+
+    auto processSubtree = [&walker, useTempProjections] (SubtreeTask &task) {
+        KisAsyncMerger merger;
+
+        Q_FOREACH (const KisBaseRectsWalker::JobItem &item, task.items) {
+            if (!merger.processItem(walker, item, useTempProjections, 0)) {
+                return;
+            }
         }
 
-        compositeWithProjection(currentLeaf, applyRect);
+        if (task.hasRootItem &&
+            (task.root->visible() || task.root->hasClones())) {
 
-        if(item.m_position & KisMergeWalker::N_TOPMOST) {
-            writeProjection(currentLeaf, useTempProjections, applyRect);
-            resetProjection();
+            KisUpdateOriginalVisitor originalVisitor(task.rootItem.m_applyRect,
+                                                     KisPaintDeviceSP(),
+                                                     walker.cropRect());
+            task.root->accept(originalVisitor);
+            task.root->projectionPlane()->recalculate(task.rootItem.m_applyRect, walker.startNode());
+        }
+    };
+
+    /**
+     * The calling thread is one of the updater context's threads
+     * itself, so it takes the tasks too. Then it waits for the tasks
+     * the helpers have taken, not for the helpers themselves: a helper
+     * that gets a thread after all the tasks are taken just exits. So
+     * the merge never waits for a helper that cannot get a thread. The
+     * state is shared, since such a helper may outlive this call.
+     */
+    QSharedPointer<SubtreesMergeState> state(new SubtreesMergeState);
+    state->tasks.swap(tasks);
+
+    auto worker = [state, processSubtree] () {
+        int i;
+        while ((i = state->nextTask++) < state->tasks.size()) {
+            processSubtree(state->tasks[i]);
+            state->tasksDone.release();
         }
+    };
 
-        // FIXME: remove it from the inner loop and/or change to a warning!
-        Q_ASSERT(currentLeaf->projection()->defaultBounds()->currentLevelOfDetail() ==
-                 walker.levelOfDetail());
-    }
+    const int numHelpers = qMin(state->tasks.size(), s_subtreesThreadPool->maxThreadCount()) - 1;
 
-    if(notifyClones) {
-        doNotifyClones(walker);
+    for (int i = 0; i < numHelpers; i++) {
+        QtConcurrent::run(s_subtreesThreadPool, worker);
     }
 
-    if(m_currentProjection) {
-        warnImage << "BUG: The walker hasn't reached the root layer!";
-        warnImage << "     Start node:" << walker.startNode() << "Requested rect:" << walker.requestedRect();
-        warnImage << "     An inconsistency in the walkers occurred!";
-        warnImage << "     Please report a bug describing how you got this message.";
-        // reset projection to avoid artifacts in next merges and allow people to work further
-        resetProjection();
+    worker();
+
+    state->tasksDone.acquire(state->tasks.size());
+
+    Q_FOREACH (const SubtreeTask &task, state->tasks) {
+        if (task.hasRootItem) {
+            m_precalculatedLeaves.insert(task.root.data());
+        }
     }
 }
 
+void KisAsyncMerger::setParallelSubtreesEnabled(bool value)
+{
+    s_parallelSubtreesEnabled = value;
+}
+
+void KisAsyncMerger::setParallelSubtreesThreadsLimit(int value)
+{
+    s_subtreesThreadPool->setMaxThreadCount(qMax(1, value));
+}
+
 void KisAsyncMerger::resetProjection() {
     m_currentProjection = 0;
     m_finalProjection = 0;
+
+    m_splitCache = 0;
+    m_splitCacheState = KisSplitCompositeCache::State();
+    m_splitPivot = 0;
+    m_splitPivotPassed = false;
+    m_splitAboveCacheable = false;
+}
+
+void KisAsyncMerger::setupSplitCache(KisBaseRectsWalker &walker,
+                                     const KisBaseRectsWalker::LeafStack *pendingItems,
+                                     const KisBaseRectsWalker::JobItem &firstItem,
+                                     const QRect &rect)
+{
+    if (!KisSplitCompositeCache::isEnabled() || !m_currentProjection) return;
+
+    KisGroupLayer *group = dynamic_cast<KisGroupLayer*>(firstItem.m_leaf->parent()->node().data());
+    if (!group) return;
+
+    if (!pendingItems) {
+        // we don't see the rest of the group, so just drop the cache
+        group->splitCompositeCache()->reset();
+        return;
+    }
+
+    /**
+     * The items of the current group lie on the top of the stack,
+     * the topmost one ends the group
+     */
+    const KisMergeWalker::LeafStack &leafStack = *pendingItems;
+
+    KisProjectionLeafSP pivot;
+    bool hasAbove = false;
+    bool aboveCacheable = true;
+    bool canUseCache = !walker.needRectVaries() && !walker.changeRectVaries();
+
+    KisBaseRectsWalker::JobItem item = firstItem;
+    int nextIndex = leafStack.size() - 1;
+
+    while (1) {
+        if (item.m_position & KisMergeWalker::N_EXTRA || item.m_applyRect != rect) {
+            canUseCache = false;
+        }
+
+        if (item.m_position & (KisMergeWalker::N_FILTHY | KisMergeWalker::N_FILTHY_PROJECTION)) {
+            if (pivot) {
+                // e.g. a full refresh, everything is filthy
+                canUseCache = false;
+            }
+            pivot = item.m_leaf;
+        } else if (pivot) {
+            hasAbove = true;
+            aboveCacheable &= canFlattenAbove(item.m_leaf);
+        }
+
+        if (item.m_position & KisMergeWalker::N_TOPMOST || nextIndex < 0) break;
+        item = leafStack[nextIndex--];
+    }
+
+    KisSplitCompositeCache *cache = group->splitCompositeCache();
+
+    if (!pivot || !canUseCache) {
+        cache->reset();
+        return;
+    }
+
+    m_splitCache = cache;
+    m_splitCacheState = cache->fetch(pivot->node(), walker.levelOfDetail(),
+                                     m_currentProjection->colorSpace(), rect);
+    m_splitPivot = pivot;
+    m_splitPivotPassed = false;
+    m_splitAboveCacheable = hasAbove && aboveCacheable;
+}
+
+bool KisAsyncMerger::processSplitCacheBelow(KisProjectionLeafSP leaf, const QRect &rect)
+{
+    if (m_splitPivotPassed) return false;
+
+    if (leaf != m_splitPivot) {
+        // skip the layers below the pivot if their composite is cached
+        return m_splitCacheState.belowValid;
+    }
+
+    /**
+     * The pivot may depend on the lower nodes (e.g. an adjustment
+     * layer), so the below-part should be ready before updating
+     * its original
+     */
+    if (m_splitCacheState.belowValid) {
+        KisPainter::copyAreaOptimized(rect.topLeft(), m_splitCacheState.below, m_currentProjection, rect);
+    } else {
+        KisPainter::copyAreaOptimized(rect.topLeft(), m_currentProjection, m_splitCacheState.below, rect);
+        m_splitCache->markBelowValid(m_splitCacheState, rect);
+    }
+
+    if (m_splitAboveCacheable && !m_splitCacheState.aboveValid) {
+        m_splitCacheState.above->clear(rect);
+    }
+
+    m_splitPivotPassed = true;
+    return false;
+}
+
+void KisAsyncMerger::compositeWithSplitCache(KisProjectionLeafSP leaf, const QRect &rect)
+{
+    if (!m_splitAboveCacheable || leaf == m_splitPivot) {
+        compositeWithProjection(leaf, rect);
+        return;
+    }
+
+    if (!m_splitCacheState.aboveValid && leaf->visible()) {
+        KisPainter gc(m_splitCacheState.above);
+        leaf->projectionPlane()->apply(&gc, rect);
+    }
+}
+
+void KisAsyncMerger::finishSplitCache(const QRect &rect)
+{
+    if (!m_splitAboveCacheable) return;
+
+    if (!m_splitCacheState.aboveValid) {
+        m_splitCache->markAboveValid(m_splitCacheState, rect);
+    }
+
+    KisPainter gc(m_currentProjection);
+    gc.bitBlt(rect.topLeft(), m_splitCacheState.above, rect);
+}
+
+bool KisAsyncMerger::canFlattenAbove(KisProjectionLeafSP leaf)
+{
+    /**
+     * Only COMPOSITE_OVER is associative, so only such layers
+     * can be pre-composited without the layers below them
+     */
+    KisLayer *layer = dynamic_cast<KisLayer*>(leaf->node().data());
+
+    return layer &&
+        !leaf->dependsOnLowerNodes() &&
+        !leaf->isOverlayProjectionLeaf() &&
+        layer->compositeOpId() == COMPOSITE_OVER &&
+        layer->channelFlags().isEmpty() &&
+        !layer->alphaChannelDisabled() &&
+        !layer->layerStyle();
+}
+
+void KisAsyncMerger::resetSplitCaches(KisNodeSP node)
+{
+    for (KisNodeSP parent = node->parent(); parent; parent = parent->parent()) {
+        KisGroupLayer *group = dynamic_cast<KisGroupLayer*>(parent.data());
+        if (group) {
+            group->splitCompositeCache()->reset();
+        }
+    }
 }
 
 void KisAsyncMerger::setupProjection(KisProjectionLeafSP currentLeaf, const QRect& rect, bool useTempProjection) {
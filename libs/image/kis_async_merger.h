@@ -19,24 +19,56 @@
 #ifndef __KIS_ASYNC_MERGER_H
 #define __KIS_ASYNC_MERGER_H
 
+#include <QSet>
+
 #include "kritaimage_export.h"
 #include "kis_types.h"
+#include "kis_base_rects_walker.h"
+#include "kis_split_composite_cache.h"
 
 class QRect;
-class KisBaseRectsWalker;
 
 class KRITAIMAGE_EXPORT KisAsyncMerger
 {
 public:
     void startMerge(KisBaseRectsWalker &walker, bool notifyClones = true);
 
+    /**
+     * Allow merging the subtrees of the sibling groups concurrently
+     * \see KisImageConfig::parallelSubtreesMerge()
+     */
+    static void setParallelSubtreesEnabled(bool value);
+
+    /**
+     * Limits the number of threads used for merging the subtrees,
+     * including the thread that started the merge. Should be kept
+     * equal to the threads limit of the updater context.
+     */
+    static void setParallelSubtreesThreadsLimit(int value);
+
 private:
+    bool processItem(KisBaseRectsWalker &walker,
+                     const KisBaseRectsWalker::JobItem &item,
+                     bool useTempProjections,
+                     const KisBaseRectsWalker::LeafStack *pendingItems);
+    void mergeIndependentSubtrees(KisBaseRectsWalker &walker, bool useTempProjections);
+
     inline void resetProjection();
     inline void setupProjection(KisProjectionLeafSP currentLeaf, const QRect& rect, bool useTempProjection);
     inline void writeProjection(KisProjectionLeafSP topmostLeaf, bool useTempProjection, const QRect &rect);
     inline bool compositeWithProjection(KisProjectionLeafSP leaf, const QRect &rect);
     inline void doNotifyClones(KisBaseRectsWalker &walker);
 
+    void setupSplitCache(KisBaseRectsWalker &walker,
+                         const KisBaseRectsWalker::LeafStack *pendingItems,
+                         const KisBaseRectsWalker::JobItem &firstItem,
+                         const QRect &rect);
+    inline bool processSplitCacheBelow(KisProjectionLeafSP leaf, const QRect &rect);
+    inline void compositeWithSplitCache(KisProjectionLeafSP leaf, const QRect &rect);
+    inline void finishSplitCache(const QRect &rect);
+    static bool canFlattenAbove(KisProjectionLeafSP leaf);
+    static void resetSplitCaches(KisNodeSP node);
+
 private:
     /**
      * The place where intermediate results of layer's merge
@@ -62,6 +94,22 @@ private:
      * setupProjection()
      */
     KisPaintDeviceSP m_cachedPaintDevice;
+
+    /**
+     * The split composite cache of the group being merged now,
+     * \see KisSplitCompositeCache
+     */
+    KisSplitCompositeCache *m_splitCache = 0;
+    KisSplitCompositeCache::State m_splitCacheState;
+    KisProjectionLeafSP m_splitPivot;
+    bool m_splitPivotPassed = false;
+    bool m_splitAboveCacheable = false;
+
+    /**
+     * The leaves whose projections have been already recalculated
+     * by mergeIndependentSubtrees()
+     */
+    QSet<KisProjectionLeaf*> m_precalculatedLeaves;
 };
 
 
@@ -167,6 +167,10 @@ public:
         return ACTUAL_DATAMGR::region();
     }
 
+    KisRegion changedRegion(int writeEpoch) const {
+        return ACTUAL_DATAMGR::changedRegion(writeEpoch);
+    }
+
 public:
 
     /**
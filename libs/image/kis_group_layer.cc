@@ -37,6 +37,7 @@
 #include "kis_selection_mask.h"
 #include "kis_psd_layer_style.h"
 #include "kis_layer_properties_icons.h"
+#include "kis_split_composite_cache.h"
 
 
 struct Q_DECL_HIDDEN KisGroupLayer::Private
@@ -54,6 +55,7 @@ public:
     qint32 x;
     qint32 y;
     bool passThroughMode;
+    KisSplitCompositeCache splitCompositeCache;
 };
 
 KisGroupLayer::KisGroupLayer(KisImageWSP image, const QString &name, quint8 opacity) :
@@ -221,6 +223,8 @@ void KisGroupLayer::resetCache(const KoColorSpace *colorSpace)
 
         m_d->paintDevice->clear();
     }
+
+    m_d->splitCompositeCache.reset();
 }
 
 KisLayer* KisGroupLayer::onlyMeaningfulChild() const
@@ -295,6 +299,11 @@ bool KisGroupLayer::projectionIsValid() const
     return !tryObligeChild();
 }
 
+KisSplitCompositeCache* KisGroupLayer::splitCompositeCache() const
+{
+    return &m_d->splitCompositeCache;
+}
+
 void KisGroupLayer::setDefaultProjectionColor(KoColor color)
 {
     m_d->paintDevice->setDefaultPixel(color);
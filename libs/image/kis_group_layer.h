@@ -23,6 +23,7 @@
 #include "kis_types.h"
 
 class KoColorSpace;
+class KisSplitCompositeCache;
 
 /**
  * A KisLayer that bundles child layers into a single layer.
@@ -107,6 +108,12 @@ public:
 
     bool projectionIsValid() const;
 
+    /**
+     * The cache of the composites of the children lying below and
+     * above the child being painted on, used by KisAsyncMerger
+     */
+    KisSplitCompositeCache* splitCompositeCache() const;
+
 protected:
     KisLayer* onlyMeaningfulChild() const;
     KisPaintDeviceSP tryObligeChild() const;
@@ -160,10 +160,12 @@ public:
 
             // Each of these lambdas defines a new factory function.
             scheduler.setLod0ToNStrokeStrategyFactory(
-                [=](bool forgettable) {
+                [=](bool forgettable, int levelOfDetail, int sourceLevelOfDetail) {
                     return KisLodSyncPair(
                         new KisSyncLodCacheStrokeStrategy(KisImageWSP(q), forgettable),
-                        KisSyncLodCacheStrokeStrategy::createJobsData(KisImageWSP(q)));
+                        KisSyncLodCacheStrokeStrategy::createJobsData(KisImageWSP(q),
+                                                                      levelOfDetail,
+                                                                      sourceLevelOfDetail));
                 });
 
             scheduler.setSuspendResumeUpdatesStrokeStrategyFactory(
@@ -2200,6 +2202,11 @@ void KisImage::setDesiredLevelOfDetail(int lod)
     m_d->scheduler.setDesiredLevelOfDetail(lod);
 }
 
+void KisImage::setUpdatePriorityRect(const QRect &rc)
+{
+    m_d->scheduler.setUpdatePriorityRect(rc);
+}
+
 int KisImage::currentLevelOfDetail() const
 {
     if (m_d->blockLevelOfDetail) {
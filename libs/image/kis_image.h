@@ -699,6 +699,15 @@ public:
      */
     void setDesiredLevelOfDetail(int lod);
 
+    /**
+     * Notify KisImage which area of the image is visible on the
+     * canvas. The updates of this area are processed before the
+     * updates of the rest of the image, so the user sees the result
+     * of the action sooner. Pass an empty rect to disable the
+     * prioritization.
+     */
+    void setUpdatePriorityRect(const QRect &rc);
+
     /**
      * Relative position of the mirror axis center
      *     0,0 - topleft corner of the image
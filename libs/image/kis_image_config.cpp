@@ -90,6 +90,28 @@ void KisImageConfig::setEnablePerfLog(bool value)
     m_config.writeEntry("enablePerfLog", value);
 }
 
+bool KisImageConfig::enableUpdateTracing(bool requestDefault) const
+{
+    return !requestDefault ?
+        m_config.readEntry("enableUpdateTracing", false) : false;
+}
+
+void KisImageConfig::setEnableUpdateTracing(bool value)
+{
+    m_config.writeEntry("enableUpdateTracing", value);
+}
+
+int KisImageConfig::updateTraceBufferSize(bool requestDefault) const
+{
+    return !requestDefault ?
+        m_config.readEntry("updateTraceBufferSize", 100000) : 100000;
+}
+
+void KisImageConfig::setUpdateTraceBufferSize(int value)
+{
+    m_config.writeEntry("updateTraceBufferSize", value);
+}
+
 qreal KisImageConfig::transformMaskOffBoundsReadArea() const
 {
     return m_config.readEntry("transformMaskOffBoundsReadArea", 0.5);
@@ -115,6 +137,61 @@ void KisImageConfig::setUpdatePatchWidth(int value)
     m_config.writeEntry("updatePatchWidth", value);
 }
 
+bool KisImageConfig::adaptiveUpdatePatchSize(bool requestDefault) const
+{
+    return !requestDefault ?
+        m_config.readEntry("adaptiveUpdatePatchSize", true) : true;
+}
+
+void KisImageConfig::setAdaptiveUpdatePatchSize(bool value)
+{
+    m_config.writeEntry("adaptiveUpdatePatchSize", value);
+}
+
+int KisImageConfig::updatePatchTargetTime(bool requestDefault) const
+{
+    return !requestDefault ?
+        m_config.readEntry("updatePatchTargetTime", 8) : 8;
+}
+
+void KisImageConfig::setUpdatePatchTargetTime(int value)
+{
+    m_config.writeEntry("updatePatchTargetTime", value);
+}
+
+int KisImageConfig::minUpdatePatchSize(bool requestDefault) const
+{
+    return !requestDefault ?
+        m_config.readEntry("minUpdatePatchSize", 128) : 128;
+}
+
+void KisImageConfig::setMinUpdatePatchSize(int value)
+{
+    m_config.writeEntry("minUpdatePatchSize", value);
+}
+
+int KisImageConfig::maxUpdatePatchSize(bool requestDefault) const
+{
+    return !requestDefault ?
+        m_config.readEntry("maxUpdatePatchSize", 1024) : 1024;
+}
+
+void KisImageConfig::setMaxUpdatePatchSize(int value)
+{
+    m_config.writeEntry("maxUpdatePatchSize", value);
+}
+
+int KisImageConfig::updateSubtaskSize(bool requestDefault) const
+{
+    return !requestDefault ?
+        m_config.readEntry("updateSubtaskSize", 256) : 256;
+}
+
+void KisImageConfig::setUpdateSubtaskSize(int value)
+{
+    m_config.writeEntry("updateSubtaskSize", value);
+}
+
 qreal KisImageConfig::maxCollectAlpha() const
 {
     return m_config.readEntry("maxCollectAlpha", 2.5);
@@ -174,6 +251,72 @@ void KisImageConfig::setSwapWindowSize(int value)
     m_config.writeEntry("swapWindowSize", value);
 }
 
+int KisImageConfig::maxCompressedSwapCacheSize(bool requestDefault) const
+{
+    return !requestDefault ?
+        m_config.readEntry("maxCompressedSwapCacheSize", 256) : 256; // in MiB
+}
+
+void KisImageConfig::setMaxCompressedSwapCacheSize(int value)
+{
+    m_config.writeEntry("maxCompressedSwapCacheSize", value);
+}
+
+QString KisImageConfig::swapCompression(bool requestDefault) const
+{
+    return !requestDefault ?
+        m_config.readEntry("swapCompression", "lzf") : "lzf";
+}
+
+void KisImageConfig::setSwapCompression(const QString &value)
+{
+    m_config.writeEntry("swapCompression", value);
+}
+
+int KisImageConfig::swapCompressionLevel(bool requestDefault) const
+{
+    return !requestDefault ?
+        m_config.readEntry("swapCompressionLevel", 1) : 1;
+}
+
+void KisImageConfig::setSwapCompressionLevel(int value)
+{
+    m_config.writeEntry("swapCompressionLevel", value);
+}
+
+int KisImageConfig::swapCompactionThreshold(bool requestDefault) const
+{
+    return !requestDefault ?
+        m_config.readEntry("swapCompactionThreshold", 25) : 25; // in %
+}
+
+void KisImageConfig::setSwapCompactionThreshold(int value)
+{
+    m_config.writeEntry("swapCompactionThreshold", value);
+}
+
+bool KisImageConfig::compressHistoryDeltas(bool requestDefault) const
+{
+    return !requestDefault ?
+        m_config.readEntry("compressHistoryDeltas", false) : false;
+}
+
+void KisImageConfig::setCompressHistoryDeltas(bool value)
+{
+    m_config.writeEntry("compressHistoryDeltas", value);
+}
+
+int KisImageConfig::undoRevisionsInMemory(bool requestDefault) const
+{
+    return !requestDefault ?
+        m_config.readEntry("undoRevisionsInMemory", 0) : 0;
+}
+
+void KisImageConfig::setUndoRevisionsInMemory(int value)
+{
+    m_config.writeEntry("undoRevisionsInMemory", value);
+}
+
 int KisImageConfig::tilesHardLimit() const
 {
     qreal hp = qreal(memoryHardLimitPercent()) / 100.0;
@@ -230,6 +373,17 @@ void KisImageConfig::setMemoryPoolLimitPercent(qreal value)
     m_config.writeEntry("memoryPoolLimitPercent", value);
 }
 
+bool KisImageConfig::useTileDataHugePages(bool requestDefault) const
+{
+    return !requestDefault ?
+        m_config.readEntry("useTileDataHugePages", false) : false;
+}
+
+void KisImageConfig::setUseTileDataHugePages(bool value)
+{
+    m_config.writeEntry("useTileDataHugePages", value);
+}
+
 QString KisImageConfig::safelyGetWritableTempLocation(const QString &suffix, const QString &configKey, bool requestDefault) const
 {
 #ifdef Q_OS_MACOS
@@ -527,6 +681,39 @@ void KisImageConfig::setUseLodForColorizeMask(bool value)
     m_config.writeEntry("useLodForColorizeMask", value);
 }
 
+bool KisImageConfig::useSplitCompositeCache(bool requestDefault) const
+{
+    return !requestDefault ?
+        m_config.readEntry("useSplitCompositeCache", false) : false;
+}
+
+void KisImageConfig::setUseSplitCompositeCache(bool value)
+{
+    m_config.writeEntry("useSplitCompositeCache", value);
+}
+
+bool KisImageConfig::parallelSubtreesMerge(bool requestDefault) const
+{
+    return !requestDefault ?
+        m_config.readEntry("parallelSubtreesMerge", false) : false;
+}
+
+void KisImageConfig::setParallelSubtreesMerge(bool value)
+{
+    m_config.writeEntry("parallelSubtreesMerge", value);
+}
+
+bool KisImageConfig::pipelinedStrokes(bool requestDefault) const
+{
+    return !requestDefault ?
+        m_config.readEntry("pipelinedStrokes", true) : true;
+}
+
+void KisImageConfig::setPipelinedStrokes(bool value)
+{
+    m_config.writeEntry("pipelinedStrokes", value);
+}
+
 int KisImageConfig::maxNumberOfThreads(bool defaultValue) const
 {
     return (defaultValue ? QThread::idealThreadCount() : m_config.readEntry("maxNumberOfThreads", QThread::idealThreadCount()));
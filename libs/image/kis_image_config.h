@@ -36,6 +36,12 @@ public:
     bool enablePerfLog(bool requestDefault = false) const;
     void setEnablePerfLog(bool value);
 
+    bool enableUpdateTracing(bool requestDefault = false) const;
+    void setEnableUpdateTracing(bool value);
+
+    int updateTraceBufferSize(bool requestDefault = false) const;
+    void setUpdateTraceBufferSize(int value);
+
     qreal transformMaskOffBoundsReadArea() const;
 
     int updatePatchHeight() const;
@@ -43,6 +49,24 @@ public:
     int updatePatchWidth() const;
     void setUpdatePatchWidth(int value);
 
+    /**
+     * When enabled, the size of the update patches is adjusted at
+     * runtime from the measured cost of the merge jobs of each node,
+     * so that a single patch takes about updatePatchTargetTime()
+     * milliseconds to merge. updatePatchWidth() and updatePatchHeight()
+     * are used until the cost of the node is known.
+     */
+    bool adaptiveUpdatePatchSize(bool requestDefault = false) const;
+    void setAdaptiveUpdatePatchSize(bool value);
+    int updatePatchTargetTime(bool requestDefault = false) const;
+    void setUpdatePatchTargetTime(int value);
+    int minUpdatePatchSize(bool requestDefault = false) const;
+    void setMinUpdatePatchSize(int value);
+    int maxUpdatePatchSize(bool requestDefault = false) const;
+    void setMaxUpdatePatchSize(int value);
+    int updateSubtaskSize(bool requestDefault = false) const;
+    void setUpdateSubtaskSize(int value);
+
     qreal maxCollectAlpha() const;
     qreal maxMergeAlpha() const;
     qreal maxMergeCollectAlpha() const;
@@ -58,6 +82,48 @@ public:
     int swapWindowSize() const;
     void setSwapWindowSize(int value);
 
+    /**
+     * Size of the in-memory tier of the swap, where the swapped out
+     * tiles are kept in compressed form before being spilled to
+     * the swap file. Zero disables the tier.
+     */
+    int maxCompressedSwapCacheSize(bool requestDefault = false) const; // MiB
+    void setMaxCompressedSwapCacheSize(int value);
+
+    /**
+     * Compression used for the swapped out tiles: "lzf" or "zstd".
+     * The latter is available only if Krita is built with zstd.
+     */
+    QString swapCompression(bool requestDefault = false) const;
+    void setSwapCompression(const QString &value);
+
+    int swapCompressionLevel(bool requestDefault = false) const;
+    void setSwapCompressionLevel(int value);
+
+    /**
+     * The swap file is compacted in background when the holes
+     * between the chunks take more than this part of it
+     */
+    int swapCompactionThreshold(bool requestDefault = false) const; // %
+    void setSwapCompactionThreshold(int value);
+
+    /**
+     * When enabled, the tile datas that went down in the undo
+     * history are kept as compressed XOR-deltas against the
+     * following revision of the tile and restored on access.
+     */
+    bool compressHistoryDeltas(bool requestDefault = false) const;
+    void setCompressHistoryDeltas(bool value);
+
+    /**
+     * Number of the most recent revisions of every paint device,
+     * whose tile datas are kept in memory. The tile datas of older
+     * revisions are written to the swap file and loaded back on
+     * undo. Zero means no limit.
+     */
+    int undoRevisionsInMemory(bool requestDefault = false) const;
+    void setUndoRevisionsInMemory(int value);
+
     int tilesHardLimit() const; // MiB
     int tilesSoftLimit() const; // MiB
     int poolLimit() const; // MiB
@@ -71,6 +137,13 @@ public:
 
     static int totalRAM(); // MiB
 
+    /**
+     * Ask the system to back the tile data arenas with
+     * transparent huge pages (if supported by the OS)
+     */
+    bool useTileDataHugePages(bool requestDefault = false) const;
+    void setUseTileDataHugePages(bool value);
+
     /**
      * @return a specific directory for the swapfile, if set. If not set, return an
      * empty QString and use the default KDE directory.
@@ -111,6 +184,15 @@ public:
     bool useLodForColorizeMask(bool requestDefault = false) const;
     void setUseLodForColorizeMask(bool value);
 
+    bool useSplitCompositeCache(bool requestDefault = false) const;
+    void setUseSplitCompositeCache(bool value);
+
+    bool parallelSubtreesMerge(bool requestDefault = false) const;
+    void setParallelSubtreesMerge(bool value);
+
+    bool pipelinedStrokes(bool requestDefault = false) const;
+    void setPipelinedStrokes(bool value);
+
     int maxNumberOfThreads(bool defaultValue = false) const;
     void setMaxNumberOfThreads(int value);
 
@@ -156,6 +156,10 @@ KisMemoryStatisticsServer::fetchMemoryStatistics(KisImageSP image) const
     stats.poolSize = tileStats.poolSize;
 
     stats.swapSize = tileStats.swapSize;
+    stats.compressedSwapSize = tileStats.compressedSwapSize;
+
+    stats.slabReservedSize = tileStats.slabReservedSize;
+    stats.slabUsedSize = tileStats.slabUsedSize;
 
     KisImageConfig cfg(true);
 
@@ -45,6 +45,10 @@ public:
               poolSize(0),
 
               swapSize(0),
+              compressedSwapSize(0),
+
+              slabReservedSize(0),
+              slabUsedSize(0),
 
               totalMemoryLimit(0),
               tilesHardLimit(0),
@@ -64,6 +68,10 @@ public:
         qint64 poolSize;
 
         qint64 swapSize;
+        qint64 compressedSwapSize;
+
+        qint64 slabReservedSize;
+        qint64 slabUsedSize;
 
         qint64 totalMemoryLimit;
         qint64 tilesHardLimit;
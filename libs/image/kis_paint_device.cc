@@ -25,6 +25,9 @@
 #include <QList>
 #include <QHash>
 #include <QIODevice>
+#include <QRegion>
+#include <QMutex>
+#include <QtConcurrent>
 #include <qmath.h>
 #include <KisRegion.h>
 
@@ -54,6 +57,7 @@
 #include "tiles3/kis_hline_iterator.h"
 #include "tiles3/kis_vline_iterator.h"
 #include "tiles3/kis_random_accessor.h"
+#include "tiles3/kis_tile.h"
 
 #include "kis_default_bounds.h"
 
@@ -112,7 +116,7 @@ public:
     KisPaintDeviceStrategy* currentStrategy();
 
     void init(const KoColorSpace *cs, const quint8 *defaultPixel);
-    void convertColorSpace(const KoColorSpace * dstColorSpace, KoColorConversionTransformation::Intent renderingIntent, KoColorConversionTransformation::ConversionFlags conversionFlags, KUndo2Command *parentCommand);
+    void convertColorSpace(const KoColorSpace * dstColorSpace, KoColorConversionTransformation::Intent renderingIntent, KoColorConversionTransformation::ConversionFlags conversionFlags, KUndo2Command *parentCommand, KoUpdater *progressUpdater);
     bool assignProfile(const KoColorProfile * profile, KUndo2Command *parentCommand);
 
     inline const KoColorSpace* colorSpace() const
@@ -154,7 +158,9 @@ public:
     void cloneAllDataObjects(Private *rhs, bool copyFrames)
     {
 
-        m_lodData.reset();
+        for (int i = 0; i < NumLodLevels; i++) {
+            m_lodData[i].reset();
+        }
         m_externalFrameData.reset();
 
         if (!m_frames.isEmpty()) {
@@ -188,8 +194,10 @@ public:
             m_nextFreeFrameId = rhs->m_nextFreeFrameId;
         }
 
-        if (rhs->m_lodData) {
-            m_lodData.reset(new KisPaintDeviceData(q, rhs->m_lodData.data(), true));
+        for (int i = 0; i < NumLodLevels; i++) {
+            if (rhs->m_lodData[i]) {
+                m_lodData[i].reset(new KisPaintDeviceData(q, rhs->m_lodData[i].data(), true));
+            }
         }
     }
 
@@ -405,11 +413,28 @@ public:
     void uploadFrame(int dstFrameId, KisPaintDeviceSP srcDevice);
     void uploadFrameData(DataSP srcData, DataSP dstData);
 
+    /**
+     * The state of the original data the level of detail has been
+     * synchronized with. It is used for finding out which parts of
+     * the level should be regenerated on the next synchronization.
+     */
+    struct LodSyncState {
+        KisWeakSharedPtr<KisDataManager> sourceDataManager;
+        KisWeakSharedPtr<KisDataManager> lodDataManager;
+        QPoint sourceOffset;
+        QRegion sourceRegion;
+        int sourceWriteEpoch = 0;
+        int lodWriteEpoch = 0;
+    };
+
     struct LodDataStructImpl;
-    LodDataStruct* createLodDataStruct(int lod);
+    LodDataStruct* createLodDataStruct(int lod, int sourceLod);
     void updateLodDataStruct(LodDataStruct *dst, const QRect &srcRect);
     void uploadLodDataStruct(LodDataStruct *dst);
     KisRegion regionForLodSyncing() const;
+    KisRegion regionForLodSyncing(LodDataStruct *dst) const;
+    bool hasLodData(int lod) const;
+    bool canSyncLodDataIncrementally(int lod, Data *srcData) const;
 
     void updateLodDataManager(KisDataManager *srcDataManager,
                               KisDataManager *dstDataManager, const QPoint &srcOffset, const QPoint &dstOffset,
@@ -437,8 +462,10 @@ public:
             imageData += estimateDataSize(m_data.data());
         }
 
-        if (m_lodData) {
-            lodData += estimateDataSize(m_lodData.data());
+        for (int i = 0; i < NumLodLevels; i++) {
+            if (m_lodData[i]) {
+                lodData += estimateDataSize(m_lodData[i].data());
+            }
         }
 
         if (m_externalFrameData) {
@@ -498,25 +525,39 @@ private:
         return data;
     }
 
-    inline void ensureLodDataPresent() const
+    /**
+     * The levels higher than the size of the pyramid share the
+     * last slot of it
+     */
+    static inline int lodSlot(int lod)
+    {
+        return qBound(1, lod, NumLodLevels - 1);
+    }
+
+    inline Data* ensureLodDataPresent(int lod) const
     {
-        if (!m_lodData) {
+        QScopedPointer<Data> &lodData = m_lodData[lodSlot(lod)];
+
+        if (!lodData) {
             Data *srcData = currentNonLodData();
 
             QMutexLocker l(&m_dataSwitchLock);
-            if (!m_lodData) {
-                m_lodData.reset(new Data(q, srcData, false));
+            if (!lodData) {
+                lodData.reset(new Data(q, srcData, false));
             }
         }
+
+        return lodData.data();
     }
 
     inline Data* currentData() const
     {
         Data *data;
 
-        if (defaultBounds->currentLevelOfDetail()) {
-            ensureLodDataPresent();
-            data = m_lodData.data();
+        const int lod = defaultBounds->currentLevelOfDetail();
+
+        if (lod) {
+            data = ensureLodDataPresent(lod);
         } else {
             data = currentNonLodData();
         }
@@ -552,7 +593,9 @@ private:
         if (m_frames.isEmpty()) {
             dataObjects << m_data.data();
         }
-        dataObjects << m_lodData.data();
+        for (int i = 0; i < NumLodLevels; i++) {
+            dataObjects << m_lodData[i].data();
+        }
         dataObjects << m_externalFrameData.data();
 
         Q_FOREACH (DataSP value, m_frames.values()) {
@@ -573,7 +616,15 @@ private:
 
 private:
     DataSP m_data;
-    mutable QScopedPointer<Data> m_lodData;
+
+    /**
+     * The pyramid of the levels of detail, the slot
+     * with index zero is not used
+     */
+    static const int NumLodLevels = 8;
+    mutable QScopedPointer<Data> m_lodData[NumLodLevels];
+    LodSyncState m_lodSyncState[NumLodLevels];
+
     mutable QScopedPointer<Data> m_externalFrameData;
     mutable QMutex m_dataSwitchLock;
 
@@ -653,8 +704,16 @@ struct KisPaintDevice::Private::StrategyPolicy {
 };
 
 struct KisPaintDevice::Private::LodDataStructImpl : public KisPaintDevice::LodDataStruct {
-    LodDataStructImpl(Data *_lodData) : lodData(_lodData) {}
+    LodDataStructImpl(Data *_lodData, int _sourceLod) : lodData(_lodData), sourceLod(_sourceLod) {}
     QScopedPointer<Data> lodData;
+    int sourceLod;
+
+    /**
+     * The region of the original data that should be resampled
+     * and the state that will be reached when it is done
+     */
+    KisRegion syncRegion;
+    LodSyncState syncState;
 };
 
 KisRegion KisPaintDevice::Private::regionForLodSyncing() const
@@ -663,14 +722,125 @@ KisRegion KisPaintDevice::Private::regionForLodSyncing() const
     return srcData->dataManager()->region().translated(srcData->x(), srcData->y());
 }
 
-KisPaintDevice::LodDataStruct* KisPaintDevice::Private::createLodDataStruct(int newLod)
+KisRegion KisPaintDevice::Private::regionForLodSyncing(LodDataStruct *_dst) const
+{
+    LodDataStructImpl *dst = dynamic_cast<LodDataStructImpl*>(_dst);
+    KIS_SAFE_ASSERT_RECOVER(dst) { return regionForLodSyncing(); }
+
+    return dst->syncRegion;
+}
+
+bool KisPaintDevice::Private::canSyncLodDataIncrementally(int lod, Data *srcData) const
+{
+    const int slot = lodSlot(lod);
+    Data *lodData = m_lodData[slot].data();
+    const LodSyncState &state = m_lodSyncState[slot];
+
+    /**
+     * The level can be updated incrementally only if it has been
+     * generated from the same data manager as the current one, and
+     * nobody has recreated it since then
+     */
+    return lodData &&
+        lodData->levelOfDetail() == lod &&
+        lodData->colorSpace() == srcData->colorSpace() &&
+        lodData->x() == KisLodTransform::coordToLodCoord(srcData->x(), lod) &&
+        lodData->y() == KisLodTransform::coordToLodCoord(srcData->y(), lod) &&
+        state.sourceDataManager.isValid() &&
+        state.sourceDataManager == srcData->dataManager().data() &&
+        state.lodDataManager.isValid() &&
+        state.lodDataManager == lodData->dataManager().data() &&
+        state.sourceOffset == QPoint(srcData->x(), srcData->y()) &&
+        !memcmp(lodData->dataManager()->defaultPixel(),
+                srcData->dataManager()->defaultPixel(),
+                srcData->dataManager()->pixelSize());
+}
+
+bool KisPaintDevice::Private::hasLodData(int lod) const
+{
+    Data *lodData = m_lodData[lodSlot(lod)].data();
+    return lodData && lodData->levelOfDetail() == lod;
+}
+
+KisPaintDevice::LodDataStruct* KisPaintDevice::Private::createLodDataStruct(int newLod, int sourceLod)
 {
     KIS_SAFE_ASSERT_RECOVER_NOOP(newLod > 0);
+    KIS_SAFE_ASSERT_RECOVER(sourceLod < newLod) { sourceLod = 0; }
 
     Data *srcData = currentNonLodData();
 
+    /**
+     * The cached level can be used as a source only if it is
+     * still consistent with the original data
+     */
+    if (sourceLod > 0) {
+        Data *sourceData = m_lodData[lodSlot(sourceLod)].data();
+
+        if (!sourceData ||
+            sourceData->levelOfDetail() != sourceLod ||
+            sourceData->colorSpace() != srcData->colorSpace() ||
+            sourceData->x() != KisLodTransform::coordToLodCoord(srcData->x(), sourceLod) ||
+            sourceData->y() != KisLodTransform::coordToLodCoord(srcData->y(), sourceLod)) {
+
+            sourceLod = 0;
+        }
+    }
+
+    /**
+     * All the writes to the original data that happen after this
+     * point will be considered as changes by the next synchronization
+     */
+    LodSyncState syncState;
+    syncState.sourceWriteEpoch = KisTile::startNewWriteEpoch();
+    syncState.sourceDataManager = srcData->dataManager();
+    syncState.sourceOffset = QPoint(srcData->x(), srcData->y());
+    syncState.sourceRegion = srcData->dataManager()->region().toQRegion();
+
+    if (!sourceLod && canSyncLodDataIncrementally(newLod, srcData)) {
+        const int slot = lodSlot(newLod);
+        const LodSyncState &state = m_lodSyncState[slot];
+        Data *levelData = m_lodData[slot].data();
+
+        /**
+         * The tiles that have been changed, created or removed since
+         * the last synchronization...
+         */
+        QRegion dirtyRegion =
+            srcData->dataManager()->changedRegion(state.sourceWriteEpoch).toQRegion();
+        dirtyRegion += state.sourceRegion.xored(syncState.sourceRegion);
+
+        /**
+         * ... and the areas the strokes have painted on the level
+         * itself, because their result differs from the resampled
+         * original data
+         */
+        Q_FOREACH (const QRect &rc, levelData->dataManager()->changedRegion(state.lodWriteEpoch).rects()) {
+            const QRect levelRect = rc.translated(levelData->x(), levelData->y());
+            dirtyRegion += KisLodTransform::upscaledRect(levelRect, newLod)
+                .translated(-srcData->x(), -srcData->y());
+        }
+
+        Data *lodData = new Data(q, levelData, true);
+        LodDataStructImpl *lodStruct = new LodDataStructImpl(lodData, 0);
+        lodStruct->syncRegion = KisRegion::fromQRegion(dirtyRegion).translated(srcData->x(), srcData->y());
+        lodStruct->syncState = syncState;
+
+        lodData->cache()->invalidate();
+
+        return lodStruct;
+    }
+
     Data *lodData = new Data(q, srcData, false);
-    LodDataStruct *lodStruct = new LodDataStructImpl(lodData);
+    LodDataStructImpl *lodStruct = new LodDataStructImpl(lodData, sourceLod);
+    lodStruct->syncRegion = KisRegion::fromQRegion(syncState.sourceRegion).translated(srcData->x(), srcData->y());
+
+    /**
+     * The level generated from another level inherits its
+     * inaccuracy, so it is always regenerated from scratch
+     */
+    if (!sourceLod) {
+        lodStruct->syncState = syncState;
+    }
 
     int expectedX = KisLodTransform::coordToLodCoord(srcData->x(), newLod);
     int expectedY = KisLodTransform::coordToLodCoord(srcData->y(), newLod);
@@ -802,14 +972,32 @@ void KisPaintDevice::Private::updateLodDataStruct(LodDataStruct *_dst, const QRe
     KIS_SAFE_ASSERT_RECOVER_RETURN(dst);
 
     Data *lodData = dst->lodData.data();
-    Data *srcData = currentNonLodData();
-
     const int lod = lodData->levelOfDetail();
 
-    updateLodDataManager(srcData->dataManager().data(), lodData->dataManager().data(),
-                         QPoint(srcData->x(), srcData->y()),
-                         QPoint(lodData->x(), lodData->y()),
-                         originalRect, lod);
+    if (dst->sourceLod > 0) {
+        /**
+         * Downsample the data from the finer level of the pyramid.
+         * The original rect is aligned to the grid of the final level
+         * first, so the rect in the source level is aligned as well.
+         */
+        Data *srcData = m_lodData[lodSlot(dst->sourceLod)].data();
+        KIS_SAFE_ASSERT_RECOVER_RETURN(srcData);
+
+        const QRect alignedRect = KisLodTransform::alignedRect(originalRect, lod);
+        const QRect sourceRect = KisLodTransform::scaledRect(alignedRect, dst->sourceLod);
+
+        updateLodDataManager(srcData->dataManager().data(), lodData->dataManager().data(),
+                             QPoint(srcData->x(), srcData->y()),
+                             QPoint(lodData->x(), lodData->y()),
+                             sourceRect, lod - dst->sourceLod);
+    } else {
+        Data *srcData = currentNonLodData();
+
+        updateLodDataManager(srcData->dataManager().data(), lodData->dataManager().data(),
+                             QPoint(srcData->x(), srcData->y()),
+                             QPoint(lodData->x(), lodData->y()),
+                             originalRect, lod);
+    }
 }
 
 void KisPaintDevice::Private::generateLodCloneDevice(KisPaintDeviceSP dst, const QRect &originalRect, int lod)
@@ -828,13 +1016,23 @@ void KisPaintDevice::Private::uploadLodDataStruct(LodDataStruct *_dst)
     LodDataStructImpl *dst = dynamic_cast<LodDataStructImpl*>(_dst);
     KIS_SAFE_ASSERT_RECOVER_RETURN(dst);
 
+    const int lod = dst->lodData->levelOfDetail();
+
     KIS_SAFE_ASSERT_RECOVER_RETURN(
-        dst->lodData->levelOfDetail() == defaultBounds->currentLevelOfDetail());
+        lod == defaultBounds->currentLevelOfDetail());
+
+    Data *lodData = ensureLodDataPresent(lod);
+
+    lodData->prepareClone(dst->lodData.data());
+    lodData->dataManager()->bitBltRough(dst->lodData->dataManager(), dst->lodData->dataManager()->extent());
 
-    ensureLodDataPresent();
+    LodSyncState &state = m_lodSyncState[lodSlot(lod)];
+    state = dst->syncState;
 
-    m_lodData->prepareClone(dst->lodData.data());
-    m_lodData->dataManager()->bitBltRough(dst->lodData->dataManager(), dst->lodData->dataManager()->extent());
+    if (state.sourceDataManager.isValid()) {
+        state.lodDataManager = lodData->dataManager();
+        state.lodWriteEpoch = KisTile::startNewWriteEpoch();
+    }
 }
 
 void KisPaintDevice::Private::transferFromData(Data *data, KisPaintDeviceSP targetDevice)
@@ -899,7 +1097,7 @@ void KisPaintDevice::Private::uploadFrameData(DataSP srcData, DataSP dstData)
 
 void KisPaintDevice::Private::tesingFetchLodDevice(KisPaintDeviceSP targetDevice)
 {
-    Data *data = m_lodData.data();
+    Data *data = m_lodData[lodSlot(defaultBounds->currentLevelOfDetail())].data();
     Q_ASSERT(data);
 
     transferFromData(data, targetDevice);
@@ -957,18 +1155,31 @@ public:
     }
 };
 
-void KisPaintDevice::Private::convertColorSpace(const KoColorSpace * dstColorSpace, KoColorConversionTransformation::Intent renderingIntent, KoColorConversionTransformation::ConversionFlags conversionFlags, KUndo2Command *parentCommand)
+void KisPaintDevice::Private::convertColorSpace(const KoColorSpace * dstColorSpace, KoColorConversionTransformation::Intent renderingIntent, KoColorConversionTransformation::ConversionFlags conversionFlags, KUndo2Command *parentCommand, KoUpdater *progressUpdater)
 {
     QList<Data*> dataObjects = allDataObjects();
-    if (dataObjects.isEmpty()) return;
+    dataObjects.removeAll(0);
+
+    if (dataObjects.isEmpty()) {
+        if (progressUpdater) {
+            progressUpdater->setProgress(100);
+        }
+        return;
+    }
 
     KUndo2Command *mainCommand =
         parentCommand ? new DeviceChangeColorSpaceCommand(q, parentCommand) : 0;
 
-    Q_FOREACH (Data *data, dataObjects) {
-        if (!data) continue;
+    for (int i = 0; i < dataObjects.size(); i++) {
+        const int progressBase = 100 * i / dataObjects.size();
+        const int progressSpan = 100 * (i + 1) / dataObjects.size() - progressBase;
 
-        data->convertDataColorSpace(dstColorSpace, renderingIntent, conversionFlags, mainCommand);
+        dataObjects[i]->convertDataColorSpace(dstColorSpace, renderingIntent, conversionFlags, mainCommand,
+                                              progressUpdater, progressBase, progressSpan);
+    }
+
+    if (progressUpdater) {
+        progressUpdater->setProgress(100);
     }
 
     q->emitColorSpaceChanged();
@@ -1535,9 +1746,9 @@ void KisPaintDevice::emitProfileChanged()
     emit profileChanged(m_d->colorSpace()->profile());
 }
 
-void KisPaintDevice::convertTo(const KoColorSpace * dstColorSpace, KoColorConversionTransformation::Intent renderingIntent, KoColorConversionTransformation::ConversionFlags conversionFlags, KUndo2Command *parentCommand)
+void KisPaintDevice::convertTo(const KoColorSpace * dstColorSpace, KoColorConversionTransformation::Intent renderingIntent, KoColorConversionTransformation::ConversionFlags conversionFlags, KUndo2Command *parentCommand, KoUpdater *progressUpdater)
 {
-    m_d->convertColorSpace(dstColorSpace, renderingIntent, conversionFlags, parentCommand);
+    m_d->convertColorSpace(dstColorSpace, renderingIntent, conversionFlags, parentCommand, progressUpdater);
 }
 
 bool KisPaintDevice::setProfile(const KoColorProfile * profile, KUndo2Command *parentCommand)
@@ -1813,6 +2024,11 @@ KisRandomConstAccessorSP KisPaintDevice::createRandomConstAccessorNG(qint32 x, q
     return m_d->currentStrategy()->createRandomConstAccessorNG(x, y);
 }
 
+void KisPaintDevice::prefetchRect(const QRect &rect) const
+{
+    m_d->dataManager()->prefetchTiles(rect.translated(-m_d->x(), -m_d->y()));
+}
+
 KisRandomSubAccessorSP KisPaintDevice::createRandomSubAccessor() const
 {
     KisPaintDevice* pd = const_cast<KisPaintDevice*>(this);
@@ -2073,9 +2289,19 @@ KisRegion KisPaintDevice::regionForLodSyncing() const
     return m_d->regionForLodSyncing();
 }
 
-KisPaintDevice::LodDataStruct* KisPaintDevice::createLodDataStruct(int lod)
+KisPaintDevice::LodDataStruct* KisPaintDevice::createLodDataStruct(int lod, int sourceLod)
+{
+    return m_d->createLodDataStruct(lod, sourceLod);
+}
+
+KisRegion KisPaintDevice::regionForLodSyncing(LodDataStruct *dst) const
+{
+    return m_d->regionForLodSyncing(dst);
+}
+
+bool KisPaintDevice::hasLodData(int lod) const
 {
-    return m_d->createLodDataStruct(lod);
+    return m_d->hasLodData(lod);
 }
 
 void KisPaintDevice::updateLodDataStruct(LodDataStruct *dst, const QRect &srcRect)
@@ -2210,7 +2436,8 @@ KisPaintDeviceFramesInterface::testingGetDataObjects() const
     TestingDataObjects objects;
 
     objects.m_data = q->m_d->m_data.data();
-    objects.m_lodData = q->m_d->m_lodData.data();
+    const int lod = q->m_d->defaultBounds->currentLevelOfDetail();
+    objects.m_lodData = lod ? q->m_d->m_lodData[KisPaintDevice::Private::lodSlot(lod)].data() : 0;
     objects.m_externalFrameData = q->m_d->m_externalFrameData.data();
 
     typedef KisPaintDevice::Private::FramesHash FramesHash;
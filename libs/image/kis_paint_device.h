@@ -44,6 +44,7 @@ class QIODevice;
 class KoColor;
 class KoColorSpace;
 class KoColorProfile;
+class KoUpdater;
 
 class KisRegion;
 class KisDataManager;
@@ -482,12 +483,15 @@ public:
     void writePlanarBytes(QVector<quint8*> planes, qint32 x, qint32 y, qint32 w, qint32 h);
 
     /**
-     * Converts the paint device to a different colorspace
+     * Converts the paint device to a different colorspace. The tiles of
+     * the device are converted in parallel, the progress is reported
+     * into \p progressUpdater, if present.
      */
     void convertTo(const KoColorSpace * dstColorSpace,
                    KoColorConversionTransformation::Intent renderingIntent = KoColorConversionTransformation::internalRenderingIntent(),
                    KoColorConversionTransformation::ConversionFlags conversionFlags = KoColorConversionTransformation::internalConversionFlags(),
-                   KUndo2Command *parentCommand = 0);
+                   KUndo2Command *parentCommand = 0,
+                   KoUpdater *progressUpdater = 0);
 
     /**
      * Changes the profile of the colorspace of this paint device to the given
@@ -789,6 +793,14 @@ public:
     KisRandomAccessorSP createRandomAccessorNG(qint32 x, qint32 y);
     KisRandomConstAccessorSP createRandomConstAccessorNG(qint32 x, qint32 y) const;
 
+    /**
+     * Notifies the device that \p rect is going to be accessed
+     * soon. If some of the tiles in this area are swapped out, they
+     * will be loaded in the background while the caller prepares
+     * its work.
+     */
+    void prefetchRect(const QRect &rect) const;
+
     /**
      * Create an iterator that will "artificially" extend the paint device with the
      * value of the border when trying to access values outside the range of data.
@@ -850,10 +862,34 @@ public:
     };
 
     KisRegion regionForLodSyncing() const;
-    LodDataStruct* createLodDataStruct(int lod);
+
+    /**
+     * Creates a structure for synchronizing the data of level \p lod.
+     * If \p sourceLod is non-zero, the data is downsampled from the
+     * (already synchronized) cached data of that level instead of
+     * the original data, which is 4^sourceLod times cheaper.
+     * \p sourceLod must be less than \p lod.
+     */
+    LodDataStruct* createLodDataStruct(int lod, int sourceLod = 0);
     void updateLodDataStruct(LodDataStruct *dst, const QRect &srcRect);
     void uploadLodDataStruct(LodDataStruct *dst);
 
+    /**
+     * Returns the region that should be passed to updateLodDataStruct()
+     * for \p dst. If the level has already been synchronized with the
+     * current data, the region contains only the tiles that have been
+     * changed since then and the areas painted on the level itself.
+     */
+    KisRegion regionForLodSyncing(LodDataStruct *dst) const;
+
+    /**
+     * The data of every level of detail the device has been synchronized
+     * to is kept in a pyramid, so switching between the levels doesn't
+     * need resampling if the original data hasn't changed. Returns true
+     * if the device has data for level \p lod.
+     */
+    bool hasLodData(int lod) const;
+
     void generateLodCloneDevice(KisPaintDeviceSP dst, const QRect &originalRect, int lod);
 
     void setProjectionDevice(bool value);
@@ -19,6 +19,11 @@
 #ifndef __KIS_PAINT_DEVICE_DATA_H
 #define __KIS_PAINT_DEVICE_DATA_H
 
+#include <QMutex>
+#include <QtConcurrent>
+
+#include <KoUpdater.h>
+
 #include "KoAlwaysInline.h"
 #include "kundo2command.h"
 
@@ -167,7 +172,17 @@ public:
         }
     }
 
-    void convertDataColorSpace(const KoColorSpace *dstColorSpace, KoColorConversionTransformation::Intent renderingIntent, KoColorConversionTransformation::ConversionFlags conversionFlags, KUndo2Command *parentCommand) {
+    /**
+     * Converts the data into \p dstColorSpace. The device is split into
+     * stripes of tile rows that are converted in parallel, unless the
+     * device is too small for that. The stripes never share tiles, so
+     * the workers don't contend on the destination data manager.
+     *
+     * The progress is reported into \p progressUpdater, mapped into the
+     * range [progressBase, progressBase + progressSpan]
+     */
+    void convertDataColorSpace(const KoColorSpace *dstColorSpace, KoColorConversionTransformation::Intent renderingIntent, KoColorConversionTransformation::ConversionFlags conversionFlags, KUndo2Command *parentCommand,
+                               KoUpdater *progressUpdater = 0, int progressBase = 0, int progressSpan = 100) {
         typedef KisSequentialIteratorBase<ReadOnlyIteratorPolicy<DirectDataAccessPolicy>, DirectDataAccessPolicy> InternalSequentialConstIterator;
         typedef KisSequentialIteratorBase<WritableIteratorPolicy<DirectDataAccessPolicy>, DirectDataAccessPolicy> InternalSequentialIterator;
 
@@ -186,26 +201,67 @@ public:
 
 
         if (!rc.isEmpty()) {
-            InternalSequentialConstIterator srcIt(DirectDataAccessPolicy(m_dataManager.data(), cacheInvalidator()), rc);
-            InternalSequentialIterator dstIt(DirectDataAccessPolicy(dstDataManager.data(), cacheInvalidator()), rc);
-
-            int nConseqPixels = srcIt.nConseqPixels();
+            QVector<QRect> stripes;
 
-            // since we are accessing data managers directly, the columns are always aligned
-            KIS_SAFE_ASSERT_RECOVER_NOOP(srcIt.nConseqPixels() == dstIt.nConseqPixels());
+            for (int y = rc.top(); y <= rc.bottom();) {
+                const int tileRow = y >= 0 ? y / KisTileData::HEIGHT : -((-y - 1) / KisTileData::HEIGHT) - 1;
+                const int nextY = qMin((tileRow + 1) * KisTileData::HEIGHT, rc.bottom() + 1);
 
-            while(srcIt.nextPixels(nConseqPixels) &&
-                  dstIt.nextPixels(nConseqPixels)) {
-
-                nConseqPixels = srcIt.nConseqPixels();
-
-                const quint8 *srcData = srcIt.rawDataConst();
-                quint8 *dstData = dstIt.rawData();
+                stripes << QRect(rc.left(), y, rc.width(), nextY - y);
+                y = nextY;
+            }
 
-                m_colorSpace->convertPixelsTo(srcData, dstData,
-                                              dstColorSpace,
-                                              nConseqPixels,
-                                              renderingIntent, conversionFlags);
+            const KoColorSpace *srcColorSpace = m_colorSpace;
+            KisDataManager *srcDataManager = m_dataManager.data();
+            KisIteratorCompleteListener *completionListener = cacheInvalidator();
+
+            QMutex progressMutex;
+            int numProcessedStripes = 0;
+
+            auto convertStripe =
+                [&] (const QRect &stripe) {
+                    InternalSequentialConstIterator srcIt(DirectDataAccessPolicy(srcDataManager, completionListener), stripe);
+                    InternalSequentialIterator dstIt(DirectDataAccessPolicy(dstDataManager.data(), completionListener), stripe);
+
+                    int nConseqPixels = srcIt.nConseqPixels();
+
+                    // since we are accessing data managers directly, the columns are always aligned
+                    KIS_SAFE_ASSERT_RECOVER_NOOP(srcIt.nConseqPixels() == dstIt.nConseqPixels());
+
+                    while(srcIt.nextPixels(nConseqPixels) &&
+                          dstIt.nextPixels(nConseqPixels)) {
+
+                        nConseqPixels = srcIt.nConseqPixels();
+
+                        const quint8 *srcData = srcIt.rawDataConst();
+                        quint8 *dstData = dstIt.rawData();
+
+                        srcColorSpace->convertPixelsTo(srcData, dstData,
+                                                       dstColorSpace,
+                                                       nConseqPixels,
+                                                       renderingIntent, conversionFlags);
+                    }
+
+                    if (progressUpdater) {
+                        // KoUpdater is not thread-safe
+                        QMutexLocker l(&progressMutex);
+                        numProcessedStripes++;
+                        progressUpdater->setProgress(progressBase + progressSpan * numProcessedStripes / stripes.size());
+                    }
+                };
+
+            /**
+             * Small devices (e.g. the temporary composition sources) are
+             * converted faster than the work is handed over to the pool
+             */
+            const qint64 minParallelConversionArea = 4 * KisTileData::WIDTH * KisTileData::HEIGHT;
+
+            if (stripes.size() <= 1 || qint64(rc.width()) * rc.height() < minParallelConversionArea) {
+                Q_FOREACH (const QRect &stripe, stripes) {
+                    convertStripe(stripe);
+                }
+            } else {
+                QtConcurrent::blockingMap(stripes, convertStripe);
             }
         }
 
@@ -704,6 +704,11 @@ void KisPainter::bitBltImpl(qint32 dstX, qint32 dstY,
                 qint32 srcRowStride = srcIt->rowStride(srcX_, srcY_);
                 srcIt->moveTo(srcX_, srcY_);
 
+                if (!useOldSrcData && srcIt->isUniform()) {
+                    // srcRowStride is set to zero to use the compositeOp with only a single color pixel
+                    srcRowStride = 0;
+                }
+
                 qint32 dstRowStride = dstIt->rowStride(dstX_, dstY_);
                 dstIt->moveTo(dstX_, dstY_);
 
@@ -755,6 +760,11 @@ void KisPainter::bitBltImpl(qint32 dstX, qint32 dstY,
                 qint32 srcRowStride = srcIt->rowStride(srcX_, srcY_);
                 srcIt->moveTo(srcX_, srcY_);
 
+                if (!useOldSrcData && srcIt->isUniform()) {
+                    // srcRowStride is set to zero to use the compositeOp with only a single color pixel
+                    srcRowStride = 0;
+                }
+
                 qint32 dstRowStride = dstIt->rowStride(dstX_, dstY_);
                 dstIt->moveTo(dstX_, dstY_);
 
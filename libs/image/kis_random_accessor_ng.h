@@ -19,6 +19,8 @@
 #ifndef _KIS_RANDOM_ACCESSOR_NG_H_
 #define _KIS_RANDOM_ACCESSOR_NG_H_
 
+#include <QRect>
+
 #include "kis_base_accessor.h"
 
 class KRITAIMAGE_EXPORT KisRandomConstAccessorNG : public KisBaseConstAccessor
@@ -31,6 +33,21 @@ public:
     virtual qint32 numContiguousColumns(qint32 x) const = 0;
     virtual qint32 numContiguousRows(qint32 y) const = 0;
     virtual qint32 rowStride(qint32 x, qint32 y) const = 0;
+
+    /**
+     * Notifies the accessor that the pixels in \p rect are going
+     * to be accessed soon, so the swapped out data can be loaded
+     * in the background. The default implementation does nothing.
+     */
+    virtual void prefetch(const QRect &rect) { Q_UNUSED(rect); }
+
+    /**
+     * Returns true if all the pixels in the contiguous area around
+     * the current position (see numContiguousColumns() and
+     * numContiguousRows()) are known to have the same value. The
+     * default implementation returns false.
+     */
+    virtual bool isUniform() const { return false; }
 };
 
 class KRITAIMAGE_EXPORT KisRandomAccessorNG : public KisRandomConstAccessorNG, public KisBaseAccessor
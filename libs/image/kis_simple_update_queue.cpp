@@ -20,10 +20,13 @@
 
 #include <QMutexLocker>
 #include <QVector>
+#include <QtMath>
 
 #include "kis_image_config.h"
 #include "kis_full_refresh_walker.h"
 #include "kis_spontaneous_job.h"
+#include "kis_lod_transform.h"
+#include "tiles3/kis_tile_data.h"
 
 
 //#define ENABLE_DEBUG_JOIN
@@ -54,7 +57,8 @@
 
 
 KisSimpleUpdateQueue::KisSimpleUpdateQueue()
-    : m_overrideLevelOfDetail(-1)
+    : m_threadsLimit(0),
+      m_overrideLevelOfDetail(-1)
 {
     updateSettings();
 }
@@ -77,6 +81,14 @@ void KisSimpleUpdateQueue::updateSettings()
     m_patchWidth = config.updatePatchWidth();
     m_patchHeight = config.updatePatchHeight();
 
+    {
+        QMutexLocker costLocker(&m_costLock);
+        m_adaptivePatchSize = config.adaptiveUpdatePatchSize();
+        m_patchTargetTime = qint64(config.updatePatchTargetTime()) * 1000000;
+        m_minPatchSize = config.minUpdatePatchSize();
+        m_maxPatchSize = qMax(m_minPatchSize, config.maxUpdatePatchSize());
+    }
+
     m_maxCollectAlpha = config.maxCollectAlpha();
     m_maxMergeAlpha = config.maxMergeAlpha();
     m_maxMergeCollectAlpha = config.maxMergeCollectAlpha();
@@ -97,37 +109,91 @@ void KisSimpleUpdateQueue::processQueue(KisUpdaterContext &updaterContext)
     updaterContext.unlock();
 }
 
-bool KisSimpleUpdateQueue::processOneJob(KisUpdaterContext &updaterContext)
+void KisSimpleUpdateQueue::setPriorityRect(const QRect &rc)
 {
     QMutexLocker locker(&m_lock);
+    m_priorityRect = rc;
+}
 
-    KisBaseRectsWalkerSP item;
-    KisMutableWalkersListIterator iter(m_updatesList);
-    bool jobAdded = false;
+QRect KisSimpleUpdateQueue::priorityRect() const
+{
+    QMutexLocker locker(&m_lock);
+    return m_priorityRect;
+}
 
-    int currentLevelOfDetail = updaterContext.currentLevelOfDetail();
+void KisSimpleUpdateQueue::reportJobCost(KisNodeSP node, const QRect &rect, qint64 nsecs)
+{
+    const qint64 area = qint64(rect.width()) * rect.height();
+    if (!node || area <= 0) return;
 
-    while(iter.hasNext()) {
-        item = iter.next();
+    const qreal pixelCost = qreal(nsecs) / area;
 
-        if ((currentLevelOfDetail < 0 || currentLevelOfDetail == item->levelOfDetail()) &&
-            !item->checksumValid()) {
+    QMutexLocker locker(&m_costLock);
 
-            m_overrideLevelOfDetail = item->levelOfDetail();
-            item->recalculate(item->requestedRect());
-            m_overrideLevelOfDetail = -1;
-        }
+    /**
+     * We don't track the removal of the nodes, so just
+     * forget everything when the table grows too big
+     */
+    if (m_pixelCosts.size() > 256) {
+        m_pixelCosts.clear();
+    }
 
-        if ((currentLevelOfDetail < 0 || currentLevelOfDetail == item->levelOfDetail()) &&
-            updaterContext.isJobAllowed(item)) {
+    auto it = m_pixelCosts.find(node.data());
+    if (it == m_pixelCosts.end()) {
+        m_pixelCosts.insert(node.data(), pixelCost);
+    } else {
+        const qreal smoothingFactor = 0.25;
+        *it = (1.0 - smoothingFactor) * *it + smoothingFactor * pixelCost;
+    }
+}
 
-            updaterContext.addMergeJob(item);
-            iter.remove();
-            jobAdded = true;
-            break;
-        }
+void KisSimpleUpdateQueue::setThreadsLimit(int value)
+{
+    QMutexLocker locker(&m_costLock);
+    m_threadsLimit = value;
+}
+
+QSize KisSimpleUpdateQueue::patchSizeForNode(KisNodeSP node, const QRect &rc) const
+{
+    QMutexLocker locker(&m_costLock);
+
+    const qreal pixelCost = m_pixelCosts.value(node.data(), 0.0);
+
+    if (!m_adaptivePatchSize || pixelCost <= 0.0) {
+        return QSize(m_patchWidth, m_patchHeight);
     }
 
+    qreal patchArea = m_patchTargetTime / pixelCost;
+
+    /**
+     * When the whole update is heavy enough, make sure every
+     * thread gets its own patch
+     */
+    const qreal rectArea = qreal(rc.width()) * rc.height();
+    if (m_threadsLimit > 1 && rectArea * pixelCost > m_patchTargetTime) {
+        patchArea = qMin(patchArea, rectArea / m_threadsLimit);
+    }
+
+    // align the patches to the tiles
+    const int alignment = KisTileData::WIDTH;
+    int size = qRound(qSqrt(patchArea) / alignment) * alignment;
+    size = qBound(m_minPatchSize, size, m_maxPatchSize);
+
+    return QSize(size, size);
+}
+
+bool KisSimpleUpdateQueue::processOneJob(KisUpdaterContext &updaterContext)
+{
+    QMutexLocker locker(&m_lock);
+
+    /**
+     * First try the jobs the user is looking at, and only then
+     * the rest of the queue in the usual FIFO order
+     */
+    bool jobAdded =
+        (!m_priorityRect.isEmpty() && tryStartMergeJob(updaterContext, true)) ||
+        tryStartMergeJob(updaterContext, false);
+
     if (jobAdded) return true;
 
     if (!m_spontaneousJobsList.isEmpty()) {
@@ -155,6 +221,47 @@ bool KisSimpleUpdateQueue::processOneJob(KisUpdaterContext &updaterContext)
     return jobAdded;
 }
 
+bool KisSimpleUpdateQueue::tryStartMergeJob(KisUpdaterContext &updaterContext, bool priorityJobsOnly)
+{
+    KisBaseRectsWalkerSP item;
+    KisMutableWalkersListIterator iter(m_updatesList);
+    bool jobAdded = false;
+
+    int currentLevelOfDetail = updaterContext.currentLevelOfDetail();
+
+    while(iter.hasNext()) {
+        item = iter.next();
+
+        if (priorityJobsOnly) {
+            const int lod = item->levelOfDetail();
+            const QRect priorityRect = lod > 0 ?
+                KisLodTransform::scaledRect(KisLodTransform::alignedRect(m_priorityRect, lod), lod) :
+                m_priorityRect;
+
+            if (!priorityRect.intersects(item->requestedRect())) continue;
+        }
+
+        if ((currentLevelOfDetail < 0 || currentLevelOfDetail == item->levelOfDetail()) &&
+            !item->checksumValid()) {
+
+            m_overrideLevelOfDetail = item->levelOfDetail();
+            item->recalculate(item->requestedRect());
+            m_overrideLevelOfDetail = -1;
+        }
+
+        if ((currentLevelOfDetail < 0 || currentLevelOfDetail == item->levelOfDetail()) &&
+            updaterContext.isJobAllowed(item)) {
+
+            updaterContext.addMergeJob(item);
+            iter.remove();
+            jobAdded = true;
+            break;
+        }
+    }
+
+    return jobAdded;
+}
+
 void KisSimpleUpdateQueue::addUpdateJob(KisNodeSP node, const QVector<QRect> &rects, const QRect& cropRect, int levelOfDetail)
 {
     addJob(node, rects, cropRect, levelOfDetail, KisBaseRectsWalker::UPDATE);
@@ -179,7 +286,8 @@ void KisSimpleUpdateQueue::addFullRefreshJob(KisNodeSP node, const QRect& rc, co
 void KisSimpleUpdateQueue::addJob(KisNodeSP node, const QVector<QRect> &rects,
                                   const QRect& cropRect,
                                   int levelOfDetail,
-                                  KisBaseRectsWalker::UpdateType type)
+                                  KisBaseRectsWalker::UpdateType type,
+                                  bool allowSplitting)
 {
     QList<KisBaseRectsWalkerSP> walkers;
 
@@ -188,7 +296,7 @@ void KisSimpleUpdateQueue::addJob(KisNodeSP node, const QVector<QRect> &rects,
 
         KisBaseRectsWalkerSP walker;
 
-        if(trySplitJob(node, rc, cropRect, levelOfDetail, type)) continue;
+        if(allowSplitting && trySplitJob(node, rc, cropRect, levelOfDetail, type)) continue;
         if(tryMergeJob(node, rc, cropRect, levelOfDetail, type)) continue;
 
         if (type == KisBaseRectsWalker::UPDATE) {
@@ -251,30 +359,39 @@ bool KisSimpleUpdateQueue::trySplitJob(KisNodeSP node, const QRect& rc,
                                        int levelOfDetail,
                                        KisBaseRectsWalker::UpdateType type)
 {
-    if(rc.width() <= m_patchWidth || rc.height() <= m_patchHeight)
+    const QSize patchSize = patchSizeForNode(node, rc);
+    const qint32 patchWidth = patchSize.width();
+    const qint32 patchHeight = patchSize.height();
+
+    if(rc.width() <= patchWidth || rc.height() <= patchHeight)
         return false;
 
     // a bit of recursive splitting...
 
-    qint32 firstCol = rc.x() / m_patchWidth;
-    qint32 firstRow = rc.y() / m_patchHeight;
+    qint32 firstCol = rc.x() / patchWidth;
+    qint32 firstRow = rc.y() / patchHeight;
 
-    qint32 lastCol = (rc.x() + rc.width()) / m_patchWidth;
-    qint32 lastRow = (rc.y() + rc.height()) / m_patchHeight;
+    qint32 lastCol = (rc.x() + rc.width()) / patchWidth;
+    qint32 lastRow = (rc.y() + rc.height()) / patchHeight;
 
     QVector<QRect> splitRects;
 
     for(qint32 i = firstRow; i <= lastRow; i++) {
         for(qint32 j = firstCol; j <= lastCol; j++) {
-            QRect maxPatchRect(j * m_patchWidth, i * m_patchHeight,
-                               m_patchWidth, m_patchHeight);
+            QRect maxPatchRect(j * patchWidth, i * patchHeight,
+                               patchWidth, patchHeight);
             QRect patchRect = rc & maxPatchRect;
             splitRects.append(patchRect);
         }
     }
 
     KIS_SAFE_ASSERT_RECOVER_NOOP(!splitRects.isEmpty());
-    addJob(node, splitRects, cropRect, levelOfDetail, type);
+
+    /**
+     * The patch size depends on the size of the update, so the
+     * patches should not be split again
+     */
+    addJob(node, splitRects, cropRect, levelOfDetail, type, false);
 
     return true;
 }
@@ -284,6 +401,8 @@ bool KisSimpleUpdateQueue::tryMergeJob(KisNodeSP node, const QRect& rc,
                                        int levelOfDetail,
                                        KisBaseRectsWalker::UpdateType type)
 {
+    const QSize patchSize = patchSizeForNode(node, rc);
+
     QMutexLocker locker(&m_lock);
 
     QRect baseRect = rc;
@@ -307,7 +426,7 @@ bool KisSimpleUpdateQueue::tryMergeJob(KisNodeSP node, const QRect& rc,
         if(item->cropRect() != cropRect) continue;
         if(item->levelOfDetail() != levelOfDetail) continue;
 
-        if(joinRects(baseRect, item->requestedRect(), m_maxMergeAlpha)) {
+        if(joinRects(baseRect, item->requestedRect(), m_maxMergeAlpha, patchSize)) {
             goodCandidate = item;
             break;
         }
@@ -338,6 +457,8 @@ void KisSimpleUpdateQueue::collectJobs(KisBaseRectsWalkerSP &baseWalker,
     KisBaseRectsWalkerSP item;
     KisMutableWalkersListIterator iter(m_updatesList);
 
+    const QSize patchSize = patchSizeForNode(baseWalker->startNode(), baseRect);
+
     while(iter.hasNext()) {
         item = iter.next();
 
@@ -347,7 +468,7 @@ void KisSimpleUpdateQueue::collectJobs(KisBaseRectsWalkerSP &baseWalker,
         if(item->cropRect() != baseWalker->cropRect()) continue;
         if(item->levelOfDetail() != baseWalker->levelOfDetail()) continue;
 
-        if(joinRects(baseRect, item->requestedRect(), maxAlpha)) {
+        if(joinRects(baseRect, item->requestedRect(), maxAlpha, patchSize)) {
             iter.remove();
         }
     }
@@ -358,10 +479,11 @@ void KisSimpleUpdateQueue::collectJobs(KisBaseRectsWalkerSP &baseWalker,
 }
 
 bool KisSimpleUpdateQueue::joinRects(QRect& baseRect,
-                                     const QRect& newRect, qreal maxAlpha)
+                                     const QRect& newRect, qreal maxAlpha,
+                                     const QSize &patchSize)
 {
     QRect unitedRect = baseRect | newRect;
-    if(unitedRect.width() > m_patchWidth || unitedRect.height() > m_patchHeight)
+    if(unitedRect.width() > patchSize.width() || unitedRect.height() > patchSize.height())
         return false;
 
     bool result = false;
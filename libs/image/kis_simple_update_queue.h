@@ -20,6 +20,8 @@
 #define __KIS_SIMPLE_UPDATE_QUEUE_H
 
 #include <QMutex>
+#include <QHash>
+#include <QSize>
 #include "kis_updater_context.h"
 
 typedef QList<KisBaseRectsWalkerSP> KisWalkersList;
@@ -55,17 +57,45 @@ public:
 
     int overrideLevelOfDetail() const;
 
+    /**
+     * Set the area of the image (in image pixels of LoD 0) the user
+     * is looking at. The jobs intersecting it are started before
+     * all the other jobs in the queue. An empty rect disables
+     * the prioritization.
+     */
+    void setPriorityRect(const QRect &rc);
+    QRect priorityRect() const;
+
+    /**
+     * Reports the time \p nsecs spent on merging \p rect
+     * of the walk started at \p node. The measurements are
+     * used for adapting the size of the update patches.
+     */
+    void reportJobCost(KisNodeSP node, const QRect &rect, qint64 nsecs);
+
+    /**
+     * The number of threads the patches are distributed over
+     */
+    void setThreadsLimit(int value);
+
+    /**
+     * Returns the size of the patches the updates of
+     * \p node in area \p rc are split into
+     */
+    QSize patchSizeForNode(KisNodeSP node, const QRect &rc) const;
+
 protected:
-    void addJob(KisNodeSP node, const QVector<QRect> &rects, const QRect& cropRect, int levelOfDetail, KisBaseRectsWalker::UpdateType type);
+    void addJob(KisNodeSP node, const QVector<QRect> &rects, const QRect& cropRect, int levelOfDetail, KisBaseRectsWalker::UpdateType type, bool allowSplitting = true);
 
     bool processOneJob(KisUpdaterContext &updaterContext);
+    bool tryStartMergeJob(KisUpdaterContext &updaterContext, bool priorityJobsOnly);
 
     bool trySplitJob(KisNodeSP node, const QRect& rc, const QRect& cropRect, int levelOfDetail, KisBaseRectsWalker::UpdateType type);
     bool tryMergeJob(KisNodeSP node, const QRect& rc, const QRect& cropRect, int levelOfDetail, KisBaseRectsWalker::UpdateType type);
 
     void collectJobs(KisBaseRectsWalkerSP &baseWalker, QRect baseRect,
                      const qreal maxAlpha);
-    bool joinRects(QRect& baseRect, const QRect& newRect, qreal maxAlpha);
+    bool joinRects(QRect& baseRect, const QRect& newRect, qreal maxAlpha, const QSize &patchSize);
 
 protected:
 
@@ -86,6 +116,24 @@ protected:
     qint32 m_patchWidth;
     qint32 m_patchHeight;
 
+    /**
+     * Parameters of the adaptive patch size, see
+     * KisImageConfig::adaptiveUpdatePatchSize()
+     */
+    bool m_adaptivePatchSize;
+    qint64 m_patchTargetTime;
+    qint32 m_minPatchSize;
+    qint32 m_maxPatchSize;
+    int m_threadsLimit;
+
+    /**
+     * Moving average of the merge time of a single pixel (in
+     * nanoseconds) for the walks started at each node. The node
+     * is used as a key only, it is never dereferenced.
+     */
+    mutable QMutex m_costLock;
+    QHash<const KisNode*, qreal> m_pixelCosts;
+
     /**
      * Maximum coefficient of work while regular optimization()
      */
@@ -103,6 +151,8 @@ protected:
     qreal m_maxMergeCollectAlpha;
 
     int m_overrideLevelOfDetail;
+
+    QRect m_priorityRect;
 };
 
 class KRITAIMAGE_EXPORT KisTestableSimpleUpdateQueue : public KisSimpleUpdateQueue
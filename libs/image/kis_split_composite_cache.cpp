@@ -0,0 +1,127 @@
+/*
+ *  Copyright (c) 2020 Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_split_composite_cache.h"
+
+#include <atomic>
+
+#include <KoColorSpace.h>
+
+#include "kis_node.h"
+#include "kis_paint_device.h"
+
+namespace {
+std::atomic<bool> s_enabled {false};
+}
+
+KisSplitCompositeCache::KisSplitCompositeCache()
+    : m_generation(0),
+      m_pivot(0),
+      m_levelOfDetail(-1),
+      m_graphSequenceNumber(-1),
+      m_colorSpace(0)
+{
+}
+
+KisSplitCompositeCache::~KisSplitCompositeCache()
+{
+}
+
+bool KisSplitCompositeCache::isEnabled()
+{
+    return s_enabled;
+}
+
+void KisSplitCompositeCache::setEnabled(bool value)
+{
+    s_enabled = value;
+}
+
+KisSplitCompositeCache::State
+KisSplitCompositeCache::fetch(KisNodeSP pivot, int levelOfDetail, const KoColorSpace *colorSpace, const QRect &rc)
+{
+    QMutexLocker l(&m_lock);
+
+    const int graphSequenceNumber = pivot->graphSequenceNumber();
+
+    if (m_pivot != pivot.data() ||
+        m_levelOfDetail != levelOfDetail ||
+        m_graphSequenceNumber != graphSequenceNumber ||
+        !m_colorSpace || !(*m_colorSpace == *colorSpace)) {
+
+        /**
+         * Other threads may still be reading the old devices,
+         * so we create new ones instead of clearing them
+         */
+        m_generation++;
+        m_pivot = pivot.data();
+        m_levelOfDetail = levelOfDetail;
+        m_graphSequenceNumber = graphSequenceNumber;
+        m_colorSpace = colorSpace;
+
+        m_below = new KisPaintDevice(colorSpace);
+        m_above = new KisPaintDevice(colorSpace);
+        m_belowValidRegion = QRegion();
+        m_aboveValidRegion = QRegion();
+    }
+
+    State state;
+    state.generation = m_generation;
+    state.below = m_below;
+    state.above = m_above;
+    /**
+     * QRegion::contains(QRect) only checks whether the rect
+     * overlaps the region, but we need the full coverage
+     */
+    state.belowValid = (QRegion(rc) - m_belowValidRegion).isEmpty();
+    state.aboveValid = (QRegion(rc) - m_aboveValidRegion).isEmpty();
+
+    return state;
+}
+
+void KisSplitCompositeCache::reset()
+{
+    QMutexLocker l(&m_lock);
+
+    if (!m_pivot) return;
+
+    m_generation++;
+    m_pivot = 0;
+    m_below = 0;
+    m_above = 0;
+    m_belowValidRegion = QRegion();
+    m_aboveValidRegion = QRegion();
+}
+
+void KisSplitCompositeCache::markBelowValid(const State &state, const QRect &rc)
+{
+    QMutexLocker l(&m_lock);
+
+    if (state.generation == m_generation) {
+        m_belowValidRegion += rc;
+    }
+}
+
+void KisSplitCompositeCache::markAboveValid(const State &state, const QRect &rc)
+{
+    QMutexLocker l(&m_lock);
+
+    if (state.generation == m_generation) {
+        m_aboveValidRegion += rc;
+    }
+}
@@ -0,0 +1,105 @@
+/*
+ *  Copyright (c) 2020 Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __KIS_SPLIT_COMPOSITE_CACHE_H
+#define __KIS_SPLIT_COMPOSITE_CACHE_H
+
+#include <QMutex>
+#include <QRegion>
+
+#include "kritaimage_export.h"
+#include "kis_types.h"
+
+class KoColorSpace;
+
+
+/**
+ * Caches the composite of the children of a group layer lying below
+ * and above one selected child (the "pivot"), usually the layer the
+ * user is painting on. With the cache, KisAsyncMerger can merge the
+ * group as composite(below, pivot, above) regardless of the number
+ * of its children.
+ *
+ * The cache is bound to a pivot, a level of detail and a graph
+ * sequence number. Any merge passing through the group with another
+ * pivot means the other children have changed, so the cache is
+ * dropped and rebuilt for the new pivot.
+ *
+ * The "above" part is only valid when all the children above the
+ * pivot are composited with COMPOSITE_OVER without any extra flags,
+ * because only this operation is associative.
+ *
+ * The cache is shared by all the updater threads, they work on
+ * non-intersecting rects of it.
+ */
+class KRITAIMAGE_EXPORT KisSplitCompositeCache
+{
+public:
+    struct State {
+        int generation = -1;
+        KisPaintDeviceSP below;
+        KisPaintDeviceSP above;
+        bool belowValid = false;
+        bool aboveValid = false;
+    };
+
+public:
+    KisSplitCompositeCache();
+    ~KisSplitCompositeCache();
+
+    /**
+     * \see KisImageConfig::useSplitCompositeCache()
+     */
+    static bool isEnabled();
+    static void setEnabled(bool value);
+
+    /**
+     * Fetches the cache devices for merging \p rc with \p pivot.
+     * If the cache was built for a different pivot, it is reset.
+     */
+    State fetch(KisNodeSP pivot, int levelOfDetail, const KoColorSpace *colorSpace, const QRect &rc);
+
+    /**
+     * Drops the cache, e.g. when the group is merged without
+     * a single pivot
+     */
+    void reset();
+
+    /**
+     * Marks the area \p rc of the devices as valid. Does nothing if the
+     * cache has been reset since \p state was fetched.
+     */
+    void markBelowValid(const State &state, const QRect &rc);
+    void markAboveValid(const State &state, const QRect &rc);
+
+private:
+    QMutex m_lock;
+
+    int m_generation;
+    KisNode *m_pivot;
+    int m_levelOfDetail;
+    int m_graphSequenceNumber;
+    const KoColorSpace *m_colorSpace;
+
+    KisPaintDeviceSP m_below;
+    KisPaintDeviceSP m_above;
+    QRegion m_belowValidRegion;
+    QRegion m_aboveValidRegion;
+};
+
+#endif /* __KIS_SPLIT_COMPOSITE_CACHE_H */
@@ -19,6 +19,7 @@
 #include "kis_stroke.h"
 
 #include "kis_stroke_strategy.h"
+#include "kis_node.h"
 
 
 KisStroke::KisStroke(KisStrokeStrategy *strokeStrategy, Type type, int levelOfDetail)
@@ -107,7 +108,7 @@ void KisStroke::addMutatedJobs(const QVector<KisStrokeJobData *> list)
 
 
     Q_FOREACH (KisStrokeJobData *data, list) {
-        it = m_jobsQueue.insert(it, new KisStrokeJob(m_dabStrategy.data(), data, worksOnLevelOfDetail(), true));
+        it = m_jobsQueue.insert(it, new KisStrokeJob(m_dabStrategy.data(), data, worksOnLevelOfDetail(), true, this));
         ++it;
     }
 }
@@ -272,6 +273,16 @@ qreal KisStroke::balancingRatioOverride() const
     return m_strokeStrategy->balancingRatioOverride();
 }
 
+KisNodeList KisStroke::modifiedNodes() const
+{
+    return m_strokeStrategy->modifiedNodes();
+}
+
+KisNodeList KisStroke::readNodes() const
+{
+    return m_strokeStrategy->readNodes();
+}
+
 KisStrokeJobData::Sequentiality KisStroke::nextJobSequentiality() const
 {
     return !m_jobsQueue.isEmpty() ?
@@ -287,7 +298,7 @@ void KisStroke::enqueue(KisStrokeJobStrategy *strategy,
         return;
     }
 
-    m_jobsQueue.enqueue(new KisStrokeJob(strategy, data, worksOnLevelOfDetail(), true));
+    m_jobsQueue.enqueue(new KisStrokeJob(strategy, data, worksOnLevelOfDetail(), true, this));
 }
 
 void KisStroke::prepend(KisStrokeJobStrategy *strategy,
@@ -304,7 +315,7 @@ void KisStroke::prepend(KisStrokeJobStrategy *strategy,
     // LOG_MERGE_FIXME:
     Q_UNUSED(levelOfDetail);
 
-    m_jobsQueue.prepend(new KisStrokeJob(strategy, data, worksOnLevelOfDetail(), isOwnJob));
+    m_jobsQueue.prepend(new KisStrokeJob(strategy, data, worksOnLevelOfDetail(), isOwnJob, this));
 }
 
 KisStrokeJob* KisStroke::dequeue()
@@ -71,6 +71,12 @@ public:
     bool canForgetAboutMe() const;
     qreal balancingRatioOverride() const;
 
+    /**
+     * \see KisStrokeStrategy::setAccessedNodes()
+     */
+    KisNodeList modifiedNodes() const;
+    KisNodeList readNodes() const;
+
     KisStrokeJobData::Sequentiality nextJobSequentiality() const;
 
     void setLodBuddy(KisStrokeSP buddy);
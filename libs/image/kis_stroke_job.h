@@ -22,17 +22,21 @@
 #include "kis_runnable_with_debug_name.h"
 #include "kis_stroke_job_strategy.h"
 
+class KisStroke;
+
 class KisStrokeJob : public KisRunnableWithDebugName
 {
 public:
     KisStrokeJob(KisStrokeJobStrategy *strategy,
                  KisStrokeJobData *data,
                  int levelOfDetail,
-                 bool isOwnJob)
+                 bool isOwnJob,
+                 const KisStroke *stroke = 0)
         : m_dabStrategy(strategy),
           m_dabData(data),
           m_levelOfDetail(levelOfDetail),
-          m_isOwnJob(isOwnJob)
+          m_isOwnJob(isOwnJob),
+          m_stroke(stroke)
     {
     }
 
@@ -76,6 +80,14 @@ public:
         return m_isOwnJob;
     }
 
+    /**
+     * The stroke the job belongs to. It is used for identification
+     * only and must not be dereferenced.
+     */
+    const KisStroke* stroke() const {
+        return m_stroke;
+    }
+
     QString debugName() const override {
         return m_dabStrategy->debugId();
     }
@@ -103,6 +115,7 @@ private:
 
     int m_levelOfDetail;
     bool m_isOwnJob;
+    const KisStroke *m_stroke;
 };
 
 #endif /* __KIS_STROKE_JOB_H */
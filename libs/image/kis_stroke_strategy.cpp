@@ -20,6 +20,7 @@
 #include <KoCompositeOpRegistry.h>
 #include "kis_stroke_job_strategy.h"
 #include "KisStrokesQueueMutatedJobInterface.h"
+#include "kis_node.h"
 
 
 KisStrokeStrategy::KisStrokeStrategy(const QLatin1String &id, const KUndo2MagicString &name)
@@ -44,6 +45,8 @@ KisStrokeStrategy::KisStrokeStrategy(const KisStrokeStrategy &rhs)
       m_canForgetAboutMe(rhs.m_canForgetAboutMe),
       m_needsExplicitCancel(rhs.m_needsExplicitCancel),
       m_balancingRatioOverride(rhs.m_balancingRatioOverride),
+      m_modifiedNodes(rhs.m_modifiedNodes),
+      m_readNodes(rhs.m_readNodes),
       m_id(rhs.m_id),
       m_name(rhs.m_name),
       m_mutatedJobsInterface(0)
@@ -225,3 +228,19 @@ void KisStrokeStrategy::setBalancingRatioOverride(qreal value)
 {
     m_balancingRatioOverride = value;
 }
+
+KisNodeList KisStrokeStrategy::modifiedNodes() const
+{
+    return m_modifiedNodes;
+}
+
+KisNodeList KisStrokeStrategy::readNodes() const
+{
+    return m_readNodes;
+}
+
+void KisStrokeStrategy::setAccessedNodes(const KisNodeList &modifiedNodes, const KisNodeList &readNodes)
+{
+    m_modifiedNodes = modifiedNodes;
+    m_readNodes = readNodes;
+}
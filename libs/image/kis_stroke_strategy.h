@@ -109,6 +109,12 @@ public:
      */
     qreal balancingRatioOverride() const;
 
+    /**
+     * \see setAccessedNodes() for details
+     */
+    KisNodeList modifiedNodes() const;
+    KisNodeList readNodes() const;
+
     QString id() const;
     KUndo2MagicString name() const;
 
@@ -168,6 +174,20 @@ protected:
      */
     void setBalancingRatioOverride(qreal value);
 
+    /**
+     * Declares the nodes the stroke changes and the nodes it only
+     * reads (e.g. the node of the active selection). If two successive
+     * strokes declare their nodes and neither of them changes a node
+     * (or a parent or a child of a node) the other one accesses, the
+     * second stroke is allowed to start its initialization while the
+     * first one is still being finished.
+     *
+     * The stroke that doesn't declare any nodes (default) is considered
+     * to access the whole image.
+     */
+    void setAccessedNodes(const KisNodeList &modifiedNodes,
+                          const KisNodeList &readNodes = KisNodeList());
+
 protected:
     /**
      * Protected c-tor, used for cloning of hi-level strategies
@@ -184,6 +204,9 @@ private:
     bool m_needsExplicitCancel;
     qreal m_balancingRatioOverride;
 
+    KisNodeList m_modifiedNodes;
+    KisNodeList m_readNodes;
+
     QLatin1String m_id;
     KUndo2MagicString m_name;
 
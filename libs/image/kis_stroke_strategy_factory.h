@@ -23,7 +23,13 @@
 using KisStrokeStrategyFactory = std::function<KisStrokeStrategy*()>;
 
 using KisLodSyncPair = std::pair<KisStrokeStrategy*, QList<KisStrokeJobData*>>;
-using KisLodSyncStrokeStrategyFactory = std::function<KisLodSyncPair(bool /*forgettable*/)>;
+/**
+ * The factory gets the level of detail to synchronize and the level its
+ * data can be generated from: zero means the original data, a level equal
+ * to the requested one means that the level's caches are still valid
+ * and only the nodes' own caches need to be synchronized.
+ */
+using KisLodSyncStrokeStrategyFactory = std::function<KisLodSyncPair(bool /*forgettable*/, int /*levelOfDetail*/, int /*sourceLevelOfDetail*/)>;
 
 using KisSuspendResumePair = std::pair<KisStrokeStrategy*, QList<KisStrokeJobData*>>;
 using KisSuspendResumeStrategyFactory = std::function<KisSuspendResumePair()>;
@@ -20,6 +20,7 @@
 
 #include <QQueue>
 #include <QMutex>
+#include <QSet>
 #include <QMutexLocker>
 #include "kis_stroke.h"
 #include "kis_updater_context.h"
@@ -27,6 +28,7 @@
 #include "kis_stroke_strategy.h"
 #include "kis_undo_stores.h"
 #include "kis_post_execution_undo_adapter.h"
+#include "kis_node.h"
 
 typedef QQueue<KisStrokeSP> StrokesQueue;
 typedef QQueue<KisStrokeSP>::iterator StrokesQueueIterator;
@@ -78,6 +80,7 @@ struct Q_DECL_HIDDEN KisStrokesQueue::Private {
           wrapAroundModeSupported(false),
           balancingRatioOverride(-1.0),
           currentStrokeLoaded(false),
+          pipelinedStrokesEnabled(true),
           lodNNeedsSynchronization(true),
           desiredLevelOfDetail(0),
           nextDesiredLevelOfDetail(0),
@@ -92,7 +95,22 @@ struct Q_DECL_HIDDEN KisStrokesQueue::Private {
     qreal balancingRatioOverride;
     bool currentStrokeLoaded;
 
+    bool pipelinedStrokesEnabled;
+
+    /**
+     * The stroke following the head of the queue that has been
+     * started while the head stroke is being finished
+     */
+    KisStrokeSP pipelinedStroke;
+
     bool lodNNeedsSynchronization;
+
+    /**
+     * The levels of detail whose caches are still consistent with
+     * the original data of the image
+     */
+    QSet<int> syncedLevels;
+
     int desiredLevelOfDetail;
     int nextDesiredLevelOfDetail;
     QMutex mutex;
@@ -104,6 +122,8 @@ struct Q_DECL_HIDDEN KisStrokesQueue::Private {
 
     void cancelForgettableStrokes();
     void startLod0ToNStroke(int levelOfDetail, bool forgettable);
+    int sourceLevelOfDetail(int levelOfDetail) const;
+    void invalidateLodCaches();
 
     bool canUseLodN() const;
     StrokesQueueIterator findNewLod0Pos();
@@ -112,6 +132,7 @@ struct Q_DECL_HIDDEN KisStrokesQueue::Private {
 
     void switchDesiredLevelOfDetail(bool forced);
     bool hasUnfinishedStrokes() const;
+    bool canStartPipelinedStroke(KisStrokeSP finishingStroke, KisStrokeSP nextStroke) const;
     void tryClearUndoOnStrokeCompletion(KisStrokeSP finishingStroke);
 };
 
@@ -155,10 +176,103 @@ void KisStrokesQueue::Private::startLod0ToNStroke(int levelOfDetail, bool forget
 
     if (!this->lod0ToNStrokeStrategyFactory) return;
 
-    KisLodSyncPair syncPair = this->lod0ToNStrokeStrategyFactory(forgettable);
+    /**
+     * Forgettable strokes are explicit requests for regeneration of
+     * the current level, so they always start from the original data
+     */
+    const int sourceLevel = forgettable ? 0 : sourceLevelOfDetail(levelOfDetail);
+
+    KisLodSyncPair syncPair = this->lod0ToNStrokeStrategyFactory(forgettable, levelOfDetail, sourceLevel);
     executeStrokePair(syncPair, this->strokesQueue, this->strokesQueue.end(),  KisStroke::LODN, levelOfDetail, q);
 
     this->lodNNeedsSynchronization = false;
+    this->syncedLevels.insert(levelOfDetail);
+}
+
+int KisStrokesQueue::Private::sourceLevelOfDetail(int levelOfDetail) const
+{
+    // precondition: lock held!
+
+    if (syncedLevels.contains(levelOfDetail)) {
+        return levelOfDetail;
+    }
+
+    int result = 0;
+
+    Q_FOREACH (int level, syncedLevels) {
+        if (level < levelOfDetail && level > result) {
+            result = level;
+        }
+    }
+
+    return result;
+}
+
+void KisStrokesQueue::Private::invalidateLodCaches()
+{
+    // precondition: lock held!
+
+    lodNNeedsSynchronization = true;
+    syncedLevels.clear();
+}
+
+namespace {
+
+bool nodesAreRelated(KisNodeSP lhs, KisNodeSP rhs)
+{
+    for (KisNodeSP node = lhs; node; node = node->parent()) {
+        if (node == rhs) return true;
+    }
+
+    for (KisNodeSP node = rhs->parent(); node; node = node->parent()) {
+        if (node == lhs) return true;
+    }
+
+    return false;
+}
+
+bool accessesConflict(const KisNodeList &modifiedNodes, const KisNodeList &accessedNodes)
+{
+    Q_FOREACH (KisNodeSP modified, modifiedNodes) {
+        Q_FOREACH (KisNodeSP accessed, accessedNodes) {
+            if (nodesAreRelated(modified, accessed)) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+bool strokesConflict(KisStrokeSP lhs, KisStrokeSP rhs)
+{
+    const KisNodeList lhsModified = lhs->modifiedNodes();
+    const KisNodeList rhsModified = rhs->modifiedNodes();
+
+    // the strokes with no nodes declared may touch anything
+    if (lhsModified.isEmpty() || rhsModified.isEmpty()) return true;
+
+    return accessesConflict(lhsModified, rhsModified + rhs->readNodes()) ||
+        accessesConflict(rhsModified, lhs->readNodes());
+}
+
+}
+
+bool KisStrokesQueue::Private::canStartPipelinedStroke(KisStrokeSP finishingStroke, KisStrokeSP nextStroke) const
+{
+    /**
+     * The LoD strokes are not pipelined, because their order
+     * in the queue is managed separately
+     */
+    return pipelinedStrokesEnabled &&
+        finishingStroke->isEnded() && !finishingStroke->hasJobs() &&
+        finishingStroke->type() == KisStroke::LEGACY &&
+        nextStroke->type() == KisStroke::LEGACY &&
+        !needsExclusiveAccess &&
+        !finishingStroke->isExclusive() && !nextStroke->isExclusive() &&
+        finishingStroke->worksOnLevelOfDetail() == nextStroke->worksOnLevelOfDetail() &&
+        finishingStroke->supportsWrapAroundMode() == nextStroke->supportsWrapAroundMode() &&
+        !strokesConflict(finishingStroke, nextStroke);
 }
 
 void KisStrokesQueue::Private::cancelForgettableStrokes()
@@ -283,6 +397,13 @@ KisStrokeId KisStrokesQueue::startStroke(KisStrokeStrategy *strokeStrategy)
         stroke->setLodBuddy(buddy);
         m_d->strokesQueue.insert(m_d->findNewLodNPos(buddy), buddy);
 
+        /**
+         * The stroke changes the original data and the cache of
+         * the current level only, the other levels get outdated
+         */
+        m_d->syncedLevels.clear();
+        m_d->syncedLevels.insert(m_d->desiredLevelOfDetail);
+
         if (m_d->shouldWrapInSuspendUpdatesStroke()) {
 
             KisSuspendResumePair suspendPair;
@@ -310,7 +431,7 @@ KisStrokeId KisStrokesQueue::startStroke(KisStrokeStrategy *strokeStrategy)
     m_d->openedStrokesCounter++;
 
     if (stroke->type() == KisStroke::LEGACY) {
-        m_d->lodNNeedsSynchronization = true;
+        m_d->invalidateLodCaches();
     }
 
     return id;
@@ -416,7 +537,7 @@ bool KisStrokesQueue::tryCancelCurrentStrokeAsync()
                  * it doesn't store any undo data. Therefore we just regenerate
                  * the LOD caches.
                  */
-                m_d->lodNNeedsSynchronization = true;
+                m_d->invalidateLodCaches();
             }
 
         }
@@ -596,6 +717,12 @@ void KisStrokesQueue::explicitRegenerateLevelOfDetail()
     m_d->switchDesiredLevelOfDetail(true);
 }
 
+void KisStrokesQueue::setPipelinedStrokesEnabled(bool value)
+{
+    QMutexLocker locker(&m_d->mutex);
+    m_d->pipelinedStrokesEnabled = value;
+}
+
 void KisStrokesQueue::setDesiredLevelOfDetail(int lod)
 {
     QMutexLocker locker(&m_d->mutex);
@@ -610,7 +737,7 @@ void KisStrokesQueue::notifyUFOChangedImage()
 {
     QMutexLocker locker(&m_d->mutex);
 
-    m_d->lodNNeedsSynchronization = true;
+    m_d->invalidateLodCaches();
 }
 
 void KisStrokesQueue::debugDumpAllStrokes()
@@ -661,7 +788,13 @@ bool KisStrokesQueue::processOneJob(KisUpdaterContext &updaterContext,
 
     const int levelOfDetail = updaterContext.currentLevelOfDetail();
 
-    const KisUpdaterContextSnapshotEx snapshot = updaterContext.getContextSnapshotEx();
+    KisStrokeSP head = m_d->strokesQueue.head();
+
+    /**
+     * The jobs of the pipelined stroke do not restrict
+     * the jobs of the head stroke
+     */
+    const KisUpdaterContextSnapshotEx snapshot = updaterContext.getContextSnapshotEx(head.data());
 
     const bool hasStrokeJobs = !(snapshot == ContextEmpty ||
                                  snapshot == HasMergeJob);
@@ -669,16 +802,59 @@ bool KisStrokesQueue::processOneJob(KisUpdaterContext &updaterContext,
 
     if(checkStrokeState(hasStrokeJobs, levelOfDetail) &&
        checkExclusiveProperty(hasMergeJobs, hasStrokeJobs) &&
-       checkSequentialProperty(snapshot, externalJobsPending)) {
+       checkSequentialProperty(m_d->strokesQueue.head(), snapshot, externalJobsPending)) {
 
         KisStrokeSP stroke = m_d->strokesQueue.head();
         updaterContext.addStrokeJob(stroke->popOneJob());
         result = true;
+    } else if (!m_d->strokesQueue.isEmpty() &&
+               m_d->strokesQueue.head() != head) {
+
+        /**
+         * The head stroke has been completed and replaced with
+         * the pipelined one, whose jobs may still be running
+         */
+        result = processOneJob(updaterContext, externalJobsPending);
+    } else if (!m_d->strokesQueue.isEmpty()) {
+        result = processPipelinedJob(updaterContext, externalJobsPending);
     }
 
     return result;
 }
 
+bool KisStrokesQueue::processPipelinedJob(KisUpdaterContext &updaterContext,
+                                          bool externalJobsPending)
+{
+    if (m_d->strokesQueue.size() < 2) return false;
+
+    KisStrokeSP head = m_d->strokesQueue.head();
+    KisStrokeSP next = m_d->strokesQueue[1];
+
+    if (m_d->pipelinedStroke) {
+        KIS_SAFE_ASSERT_RECOVER_RETURN_VALUE(m_d->pipelinedStroke == next, false);
+    } else if (m_d->canStartPipelinedStroke(head, next)) {
+        m_d->pipelinedStroke = next;
+    } else {
+        return false;
+    }
+
+    if (!next->hasJobs()) return false;
+
+    /**
+     * The last job of the ended stroke is its finishing (or
+     * cancelling) job. It is postponed until the previous stroke
+     * is completed to keep the order of the undo commands.
+     */
+    if (next->isEnded() && next->numJobs() <= 1) return false;
+
+    const KisUpdaterContextSnapshotEx snapshot = updaterContext.getContextSnapshotEx(next.data());
+
+    if (!checkSequentialProperty(next, snapshot, externalJobsPending)) return false;
+
+    updaterContext.addStrokeJob(next->popOneJob());
+    return true;
+}
+
 bool KisStrokesQueue::checkStrokeState(bool hasStrokeJobsRunning,
                                        int runningLevelOfDetail)
 {
@@ -739,6 +915,25 @@ bool KisStrokesQueue::checkStrokeState(bool hasStrokeJobsRunning,
         m_d->balancingRatioOverride = -1.0;
         m_d->currentStrokeLoaded = false;
 
+        if (m_d->pipelinedStroke) {
+            KIS_SAFE_ASSERT_RECOVER_NOOP(!m_d->strokesQueue.isEmpty() &&
+                                         m_d->strokesQueue.head() == m_d->pipelinedStroke);
+            m_d->pipelinedStroke.clear();
+
+            /**
+             * The sync stroke of a pending LoD switch is appended
+             * to the end of the queue, so it is safe to start it
+             * while the pipelined stroke is running
+             */
+            m_d->switchDesiredLevelOfDetail(false);
+
+            /**
+             * The new head stroke may have running jobs, so the
+             * caller should fetch a new snapshot of the context
+             */
+            return false;
+        }
+
         m_d->switchDesiredLevelOfDetail(false);
 
         if(!m_d->strokesQueue.isEmpty()) {
@@ -758,11 +953,10 @@ bool KisStrokesQueue::checkExclusiveProperty(bool hasMergeJobs,
     return hasMergeJobs == 0;
 }
 
-bool KisStrokesQueue::checkSequentialProperty(KisUpdaterContextSnapshotEx snapshot,
+bool KisStrokesQueue::checkSequentialProperty(KisStrokeSP stroke,
+                                              KisUpdaterContextSnapshotEx snapshot,
                                               bool externalJobsPending)
 {
-    KisStrokeSP stroke = m_d->strokesQueue.head();
-
     if (snapshot & HasSequentialJob ||
         snapshot & HasBarrierJob) {
         return false;
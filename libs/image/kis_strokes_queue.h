@@ -65,6 +65,15 @@ public:
     bool wrapAroundModeSupported() const;
     qreal balancingRatioOverride() const;
 
+    /**
+     * If enabled, the stroke may start its initialization while the
+     * previous one is being finished, if both strokes have declared
+     * the nodes they access and the nodes do not overlap.
+     *
+     * \see KisStrokeStrategy::setAccessedNodes()
+     */
+    void setPipelinedStrokesEnabled(bool value);
+
     void setDesiredLevelOfDetail(int lod);
     void explicitRegenerateLevelOfDetail();
     void setLod0ToNStrokeStrategyFactory(const KisLodSyncStrokeStrategyFactory &factory);
@@ -86,10 +95,12 @@ public:
 private:
     bool processOneJob(KisUpdaterContext &updaterContext,
                        bool externalJobsPending);
+    bool processPipelinedJob(KisUpdaterContext &updaterContext,
+                             bool externalJobsPending);
     bool checkStrokeState(bool hasStrokeJobsRunning,
                           int runningLevelOfDetail);
     bool checkExclusiveProperty(bool hasMergeJobs, bool hasStrokeJobs);
-    bool checkSequentialProperty(KisUpdaterContextSnapshotEx snapshot, bool externalJobsPending);
+    bool checkSequentialProperty(KisStrokeSP stroke, KisUpdaterContextSnapshotEx snapshot, bool externalJobsPending);
     bool checkBarrierProperty(bool hasMergeJobs, bool hasStrokeJobs,
                               bool externalJobsPending);
     bool checkLevelOfDetailProperty(int runningLevelOfDetail);
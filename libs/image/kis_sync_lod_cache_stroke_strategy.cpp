@@ -22,6 +22,8 @@
 #include <kundo2magicstring.h>
 #include "krita_utils.h"
 #include "kis_layer_utils.h"
+#include "kis_node.h"
+#include "kis_update_time_monitor.h"
 
 
 struct KisSyncLodCacheStrokeStrategy::Private
@@ -36,12 +38,14 @@ struct KisSyncLodCacheStrokeStrategy::Private
 
     class InitData : public KisStrokeJobData {
     public:
-        InitData(KisPaintDeviceSP _device)
-            : KisStrokeJobData(SEQUENTIAL),
-              device(_device)
+        InitData(const KisPaintDeviceList &_devices, int _sourceLevelOfDetail)
+            : KisStrokeJobData(BARRIER),
+              devices(_devices),
+              sourceLevelOfDetail(_sourceLevelOfDetail)
             {}
 
-        KisPaintDeviceSP device;
+        KisPaintDeviceList devices;
+        int sourceLevelOfDetail;
     };
 
     class ProcessData : public KisStrokeJobData {
@@ -90,29 +94,80 @@ KisSyncLodCacheStrokeStrategy::~KisSyncLodCacheStrokeStrategy()
 {
 }
 
+namespace {
+QString deviceNodeName(KisPaintDeviceSP device)
+{
+    KisNodeSP node = device->parentNode();
+    return node ? node->name() : QString();
+}
+}
+
 void KisSyncLodCacheStrokeStrategy::doStrokeCallback(KisStrokeJobData *data)
 {
     Private::InitData *initData = dynamic_cast<Private::InitData*>(data);
     Private::ProcessData *processData = dynamic_cast<Private::ProcessData*>(data);
     Private::AdditionalProcessNode *additionalProcessNode = dynamic_cast<Private::AdditionalProcessNode*>(data);
 
+    KisUpdateTimeMonitor::TraceScope trace(KisUpdateTimeMonitor::LodSync);
+
     if (initData) {
-        KisPaintDeviceSP dev = initData->device;
-        const int lod = dev->defaultBounds()->currentLevelOfDetail();
-        m_d->dataObjects.insert(dev, dev->createLodDataStruct(lod));
+        if (trace.isActive()) {
+            trace.setDetails("Init LoD data");
+        }
+
+        /**
+         * All the devices are initialized in a single barrier job, so
+         * the resampling jobs of all of them can run concurrently
+         * instead of waiting for each other device by device
+         */
+        QVector<KisStrokeJobData*> jobs;
+
+        Q_FOREACH (KisPaintDeviceSP dev, initData->devices) {
+            const int lod = dev->defaultBounds()->currentLevelOfDetail();
+            KisPaintDevice::LodDataStruct *data = dev->createLodDataStruct(lod, initData->sourceLevelOfDetail);
+            m_d->dataObjects.insert(dev, data);
+
+            /**
+             * The region is fetched only when all the updates are
+             * finished, so only the really changed areas are resampled
+             * if the device has already been synchronized before
+             */
+            const KisRegion region = dev->regionForLodSyncing(data);
+            const QVector<QRect> rects =
+                KritaUtils::splitRegionIntoPatches(region, KritaUtils::optimalPatchSize());
+
+            Q_FOREACH (const QRect &rc, rects) {
+                jobs << new Private::ProcessData(dev, rc);
+            }
+        }
+
+        addMutatedJobs(jobs);
     } else if (processData) {
         KisPaintDeviceSP dev = processData->device;
         KIS_ASSERT(m_d->dataObjects.contains(dev));
 
+        if (trace.isActive()) {
+            trace.setDetails("Update LoD data", deviceNodeName(dev), processData->rect);
+        }
+
         KisPaintDevice::LodDataStruct *data = m_d->dataObjects.value(dev);
         dev->updateLodDataStruct(data, processData->rect);
     } else if (additionalProcessNode) {
+        if (trace.isActive()) {
+            trace.setDetails("Sync node LoD cache", additionalProcessNode->node->name());
+        }
+
         additionalProcessNode->node->syncLodCache();
     }
 }
 
 void KisSyncLodCacheStrokeStrategy::finishStrokeCallback()
 {
+    KisUpdateTimeMonitor::TraceScope trace(KisUpdateTimeMonitor::LodSync);
+    if (trace.isActive()) {
+        trace.setDetails("Upload LoD data");
+    }
+
     auto it = m_d->dataObjects.begin();
     auto end = m_d->dataObjects.end();
 
@@ -131,11 +186,11 @@ void KisSyncLodCacheStrokeStrategy::cancelStrokeCallback()
     m_d->dataObjects.clear();
 }
 
-QList<KisStrokeJobData*> KisSyncLodCacheStrokeStrategy::createJobsData(KisImageWSP _image)
+QList<KisStrokeJobData*> KisSyncLodCacheStrokeStrategy::createJobsData(KisImageWSP _image,
+                                                                       int levelOfDetail,
+                                                                       int sourceLevelOfDetail)
 {
     using KisLayerUtils::recursiveApplyNodes;
-    using KritaUtils::splitRegionIntoPatches;
-    using KritaUtils::optimalPatchSize;
 
     KisImageSP image = _image;
 
@@ -149,17 +204,28 @@ QList<KisStrokeJobData*> KisSyncLodCacheStrokeStrategy::createJobsData(KisImageW
 
     KritaUtils::makeContainerUnique(deviceList);
 
-    Q_FOREACH (KisPaintDeviceSP device, deviceList) {
-        jobsData << new Private::InitData(device);
-    }
+    if (sourceLevelOfDetail >= levelOfDetail) {
+        KIS_SAFE_ASSERT_RECOVER_NOOP(sourceLevelOfDetail == levelOfDetail);
 
-    Q_FOREACH (KisPaintDeviceSP device, deviceList) {
-        KisRegion region = device->regionForLodSyncing();
-        QVector<QRect> rects = splitRegionIntoPatches(region, optimalPatchSize());
+        /**
+         * The caches of the level are still valid, so we should
+         * generate the data only for the devices that have been
+         * created after the level was synchronized
+         */
+        KisPaintDeviceList missingDevices;
 
-        Q_FOREACH (const QRect &rc, rects) {
-            jobsData << new Private::ProcessData(device, rc);
+        Q_FOREACH (KisPaintDeviceSP device, deviceList) {
+            if (!device->hasLodData(levelOfDetail)) {
+                missingDevices << device;
+            }
         }
+
+        deviceList = missingDevices;
+        sourceLevelOfDetail = 0;
+    }
+
+    if (!deviceList.isEmpty()) {
+        jobsData << new Private::InitData(deviceList, sourceLevelOfDetail);
     }
 
     recursiveApplyNodes(image->root(),
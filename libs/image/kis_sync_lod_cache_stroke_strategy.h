@@ -29,7 +29,16 @@ public:
     KisSyncLodCacheStrokeStrategy(KisImageWSP image, bool forgettable);
     ~KisSyncLodCacheStrokeStrategy() override;
 
-    static QList<KisStrokeJobData*> createJobsData(KisImageWSP image);
+    /**
+     * Creates the jobs for synchronizing the caches of \p levelOfDetail.
+     * The paint devices are downsampled from their caches of
+     * \p sourceLevelOfDetail if it is non-zero. If the source level is
+     * equal to the requested one, the devices that already have the
+     * data of the level are not touched at all.
+     */
+    static QList<KisStrokeJobData*> createJobsData(KisImageWSP image,
+                                                   int levelOfDetail,
+                                                   int sourceLevelOfDetail = 0);
 
 private:
     void doStrokeCallback(KisStrokeJobData *data) override;
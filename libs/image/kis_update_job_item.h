@@ -23,16 +23,29 @@
 
 #include <QRunnable>
 #include <QReadWriteLock>
+#include <QMutex>
+#include <QSemaphore>
+#include <QElapsedTimer>
 
 #include "kis_stroke_job.h"
 #include "kis_spontaneous_job.h"
 #include "kis_base_rects_walker.h"
 #include "kis_async_merger.h"
 #include "kis_updater_context.h"
+#include "kis_update_time_monitor.h"
 
 //#define DEBUG_JOBS_SEQUENCE
 
 
+/**
+ * A part of a split merge job. When done, the thread
+ * that executed it releases \p doneSemaphore
+ */
+struct KisMergeSubtask {
+    KisBaseRectsWalkerSP walker;
+    QSemaphore *doneSemaphore;
+};
+
 class KisUpdateJobItem :  public QObject, public QRunnable
 {
     Q_OBJECT
@@ -40,6 +53,7 @@ public:
     enum class Type : int {
         EMPTY = 0,
         WAITING,
+        STEALING,
         MERGE,
         STROKE,
         SPONTANEOUS
@@ -58,7 +72,7 @@ public:
     }
 
     void run() override {
-        if (!isRunning()) return;
+        if (m_atomicType == Type::EMPTY) return;
 
         /**
          * Here we break the idea of QThreadPool a bit. Ideally, we should split the
@@ -71,46 +85,34 @@ public:
          * To overcome this problem we try to bulk-process the jobs. In sigJobFinished()
          * signal (which is DirectConnection), the context may add the job to ourselves(!!!),
          * so we switch from "done" state into "running" again.
+         *
+         * When we have no job of our own, we steal the subtasks of the merge
+         * jobs running in other threads (see runMergeJob()). The item is
+         * started in WAITING state in such a case and switches into STEALING
+         * state while executing a subtask, so the context doesn't hand
+         * us any job until the subtask is finished.
          */
 
-        while (1) {
-            KIS_SAFE_ASSERT_RECOVER_RETURN(isRunning());
+        bool hasBeenStealing = false;
 
-            if(m_exclusive) {
-                m_updaterContext->m_exclusiveJobLock.lockForWrite();
-            } else {
-                m_updaterContext->m_exclusiveJobLock.lockForRead();
+        while (1) {
+            if (isRunning()) {
+                runCurrentJob();
+                continue;
             }
 
-            if(m_atomicType == Type::MERGE) {
-                runMergeJob();
-            } else {
-                KIS_ASSERT(m_atomicType == Type::STROKE ||
-                           m_atomicType == Type::SPONTANEOUS);
-
-                if (m_runnableJob) {
-#ifdef DEBUG_JOBS_SEQUENCE
-                    if (m_atomicType == Type::STROKE) {
-                        qDebug() << "running: stroke" << m_runnableJob->debugName();
-                    } else if (m_atomicType == Type::SPONTANEOUS) {
-                        qDebug() << "running: spont " << m_runnableJob->debugName();
-                    } else {
-                        qDebug() << "running: unkn. " << m_runnableJob->debugName();
-                    }
-#endif
-
-                    m_runnableJob->run();
-                }
+            if (stealAndRunSubtask()) {
+                hasBeenStealing = true;
+                continue;
             }
 
-            setDone();
-
-            m_updaterContext->doSomeUsefulWork();
-
-            // may flip the current state from Waiting -> Running again
-            m_updaterContext->jobFinished();
-
-            m_updaterContext->m_exclusiveJobLock.unlock();
+            // the scheduler could find no spare thread while we were
+            // stealing, so tell it that we are free now
+            if (hasBeenStealing) {
+                hasBeenStealing = false;
+                m_updaterContext->stealingFinished();
+                continue;
+            }
 
             // try to exit the loop. Please note, that no one can flip the state from
             // WAITING to EMPTY except ourselves!
@@ -121,6 +123,53 @@ public:
         }
     }
 
+    inline void runCurrentJob() {
+        if(m_exclusive) {
+            m_updaterContext->m_exclusiveJobLock.lockForWrite();
+        } else {
+            m_updaterContext->m_exclusiveJobLock.lockForRead();
+        }
+
+        if(m_atomicType == Type::MERGE) {
+            runMergeJob();
+        } else {
+            KIS_ASSERT(m_atomicType == Type::STROKE ||
+                       m_atomicType == Type::SPONTANEOUS);
+
+            if (m_runnableJob) {
+                KisUpdateTimeMonitor::TraceScope trace(
+                    m_atomicType == Type::STROKE ?
+                        KisUpdateTimeMonitor::StrokeJob :
+                        KisUpdateTimeMonitor::SpontaneousJob);
+
+                if (trace.isActive()) {
+                    trace.setDetails(m_runnableJob->debugName());
+                }
+
+#ifdef DEBUG_JOBS_SEQUENCE
+                if (m_atomicType == Type::STROKE) {
+                    qDebug() << "running: stroke" << m_runnableJob->debugName();
+                } else if (m_atomicType == Type::SPONTANEOUS) {
+                    qDebug() << "running: spont " << m_runnableJob->debugName();
+                } else {
+                    qDebug() << "running: unkn. " << m_runnableJob->debugName();
+                }
+#endif
+
+                m_runnableJob->run();
+            }
+        }
+
+        setDone();
+
+        m_updaterContext->doSomeUsefulWork();
+
+        // may flip the current state from Waiting -> Running again
+        m_updaterContext->jobFinished();
+
+        m_updaterContext->m_exclusiveJobLock.unlock();
+    }
+
     inline void runMergeJob() {
         KIS_SAFE_ASSERT_RECOVER_RETURN(m_atomicType == Type::MERGE);
         KIS_SAFE_ASSERT_RECOVER_RETURN(m_walker);
@@ -132,12 +181,129 @@ public:
 
 #endif
 
-        m_merger.startMerge(*m_walker);
+        KisUpdateTimeMonitor::TraceScope trace(KisUpdateTimeMonitor::MergeJob);
+        if (trace.isActive()) {
+            trace.setDetails(mergeJobTraceName(m_walker),
+                             m_walker->startNode()->name(),
+                             m_walker->requestedRect());
+        }
+
+        QVector<KisBaseRectsWalkerSP> subtasks =
+            m_updaterContext->splitMergeJob(m_walker);
+
+        if (subtasks.isEmpty()) {
+            QElapsedTimer timer;
+            timer.start();
+
+            m_merger.startMerge(*m_walker);
+
+            m_updaterContext->reportMergeJobCost(m_walker, timer.nsecsElapsed());
+        } else {
+            runMergeSubtasks(subtasks);
+        }
 
         QRect changeRect = m_walker->changeRect();
         m_updaterContext->continueUpdate(changeRect);
     }
 
+    /**
+     * Pushes the subtasks into our deque, wakes up the idle threads
+     * to steal them and processes the ones left for us. We still
+     * hold m_exclusiveJobLock for read here, so the thieves don't
+     * need to take it (and must not, since a pending writer would
+     * block them forever).
+     */
+    inline void runMergeSubtasks(const QVector<KisBaseRectsWalkerSP> &subtasks) {
+        QSemaphore stolenSubtasksDone;
+
+        {
+            QMutexLocker l(&m_subtasksLock);
+            Q_FOREACH (KisBaseRectsWalkerSP walker, subtasks) {
+                m_subtasks.append({walker, &stolenSubtasksDone});
+            }
+        }
+
+        m_updaterContext->wakeUpIdleThreads(subtasks.size() - 1);
+
+        int numSubtasksDoneHere = 0;
+
+        while (1) {
+            KisMergeSubtask subtask;
+
+            {
+                QMutexLocker l(&m_subtasksLock);
+                if (m_subtasks.isEmpty()) break;
+                subtask = m_subtasks.takeLast();
+            }
+
+            runMergeSubtask(subtask.walker);
+            numSubtasksDoneHere++;
+        }
+
+        stolenSubtasksDone.acquire(subtasks.size() - numSubtasksDoneHere);
+    }
+
+    inline void runMergeSubtask(KisBaseRectsWalkerSP walker) {
+        KisUpdateTimeMonitor::TraceScope trace(KisUpdateTimeMonitor::MergeJob);
+        if (trace.isActive()) {
+            trace.setDetails(mergeJobTraceName(walker) + " (subtask)",
+                             walker->startNode()->name(),
+                             walker->requestedRect());
+        }
+
+        m_merger.startMerge(*walker);
+    }
+
+    static QString mergeJobTraceName(KisBaseRectsWalkerSP walker) {
+        switch (walker->type()) {
+        case KisBaseRectsWalker::UPDATE:
+            return "Merge";
+        case KisBaseRectsWalker::UPDATE_NO_FILTHY:
+            return "Merge (no filthy)";
+        case KisBaseRectsWalker::FULL_REFRESH:
+            return "Full refresh";
+        case KisBaseRectsWalker::UNSUPPORTED:
+            break;
+        }
+        return "Subtree refresh";
+    }
+
+    inline bool trySteal(KisMergeSubtask *subtask) {
+        QMutexLocker l(&m_subtasksLock);
+        if (m_subtasks.isEmpty()) return false;
+
+        *subtask = m_subtasks.takeFirst();
+        return true;
+    }
+
+    // return true if a subtask has been executed or we got a job of our own
+    inline bool stealAndRunSubtask() {
+        Type expectedValue = Type::WAITING;
+        if (!m_atomicType.compare_exchange_strong(expectedValue, Type::STEALING)) {
+            return true;
+        }
+
+        KisMergeSubtask subtask;
+        const bool stolen = m_updaterContext->stealMergeSubtask(this, &subtask);
+
+        if (stolen) {
+            runMergeSubtask(subtask.walker);
+            subtask.walker = 0;
+            subtask.doneSemaphore->release();
+        }
+
+        // no one can flip the state from STEALING except ourselves
+        m_atomicType = Type::WAITING;
+
+        return stolen;
+    }
+
+    // return true if the thread should be started to steal subtasks
+    inline bool tryStartStealing() {
+        Type expectedValue = Type::EMPTY;
+        return m_atomicType.compare_exchange_strong(expectedValue, Type::WAITING);
+    }
+
     // return true if the thread should actually be started
     inline bool setWalker(KisBaseRectsWalkerSP walker) {
         KIS_ASSERT(m_atomicType <= Type::WAITING);
@@ -148,6 +314,7 @@ public:
 
         m_exclusive = false;
         m_runnableJob = 0;
+        m_stroke = 0;
 
         const Type oldState = m_atomicType.exchange(Type::MERGE);
         return oldState == Type::EMPTY;
@@ -159,6 +326,7 @@ public:
 
         m_runnableJob = strokeJob;
         m_strokeJobSequentiality = strokeJob->sequentiality();
+        m_stroke = strokeJob->stroke();
 
         m_exclusive = strokeJob->isExclusive();
         m_walker = 0;
@@ -173,6 +341,7 @@ public:
         KIS_ASSERT(m_atomicType <= Type::WAITING);
 
         m_runnableJob = spontaneousJob;
+        m_stroke = 0;
 
         m_exclusive = spontaneousJob->isExclusive();
         m_walker = 0;
@@ -193,6 +362,15 @@ public:
         return m_atomicType >= Type::MERGE;
     }
 
+    /**
+     * The item can be given a new job. A thread executing a stolen
+     * subtask is not running a job of its own, but it is not idle
+     * either.
+     */
+    inline bool isIdle() const {
+        return m_atomicType <= Type::WAITING;
+    }
+
     inline Type type() const {
         return m_atomicType;
     }
@@ -209,6 +387,14 @@ public:
         return m_strokeJobSequentiality;
     }
 
+    /**
+     * The stroke the running stroke job belongs to, used
+     * for identification only
+     */
+    inline const KisStroke* stroke() const {
+        return m_stroke;
+    }
+
 private:
     /**
      * Open walker and stroke job for the testing suite.
@@ -240,6 +426,7 @@ private:
     bool m_exclusive {false};
     std::atomic<Type> m_atomicType {Type::EMPTY};
     volatile KisStrokeJobData::Sequentiality m_strokeJobSequentiality;
+    const KisStroke *m_stroke {0};
 
     /**
      * Runnable jobs part
@@ -253,6 +440,13 @@ private:
     KisBaseRectsWalkerSP m_walker;
     KisAsyncMerger m_merger;
 
+    /**
+     * The subtasks of the current merge job. We take them
+     * from the back, the other threads steal from the front.
+     */
+    QMutex m_subtasksLock;
+    QList<KisMergeSubtask> m_subtasks;
+
     /**
      * These rects cache actual values from the walker
      * to eliminate concurrent access to a walker structure
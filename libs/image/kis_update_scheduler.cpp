@@ -26,6 +26,8 @@
 #include "kis_updater_context.h"
 #include "kis_simple_update_queue.h"
 #include "kis_strokes_queue.h"
+#include "kis_split_composite_cache.h"
+#include "kis_async_merger.h"
 
 #include "kis_queues_progress_updater.h"
 #include "KisImageConfigNotifier.h"
@@ -106,6 +108,8 @@ void KisUpdateScheduler::setThreadsLimit(int value)
     m_d->updaterContext.lock();
     m_d->updaterContext.setThreadsLimit(value);
     m_d->updaterContext.unlock();
+    m_d->updatesQueue.setThreadsLimit(value);
+    KisAsyncMerger::setParallelSubtreesThreadsLimit(value);
     unlock(false);
 }
 
@@ -263,6 +267,11 @@ void KisUpdateScheduler::setDesiredLevelOfDetail(int lod)
     processQueues();
 }
 
+void KisUpdateScheduler::setUpdatePriorityRect(const QRect &rc)
+{
+    m_d->updatesQueue.setPriorityRect(rc);
+}
+
 void KisUpdateScheduler::explicitRegenerateLevelOfDetail()
 {
     m_d->strokesQueue.explicitRegenerateLevelOfDetail();
@@ -306,6 +315,10 @@ void KisUpdateScheduler::updateSettings()
     m_d->updatesQueue.updateSettings();
     KisImageConfig config(true);
     m_d->defaultBalancingRatio = config.schedulerBalancingRatio();
+    m_d->updaterContext.setSubtaskSize(config.updateSubtaskSize());
+    KisSplitCompositeCache::setEnabled(config.useSplitCompositeCache());
+    KisAsyncMerger::setParallelSubtreesEnabled(config.parallelSubtreesMerge());
+    m_d->strokesQueue.setPipelinedStrokesEnabled(config.pipelinedStrokes());
     setThreadsLimit(config.maxNumberOfThreads());
 }
 
@@ -457,6 +470,11 @@ void KisUpdateScheduler::continueUpdate(const QRect &rect)
     m_d->projectionUpdateListener->notifyProjectionUpdated(rect);
 }
 
+void KisUpdateScheduler::reportMergeJobCost(KisNodeSP node, const QRect &rect, qint64 nsecs)
+{
+    m_d->updatesQueue.reportJobCost(node, rect, nsecs);
+}
+
 void KisUpdateScheduler::doSomeUsefulWork()
 {
     m_d->updatesQueue.optimize();
@@ -158,6 +158,14 @@ public:
      */
     void setDesiredLevelOfDetail(int lod);
 
+    /**
+     * Sets the area of the image visible to the user. The updates
+     * intersecting it are processed before all the other updates.
+     *
+     * \see KisSimpleUpdateQueue::setPriorityRect()
+     */
+    void setUpdatePriorityRect(const QRect &rc);
+
     /**
      * Explicitly start regeneration of LoD planes of all the devices
      * in the image. This call should be performed when the user is idle,
@@ -202,6 +210,7 @@ public:
     int currentLevelOfDetail() const;
 
     void continueUpdate(const QRect &rect);
+    void reportMergeJobCost(KisNodeSP node, const QRect &rect, qint64 nsecs);
     void doSomeUsefulWork();
     void spareThreadAppeared();
 
@@ -30,9 +30,16 @@
 #include <QDir>
 
 #include <QElapsedTimer>
+#include <QThread>
+#include <QCoreApplication>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
 
 #include <QFileInfo>
 
+#include <atomic>
+
 #include "kis_debug.h"
 #include "kis_global.h"
 #include "kis_image_config.h"
@@ -77,6 +84,17 @@ private:
     qint64 m_updateTime;
 };
 
+struct TraceEvent
+{
+    KisUpdateTimeMonitor::TraceCategory category;
+    QString name;
+    QString nodeName;
+    QRect rect;
+    qint64 startTime;
+    qint64 duration;
+    int threadId;
+};
+
 struct Q_DECL_HIDDEN KisUpdateTimeMonitor::Private
 {
     Private()
@@ -87,7 +105,28 @@ struct Q_DECL_HIDDEN KisUpdateTimeMonitor::Private
           mousePath(0.0),
           loggingEnabled(false)
     {
-        loggingEnabled = KisImageConfig(true).enablePerfLog();
+        KisImageConfig cfg(true);
+        loggingEnabled = cfg.enablePerfLog();
+        tracingEnabled = cfg.enableUpdateTracing();
+        traceBufferSize = qMax(1, cfg.updateTraceBufferSize());
+
+        traceTimer.start();
+    }
+
+    int threadIdLocked(QThread *thread) {
+        auto it = threadIds.find(thread);
+        if (it == threadIds.end()) {
+            const int id = threadIds.size() + 1;
+            it = threadIds.insert(thread, id);
+
+            QString name = thread->objectName();
+            if (name.isEmpty()) {
+                name = thread == qApp->thread() ?
+                    QString("Main Thread") : QString("Thread %1").arg(id);
+            }
+            threadNames.insert(id, name);
+        }
+        return it.value();
     }
 
     QHash<void*, StrokeTicket*> preliminaryTickets;
@@ -105,6 +144,15 @@ struct Q_DECL_HIDDEN KisUpdateTimeMonitor::Private
     KisPaintOpPresetSP preset;
 
     bool loggingEnabled;
+
+    std::atomic<bool> tracingEnabled;
+    QElapsedTimer traceTimer;
+    QMutex traceMutex;
+    QVector<TraceEvent> traceEvents;
+    int traceHead = 0;
+    int traceBufferSize;
+    QHash<QThread*, int> threadIds;
+    QHash<int, QString> threadNames;
 };
 
 KisUpdateTimeMonitor::KisUpdateTimeMonitor()
@@ -256,3 +304,152 @@ void KisUpdateTimeMonitor::reportUpdateFinished(const QRect &rect)
     }
     m_d->numUpdates++;
 }
+
+void KisUpdateTimeMonitor::setTracingEnabled(bool value)
+{
+    m_d->tracingEnabled = value;
+}
+
+bool KisUpdateTimeMonitor::tracingEnabled() const
+{
+    return m_d->tracingEnabled;
+}
+
+qint64 KisUpdateTimeMonitor::traceTimestamp() const
+{
+    return m_d->traceTimer.nsecsElapsed() / 1000;
+}
+
+void KisUpdateTimeMonitor::reportTraceEvent(TraceCategory category,
+                                            const QString &name,
+                                            const QString &nodeName,
+                                            const QRect &rect,
+                                            qint64 startTime,
+                                            qint64 duration)
+{
+    if (!m_d->tracingEnabled) return;
+
+    QMutexLocker locker(&m_d->traceMutex);
+
+    TraceEvent event;
+    event.category = category;
+    event.name = name;
+    event.nodeName = nodeName;
+    event.rect = rect;
+    event.startTime = startTime;
+    event.duration = duration;
+    event.threadId = m_d->threadIdLocked(QThread::currentThread());
+
+    /**
+     * The trace works as a ring buffer, we keep
+     * only the latest events
+     */
+    if (m_d->traceEvents.size() < m_d->traceBufferSize) {
+        m_d->traceEvents.append(event);
+    } else {
+        m_d->traceEvents[m_d->traceHead] = event;
+        m_d->traceHead = (m_d->traceHead + 1) % m_d->traceEvents.size();
+    }
+}
+
+bool KisUpdateTimeMonitor::exportChromeTrace(const QString &fileName)
+{
+    static const char *categoryNames[] = {
+        "stroke", "merge", "spontaneous", "lod_sync", "canvas_upload"
+    };
+
+    QJsonArray events;
+
+    {
+        QMutexLocker locker(&m_d->traceMutex);
+
+        const qint64 pid = QCoreApplication::applicationPid();
+
+        for (auto it = m_d->threadNames.constBegin(); it != m_d->threadNames.constEnd(); ++it) {
+            QJsonObject metadata;
+            metadata["name"] = "thread_name";
+            metadata["ph"] = "M";
+            metadata["pid"] = pid;
+            metadata["tid"] = it.key();
+            metadata["args"] = QJsonObject({{"name", it.value()}});
+            events.append(metadata);
+        }
+
+        const int numEvents = m_d->traceEvents.size();
+
+        for (int i = 0; i < numEvents; i++) {
+            const TraceEvent &event =
+                m_d->traceEvents[(m_d->traceHead + i) % numEvents];
+
+            QJsonObject args;
+            if (!event.nodeName.isEmpty()) {
+                args["node"] = event.nodeName;
+            }
+            if (!event.rect.isEmpty()) {
+                args["rect"] = QString("%1,%2 %3x%4")
+                    .arg(event.rect.x()).arg(event.rect.y())
+                    .arg(event.rect.width()).arg(event.rect.height());
+                args["pixels"] = qint64(event.rect.width()) * event.rect.height();
+            }
+
+            QJsonObject object;
+            object["name"] = event.name;
+            object["cat"] = categoryNames[event.category];
+            object["ph"] = "X";
+            object["ts"] = event.startTime;
+            object["dur"] = event.duration;
+            object["pid"] = pid;
+            object["tid"] = event.threadId;
+            object["args"] = args;
+            events.append(object);
+        }
+    }
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        warnKrita << "Failed to open the update trace file:" << fileName;
+        return false;
+    }
+
+    QJsonObject root;
+    root["traceEvents"] = events;
+    root["displayTimeUnit"] = "ms";
+
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    return true;
+}
+
+void KisUpdateTimeMonitor::clearTrace()
+{
+    QMutexLocker locker(&m_d->traceMutex);
+    m_d->traceEvents.clear();
+    m_d->traceHead = 0;
+}
+
+KisUpdateTimeMonitor::TraceScope::TraceScope(TraceCategory category)
+    : m_category(category),
+      m_startTime(-1)
+{
+    KisUpdateTimeMonitor *monitor = KisUpdateTimeMonitor::instance();
+    if (monitor->tracingEnabled()) {
+        m_startTime = monitor->traceTimestamp();
+    }
+}
+
+KisUpdateTimeMonitor::TraceScope::~TraceScope()
+{
+    if (!isActive()) return;
+
+    KisUpdateTimeMonitor *monitor = KisUpdateTimeMonitor::instance();
+    monitor->reportTraceEvent(m_category, m_name, m_nodeName, m_rect,
+                              m_startTime, monitor->traceTimestamp() - m_startTime);
+}
+
+void KisUpdateTimeMonitor::TraceScope::setDetails(const QString &name,
+                                                  const QString &nodeName,
+                                                  const QRect &rect)
+{
+    m_name = name;
+    m_nodeName = nodeName;
+    m_rect = rect;
+}
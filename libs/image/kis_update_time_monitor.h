@@ -24,8 +24,9 @@
 
 
 #include <QVector>
+#include <QRect>
+#include <QString>
 class QPointF;
-class QRect;
 
 
 class KRITAIMAGE_EXPORT KisUpdateTimeMonitor
@@ -46,6 +47,76 @@ public:
     void reportJobFinished(void *key, const QVector<QRect> &rects);
     void reportUpdateFinished(const QRect &rect);
 
+public:
+    enum TraceCategory {
+        StrokeJob = 0,
+        MergeJob,
+        SpontaneousJob,
+        LodSync,
+        CanvasUpload
+    };
+
+    /**
+     * Records the duration of a job into the update trace. The
+     * details of the event are expected to be set only when
+     * isActive() returns true, so that the disabled tracing costs
+     * nothing but a single check.
+     */
+    class KRITAIMAGE_EXPORT TraceScope
+    {
+    public:
+        TraceScope(TraceCategory category);
+        ~TraceScope();
+
+        inline bool isActive() const {
+            return m_startTime >= 0;
+        }
+
+        void setDetails(const QString &name,
+                        const QString &nodeName = QString(),
+                        const QRect &rect = QRect());
+
+    private:
+        Q_DISABLE_COPY(TraceScope)
+
+        TraceCategory m_category;
+        qint64 m_startTime;
+        QString m_name;
+        QString m_nodeName;
+        QRect m_rect;
+    };
+
+    /**
+     * Enables recording of the update trace, see
+     * KisImageConfig::enableUpdateTracing()
+     */
+    void setTracingEnabled(bool value);
+    bool tracingEnabled() const;
+
+    /**
+     * Timestamp in microseconds used for the trace events
+     */
+    qint64 traceTimestamp() const;
+
+    /**
+     * Adds an event to the trace. The trace keeps only the latest
+     * KisImageConfig::updateTraceBufferSize() events.
+     */
+    void reportTraceEvent(TraceCategory category,
+                          const QString &name,
+                          const QString &nodeName,
+                          const QRect &rect,
+                          qint64 startTime,
+                          qint64 duration);
+
+    /**
+     * Writes the recorded events in Chrome Trace Event format, which
+     * can be opened in chrome://tracing or Perfetto UI
+     */
+    bool exportChromeTrace(const QString &fileName);
+
+    void clearTrace();
+
 
 private:
     struct Private;
@@ -23,11 +23,16 @@
 
 #include "kis_update_job_item.h"
 #include "kis_stroke_job.h"
+#include "kis_merge_walker.h"
+#include "kis_full_refresh_walker.h"
+#include "kis_image_config.h"
 
 const int KisUpdaterContext::useIdealThreadCountTag = -1;
 
 KisUpdaterContext::KisUpdaterContext(qint32 threadCount, QObject *parent)
-    : QObject(parent), m_scheduler(qobject_cast<KisUpdateScheduler *>(parent))
+    : QObject(parent),
+      m_scheduler(qobject_cast<KisUpdateScheduler *>(parent)),
+      m_subtaskSize(KisImageConfig(true).updateSubtaskSize())
 {
     if(threadCount <= 0) {
         threadCount = QThread::idealThreadCount();
@@ -62,6 +67,11 @@ void KisUpdaterContext::getJobsSnapshot(qint32 &numMergeJobs,
 }
 
 KisUpdaterContextSnapshotEx KisUpdaterContext::getContextSnapshotEx() const
+{
+    return getContextSnapshotEx(0);
+}
+
+KisUpdaterContextSnapshotEx KisUpdaterContext::getContextSnapshotEx(const KisStroke *stroke) const
 {
     KisUpdaterContextSnapshotEx state = ContextEmpty;
 
@@ -70,6 +80,14 @@ KisUpdaterContextSnapshotEx KisUpdaterContext::getContextSnapshotEx() const
             item->type() == KisUpdateJobItem::Type::SPONTANEOUS) {
             state |= HasMergeJob;
         } else if(item->type() == KisUpdateJobItem::Type::STROKE) {
+            /**
+             * The jobs with no stroke assigned are considered
+             * to belong to every stroke
+             */
+            if (stroke && item->stroke() && item->stroke() != stroke) {
+                continue;
+            }
+
             switch (item->strokeJobSequentiality()) {
             case KisStrokeJobData::SEQUENTIAL:
                 state |= HasSequentialJob;
@@ -100,7 +118,7 @@ bool KisUpdaterContext::hasSpareThread()
     bool found = false;
 
     Q_FOREACH (const KisUpdateJobItem *item, m_jobs) {
-        if(!item->isRunning()) {
+        if(item->isIdle()) {
             found = true;
             break;
         }
@@ -238,12 +256,131 @@ bool KisUpdaterContext::walkerIntersectsJob(KisBaseRectsWalkerSP walker,
 qint32 KisUpdaterContext::findSpareThread()
 {
     for(qint32 i=0; i < m_jobs.size(); i++)
-        if(!m_jobs[i]->isRunning())
+        if(m_jobs[i]->isIdle())
             return i;
 
     return -1;
 }
 
+QVector<KisBaseRectsWalkerSP> KisUpdaterContext::splitMergeJob(KisBaseRectsWalkerSP walker)
+{
+    QVector<KisBaseRectsWalkerSP> subtasks;
+
+    const int subtaskSize = m_subtaskSize;
+    const QRect rc = walker->requestedRect();
+
+    if (subtaskSize <= 0 ||
+        (rc.width() <= subtaskSize && rc.height() <= subtaskSize)) {
+
+        return subtasks;
+    }
+
+    int numIdleThreads = 0;
+    Q_FOREACH (const KisUpdateJobItem *item, m_jobs) {
+        if (item->isIdle()) {
+            numIdleThreads++;
+        }
+    }
+
+    if (!numIdleThreads) return subtasks;
+
+    for (int y = rc.y(); y <= rc.bottom(); y += subtaskSize) {
+        for (int x = rc.x(); x <= rc.right(); x += subtaskSize) {
+            const QRect subtaskRect = rc & QRect(x, y, subtaskSize, subtaskSize);
+
+            KisBaseRectsWalkerSP subtask;
+
+            switch (walker->type()) {
+            case KisBaseRectsWalker::UPDATE:
+                subtask = new KisMergeWalker(walker->cropRect(), KisMergeWalker::DEFAULT);
+                break;
+            case KisBaseRectsWalker::UPDATE_NO_FILTHY:
+                subtask = new KisMergeWalker(walker->cropRect(), KisMergeWalker::NO_FILTHY);
+                break;
+            case KisBaseRectsWalker::FULL_REFRESH:
+                subtask = new KisFullRefreshWalker(walker->cropRect());
+                break;
+            case KisBaseRectsWalker::UNSUPPORTED:
+                return QVector<KisBaseRectsWalkerSP>();
+            }
+
+            subtask->collectRects(walker->startNode(), subtaskRect);
+            subtasks.append(subtask);
+        }
+    }
+
+    /**
+     * The subtasks are executed concurrently, so they should follow
+     * the same rules as the jobs in the context, see isJobAllowed().
+     *
+     * The subtasks form a grid, so we don't need to check all the
+     * pairs. A change rect cannot stick out of its cell further than
+     * the maximum overhang, so the access rect of a subtask can
+     * intersect only the change rects of the cells that are touched
+     * by the access rect grown by this overhang.
+     */
+    const int numColumns = (rc.width() + subtaskSize - 1) / subtaskSize;
+
+    int overhang = 0;
+    Q_FOREACH (KisBaseRectsWalkerSP subtask, subtasks) {
+        const QRect cell = subtask->requestedRect();
+        const QRect change = subtask->changeRect();
+        if (change.isEmpty()) continue;
+
+        overhang = qMax(overhang, qMax(cell.left() - change.left(), change.right() - cell.right()));
+        overhang = qMax(overhang, qMax(cell.top() - change.top(), change.bottom() - cell.bottom()));
+    }
+
+    for (int i = 0; i < subtasks.size(); i++) {
+        const QRect accessRect = subtasks[i]->accessRect();
+        const QRect area = accessRect.adjusted(-overhang, -overhang, overhang, overhang) & rc;
+        if (area.isEmpty()) continue;
+
+        const int firstColumn = (area.left() - rc.left()) / subtaskSize;
+        const int lastColumn = (area.right() - rc.left()) / subtaskSize;
+        const int firstRow = (area.top() - rc.top()) / subtaskSize;
+        const int lastRow = (area.bottom() - rc.top()) / subtaskSize;
+
+        for (int row = firstRow; row <= lastRow; row++) {
+            for (int column = firstColumn; column <= lastColumn; column++) {
+                const int j = row * numColumns + column;
+                if (j == i) continue;
+
+                if (accessRect.intersects(subtasks[j]->changeRect())) {
+                    return QVector<KisBaseRectsWalkerSP>();
+                }
+            }
+        }
+    }
+
+    return subtasks;
+}
+
+void KisUpdaterContext::wakeUpIdleThreads(int count)
+{
+    for (int i = 0; i < m_jobs.size() && count > 0; i++) {
+        if (m_jobs[i]->tryStartStealing()) {
+            m_threadPool.start(m_jobs[i]);
+            count--;
+        }
+    }
+}
+
+bool KisUpdaterContext::stealMergeSubtask(KisUpdateJobItem *thief, KisMergeSubtask *subtask)
+{
+    const int thiefIndex = m_jobs.indexOf(thief);
+
+    for (int i = 1; i < m_jobs.size(); i++) {
+        KisUpdateJobItem *victim = m_jobs[(thiefIndex + i) % m_jobs.size()];
+
+        if (victim->trySteal(subtask)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 void KisUpdaterContext::lock()
 {
     m_lock.lock();
@@ -256,13 +393,15 @@ void KisUpdaterContext::unlock()
 
 void KisUpdaterContext::setThreadsLimit(int value)
 {
-    m_threadPool.setMaxThreadCount(value);
-
     for (int i = 0; i < m_jobs.size(); i++) {
         KIS_SAFE_ASSERT_RECOVER_RETURN(!m_jobs[i]->isRunning());
         // don't delete the jobs until all of them are checked!
     }
 
+    // the idle threads might still be looking for subtasks to steal
+    m_threadPool.waitForDone();
+    m_threadPool.setMaxThreadCount(value);
+
     for (int i = 0; i < m_jobs.size(); i++) {
         delete m_jobs[i];
     }
@@ -280,6 +419,16 @@ int KisUpdaterContext::threadsLimit() const
     return m_jobs.size();
 }
 
+void KisUpdaterContext::setSubtaskSize(int value)
+{
+    m_subtaskSize = value;
+}
+
+void KisUpdaterContext::reportMergeJobCost(KisBaseRectsWalkerSP walker, qint64 nsecs)
+{
+    if (m_scheduler) m_scheduler->reportMergeJobCost(walker->startNode(), walker->requestedRect(), nsecs);
+}
+
 void KisUpdaterContext::continueUpdate(const QRect& rc)
 {
     if (m_scheduler) m_scheduler->continueUpdate(rc);
@@ -296,6 +445,11 @@ void KisUpdaterContext::jobFinished()
     if (m_scheduler) m_scheduler->spareThreadAppeared();
 }
 
+void KisUpdaterContext::stealingFinished()
+{
+    if (m_scheduler) m_scheduler->spareThreadAppeared();
+}
+
 const QVector<KisUpdateJobItem*> KisUpdaterContext::getJobs()
 {
     return m_jobs;
@@ -19,6 +19,8 @@
 #ifndef __KIS_UPDATER_CONTEXT_H
 #define __KIS_UPDATER_CONTEXT_H
 
+#include <atomic>
+
 #include <QObject>
 #include <QMutex>
 #include <QReadWriteLock>
@@ -32,8 +34,10 @@
 #include "kis_update_scheduler.h"
 
 class KisUpdateJobItem;
+struct KisMergeSubtask;
 class KisSpontaneousJob;
 class KisStrokeJob;
+class KisStroke;
 
 class KRITAIMAGE_EXPORT KisUpdaterContext : public QObject
 {
@@ -56,6 +60,12 @@ public:
 
     KisUpdaterContextSnapshotEx getContextSnapshotEx() const;
 
+    /**
+     * Same as getContextSnapshotEx(), but the jobs of the strokes
+     * other than \p stroke are not taken into account
+     */
+    KisUpdaterContextSnapshotEx getContextSnapshotEx(const KisStroke *stroke) const;
+
     /**
      * Returns the current level of detail of all the running jobs in the
      * context. If there are no jobs, returns -1.
@@ -139,15 +149,53 @@ public:
      */
     int threadsLimit() const;
 
+    /**
+     * Set the size of the subtasks the merge jobs are split into
+     * when there are idle threads in the context. Zero disables
+     * splitting.
+     *
+     * \see KisImageConfig::updateSubtaskSize()
+     */
+    void setSubtaskSize(int value);
+
+    /**
+     * Reports the time spent on the merge job of \p walker,
+     * \see KisSimpleUpdateQueue::reportJobCost()
+     */
+    void reportMergeJobCost(KisBaseRectsWalkerSP walker, qint64 nsecs);
+
     void continueUpdate(const QRect& rc);
     void doSomeUsefulWork();
     void jobFinished();
 
+    /**
+     * Called by a thread that has finished executing the stolen
+     * subtasks and can accept a job again
+     */
+    void stealingFinished();
+
 protected:
     static bool walkerIntersectsJob(KisBaseRectsWalkerSP walker,
                                     const KisUpdateJobItem* job);
     qint32 findSpareThread();
 
+    /**
+     * Splits the merge job of \p walker into a set of independent
+     * subtasks covering its requested rect. Returns an empty vector
+     * if there are no idle threads to share the work with or if the
+     * parts of the job would interfere (e.g. there is a blur filter
+     * in the stack).
+     */
+    QVector<KisBaseRectsWalkerSP> splitMergeJob(KisBaseRectsWalkerSP walker);
+
+    /**
+     * Starts up to \p count threads which are not running
+     * any job to steal the subtasks of the running merge jobs
+     */
+    void wakeUpIdleThreads(int count);
+
+    bool stealMergeSubtask(KisUpdateJobItem *thief, KisMergeSubtask *subtask);
+
 protected:
     /**
      * The lock is shared by all the child update job items.
@@ -162,6 +210,7 @@ protected:
     QThreadPool m_threadPool;
     KisLockFreeLodCounter m_lodCounter;
     KisUpdateScheduler *m_scheduler;
+    std::atomic<int> m_subtaskSize;
 
 private:
 
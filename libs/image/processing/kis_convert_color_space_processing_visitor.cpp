@@ -75,16 +75,32 @@ void KisConvertColorSpaceProcessingVisitor::visitNodeWithPaintDevice(KisNode *no
     }
 
 
-    if (layer->original()) {
-        layer->original()->convertTo(m_dstColorSpace, m_renderingIntent, m_conversionFlags, parentConversionCommand);
+    /**
+     * The original, the paint device and the projection of a layer
+     * may point to the same device, convert each of them only once.
+     * Every device is converted in parallel by itself.
+     */
+    KisPaintDeviceList devices;
+    Q_FOREACH (KisPaintDeviceSP device, KisPaintDeviceList() << layer->original() << layer->paintDevice() << layer->projection()) {
+        if (device && !devices.contains(device)) {
+            devices << device;
+        }
     }
 
-    if (layer->paintDevice()) {
-        layer->paintDevice()->convertTo(m_dstColorSpace, m_renderingIntent, m_conversionFlags, parentConversionCommand);
+    /**
+     * All the subtasks are registered before the conversion starts,
+     * so the progress of the layer is split between its devices
+     * instead of restarting from zero for every device
+     */
+    ProgressHelper helper(node);
+
+    QVector<KoUpdater*> updaters;
+    for (int i = 0; i < devices.size(); i++) {
+        updaters << helper.updater();
     }
 
-    if (layer->projection()) {
-        layer->projection()->convertTo(m_dstColorSpace, m_renderingIntent, m_conversionFlags, parentConversionCommand);
+    for (int i = 0; i < devices.size(); i++) {
+        devices[i]->convertTo(m_dstColorSpace, m_renderingIntent, m_conversionFlags, parentConversionCommand, updaters[i]);
     }
 
     if (layer && alphaDisabled) {
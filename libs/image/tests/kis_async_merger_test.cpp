@@ -43,6 +43,7 @@
 
 #include "kis_image_config.h"
 #include "KisImageConfigNotifier.h"
+#include "kis_split_composite_cache.h"
 
 void KisAsyncMergerTest::init()
 {
@@ -509,5 +510,273 @@ void KisAsyncMergerTest::testFilterMaskOnFilterLayer()
 }
 
 
+/*
+  +--------------+
+  |root          |
+  | paint 5      |
+  | paint 4      |
+  | pivot        |
+  | paint 2      |
+  | paint 1      |
+  +--------------+
+ */
+void KisAsyncMergerTest::testSplitCompositeCache()
+{
+    const QRect imageRect(0, 0, 128, 128);
+
+    const KoColorSpace *colorSpace = KoColorSpaceRegistry::instance()->rgb8();
+    KisImageSP image = new KisImage(0, imageRect.width(), imageRect.height(), colorSpace, "split cache test");
+
+    KisPaintDeviceSP device1 = new KisPaintDevice(colorSpace);
+    device1->fill(imageRect, KoColor(Qt::white, colorSpace));
+    KisLayerSP paintLayer1 = new KisPaintLayer(image, "paint1", OPACITY_OPAQUE_U8, device1);
+
+    KisPaintDeviceSP device2 = new KisPaintDevice(colorSpace);
+    device2->fill(QRect(10, 10, 80, 80), KoColor(Qt::blue, colorSpace));
+    KisLayerSP paintLayer2 = new KisPaintLayer(image, "paint2", 128, device2);
+
+    KisPaintDeviceSP pivotDevice = new KisPaintDevice(colorSpace);
+    pivotDevice->fill(QRect(30, 30, 60, 60), KoColor(Qt::red, colorSpace));
+    KisLayerSP pivotLayer = new KisPaintLayer(image, "pivot", 200, pivotDevice);
+
+    KisPaintDeviceSP device4 = new KisPaintDevice(colorSpace);
+    device4->fill(QRect(50, 0, 20, 128), KoColor(Qt::green, colorSpace));
+    KisLayerSP paintLayer4 = new KisPaintLayer(image, "paint4", OPACITY_OPAQUE_U8, device4);
+
+    KisPaintDeviceSP device5 = new KisPaintDevice(colorSpace);
+    device5->fill(QRect(0, 60, 128, 10), KoColor(Qt::black, colorSpace));
+    KisLayerSP paintLayer5 = new KisPaintLayer(image, "paint5", OPACITY_OPAQUE_U8, device5);
+
+    image->addNode(paintLayer1, image->rootLayer());
+    image->addNode(paintLayer2, image->rootLayer());
+    image->addNode(pivotLayer, image->rootLayer());
+    image->addNode(paintLayer4, image->rootLayer());
+    image->addNode(paintLayer5, image->rootLayer());
+
+    image->initialRefreshGraph();
+
+    KisSplitCompositeCache::setEnabled(true);
+
+    KisAsyncMerger merger;
+
+    {
+        KisMergeWalker walker(imageRect);
+        walker.collectRects(pivotLayer, imageRect);
+        merger.startMerge(walker);
+    }
+
+    {
+        KisSplitCompositeCache::State state =
+            image->rootLayer()->splitCompositeCache()->fetch(pivotLayer, 0, colorSpace, imageRect);
+
+        QVERIFY(state.belowValid);
+        QVERIFY(state.aboveValid);
+    }
+
+    pivotDevice->fill(QRect(20, 20, 40, 40), KoColor(Qt::yellow, colorSpace));
+
+    {
+        KisMergeWalker walker(imageRect);
+        walker.collectRects(pivotLayer, imageRect);
+        merger.startMerge(walker);
+    }
+
+    KisPaintDeviceSP cachedProjection = new KisPaintDevice(*image->projection());
+
+    KisSplitCompositeCache::setEnabled(false);
+
+    {
+        KisFullRefreshWalker walker(imageRect);
+        walker.collectRects(image->rootLayer(), imageRect);
+        merger.startMerge(walker);
+    }
+
+    QPoint pt;
+    if (!TestUtil::comparePaintDevices(pt, cachedProjection, image->projection())) {
+        QFAIL(QString("The cached merge differs from the full refresh at %1,%2").arg(pt.x()).arg(pt.y()).toLatin1());
+    }
+}
+
+/*
+  +----------------+
+  |root            |
+  | group 2        |
+  |  paint 4       |
+  |  paint 3       |
+  | group 1        |
+  |  group 3       |
+  |   paint 2      |
+  |  paint 1       |
+  | background     |
+  +----------------+
+ */
+void KisAsyncMergerTest::testParallelSubtrees()
+{
+    const QRect imageRect(0, 0, 256, 256);
+
+    const KoColorSpace *colorSpace = KoColorSpaceRegistry::instance()->rgb8();
+    KisImageSP image = new KisImage(0, imageRect.width(), imageRect.height(), colorSpace, "parallel subtrees test");
+
+    KisPaintDeviceSP background = new KisPaintDevice(colorSpace);
+    background->fill(imageRect, KoColor(Qt::white, colorSpace));
+    KisLayerSP backgroundLayer = new KisPaintLayer(image, "background", OPACITY_OPAQUE_U8, background);
+
+    KisGroupLayerSP group1 = new KisGroupLayer(image, "group1", OPACITY_OPAQUE_U8);
+    KisGroupLayerSP group2 = new KisGroupLayer(image, "group2", 160);
+    KisGroupLayerSP group3 = new KisGroupLayer(image, "group3", 200);
+
+    const QRect rects[] = {
+        QRect(10, 10, 100, 100),
+        QRect(60, 60, 100, 100),
+        QRect(120, 20, 100, 200),
+        QRect(0, 150, 256, 50)
+    };
+
+    const QColor colors[] = { Qt::red, Qt::green, Qt::blue, Qt::yellow };
+
+    QVector<KisLayerSP> paintLayers;
+    for (int i = 0; i < 4; i++) {
+        KisPaintDeviceSP device = new KisPaintDevice(colorSpace);
+        device->fill(rects[i], KoColor(colors[i], colorSpace));
+        paintLayers << new KisPaintLayer(image, QString("paint%1").arg(i + 1), 180, device);
+    }
+
+    image->addNode(backgroundLayer, image->rootLayer());
+    image->addNode(group1, image->rootLayer());
+    image->addNode(group2, image->rootLayer());
+    image->addNode(paintLayers[0], group1);
+    image->addNode(group3, group1);
+    image->addNode(paintLayers[1], group3);
+    image->addNode(paintLayers[2], group2);
+    image->addNode(paintLayers[3], group2);
+
+    KisAsyncMerger merger;
+
+    KisAsyncMerger::setParallelSubtreesEnabled(false);
+
+    {
+        KisFullRefreshWalker walker(imageRect);
+        walker.collectRects(image->rootLayer(), imageRect);
+        merger.startMerge(walker);
+    }
+
+    KisPaintDeviceSP sequentialProjection = new KisPaintDevice(*image->projection());
+
+    image->projection()->clear();
+    group1->projection()->clear();
+    group2->projection()->clear();
+    group3->projection()->clear();
+
+    KisAsyncMerger::setParallelSubtreesEnabled(true);
+
+    {
+        KisFullRefreshWalker walker(imageRect);
+        walker.collectRects(image->rootLayer(), imageRect);
+        merger.startMerge(walker);
+    }
+
+    KisAsyncMerger::setParallelSubtreesEnabled(false);
+
+    QPoint pt;
+    if (!TestUtil::comparePaintDevices(pt, sequentialProjection, image->projection())) {
+        QFAIL(QString("The parallel merge differs from the sequential one at %1,%2").arg(pt.x()).arg(pt.y()).toLatin1());
+    }
+}
+
+/*
+  The same graph as above, but the layers above the pivot are
+  semi-transparent, so the pre-composited above-part rounds
+  differently, and the second merge covers the cached rect
+  only partially.
+ */
+void KisAsyncMergerTest::testSplitCompositeCachePartialRect()
+{
+    const QRect imageRect(0, 0, 128, 128);
+    const QRect firstRect(0, 0, 64, 64);
+    const QRect secondRect(32, 32, 64, 64);
+
+    const KoColorSpace *colorSpace = KoColorSpaceRegistry::instance()->rgb8();
+    KisImageSP image = new KisImage(0, imageRect.width(), imageRect.height(), colorSpace, "split cache test");
+
+    KisPaintDeviceSP device1 = new KisPaintDevice(colorSpace);
+    device1->fill(imageRect, KoColor(Qt::white, colorSpace));
+    KisLayerSP paintLayer1 = new KisPaintLayer(image, "paint1", OPACITY_OPAQUE_U8, device1);
+
+    KisPaintDeviceSP device2 = new KisPaintDevice(colorSpace);
+    device2->fill(QRect(10, 10, 80, 80), KoColor(Qt::blue, colorSpace));
+    KisLayerSP paintLayer2 = new KisPaintLayer(image, "paint2", 128, device2);
+
+    KisPaintDeviceSP pivotDevice = new KisPaintDevice(colorSpace);
+    pivotDevice->fill(QRect(30, 30, 60, 60), KoColor(Qt::red, colorSpace));
+    KisLayerSP pivotLayer = new KisPaintLayer(image, "pivot", 200, pivotDevice);
+
+    KisPaintDeviceSP device4 = new KisPaintDevice(colorSpace);
+    device4->fill(QRect(20, 0, 80, 128), KoColor(Qt::green, colorSpace));
+    KisLayerSP paintLayer4 = new KisPaintLayer(image, "paint4", 100, device4);
+
+    KisPaintDeviceSP device5 = new KisPaintDevice(colorSpace);
+    device5->fill(QRect(0, 20, 128, 80), KoColor(Qt::black, colorSpace));
+    KisLayerSP paintLayer5 = new KisPaintLayer(image, "paint5", 150, device5);
+
+    image->addNode(paintLayer1, image->rootLayer());
+    image->addNode(paintLayer2, image->rootLayer());
+    image->addNode(pivotLayer, image->rootLayer());
+    image->addNode(paintLayer4, image->rootLayer());
+    image->addNode(paintLayer5, image->rootLayer());
+
+    image->initialRefreshGraph();
+
+    KisSplitCompositeCache::setEnabled(true);
+
+    KisAsyncMerger merger;
+
+    {
+        KisMergeWalker walker(imageRect);
+        walker.collectRects(pivotLayer, firstRect);
+        merger.startMerge(walker);
+    }
+
+    {
+        KisSplitCompositeCache *cache = image->rootLayer()->splitCompositeCache();
+
+        KisSplitCompositeCache::State state = cache->fetch(pivotLayer, 0, colorSpace, firstRect);
+        QVERIFY(state.belowValid);
+        QVERIFY(state.aboveValid);
+
+        state = cache->fetch(pivotLayer, 0, colorSpace, secondRect);
+        QVERIFY(!state.belowValid);
+        QVERIFY(!state.aboveValid);
+    }
+
+    pivotDevice->fill(QRect(40, 40, 40, 40), KoColor(Qt::yellow, colorSpace));
+
+    {
+        KisMergeWalker walker(imageRect);
+        walker.collectRects(pivotLayer, secondRect);
+        merger.startMerge(walker);
+    }
+
+    const QImage cachedProjection = image->projection()->convertToQImage(0, imageRect);
+
+    KisSplitCompositeCache::setEnabled(false);
+
+    {
+        KisFullRefreshWalker walker(imageRect);
+        walker.collectRects(image->rootLayer(), imageRect);
+        merger.startMerge(walker);
+    }
+
+    const QImage refreshedProjection = image->projection()->convertToQImage(0, imageRect);
+
+    /**
+     * The pre-composited above-part may differ from the sequential
+     * composition by the 8-bit rounding, but not more
+     */
+    QPoint pt;
+    if (!TestUtil::compareQImages(pt, cachedProjection, refreshedProjection, 2, 2)) {
+        QFAIL(QString("The cached merge differs from the full refresh at %1,%2").arg(pt.x()).arg(pt.y()).toLatin1());
+    }
+}
+
 QTEST_MAIN(KisAsyncMergerTest)
 
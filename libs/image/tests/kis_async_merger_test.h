@@ -41,6 +41,11 @@ private Q_SLOTS:
 
     void testFilterMaskOnFilterLayer();
 
+    void testSplitCompositeCache();
+    void testSplitCompositeCachePartialRect();
+
+    void testParallelSubtrees();
+
 };
 
 #endif /* KIS_ASYNC_MERGER_TEST_H */
@@ -294,6 +294,39 @@ void KisPaintDeviceTest::testColorSpaceConversion()
     delete cmd;
 }
 
+void KisPaintDeviceTest::testParallelColorSpaceConversion()
+{
+    QImage image(QString(FILES_DATA_DIR) + QDir::separator() + "hakonepa.png");
+    const KoColorSpace* srcCs = KoColorSpaceRegistry::instance()->rgb8();
+    const KoColorSpace* dstCs = KoColorSpaceRegistry::instance()->lab16();
+    KisPaintDeviceSP dev = new KisPaintDevice(srcCs);
+    // the pixels themselves must lie at negative data coordinates,
+    // moveTo() would only change the offset of the device
+    dev->convertFromQImage(image, 0, -100, -150);
+
+    const QRect rc = dev->exactBounds();
+    QCOMPARE(rc, QRect(-100, -150, image.width(), image.height()));
+
+    const int numPixels = rc.width() * rc.height();
+    QVector<quint8> srcBytes(numPixels * srcCs->pixelSize());
+    dev->readBytes(srcBytes.data(), rc);
+
+    QVector<quint8> expectedBytes(numPixels * dstCs->pixelSize());
+    srcCs->convertPixelsTo(srcBytes.constData(), expectedBytes.data(), dstCs, numPixels,
+                           KoColorConversionTransformation::internalRenderingIntent(),
+                           KoColorConversionTransformation::internalConversionFlags());
+
+    dev->convertTo(dstCs);
+
+    QCOMPARE(dev->exactBounds(), rc);
+    QVERIFY(*dev->colorSpace() == *dstCs);
+
+    QVector<quint8> dstBytes(numPixels * dstCs->pixelSize());
+    dev->readBytes(dstBytes.data(), rc);
+
+    QVERIFY(dstBytes == expectedBytes);
+}
+
 
 void KisPaintDeviceTest::testRoundtripConversion()
 {
@@ -1506,12 +1539,11 @@ void KisPaintDeviceTest::testLodDevice()
                                   "lod", "lod1"));
 
     bounds->testingSetLevelOfDetail(2);
-    QCOMPARE(dev->exactBounds(), QRect(25,25,15,15));
 
-    qDebug() << ppVar(dev->exactBounds());
-    result = dev->convertToQImage(0,0,0,100,100);
-    /*QVERIFY*/(TestUtil::checkQImage(result, "paint_device_test",
-                                  "lod", "lod1"));
+    // every level has its own cache, so the level is empty before syncing
+    QVERIFY(dev->exactBounds().isEmpty());
+    QVERIFY(dev->hasLodData(1));
+    QVERIFY(!dev->hasLodData(2));
 
     syncLodCache(dev, 2);
     QCOMPARE(dev->exactBounds(), QRect(12,12,8,8));
@@ -1538,6 +1570,128 @@ void KisPaintDeviceTest::testLodDevice()
                                   "lod", "lod1-offset-6-14"));
 }
 
+void syncLodCacheFromLevel(KisPaintDeviceSP dev, int levelOfDetail, int sourceLevelOfDetail)
+{
+    KisPaintDevice::LodDataStruct* s = dev->createLodDataStruct(levelOfDetail, sourceLevelOfDetail);
+
+    KisRegion region = dev->regionForLodSyncing();
+    Q_FOREACH(QRect rect2, KritaUtils::splitRegionIntoPatches(region, KritaUtils::optimalPatchSize())) {
+        dev->updateLodDataStruct(s, rect2);
+    }
+
+    dev->uploadLodDataStruct(s);
+    delete s;
+}
+
+void KisPaintDeviceTest::testLodPyramid()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisPaintDeviceSP dev = new KisPaintDevice(cs);
+
+    TestingLodDefaultBounds *bounds = new TestingLodDefaultBounds();
+    dev->setDefaultBounds(bounds);
+
+    // the areas are aligned to the grid of level 2, so the box
+    // filter gives exactly the same result for both the paths
+    dev->fill(QRect(8,8,40,24), KoColor(Qt::red, cs));
+    dev->fill(QRect(20,32,16,28), KoColor(Qt::blue, cs));
+
+    bounds->testingSetLevelOfDetail(1);
+    syncLodCache(dev, 1);
+    QCOMPARE(dev->exactBounds(), QRect(4,4,20,26));
+
+    const QImage lod1 = dev->convertToQImage(0,0,0,50,50);
+
+    // build level 2 from the cached level 1
+    bounds->testingSetLevelOfDetail(2);
+    syncLodCacheFromLevel(dev, 2, 1);
+    QCOMPARE(dev->exactBounds(), QRect(2,2,10,13));
+    QVERIFY(dev->hasLodData(1));
+    QVERIFY(dev->hasLodData(2));
+
+    const QImage pyramidLod2 = dev->convertToQImage(0,0,0,25,25);
+
+    // the level 1 should have been kept intact
+    bounds->testingSetLevelOfDetail(1);
+    QCOMPARE(dev->exactBounds(), QRect(4,4,20,26));
+    QCOMPARE(dev->convertToQImage(0,0,0,50,50), lod1);
+
+    // build level 2 from the original data
+    bounds->testingSetLevelOfDetail(2);
+    syncLodCache(dev, 2);
+    QCOMPARE(dev->exactBounds(), QRect(2,2,10,13));
+
+    QCOMPARE(dev->convertToQImage(0,0,0,25,25), pyramidLod2);
+}
+
+KisRegion syncLodCacheIncrementally(KisPaintDeviceSP dev, int levelOfDetail)
+{
+    QScopedPointer<KisPaintDevice::LodDataStruct> s(dev->createLodDataStruct(levelOfDetail));
+
+    KisRegion region = dev->regionForLodSyncing(s.data());
+    Q_FOREACH(QRect rect2, KritaUtils::splitRegionIntoPatches(region, KritaUtils::optimalPatchSize())) {
+        dev->updateLodDataStruct(s.data(), rect2);
+    }
+
+    dev->uploadLodDataStruct(s.data());
+
+    return region;
+}
+
+void KisPaintDeviceTest::testLodIncrementalSync()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisPaintDeviceSP dev = new KisPaintDevice(cs);
+    KisPaintDeviceSP refDev = new KisPaintDevice(cs);
+
+    TestingLodDefaultBounds *bounds = new TestingLodDefaultBounds(QRect(0,0,256,256));
+    TestingLodDefaultBounds *refBounds = new TestingLodDefaultBounds(QRect(0,0,256,256));
+    dev->setDefaultBounds(bounds);
+    refDev->setDefaultBounds(refBounds);
+
+    auto setLevelOfDetail = [&] (int lod) {
+        bounds->testingSetLevelOfDetail(lod);
+        refBounds->testingSetLevelOfDetail(lod);
+    };
+
+    auto fill = [&] (const QRect &rc, const QColor &color) {
+        dev->fill(rc, KoColor(color, cs));
+        refDev->fill(rc, KoColor(color, cs));
+    };
+
+    fill(QRect(0,0,64,64), Qt::red);
+
+    // the first synchronization resamples everything
+    setLevelOfDetail(1);
+    QCOMPARE(syncLodCacheIncrementally(dev, 1).boundingRect(), QRect(0,0,64,64));
+
+    // only the changed tile is resampled
+    setLevelOfDetail(0);
+    fill(QRect(140,150,30,20), Qt::blue);
+
+    setLevelOfDetail(1);
+    QCOMPARE(syncLodCacheIncrementally(dev, 1), KisRegion(QRect(128,128,64,64)));
+    syncLodCache(refDev, 1);
+
+    QCOMPARE(dev->exactBounds(), QRect(0,0,85,85));
+    QCOMPARE(dev->convertToQImage(0,0,0,128,128), refDev->convertToQImage(0,0,0,128,128));
+
+    // the removed tiles are resampled as well
+    setLevelOfDetail(0);
+    dev->clear(QRect(0,0,64,64));
+    refDev->clear(QRect(0,0,64,64));
+
+    setLevelOfDetail(1);
+    QCOMPARE(syncLodCacheIncrementally(dev, 1), KisRegion(QRect(0,0,64,64)));
+    syncLodCache(refDev, 1);
+
+    QCOMPARE(dev->exactBounds(), QRect(70,75,15,10));
+    QCOMPARE(dev->convertToQImage(0,0,0,128,128), refDev->convertToQImage(0,0,0,128,128));
+
+    // nothing has changed
+    QVERIFY(syncLodCacheIncrementally(dev, 1).isEmpty());
+}
+
 void KisPaintDeviceTest::benchmarkLod1Generation()
 {
     const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
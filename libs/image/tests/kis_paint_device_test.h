@@ -44,6 +44,7 @@ private Q_SLOTS:
     void testMakeClone();
     void testBltPerformance();
     void testColorSpaceConversion();
+    void testParallelColorSpaceConversion();
     void testDeviceDuplication();
     void testTranslate();
     void testOpacity();
@@ -65,6 +66,8 @@ private Q_SLOTS:
 
     void testLodTransform();
     void testLodDevice();
+    void testLodPyramid();
+    void testLodIncrementalSync();
     void benchmarkLod1Generation();
     void benchmarkLod2Generation();
     void benchmarkLod3Generation();
@@ -18,6 +18,7 @@
 
 #include "kis_simple_update_queue_test.h"
 #include <QTest>
+#include <QtMath>
 
 #include <KoColorSpace.h>
 #include <KoColorSpaceRegistry.h>
@@ -32,6 +33,8 @@
 
 #include "kis_update_job_item.h"
 #include "kis_simple_update_queue.h"
+#include "kis_image_config.h"
+#include "tiles3/kis_tile_data.h"
 #include "scheduler_utils.h"
 #include <KisGlobalResourcesInterface.h>
 
@@ -150,6 +153,122 @@ void KisSimpleUpdateQueueTest::testSplit(bool useFullRefresh)
     QVERIFY(checkWalker(walkersList[3], QRect(512,512,488,488)));
 }
 
+void KisSimpleUpdateQueueTest::testAdaptivePatchSize()
+{
+    QRect imageRect(0,0,1024,1024);
+
+    const KoColorSpace * cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisImageSP image = new KisImage(0, imageRect.width(), imageRect.height(), cs, "merge test");
+
+    KisPaintLayerSP heavyLayer = new KisPaintLayer(image, "heavy", OPACITY_OPAQUE_U8);
+    KisPaintLayerSP lightLayer = new KisPaintLayer(image, "light", OPACITY_OPAQUE_U8);
+    KisPaintLayerSP mediumLayer = new KisPaintLayer(image, "medium", OPACITY_OPAQUE_U8);
+
+    image->barrierLock();
+    image->addNode(heavyLayer);
+    image->addNode(lightLayer);
+    image->addNode(mediumLayer);
+    image->unlock();
+
+    const QRect dirtyRect(0,0,1000,1000);
+    const QRect measuredRect(0,0,512,512);
+    const qint64 measuredArea = measuredRect.width() * measuredRect.height();
+
+    // the patches are aligned to the tiles, see patchSizeForNode()
+    auto expectedPatchSize = [] (qreal area) {
+        KisImageConfig config(true);
+        const int alignment = KisTileData::WIDTH;
+        int size = qRound(qSqrt(area) / alignment) * alignment;
+        size = qBound(config.minUpdatePatchSize(), size, config.maxUpdatePatchSize());
+        return QSize(size, size);
+    };
+
+    KisTestableSimpleUpdateQueue queue;
+    KisWalkersList& walkersList = queue.getWalkersList();
+
+    // no measurements yet, the configured size is used
+    QCOMPARE(queue.patchSizeForNode(heavyLayer, dirtyRect), QSize(512, 512));
+
+    // 100 ns per pixel, 8 ms per patch
+    queue.reportJobCost(heavyLayer, measuredRect, 100 * measuredArea);
+    const QSize heavyPatchSize = expectedPatchSize(8000000 / 100);
+    QCOMPARE(queue.patchSizeForNode(heavyLayer, dirtyRect), heavyPatchSize);
+
+    const int heavyPatch = heavyPatchSize.width();
+    const int numHeavyPatches = (dirtyRect.width() + heavyPatch - 1) / heavyPatch;
+    const int lastHeavyPatch = (numHeavyPatches - 1) * heavyPatch;
+
+    queue.addUpdateJob(heavyLayer, dirtyRect, imageRect, 0);
+    QCOMPARE(walkersList.size(), numHeavyPatches * numHeavyPatches);
+    QVERIFY(checkWalker(walkersList.first(), QRect(0, 0, heavyPatch, heavyPatch)));
+    QVERIFY(checkWalker(walkersList.last(),
+                        QRect(lastHeavyPatch, lastHeavyPatch,
+                              dirtyRect.width() - lastHeavyPatch,
+                              dirtyRect.height() - lastHeavyPatch)));
+    walkersList.clear();
+
+    // 1 ns per pixel, the patches are limited by the maximum size
+    queue.reportJobCost(lightLayer, measuredRect, measuredArea);
+    QCOMPARE(queue.patchSizeForNode(lightLayer, dirtyRect), expectedPatchSize(8000000 / 1));
+
+    queue.addUpdateJob(lightLayer, dirtyRect, imageRect, 0);
+    QCOMPARE(walkersList.size(), 1);
+    QVERIFY(checkWalker(walkersList[0], dirtyRect));
+    walkersList.clear();
+
+    // 10 ns per pixel, the work is shared between the threads
+    queue.reportJobCost(mediumLayer, measuredRect, 10 * measuredArea);
+    QCOMPARE(queue.patchSizeForNode(mediumLayer, dirtyRect), expectedPatchSize(8000000 / 10));
+
+    queue.setThreadsLimit(4);
+    QCOMPARE(queue.patchSizeForNode(mediumLayer, dirtyRect),
+             expectedPatchSize(qreal(dirtyRect.width()) * dirtyRect.height() / 4));
+}
+
+void KisSimpleUpdateQueueTest::testPriorityRect()
+{
+    KisTestableUpdaterContext context(1);
+
+    QRect imageRect(0,0,1024,1024);
+
+    const KoColorSpace * cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisImageSP image = new KisImage(0, imageRect.width(), imageRect.height(), cs, "merge test");
+
+    KisPaintLayerSP paintLayer = new KisPaintLayer(image, "test", OPACITY_OPAQUE_U8);
+
+    image->barrierLock();
+    image->addNode(paintLayer);
+    image->unlock();
+
+    KisTestableSimpleUpdateQueue queue;
+    KisWalkersList& walkersList = queue.getWalkersList();
+
+    queue.addUpdateJob(paintLayer, QRect(0,0,1000,1000), imageRect, 0);
+    QCOMPARE(walkersList.size(), 4);
+
+    queue.setPriorityRect(QRect(600,600,100,100));
+    queue.processQueue(context);
+
+    // the visible patch goes first...
+    QVector<KisUpdateJobItem*> jobs = context.getJobs();
+    QCOMPARE(jobs.size(), 1);
+    QVERIFY(checkWalker(jobs[0]->walker(), QRect(512,512,488,488)));
+
+    // ... and the rest keeps the original order
+    QCOMPARE(walkersList.size(), 3);
+    QVERIFY(checkWalker(walkersList[0], QRect(0,0,512,512)));
+    QVERIFY(checkWalker(walkersList[1], QRect(512,0,488,512)));
+    QVERIFY(checkWalker(walkersList[2], QRect(0,512,512,488)));
+
+    context.clear();
+
+    queue.setPriorityRect(QRect());
+    queue.processQueue(context);
+
+    jobs = context.getJobs();
+    QVERIFY(checkWalker(jobs[0]->walker(), QRect(0,0,512,512)));
+}
+
 void KisSimpleUpdateQueueTest::testChecksum()
 {
     QRect imageRect(0,0,512,512);
@@ -33,6 +33,8 @@ private Q_SLOTS:
     void testJobProcessing();
     void testSplitUpdate();
     void testSplitFullRefresh();
+    void testAdaptivePatchSize();
+    void testPriorityRect();
     void testChecksum();
     void testMixingTypes();
     void testSpontaneousJobsCompression();
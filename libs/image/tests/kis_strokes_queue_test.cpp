@@ -405,8 +405,9 @@ struct KisStrokesQueueTest::LodStrokesQueueTester {
             });
 
         queue.setLod0ToNStrokeStrategyFactory(
-            [] (bool forgettable) {
+            [this] (bool forgettable, int levelOfDetail, int sourceLevelOfDetail) {
                 Q_UNUSED(forgettable);
+                syncRequests << qMakePair(levelOfDetail, sourceLevelOfDetail);
                 return KisLodSyncPair(
                     new KisTestingStrokeStrategy(QLatin1String("sync_u_"), false, true, true),
                     QList<KisStrokeJobData*>());
@@ -414,6 +415,7 @@ struct KisStrokesQueueTest::LodStrokesQueueTester {
     }
 
     KisStrokesQueue queue;
+    QVector<QPair<int, int>> syncRequests;
 
     KisTestableUpdaterContext fakeContext;
     KisUpdaterContext realContext;
@@ -447,6 +449,13 @@ struct KisStrokesQueueTest::LodStrokesQueueTester {
         }
     }
 
+    void processAll() {
+        for (int i = 0; i < 64 && !queue.isEmpty(); i++) {
+            processQueue();
+        }
+        QVERIFY(queue.isEmpty());
+    }
+
     void checkNothing() {
         KIS_ASSERT(&context == &fakeContext);
 
@@ -580,6 +589,56 @@ void KisStrokesQueueTest::testStrokesLevelOfDetail()
     context.clear();
 }
 
+void KisStrokesQueueTest::testLodPyramidSync()
+{
+    typedef QPair<int, int> SyncRequest;
+
+    LodStrokesQueueTester t;
+    KisStrokesQueue &queue = t.queue;
+
+    queue.setDesiredLevelOfDetail(2);
+    t.processAll();
+
+    queue.setDesiredLevelOfDetail(1);
+    t.processAll();
+
+    // level 2 is still valid, so only the node caches are synced
+    queue.setDesiredLevelOfDetail(2);
+    t.processAll();
+
+    // level 3 is generated from level 2
+    queue.setDesiredLevelOfDetail(3);
+    t.processAll();
+
+    QCOMPARE(t.syncRequests,
+             QVector<SyncRequest>() << SyncRequest(2, 0) << SyncRequest(1, 0)
+                                    << SyncRequest(2, 2) << SyncRequest(3, 2));
+    t.syncRequests.clear();
+
+    // the image has been changed, all the caches are outdated
+    queue.notifyUFOChangedImage();
+    queue.setDesiredLevelOfDetail(2);
+    t.processAll();
+
+    QCOMPARE(t.syncRequests, QVector<SyncRequest>() << SyncRequest(2, 0));
+    t.syncRequests.clear();
+
+    // a stroke with a level of detail outdates the other levels
+    KisStrokeId id = queue.startStroke(new KisTestingStrokeStrategy(QLatin1String("lod_"), false, true));
+    queue.addJob(id, new KisTestingStrokeJobData(KisStrokeJobData::CONCURRENT));
+    queue.endStroke(id);
+    t.processAll();
+
+    queue.setDesiredLevelOfDetail(3);
+    t.processAll();
+
+    queue.setDesiredLevelOfDetail(1);
+    t.processAll();
+
+    QCOMPARE(t.syncRequests,
+             QVector<SyncRequest>() << SyncRequest(3, 2) << SyncRequest(1, 0));
+}
+
 #include <kundo2command.h>
 #include <kis_post_execution_undo_adapter.h>
 struct TestUndoCommand : public KUndo2Command
@@ -836,4 +895,144 @@ void KisStrokesQueueTest::testUniquelyConcurrentJobs()
 }
 
 
+#include <sdk/tests/testing_nodes.h>
+#include "kis_node_facade.h"
+
+struct PipelinedTestingNode : public TestUtil::DefaultNode
+{
+    KisNodeSP clone() const override {
+        return new PipelinedTestingNode(*this);
+    }
+};
+
+void processPipelinedStrokes(const KisNodeList &firstNodes,
+                             const KisNodeList &secondNodes,
+                             const KisNodeList &secondReadNodes,
+                             bool pipelined)
+{
+    KisStrokesQueue queue;
+
+    KisTestingStrokeStrategy *first = new KisTestingStrokeStrategy(QLatin1String("1_"));
+    first->setTestingAccessedNodes(firstNodes);
+    KisStrokeId id = queue.startStroke(first);
+    queue.addJob(id, new KisStrokeJobData(KisStrokeJobData::SEQUENTIAL));
+    queue.endStroke(id);
+
+    KisTestingStrokeStrategy *second = new KisTestingStrokeStrategy(QLatin1String("2_"));
+    second->setTestingAccessedNodes(secondNodes, secondReadNodes);
+    id = queue.startStroke(second);
+    queue.addJob(id, new KisStrokeJobData(KisStrokeJobData::SEQUENTIAL));
+    queue.endStroke(id);
+
+    KisTestableUpdaterContext context(2);
+    QVector<KisUpdateJobItem*> jobs;
+
+    queue.processQueue(context, false);
+
+    jobs = context.getJobs();
+    COMPARE_NAME(jobs[0], "1_init");
+    VERIFY_EMPTY(jobs[1]);
+
+    context.clear();
+    queue.processQueue(context, false);
+
+    jobs = context.getJobs();
+    COMPARE_NAME(jobs[0], "1_dab");
+    VERIFY_EMPTY(jobs[1]);
+
+    context.clear();
+    queue.processQueue(context, false);
+
+    jobs = context.getJobs();
+    COMPARE_NAME(jobs[0], "1_finish");
+
+    if (pipelined) {
+        COMPARE_NAME(jobs[1], "2_init");
+
+        context.clear();
+        queue.processQueue(context, false);
+
+        jobs = context.getJobs();
+        COMPARE_NAME(jobs[0], "2_dab");
+        VERIFY_EMPTY(jobs[1]);
+    } else {
+        VERIFY_EMPTY(jobs[1]);
+
+        context.clear();
+        queue.processQueue(context, false);
+
+        jobs = context.getJobs();
+        COMPARE_NAME(jobs[0], "2_init");
+        VERIFY_EMPTY(jobs[1]);
+
+        context.clear();
+        queue.processQueue(context, false);
+
+        jobs = context.getJobs();
+        COMPARE_NAME(jobs[0], "2_dab");
+        VERIFY_EMPTY(jobs[1]);
+    }
+
+    // the finishing job always waits for the previous stroke
+    context.clear();
+    queue.processQueue(context, false);
+
+    jobs = context.getJobs();
+    COMPARE_NAME(jobs[0], "2_finish");
+    VERIFY_EMPTY(jobs[1]);
+}
+
+void KisStrokesQueueTest::testPipelinedStrokes()
+{
+    KisNodeSP root = new PipelinedTestingNode();
+    KisNodeSP group = new PipelinedTestingNode();
+    KisNodeSP layer1 = new PipelinedTestingNode();
+    KisNodeSP layer2 = new PipelinedTestingNode();
+    KisNodeSP mask = new PipelinedTestingNode();
+
+    KisNodeFacade facade(root);
+    QVERIFY(facade.addNode(group, root));
+    QVERIFY(facade.addNode(layer1, group));
+    QVERIFY(facade.addNode(layer2, group));
+    QVERIFY(facade.addNode(mask, root));
+
+    // independent layers
+    processPipelinedStrokes({layer1}, {layer2}, {}, true);
+
+    // the same layer
+    processPipelinedStrokes({layer1}, {layer1}, {}, false);
+
+    // the parent group of the layer
+    processPipelinedStrokes({layer1}, {group}, {}, false);
+    processPipelinedStrokes({group}, {layer2}, {}, false);
+
+    // the second stroke reads the layer painted by the first one
+    processPipelinedStrokes({layer1}, {layer2}, {layer1}, false);
+    processPipelinedStrokes({layer1}, {layer2}, {mask}, true);
+
+    // undeclared nodes may be anything
+    processPipelinedStrokes({layer1}, {}, {}, false);
+    processPipelinedStrokes({}, {layer2}, {}, false);
+}
+
+void KisStrokesQueueTest::testPipelinedStrokeReadingImage()
+{
+    KisNodeSP root = new PipelinedTestingNode();
+    KisNodeSP layer1 = new PipelinedTestingNode();
+    KisNodeSP layer2 = new PipelinedTestingNode();
+
+    KisNodeFacade facade(root);
+    QVERIFY(facade.addNode(layer1, root));
+    QVERIFY(facade.addNode(layer2, root));
+
+    // a usual brush on another layer is pipelined
+    processPipelinedStrokes({layer1}, {layer2}, {}, true);
+
+    /**
+     * The clone and color smudge brushes declare the image root as
+     * read, so they should wait for the stroke on any other layer
+     */
+    processPipelinedStrokes({layer1}, {layer2}, {root}, false);
+}
+
 QTEST_MAIN(KisStrokesQueueTest)
@@ -37,10 +37,13 @@ private Q_SLOTS:
     void testOpenedStrokeCounter();
     void testAsyncCancelWhileOpenedStroke();
     void testStrokesLevelOfDetail();
+    void testLodPyramidSync();
     void testLodUndoBase();
     void testLodUndoBase2();
     void testMutatedJobs();
     void testUniquelyConcurrentJobs();
+    void testPipelinedStrokes();
+    void testPipelinedStrokeReadingImage();
 
 private:
     struct LodStrokesQueueTester;
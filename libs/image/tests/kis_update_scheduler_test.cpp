@@ -411,6 +411,66 @@ void KisUpdateSchedulerTest::testTimeMonitor()
     KisUpdateTimeMonitor::instance()->endStrokeMeasure();
 }
 
+#include <QTemporaryDir>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+void KisUpdateSchedulerTest::testUpdateTrace()
+{
+    KisUpdateTimeMonitor *monitor = KisUpdateTimeMonitor::instance();
+
+    KisImageSP image = buildTestingImage();
+    KisNodeSP paintLayer1 = image->root()->firstChild();
+
+    monitor->clearTrace();
+    monitor->setTracingEnabled(true);
+
+    image->refreshGraphAsync();
+    image->waitForDone();
+
+    paintLayer1->setDirty(QRect(10, 10, 100, 100));
+    image->waitForDone();
+
+    monitor->setTracingEnabled(false);
+
+    QTemporaryDir dir;
+    const QString fileName = dir.filePath("trace.json");
+    QVERIFY(monitor->exportChromeTrace(fileName));
+
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+
+    QJsonParseError error;
+    QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &error);
+    QCOMPARE(error.error, QJsonParseError::NoError);
+
+    int numThreadNames = 0;
+    int numMergeJobs = 0;
+    bool hasDirtyNode = false;
+
+    Q_FOREACH (const QJsonValue &value, doc.object()["traceEvents"].toArray()) {
+        const QJsonObject event = value.toObject();
+
+        if (event["ph"].toString() == "M") {
+            numThreadNames++;
+        } else if (event["cat"].toString() == "merge") {
+            QCOMPARE(event["ph"].toString(), QString("X"));
+            QVERIFY(event["dur"].toDouble() >= 0);
+            numMergeJobs++;
+
+            hasDirtyNode |=
+                event["args"].toObject()["node"].toString() == paintLayer1->name();
+        }
+    }
+
+    QVERIFY(numThreadNames > 0);
+    QVERIFY(numMergeJobs > 0);
+    QVERIFY(hasDirtyNode);
+
+    monitor->clearTrace();
+}
+
 void KisUpdateSchedulerTest::testLodSync()
 {
     KisImageSP image = buildTestingImage();
@@ -34,6 +34,8 @@
 #include "lod_override.h"
 #include "config-limit-long-tests.h"
 
+#include "../../sdk/tests/testutil.h"
+
 void KisUpdaterContextTest::testJobInterference()
 {
     KisTestableUpdaterContext context(3);
@@ -245,5 +247,48 @@ void KisUpdaterContextTest::stressTestExclusiveJobs()
              << "/" << NUM_CHECKS * NUM_JOBS;
 }
 
+void KisUpdaterContextTest::testMergeJobSplitting()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+
+    QRect imageRect(0,0,512,512);
+    KisImageSP image = new KisImage(0, imageRect.width(), imageRect.height(), cs, "split test");
+
+    KisPaintDeviceSP device1 = new KisPaintDevice(cs);
+    device1->fill(imageRect, KoColor(Qt::white, cs));
+    KisLayerSP paintLayer1 = new KisPaintLayer(image, "paint1", OPACITY_OPAQUE_U8, device1);
+
+    KisPaintDeviceSP device2 = new KisPaintDevice(cs);
+    device2->fill(QRect(100,100,300,200), KoColor(Qt::red, cs));
+    KisLayerSP paintLayer2 = new KisPaintLayer(image, "paint2", 128, device2);
+
+    image->addNode(paintLayer1, image->rootLayer());
+    image->addNode(paintLayer2, image->rootLayer());
+
+    image->initialRefreshGraph();
+
+    KisPaintDeviceSP referenceProjection = new KisPaintDevice(*image->projection());
+    image->projection()->clear();
+
+    KisUpdaterContext context(4);
+    context.setSubtaskSize(64);
+
+    KisBaseRectsWalkerSP walker = new KisMergeWalker(imageRect);
+    walker->collectRects(paintLayer2, imageRect);
+
+    QCOMPARE(context.splitMergeJob(walker).size(), 64);
+
+    context.lock();
+    context.addMergeJob(walker);
+    context.unlock();
+
+    context.waitForDone();
+
+    QPoint pt;
+    if (!TestUtil::comparePaintDevices(pt, referenceProjection, image->projection())) {
+        QFAIL(QString("Split merge job gave a different result at %1,%2").arg(pt.x()).arg(pt.y()).toLatin1());
+    }
+}
+
 QTEST_MAIN(KisUpdaterContextTest)
 
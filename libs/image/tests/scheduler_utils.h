@@ -251,6 +251,11 @@ public:
         return new KisTestingStrokeStrategy(*this, levelOfDetail);
     }
 
+    void setTestingAccessedNodes(const KisNodeList &modifiedNodes,
+                                 const KisNodeList &readNodes = KisNodeList()) {
+        setAccessedNodes(modifiedNodes, readNodes);
+    }
+
     class CancelData : public KisStrokeJobData
     {
     public:
@@ -0,0 +1,269 @@
+/*
+ *  Copyright (c) 2020 Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "KisTileDataSlabAllocator.h"
+
+#include <QGlobalStatic>
+#include <QMutex>
+#include <QSet>
+#include <QVector>
+
+#include <cstdlib>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#include "kis_tile_data_interface.h"
+#include "kis_image_config.h"
+#include "kis_debug.h"
+
+Q_GLOBAL_STATIC(KisTileDataSlabAllocator, s_instance)
+
+const qint32 KisTileDataSlabAllocator::MAX_POOLED_PIXEL_SIZE;
+const qint64 KisTileDataSlabAllocator::ARENA_SIZE;
+
+namespace {
+
+quint8* mapArena(qint64 size, bool useHugePages)
+{
+#ifdef Q_OS_WIN
+    Q_UNUSED(useHugePages);
+    return static_cast<quint8*>(VirtualAlloc(0, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+#else
+    void *ptr = mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED) return 0;
+
+#ifdef MADV_HUGEPAGE
+    if (useHugePages) {
+        madvise(ptr, size, MADV_HUGEPAGE);
+    }
+#else
+    Q_UNUSED(useHugePages);
+#endif
+
+    return static_cast<quint8*>(ptr);
+#endif
+}
+
+void unmapArena(quint8 *ptr, qint64 size)
+{
+#ifdef Q_OS_WIN
+    Q_UNUSED(size);
+    VirtualFree(ptr, 0, MEM_RELEASE);
+#else
+    munmap(ptr, size);
+#endif
+}
+
+}
+
+struct KisTileDataSlabAllocator::Private
+{
+    struct Arena {
+        quint8 *ptr;
+        qint64 size;
+    };
+
+    /**
+     * The free chunks are linked into a list through their own
+     * memory, the first bytes of a free chunk hold the pointer to
+     * the next one
+     */
+    struct FreeChunk {
+        FreeChunk *next;
+    };
+
+    /**
+     * A slab serves a single pixel size. All the fields are guarded
+     * by the lock. In the usual allocate/free cycle of the tiles the
+     * lock is held only for popping/pushing the head of the free list.
+     */
+    struct Slab {
+        FreeChunk *freeChunks = 0;
+
+        QMutex lock;
+        qint64 chunkSize = 0;
+
+        quint8 *bumpPtr = 0;
+        quint8 *bumpEnd = 0;
+
+        QVector<Arena> arenas;
+
+        /**
+         * When the system refuses to map a new arena, the chunks
+         * are allocated with malloc(). They must be returned with
+         * ::free() and never appear in the free list.
+         */
+        QSet<quint8*> fallbackChunks;
+
+        qint64 usedSize = 0;
+    };
+
+    Slab slabs[MAX_POOLED_PIXEL_SIZE + 1];
+    bool useHugePages = false;
+
+    quint8* allocateFromSlab(Slab &slab);
+    void freeToSlab(Slab &slab, quint8 *ptr);
+};
+
+quint8* KisTileDataSlabAllocator::Private::allocateFromSlab(Slab &slab)
+{
+    quint8 *ptr = 0;
+    QMutexLocker l(&slab.lock);
+
+    if (slab.freeChunks) {
+        ptr = reinterpret_cast<quint8*>(slab.freeChunks);
+        slab.freeChunks = slab.freeChunks->next;
+    } else {
+        if (slab.bumpPtr + slab.chunkSize > slab.bumpEnd) {
+            const qint64 arenaSize =
+                qMax(ARENA_SIZE / slab.chunkSize, qint64(16)) * slab.chunkSize;
+
+            quint8 *arena = mapArena(arenaSize, useHugePages);
+            if (!arena) {
+                warnKrita << "WARNING: failed to map a new arena for the tiles of size" << slab.chunkSize;
+
+                ptr = (quint8*) malloc(slab.chunkSize);
+                if (ptr) {
+                    slab.fallbackChunks.insert(ptr);
+                }
+
+                return ptr;
+            }
+
+            slab.arenas.append({arena, arenaSize});
+            slab.bumpPtr = arena;
+            slab.bumpEnd = arena + arenaSize;
+        }
+
+        ptr = slab.bumpPtr;
+        slab.bumpPtr += slab.chunkSize;
+    }
+
+    slab.usedSize += slab.chunkSize;
+    return ptr;
+}
+
+void KisTileDataSlabAllocator::Private::freeToSlab(Slab &slab, quint8 *ptr)
+{
+    QMutexLocker l(&slab.lock);
+
+    if (!slab.fallbackChunks.isEmpty() && slab.fallbackChunks.remove(ptr)) {
+        ::free(ptr);
+        return;
+    }
+
+    FreeChunk *chunk = reinterpret_cast<FreeChunk*>(ptr);
+    chunk->next = slab.freeChunks;
+    slab.freeChunks = chunk;
+
+    slab.usedSize -= slab.chunkSize;
+}
+
+KisTileDataSlabAllocator::KisTileDataSlabAllocator()
+    : m_d(new Private)
+{
+    for (int i = 1; i <= MAX_POOLED_PIXEL_SIZE; i++) {
+        m_d->slabs[i].chunkSize = qint64(i) * __TILE_DATA_WIDTH * __TILE_DATA_HEIGHT;
+    }
+
+    KisImageConfig cfg(true);
+    m_d->useHugePages = cfg.useTileDataHugePages();
+}
+
+KisTileDataSlabAllocator::~KisTileDataSlabAllocator()
+{
+    purge();
+}
+
+KisTileDataSlabAllocator *KisTileDataSlabAllocator::instance()
+{
+    return s_instance;
+}
+
+bool KisTileDataSlabAllocator::isPooled(qint32 pixelSize)
+{
+    return pixelSize > 0 && pixelSize <= MAX_POOLED_PIXEL_SIZE;
+}
+
+bool KisTileDataSlabAllocator::isDestroyed()
+{
+    return s_instance.isDestroyed();
+}
+
+quint8* KisTileDataSlabAllocator::allocate(qint32 pixelSize)
+{
+    return isPooled(pixelSize) ?
+        m_d->allocateFromSlab(m_d->slabs[pixelSize]) :
+        (quint8*) malloc(pixelSize * __TILE_DATA_WIDTH * __TILE_DATA_HEIGHT);
+}
+
+void KisTileDataSlabAllocator::free(quint8 *ptr, qint32 pixelSize)
+{
+    if (isPooled(pixelSize)) {
+        m_d->freeToSlab(m_d->slabs[pixelSize], ptr);
+    } else {
+        ::free(ptr);
+    }
+}
+
+void KisTileDataSlabAllocator::purge()
+{
+    for (int i = 1; i <= MAX_POOLED_PIXEL_SIZE; i++) {
+        Private::Slab &slab = m_d->slabs[i];
+        QMutexLocker l(&slab.lock);
+
+        slab.freeChunks = 0;
+
+        Q_FOREACH (const Private::Arena &arena, slab.arenas) {
+            unmapArena(arena.ptr, arena.size);
+        }
+
+        Q_FOREACH (quint8 *ptr, slab.fallbackChunks) {
+            ::free(ptr);
+        }
+
+        slab.arenas.clear();
+        slab.fallbackChunks.clear();
+        slab.bumpPtr = 0;
+        slab.bumpEnd = 0;
+        slab.usedSize = 0;
+    }
+}
+
+KisTileDataSlabAllocator::Statistics KisTileDataSlabAllocator::statistics() const
+{
+    Statistics stats;
+
+    for (int i = 1; i <= MAX_POOLED_PIXEL_SIZE; i++) {
+        Private::Slab &slab = m_d->slabs[i];
+        QMutexLocker l(&slab.lock);
+
+        Q_FOREACH (const Private::Arena &arena, slab.arenas) {
+            stats.reservedSize += arena.size;
+        }
+
+        stats.numArenas += slab.arenas.size();
+        stats.usedSize += slab.usedSize;
+    }
+
+    return stats;
+}
@@ -0,0 +1,90 @@
+/*
+ *  Copyright (c) 2020 Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KISTILEDATASLABALLOCATOR_H
+#define KISTILEDATASLABALLOCATOR_H
+
+#include "kritaimage_export.h"
+
+#include <QtGlobal>
+#include <QScopedPointer>
+
+/**
+ * Allocates the memory blobs for the tile data objects.
+ *
+ * Every pixel size up to MAX_POOLED_PIXEL_SIZE (that covers all the
+ * colorspaces shipped with Krita, including 64-bit float RGBA) has
+ * its own slab. A slab carves tile-sized chunks out of large arenas
+ * mapped directly from the system, so the tiles do not fragment the
+ * general-purpose heap. Freed chunks are kept in an intrusive free
+ * list (the link is stored in the freed chunk itself, so freeing never
+ * allocates) and reused by the following allocations of the same pixel
+ * size. Every slab has its own lock, which is held only for a couple of
+ * pointer operations unless the slab needs to grow.
+ *
+ * The arenas can optionally be marked as eligible for transparent
+ * huge pages (see KisImageConfig::useTileDataHugePages()).
+ *
+ * Tiles with bigger pixel sizes are allocated with malloc().
+ */
+class KRITAIMAGE_EXPORT KisTileDataSlabAllocator
+{
+public:
+    struct Statistics {
+        qint64 reservedSize = 0;
+        qint64 usedSize = 0;
+        qint64 numArenas = 0;
+    };
+
+public:
+    KisTileDataSlabAllocator();
+    ~KisTileDataSlabAllocator();
+
+    static KisTileDataSlabAllocator* instance();
+
+    /**
+     * \return true if the global instance has already been destroyed
+     * during the static destruction. After that the arenas are unmapped
+     * and instance() returns null.
+     */
+    static bool isDestroyed();
+
+    static bool isPooled(qint32 pixelSize);
+
+    quint8* allocate(qint32 pixelSize);
+    void free(quint8 *ptr, qint32 pixelSize);
+
+    /**
+     * Returns all the arenas back to the system. All the chunks
+     * become invalid, so the caller must ensure none of them is
+     * used anymore.
+     */
+    void purge();
+
+    Statistics statistics() const;
+
+public:
+    static const qint32 MAX_POOLED_PIXEL_SIZE = 32;
+    static const qint64 ARENA_SIZE = 4 * (1 << 20);
+
+private:
+    struct Private;
+    const QScopedPointer<Private> m_d;
+};
+
+#endif // KISTILEDATASLABALLOCATOR_H
@@ -53,27 +53,27 @@ inline bool KisTiledExtentManager::Data::add(qint32 index)
         currentIndex = m_offset + index;
     }
 
-    KIS_ASSERT_RECOVER_NOOP(m_buffer[currentIndex].loadAcquire() >= 0);
-    bool needsUpdateExtent = false;
-    QReadLocker rl(&m_extentLock);
-
-    if (!m_buffer[currentIndex].loadAcquire()) {
-        rl.unlock();
-        QWriteLocker wl(&m_extentLock);
+    QAtomicInt &counter = m_buffer[currentIndex];
+    KIS_ASSERT_RECOVER_NOOP(counter.loadAcquire() >= 0);
+
+    // fast path: the index is already present, so the extent cannot change
+    int oldValue = counter.loadAcquire();
+    while (oldValue > 0) {
+        if (counter.testAndSetOrdered(oldValue, oldValue + 1)) {
+            return false;
+        }
+        oldValue = counter.loadAcquire();
+    }
 
-        if (!m_buffer[currentIndex].load()) {
-            m_buffer[currentIndex].store(1);
+    bool needsUpdateExtent = false;
+    QMutexLocker l(&m_extentMutex);
 
-            if (m_min > index) m_min = index;
-            if (m_max < index) m_max = index;
+    if (!counter.fetchAndAddOrdered(1)) {
+        if (m_min > index) m_min = index;
+        if (m_max < index) m_max = index;
 
-            ++m_count;
-            needsUpdateExtent = true;
-        } else {
-            m_buffer[currentIndex].ref();
-        }
-    } else {
-        m_buffer[currentIndex].ref();
+        ++m_count;
+        needsUpdateExtent = true;
     }
 
     return needsUpdateExtent;
@@ -84,27 +84,27 @@ inline bool KisTiledExtentManager::Data::remove(qint32 index)
     QReadLocker lock(&m_migrationLock);
     qint32 currentIndex = m_offset + index;
 
-    KIS_ASSERT_RECOVER_NOOP(m_buffer[currentIndex].loadAcquire() > 0);
-    bool needsUpdateExtent = false;
-    QReadLocker rl(&m_extentLock);
+    QAtomicInt &counter = m_buffer[currentIndex];
+    KIS_ASSERT_RECOVER_NOOP(counter.loadAcquire() > 0);
 
-    if (m_buffer[currentIndex].loadAcquire() == 1) {
-        rl.unlock();
-        QWriteLocker wl(&m_extentLock);
+    // fast path: the index is still used by other tiles
+    int oldValue = counter.loadAcquire();
+    while (oldValue > 1) {
+        if (counter.testAndSetOrdered(oldValue, oldValue - 1)) {
+            return false;
+        }
+        oldValue = counter.loadAcquire();
+    }
 
-        if (m_buffer[currentIndex].load() == 1) {
-            m_buffer[currentIndex].store(0);
+    bool needsUpdateExtent = false;
+    QMutexLocker l(&m_extentMutex);
 
-            if (m_min == index) updateMin();
-            if (m_max == index) updateMax();
+    if (counter.fetchAndSubOrdered(1) == 1) {
+        if (m_min == index) updateMin();
+        if (m_max == index) updateMax();
 
-            --m_count;
-            needsUpdateExtent = true;
-        } else {
-            m_buffer[currentIndex].deref();
-        }
-    } else {
-        m_buffer[currentIndex].deref();
+        --m_count;
+        needsUpdateExtent = true;
     }
 
     return needsUpdateExtent;
@@ -113,7 +113,7 @@ inline bool KisTiledExtentManager::Data::remove(qint32 index)
 void KisTiledExtentManager::Data::replace(const QVector<qint32> &indexes)
 {
     QWriteLocker lock(&m_migrationLock);
-    QWriteLocker l(&m_extentLock);
+    QMutexLocker l(&m_extentMutex);
 
     for (qint32 i = 0; i < m_capacity; ++i) {
         m_buffer[i].store(0);
@@ -131,7 +131,7 @@ void KisTiledExtentManager::Data::replace(const QVector<qint32> &indexes)
 void KisTiledExtentManager::Data::clear()
 {
     QWriteLocker lock(&m_migrationLock);
-    QWriteLocker l(&m_extentLock);
+    QMutexLocker l(&m_extentMutex);
 
     for (qint32 i = 0; i < m_capacity; ++i) {
         m_buffer[i].store(0);
@@ -236,9 +236,12 @@ void KisTiledExtentManager::Data::updateMax()
 }
 
 KisTiledExtentManager::KisTiledExtentManager()
+    : m_extentSeqNo(0),
+      m_extentX(0),
+      m_extentY(0),
+      m_extentWidth(0),
+      m_extentHeight(0)
 {
-    QWriteLocker l(&m_extentLock);
-    m_currentExtent = QRect();
 }
 
 void KisTiledExtentManager::notifyTileAdded(qint32 col, qint32 row)
@@ -285,22 +288,57 @@ void KisTiledExtentManager::clear()
     m_colsData.clear();
     m_rowsData.clear();
 
-    QWriteLocker lock(&m_extentLock);
-    m_currentExtent = QRect();
+    QMutexLocker l(&m_updateMutex);
+    publishExtent(QRect());
 }
 
 QRect KisTiledExtentManager::extent() const
 {
-    QReadLocker lock(&m_extentLock);
-    return m_currentExtent;
+    int seqNo = 0;
+    QRect rect;
+
+    do {
+        seqNo = m_extentSeqNo.loadAcquire();
+
+        rect = QRect(m_extentX.loadAcquire(),
+                     m_extentY.loadAcquire(),
+                     m_extentWidth.loadAcquire(),
+                     m_extentHeight.loadAcquire());
+
+    } while ((seqNo & 0x1) || seqNo != m_extentSeqNo.loadAcquire());
+
+    return rect;
+}
+
+void KisTiledExtentManager::publishExtent(const QRect &rect)
+{
+    /**
+     * Called with m_updateMutex held, so there is only one writer
+     */
+    const int seqNo = m_extentSeqNo.load();
+
+    m_extentSeqNo.store(seqNo + 1);
+    m_extentX.storeRelease(rect.x());
+    m_extentY.storeRelease(rect.y());
+    m_extentWidth.storeRelease(rect.width());
+    m_extentHeight.storeRelease(rect.height());
+    m_extentSeqNo.storeRelease(seqNo + 2);
 }
 
 void KisTiledExtentManager::updateExtent()
 {
+    /**
+     * The extent is calculated under the update mutex, so the
+     * last writer always publishes the most recent state of the
+     * counters, even if several threads call updateExtent()
+     * concurrently.
+     */
+    QMutexLocker l(&m_updateMutex);
+
     qint32 minX, width, minY, height;
 
     {
-        QReadLocker cl(&m_colsData.m_extentLock);
+        QMutexLocker cl(&m_colsData.m_extentMutex);
 
         if (m_colsData.isEmpty()) {
             minX = 0;
@@ -312,7 +350,7 @@ void KisTiledExtentManager::updateExtent()
     }
 
     {
-        QReadLocker rl(&m_rowsData.m_extentLock);
+        QMutexLocker rl(&m_rowsData.m_extentMutex);
 
         if (m_rowsData.isEmpty()) {
             minY = 0;
@@ -323,6 +361,5 @@ void KisTiledExtentManager::updateExtent()
         }
     }
 
-    QWriteLocker lock(&m_extentLock);
-    m_currentExtent = QRect(minX, minY, width, height);
+    publishExtent(QRect(minX, minY, width, height));
 }
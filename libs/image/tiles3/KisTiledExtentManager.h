@@ -22,6 +22,7 @@
 
 #include <QMutex>
 #include <QReadWriteLock>
+#include <QAtomicInt>
 #include <QMap>
 #include <QRect>
 #include "kritaimage_export.h"
@@ -46,7 +47,13 @@ class KRITAIMAGE_EXPORT KisTiledExtentManager
         qint32 max();
 
     public:
-        QReadWriteLock m_extentLock;
+        /**
+         * Guards transitions of the counters from zero to one and
+         * back, that is the only moments when the min/max values
+         * can change. All other changes to the counters are done
+         * with atomic operations only.
+         */
+        QMutex m_extentMutex;
 
     private:
         inline void unsafeAdd(qint32 index);
@@ -76,10 +83,21 @@ public:
 
 private:
     void updateExtent();
+    void publishExtent(const QRect &rect);
 
 private:
-    mutable QReadWriteLock m_extentLock;
-    QRect m_currentExtent;
+    /**
+     * The extent is published with a sequence lock, so that extent()
+     * never blocks: the readers just retry when the sequence number
+     * is odd or has changed while they were reading the values.
+     */
+    QMutex m_updateMutex;
+    QAtomicInt m_extentSeqNo;
+    QAtomicInt m_extentX;
+    QAtomicInt m_extentY;
+    QAtomicInt m_extentWidth;
+    QAtomicInt m_extentHeight;
+
     Data m_colsData;
     Data m_rowsData;
 };
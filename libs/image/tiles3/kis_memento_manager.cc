@@ -187,6 +187,10 @@ void KisMementoManager::commit()
     KisMementoItemSP parentMI;
     bool newTile;
 
+    KisTileDataStore *store = KisTileDataStore::instance();
+    const bool collectDeltas = store->historyDeltasEnabled();
+    QVector<KisSwappedDataStore::DeltaCandidate> deltaCandidates;
+
     KisMementoItemHashTableIterator iter(&m_index);
     while ((mi = iter.tile())) {
         parentMI = m_headsHashTable.getTileLazy(mi->col(), mi->row(), newTile);
@@ -195,6 +199,17 @@ void KisMementoManager::commit()
         mi->commit();
         revisionList.append(mi);
 
+        /**
+         * The parent's tile data is now referenced by the history
+         * only, so it can be stored as a delta against ours
+         */
+        if (collectDeltas &&
+            mi->type() == KisMementoItem::CHANGED &&
+            parentMI->type() == KisMementoItem::CHANGED) {
+
+            deltaCandidates.append(qMakePair(parentMI->tileData(), mi->tileData()));
+        }
+
         m_headsHashTable.deleteTile(mi->col(), mi->row());
 
         iter.moveCurrentToHashTable(&m_headsHashTable);
@@ -206,13 +221,38 @@ void KisMementoManager::commit()
     hItem.memento = m_currentMemento.data();
     m_revisions.append(hItem);
 
+    /**
+     * The revision that has just got older than the in-memory
+     * limit can live in the swap file until someone undoes it
+     */
+    const int revisionsInMemory = store->undoRevisionsInMemory();
+    if (revisionsInMemory > 0 && m_revisions.size() > revisionsInMemory) {
+        const KisHistoryItem &oldItem =
+            m_revisions[m_revisions.size() - 1 - revisionsInMemory];
+
+        QVector<KisTileData*> spillCandidates;
+        Q_FOREACH (KisMementoItemSP oldMI, oldItem.itemList) {
+            if (oldMI->type() == KisMementoItem::CHANGED) {
+                spillCandidates.append(oldMI->tileData());
+            }
+        }
+
+        if (!spillCandidates.isEmpty()) {
+            store->addHistorySpillCandidates(spillCandidates);
+        }
+    }
+
     m_currentMemento = 0;
     Q_ASSERT(m_index.isEmpty());
 
     DEBUG_DUMP_MESSAGE("COMMIT_DONE");
 
+    if (!deltaCandidates.isEmpty()) {
+        store->addHistoryDeltaCandidates(deltaCandidates);
+    }
+
     // Waking up pooler to prepare copies for us
-    KisTileDataStore::instance()->kickPooler();
+    store->kickPooler();
 }
 
 KisTileSP KisMementoManager::getCommitedTile(qint32 col, qint32 row, bool &existingTile)
@@ -390,6 +430,11 @@ void KisMementoManager::setDefaultTileData(KisTileData *defaultTileData)
     m_index.setDefaultTileData(defaultTileData);
 }
 
+KisTileData* KisMementoManager::defaultTileData()
+{
+    return m_headsHashTable.defaultTileData();
+}
+
 void KisMementoManager::debugPrintInfo()
 {
     printf("KisMementoManager stats:\n");
@@ -43,7 +43,7 @@ typedef KisSharedPtr<KisMemento> KisMementoSP;
 
 typedef KisTileHashTableTraits2<KisMementoItem> KisMementoItemHashTable;
 typedef KisTileHashTableIteratorTraits2<KisMementoItem> KisMementoItemHashTableIterator;
-typedef KisTileHashTableIteratorTraits2<KisMementoItem> KisMementoItemHashTableIteratorConst;
+typedef KisTileHashTableSnapshotIteratorTraits2<KisMementoItem> KisMementoItemHashTableIteratorConst;
 #else
 #include "kis_tile_hash_table.h"
 
@@ -113,6 +113,7 @@ public:
     KisMementoSP currentMemento();
 
     void setDefaultTileData(KisTileData *defaultTileData);
+    KisTileData* defaultTileData();
 
     void debugPrintInfo();
 
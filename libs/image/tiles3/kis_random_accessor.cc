@@ -69,6 +69,7 @@ void KisRandomAccessor2::moveTo(qint32 x, qint32 y)
             offset *= m_pixelSize;
             m_data = kti->data + offset;
             m_oldData = kti->oldData + offset;
+            m_isUniform = kti->isUniform;
             if (i > 0) {
                 memmove(m_tilesCache + 1, m_tilesCache, i * sizeof(KisTileInfo*));
                 m_tilesCache[0] = kti;
@@ -91,6 +92,7 @@ void KisRandomAccessor2::moveTo(qint32 x, qint32 y)
     offset *= m_pixelSize;
     m_data = kti->data + offset;
     m_oldData = kti->oldData + offset;
+    m_isUniform = kti->isUniform;
     memmove(m_tilesCache + 1, m_tilesCache, (KisRandomAccessor2::CACHESIZE - 1) * sizeof(KisTileInfo*));
     m_tilesCache[0] = kti;
 }
@@ -124,6 +126,12 @@ KisRandomAccessor2::KisTileInfo* KisRandomAccessor2::fetchTileData(qint32 col, q
     lockTile(kti->tile);
     kti->data = kti->tile->data();
 
+    /**
+     * NOTE: locking for writing resets the flag, so only
+     *       read-only accessors can see uniform tiles
+     */
+    kti->isUniform = kti->tile->tileData()->isUniform();
+
     lockOldTile(kti->oldtile);
     kti->oldData = kti->oldtile->data();
 
@@ -150,6 +158,16 @@ qint32 KisRandomAccessor2::rowStride(qint32 x, qint32 y) const
     return m_ktm->rowStride(x - m_offsetX, y - m_offsetY);
 }
 
+void KisRandomAccessor2::prefetch(const QRect &rect)
+{
+    m_ktm->prefetchTiles(rect.translated(-m_offsetX, -m_offsetY));
+}
+
+bool KisRandomAccessor2::isUniform() const
+{
+    return m_isUniform;
+}
+
 qint32 KisRandomAccessor2::x() const
 {
     return m_lastX;
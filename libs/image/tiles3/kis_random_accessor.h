@@ -35,6 +35,7 @@ class KisRandomAccessor2 : public KisRandomAccessorNG
         KisTileSP oldtile;
         quint8* data;
         const quint8* oldData;
+        bool isUniform;
         qint32 area_x1, area_y1, area_x2, area_y2;
     };
 
@@ -88,6 +89,8 @@ public:
     qint32 numContiguousColumns(qint32 x) const override;
     qint32 numContiguousRows(qint32 y) const override;
     qint32 rowStride(qint32 x, qint32 y) const override;
+    void prefetch(const QRect &rect) override;
+    bool isUniform() const override;
     qint32 x() const override;
     qint32 y() const override;
 
@@ -98,6 +101,7 @@ private:
     qint32 m_pixelSize;
     quint8* m_data;
     const quint8* m_oldData;
+    bool m_isUniform;
     bool m_writable;
     int m_lastX, m_lastY;
     qint32 m_offsetX, m_offsetY;
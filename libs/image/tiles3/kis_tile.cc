@@ -25,6 +25,15 @@
 #include "kis_debug.h"
 
 
+namespace {
+QAtomicInt s_currentWriteEpoch;
+}
+
+int KisTile::startNewWriteEpoch()
+{
+    return s_currentWriteEpoch.fetchAndAddOrdered(1);
+}
+
 void KisTile::init(qint32 col, qint32 row,
                    KisTileData *defaultTileData, KisMementoManager* mm)
 {
@@ -35,6 +44,8 @@ void KisTile::init(qint32 col, qint32 row,
     m_extent = QRect(m_col * KisTileData::WIDTH, m_row * KisTileData::HEIGHT,
                      KisTileData::WIDTH, KisTileData::HEIGHT);
 
+    m_writeEpoch.storeRelease(s_currentWriteEpoch.loadAcquire());
+
     m_tileData = defaultTileData;
     m_tileData->acquire();
 
@@ -149,6 +160,53 @@ void KisTile::notifyAttachedToDataManager(KisMementoManager *mm)
 #endif
 }
 
+bool KisTile::replaceWithUniformData(KisTileData *td)
+{
+    /**
+     * Take the locks in the same order as lockForWrite() does:
+     * first the COW mutex, then the swap barrier. While we hold
+     * the barrier and the lock counter is zero, nobody can start
+     * reading or writing the tile.
+     */
+    QMutexLocker cowLocker(&m_COWMutex);
+    QMutexLocker barrierLocker(&m_swapBarrierLock);
+
+    if (m_lockCounter || m_tileData == td) return false;
+
+    m_tileData->blockSwapping();
+    td->blockSwapping();
+    const bool sameContent =
+        !memcmp(m_tileData->data(), td->data(), KisTileData::WIDTH * KisTileData::HEIGHT * td->pixelSize());
+    td->unblockSwapping();
+    m_tileData->unblockSwapping();
+
+    if (!sameContent) return false;
+
+    td->acquire();
+    KisTileData *oldTileData = m_tileData;
+    m_tileData = td;
+    oldTileData->release();
+
+    /**
+     * The content of the tile has not changed, so we do not register
+     * the change in the memento manager, otherwise the user would get
+     * an undo step for a change they have never made
+     */
+
+    return true;
+}
+
+bool KisTile::isDataLoaded() const
+{
+    /**
+     * The old tile data is released under the barrier lock only,
+     * so the data we are looking at will stay alive until we
+     * release it
+     */
+    QMutexLocker locker(&m_swapBarrierLock);
+    return m_tileData->data();
+}
+
 //#define DEBUG_TILE_LOCKING
 //#define DEBUG_TILE_COWING
 
@@ -178,12 +236,35 @@ inline void KisTile::blockSwapping() const
     QMutexLocker locker(&m_swapBarrierLock);
     Q_ASSERT(m_lockCounter >= 0);
 
-    if(!m_lockCounter++)
+    if(!m_lockCounter++) {
         m_tileData->blockSwapping();
 
+        if (m_tileData->isLost()) {
+            recoverLostData();
+        }
+    }
+
     Q_ASSERT(data());
 }
 
+void KisTile::recoverLostData() const
+{
+    /**
+     * The memento manager shares the default tile data with the data
+     * manager, so we can take the default pixel from there
+     */
+    KisMementoManager *mm = m_mementoManager.load();
+    KisTileData *defaultTileData = mm ? mm->defaultTileData() : 0;
+
+    if (defaultTileData && defaultTileData != m_tileData) {
+        defaultTileData->blockSwapping();
+        m_tileData->fillWithPixel(defaultTileData->data());
+        defaultTileData->unblockSwapping();
+    }
+
+    m_tileData->setLost(false);
+}
+
 inline void KisTile::unblockSwapping() const
 {
     QMutexLocker locker(&m_swapBarrierLock);
@@ -269,11 +350,24 @@ void KisTile::lockForWrite()
 #endif
     }
 
+    /**
+     * The tile data is owned by this tile only now, so
+     * the caller is free to write anything into it
+     */
+    m_tileData->setUniform(false);
+
     DEBUG_LOG_ACTION("lock [W]");
 }
 
 void KisTile::unlockForWrite()
 {
+    /**
+     * The tile is stamped when the write is finished, so a reader
+     * that has started a new epoch while the tile was being written
+     * will see the tile as changed
+     */
+    m_writeEpoch.storeRelease(s_currentWriteEpoch.loadAcquire());
+
     unblockSwapping();
     DEBUG_LOG_ACTION("unlock [W]");
 
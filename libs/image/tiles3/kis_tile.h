@@ -82,6 +82,26 @@ public:
      */
     void notifyAttachedToDataManager(KisMementoManager *mm);
 
+    /**
+     * Replaces the tile data of the tile with a shared uniform tile
+     * data \p td in place, so the tile stays in the hash table all the
+     * time and concurrent readers never see a missing tile.
+     *
+     * The replacement happens only if nobody holds a lock on the tile
+     * and its data still consists of the pixels of \p td only.
+     *
+     * \return true if the tile data has been replaced
+     */
+    bool replaceWithUniformData(KisTileData *td);
+
+    /**
+     * Checks if the tile data is present in memory. The tile data
+     * cannot be released while the check is in progress, but the
+     * result may become outdated right after the call, so it should
+     * be used as a hint only.
+     */
+    bool isDataLoaded() const;
+
 public:
 
     void debugPrintInfo();
@@ -131,6 +151,23 @@ public:
         return m_tileData;
     }
 
+    /**
+     * Every tile is stamped with the current write epoch when it is
+     * created and when a write access to it is finished. Comparing
+     * the stamp with a value returned by startNewWriteEpoch() tells
+     * if the tile has been changed after that moment.
+     */
+    inline int writeEpoch() const {
+        return m_writeEpoch.loadAcquire();
+    }
+
+    /**
+     * Starts a new write epoch and returns the previous one. All the
+     * writes finished before the call have epoch less or equal to
+     * the returned value, all the later ones have a greater value.
+     */
+    static int startNewWriteEpoch();
+
 private:
     void init(qint32 col, qint32 row,
               KisTileData *defaultTileData, KisMementoManager* mm);
@@ -138,6 +175,8 @@ private:
     inline void blockSwapping() const;
     inline void unblockSwapping() const;
 
+    void recoverLostData() const;
+
     inline void safeReleaseOldTileData(KisTileData *td);
 
 private:
@@ -153,6 +192,8 @@ private:
      */
     QRect m_extent;
 
+    QAtomicInt m_writeEpoch;
+
     /**
      * For KisTiledDataManager's hash table
      */
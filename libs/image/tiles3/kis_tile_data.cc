@@ -23,48 +23,17 @@
 
 #include <kis_debug.h>
 
-#include <boost/pool/singleton_pool.hpp>
 #include "kis_tile_data_store_iterators.h"
-
-// BPP == bytes per pixel
-#define TILE_SIZE_4BPP (4 * __TILE_DATA_WIDTH * __TILE_DATA_HEIGHT)
-#define TILE_SIZE_8BPP (8 * __TILE_DATA_WIDTH * __TILE_DATA_HEIGHT)
-
-typedef boost::singleton_pool<KisTileData, TILE_SIZE_4BPP, boost::default_user_allocator_new_delete, boost::details::pool::default_mutex, 256, 4096> BoostPool4BPP;
-typedef boost::singleton_pool<KisTileData, TILE_SIZE_8BPP, boost::default_user_allocator_new_delete, boost::details::pool::default_mutex, 128, 2048> BoostPool8BPP;
+#include "KisTileDataSlabAllocator.h"
 
 const qint32 KisTileData::WIDTH = __TILE_DATA_WIDTH;
 const qint32 KisTileData::HEIGHT = __TILE_DATA_HEIGHT;
 
-SimpleCache KisTileData::m_cache;
-
-SimpleCache::~SimpleCache()
-{
-    clear();
-}
-
-void SimpleCache::clear()
-{
-    QWriteLocker l(&m_cacheLock);
-    quint8 *ptr = 0;
-
-    while (m_4Pool.pop(ptr)) {
-        BoostPool4BPP::free(ptr);
-    }
-
-    while (m_8Pool.pop(ptr)) {
-        BoostPool8BPP::free(ptr);
-    }
-
-    while (m_16Pool.pop(ptr)) {
-        free(ptr);
-    }
-}
-
-
 KisTileData::KisTileData(qint32 pixelSize, const quint8 *defPixel, KisTileDataStore *store, bool checkFreeMemory)
     : m_state(NORMAL),
       m_mementoFlag(0),
+      m_isUniform(true),
+      m_isLost(false),
       m_age(0),
       m_usersCount(0),
       m_refCount(0),
@@ -94,6 +63,8 @@ KisTileData::KisTileData(qint32 pixelSize, const quint8 *defPixel, KisTileDataSt
 KisTileData::KisTileData(const KisTileData& rhs, bool checkFreeMemory)
     : m_state(NORMAL),
       m_mementoFlag(0),
+      m_isUniform(rhs.m_isUniform),
+      m_isLost(rhs.m_isLost),
       m_age(0),
       m_usersCount(0),
       m_refCount(0),
@@ -123,6 +94,15 @@ void KisTileData::fillWithPixel(const quint8 *defPixel)
     }
 }
 
+bool KisTileData::checkUniform(const quint8 *data, qint32 pixelSize)
+{
+    /**
+     * The data consists of equal pixels iff it is equal
+     * to itself shifted by one pixel
+     */
+    return !memcmp(data, data + pixelSize, (WIDTH * HEIGHT - 1) * pixelSize);
+}
+
 void KisTileData::releaseMemory()
 {
     if (m_data) {
@@ -146,40 +126,24 @@ void KisTileData::allocateMemory()
 
 quint8* KisTileData::allocateData(const qint32 pixelSize)
 {
-    quint8 *ptr = 0;
-
-    if (!m_cache.pop(pixelSize, ptr)) {
-        switch (pixelSize) {
-        case 4:
-            ptr = (quint8*)BoostPool4BPP::malloc();
-            break;
-        case 8:
-            ptr = (quint8*)BoostPool8BPP::malloc();
-            break;
-        default:
-            ptr = (quint8*) malloc(pixelSize * WIDTH * HEIGHT);
-            break;
-        }
-    }
-
-    return ptr;
+    return KisTileDataSlabAllocator::instance()->allocate(pixelSize);
 }
 
 void KisTileData::freeData(quint8* ptr, const qint32 pixelSize)
 {
-    if (!m_cache.push(pixelSize, ptr)) {
-        switch (pixelSize) {
-        case 4:
-            BoostPool4BPP::free(ptr);
-            break;
-        case 8:
-            BoostPool8BPP::free(ptr);
-            break;
-        default:
-            free(ptr);
-            break;
+    /**
+     * The tiles may outlive the allocator during the static destruction.
+     * Its arenas are already unmapped, so only the malloc'ed chunks need
+     * to be released.
+     */
+    if (KisTileDataSlabAllocator::isDestroyed()) {
+        if (!KisTileDataSlabAllocator::isPooled(pixelSize)) {
+            ::free(ptr);
         }
+        return;
     }
+
+    KisTileDataSlabAllocator::instance()->free(ptr, pixelSize);
 }
 
 //#define DEBUG_POOL_RELEASE
@@ -210,9 +174,7 @@ void KisTileData::releaseInternalPools()
             }
 
             // check if the tile data has actually been pooled
-            if (item->m_pixelSize != 4 &&
-                item->m_pixelSize != 8) {
-
+            if (!KisTileDataSlabAllocator::isPooled(item->m_pixelSize)) {
                 continue;
             }
 
@@ -233,9 +195,7 @@ void KisTileData::releaseInternalPools()
 
         if (!failedToLock) {
             // purge the pools memory
-            m_cache.clear();
-            BoostPool4BPP::purge_memory();
-            BoostPool8BPP::purge_memory();
+            KisTileDataSlabAllocator::instance()->purge();
 
             auto it = dataObjects.begin();
             auto chunkIt = memoryChunks.constBegin();
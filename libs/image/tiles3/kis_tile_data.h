@@ -38,6 +38,7 @@ inline quint8* KisTileData::data() const {
 void KisTileData::setData(const quint8 *data) {
     Q_ASSERT(m_data);
     memcpy(m_data, data, m_pixelSize*WIDTH*HEIGHT);
+    m_isUniform = false;
 }
 
 inline quint32 KisTileData::pixelSize() const {
@@ -119,6 +120,20 @@ inline bool KisTileData::historical() const {
     return mementoed() && numUsers() <= 1;
 }
 
+inline bool KisTileData::isUniform() const {
+    return m_isUniform;
+}
+inline void KisTileData::setUniform(bool value) {
+    m_isUniform = value;
+}
+
+inline bool KisTileData::isLost() const {
+    return m_isLost;
+}
+inline void KisTileData::setLost(bool value) {
+    m_isLost = value;
+}
+
 inline int KisTileData::age() const {
     return m_age;
 }
@@ -22,7 +22,9 @@
 
 #include <QReadWriteLock>
 #include <QAtomicInt>
+#include <QByteArray>
 
+#include "config-tile-size.h"
 #include "kis_lockless_stack.h"
 #include "swap/kis_chunk_allocator.h"
 
@@ -32,9 +34,12 @@ class KisTileDataStore;
 /**
  * WARNING: Those definitions for internal use only!
  * Please use KisTileData::WIDTH/HEIGHT instead
+ *
+ * The size is selected at build time with KRITA_TILE_SIZE
+ * CMake option (64 by default).
  */
-#define __TILE_DATA_WIDTH 64
-#define __TILE_DATA_HEIGHT 64
+#define __TILE_DATA_WIDTH KRITA_TILE_SIZE
+#define __TILE_DATA_HEIGHT KRITA_TILE_SIZE
 
 typedef KisLocklessStack<KisTileData*> KisTileDataCache;
 
@@ -43,57 +48,6 @@ typedef KisTileDataList::iterator KisTileDataListIterator;
 typedef KisTileDataList::const_iterator KisTileDataListConstIterator;
 
 
-class SimpleCache
-{
-public:
-    SimpleCache() = default;
-    ~SimpleCache();
-
-    bool push(int pixelSize, quint8 *&ptr)
-    {
-        QReadLocker l(&m_cacheLock);
-        switch (pixelSize) {
-        case 4:
-            m_4Pool.push(ptr);
-            break;
-        case 8:
-            m_8Pool.push(ptr);
-            break;
-        case 16:
-            m_16Pool.push(ptr);
-            break;
-        default:
-            return false;
-        }
-
-        return true;
-    }
-
-    bool pop(int pixelSize, quint8 *&ptr)
-    {
-        QReadLocker l(&m_cacheLock);
-        switch (pixelSize) {
-        case 4:
-            return m_4Pool.pop(ptr);
-        case 8:
-            return m_8Pool.pop(ptr);
-        case 16:
-            return m_16Pool.pop(ptr);
-        default:
-            return false;
-        }
-    }
-
-    void clear();
-
-private:
-    QReadWriteLock m_cacheLock;
-    KisLocklessStack<quint8*> m_4Pool;
-    KisLocklessStack<quint8*> m_8Pool;
-    KisLocklessStack<quint8*> m_16Pool;
-};
-
-
 /**
  * Stores actual tile's data
  */
@@ -192,6 +146,31 @@ public:
      */
     inline bool historical() const;
 
+    /**
+     * Shows whether all the pixels of the tile data are known to
+     * have the same value. The flag is set for the tile datas created
+     * from a single pixel and for the ones found uniform by
+     * KisTiledDataManager::purge(). Any write access to the tile
+     * resets it, so the flag can be false for a tile data that
+     * became uniform by chance, but never the other way round.
+     */
+    inline bool isUniform() const;
+    inline void setUniform(bool value);
+
+    /**
+     * Checks whether all the pixels in \p data have the same value
+     */
+    static bool checkUniform(const quint8 *data, qint32 pixelSize);
+
+    /**
+     * Set by the swapped data store when the swapped out content of
+     * the tile data cannot be restored. The data is filled with zeros
+     * then. The tile that locks the data next fills it with the
+     * default pixel of its data manager and resets the flag.
+     */
+    inline bool isLost() const;
+    inline void setLost(bool value);
+
     /**
      * Used for swapping purposes only.
      * Frees the memory occupied by the tile data.
@@ -213,8 +192,8 @@ public:
     /**
      * Releases internal pools, which keep blobs where the tiles are
      * stored.  The point is that we don't allocate the tiles from
-     * glibc directly, but use pools (implemented via boost) to
-     * allocate bigger chunks. This method should be called when one
+     * glibc directly, but use pools (implemented by
+     * KisTileDataSlabAllocator) to allocate bigger chunks. This method should be called when one
      * knows that we have just free'd quite a lot of memory and we
      * won't need it anymore. E.g. when a document has been closed.
      */
@@ -274,6 +253,18 @@ private:
      */
     qint32 m_mementoFlag;
 
+    /**
+     * Set when all the pixels of the tile data are the same.
+     * Such tile datas are shared between all the uniform tiles
+     * of the same color, so the memory is spent only once.
+     */
+    bool m_isUniform;
+
+    /**
+     * \see isLost()
+     */
+    bool m_isLost;
+
     /**
      * Counts up time after last access to the tile data.
      * 0 - recently accessed
@@ -317,7 +308,6 @@ private:
     //qint32 m_timeStamp;
 
     KisTileDataStore *m_store;
-    static SimpleCache m_cache;
 
 public:
     static const qint32 WIDTH;
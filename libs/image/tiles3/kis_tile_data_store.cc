@@ -24,9 +24,11 @@
 
 #include "kis_tile_data_store.h"
 #include "kis_tile_data.h"
+#include "kis_tile.h"
 #include "kis_debug.h"
 
 #include "kis_tile_data_store_iterators.h"
+#include "KisTileDataSlabAllocator.h"
 
 Q_GLOBAL_STATIC(KisTileDataStore, s_instance)
 
@@ -77,10 +79,12 @@ KisTileDataStore::KisTileDataStore()
 {
     m_pooler.start();
     m_swapper.start();
+    m_prefetcher.start();
 }
 
 KisTileDataStore::~KisTileDataStore()
 {
+    m_prefetcher.terminatePrefetcher();
     m_pooler.terminatePooler();
     m_swapper.terminateSwapper();
 
@@ -114,10 +118,18 @@ KisTileDataStore::MemoryStatistics KisTileDataStore::memoryStatistics()
     stats.historicalMemorySize = m_pooler.lastHistoricalMemoryMetric() * metricCoeff;
     stats.poolSize = m_pooler.lastPoolMemoryMetric() * metricCoeff;
 
-    stats.totalMemorySize = memoryMetric() * metricCoeff + stats.poolSize;
+    stats.compressedSwapSize = m_swappedStore.compressedCacheSize();
+
+    stats.totalMemorySize = memoryMetric() * metricCoeff + stats.poolSize + stats.compressedSwapSize;
 
     stats.swapSize = m_swappedStore.totalMemoryMetric() * metricCoeff;
 
+    const KisTileDataSlabAllocator::Statistics slabStats =
+        KisTileDataSlabAllocator::instance()->statistics();
+
+    stats.slabReservedSize = slabStats.reservedSize;
+    stats.slabUsedSize = slabStats.usedSize;
+
     return stats;
 }
 
@@ -203,11 +215,13 @@ void KisTileDataStore::freeTileData(KisTileData *td)
 
     DEBUG_FREE_ACTION(td);
 
+    KisTileData *deltaBase = 0;
+
     m_iteratorLock.lockForRead();
     td->m_swapLock.lockForWrite();
 
     if (!td->data()) {
-        m_swappedStore.forgetTileData(td);
+        deltaBase = m_swappedStore.forgetTileData(td);
     } else {
         unregisterTileDataImp(td);
     }
@@ -216,6 +230,14 @@ void KisTileDataStore::freeTileData(KisTileData *td)
     m_iteratorLock.unlock();
 
     delete td;
+
+    /**
+     * The base may be freed here as well, so
+     * we should not hold any locks
+     */
+    if (deltaBase) {
+        deltaBase->deref();
+    }
 }
 
 void KisTileDataStore::ensureTileDataLoaded(KisTileData *td)
@@ -228,6 +250,17 @@ void KisTileDataStore::ensureTileDataLoaded(KisTileData *td)
     while (!td->data()) {
         td->m_swapLock.unlock();
 
+        /**
+         * A delta-compressed tile data can be restored only when
+         * its base is present in memory. The base itself may be
+         * swapped out or delta-compressed, so it should be loaded
+         * before we take any locks.
+         */
+        KisTileData *deltaBase = m_swappedStore.deltaBase(td);
+        if (deltaBase) {
+            deltaBase->blockSwapping();
+        }
+
         /**
          * The order of this heavy locking is very important.
          * Change it only in case, you really know what you are doing.
@@ -250,14 +283,20 @@ void KisTileDataStore::ensureTileDataLoaded(KisTileData *td)
         if (!td->data()) {
             td->m_swapLock.lockForWrite();
 
-            m_swappedStore.swapInTileData(td);
-            registerTileDataImp(td);
+            if (m_swappedStore.swapInTileData(td, deltaBase)) {
+                registerTileDataImp(td);
+            }
 
             td->m_swapLock.unlock();
         }
 
         m_iteratorLock.unlock();
 
+        if (deltaBase) {
+            deltaBase->unblockSwapping();
+            deltaBase->deref();
+        }
+
         /**
          * <-- In theory, livelock is possible here...
          */
@@ -266,6 +305,17 @@ void KisTileDataStore::ensureTileDataLoaded(KisTileData *td)
     }
 }
 
+void KisTileDataStore::prefetchTile(KisTileSP tile)
+{
+    /**
+     * The check is racy, but it is only a hint. The data
+     * will be loaded synchronously in the worst case.
+     */
+    if (tile->isDataLoaded()) return;
+
+    m_prefetcher.prefetchTile(tile);
+}
+
 bool KisTileDataStore::trySwapTileData(KisTileData *td)
 {
     /**
@@ -286,6 +336,99 @@ bool KisTileDataStore::trySwapTileData(KisTileData *td)
     return result;
 }
 
+void KisTileDataStore::compressHistory()
+{
+    const QVector<KisSwappedDataStore::DeltaCandidate> candidates =
+        m_swappedStore.takeDeltaCandidates();
+
+    Q_FOREACH (const KisSwappedDataStore::DeltaCandidate &candidate, candidates) {
+        KisTileData *td = candidate.first;
+        KisTileData *base = candidate.second;
+
+        /**
+         * Only the tile datas owned by the undo history can be
+         * compressed, otherwise they would be restored right away
+         */
+        if (td != base &&
+            td->historical() &&
+            !td->isUniform() &&
+            td->pixelSize() == base->pixelSize() &&
+            td->data()) {
+
+            // see the comment in ensureTileDataLoaded() about lock ordering
+            base->blockSwapping();
+            m_iteratorLock.lockForWrite();
+
+            if (td->m_swapLock.tryLockForWrite()) {
+                if (td->data() && td->historical() &&
+                    m_swappedStore.tryStoreDelta(td, base)) {
+
+                    unregisterTileDataImp(td);
+                }
+                td->m_swapLock.unlock();
+            }
+
+            m_iteratorLock.unlock();
+            base->unblockSwapping();
+        }
+
+        td->deref();
+        base->deref();
+    }
+}
+
+void KisTileDataStore::spillHistory()
+{
+    const QVector<KisTileData*> candidates = m_swappedStore.takeSpillCandidates();
+    QVector<KisTileData*> postponedCandidates;
+
+    Q_FOREACH (KisTileData *td, candidates) {
+        // the tile data has left the history, nothing to spill
+        if (!td->mementoed()) continue;
+
+        bool postpone = true;
+
+        /**
+         * The lock is taken for every tile separately, so that
+         * the other threads are not blocked while the whole batch
+         * is compressed and written
+         */
+        m_iteratorLock.lockForWrite();
+
+        if (td->m_swapLock.tryLockForWrite()) {
+            if (!td->data()) {
+                postpone = false;
+            } else if (td->historical()) {
+                if (m_swappedStore.trySwapOutTileData(td, true)) {
+                    unregisterTileDataImp(td);
+                }
+                postpone = false;
+            }
+            td->m_swapLock.unlock();
+        }
+
+        m_iteratorLock.unlock();
+
+        /**
+         * The tile data is either locked by someone else or has been
+         * restored by undo and shared with a real tile. Try again on
+         * the next pass.
+         */
+        if (postpone) {
+            postponedCandidates.append(td);
+        }
+    }
+
+    if (!postponedCandidates.isEmpty()) {
+        m_swappedStore.addSpillCandidates(postponedCandidates);
+    }
+
+    // the tile datas may be freed here, so do it without locks
+    Q_FOREACH (KisTileData *td, candidates) {
+        td->deref();
+    }
+}
+
 KisTileDataStoreIterator* KisTileDataStore::beginIteration()
 {
     m_iteratorLock.lockForWrite();
@@ -374,9 +517,15 @@ void KisTileDataStore::testingRereadConfig()
 {
     m_pooler.testingRereadConfig();
     m_swapper.testingRereadConfig();
+    m_swappedStore.testingRereadConfig();
     kickPooler();
 }
 
+void KisTileDataStore::testingWaitForPrefetcher()
+{
+    m_prefetcher.testingWaitForIdle();
+}
+
 void KisTileDataStore::testingSuspendPooler()
 {
     m_pooler.terminatePooler();
@@ -386,3 +535,13 @@ void KisTileDataStore::testingResumePooler()
 {
     m_pooler.start();
 }
+
+void KisTileDataStore::testingSuspendSwapper()
+{
+    m_swapper.terminateSwapper();
+}
+
+void KisTileDataStore::testingResumeSwapper()
+{
+    m_swapper.start();
+}
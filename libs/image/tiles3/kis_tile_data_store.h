@@ -27,6 +27,7 @@
 
 #include "kis_tile_data_pooler.h"
 #include "swap/kis_tile_data_swapper.h"
+#include "swap/kis_tile_data_prefetcher.h"
 #include "swap/kis_swapped_data_store.h"
 #include "3rdparty/lock_free_map/concurrent_map.h"
 
@@ -54,6 +55,10 @@ public:
         qint64 poolSize;
 
         qint64 swapSize;
+        qint64 compressedSwapSize;
+
+        qint64 slabReservedSize;
+        qint64 slabUsedSize;
     };
 
     MemoryStatistics memoryStatistics();
@@ -80,6 +85,79 @@ public:
         m_swapper.checkFreeMemory();
     }
 
+    /**
+     * Returns true if some tiles are present in a swap file
+     * or in the compressed in-memory tier of the swap
+     */
+    inline bool hasSwappedTiles() const
+    {
+        return m_swappedStore.numTiles() > 0;
+    }
+
+    /**
+     * Does a step of the background compaction of the swap file.
+     * \see KisSwappedDataStore::compactSwapFile()
+     */
+    inline bool compactSwapFile(qint64 maxBytes)
+    {
+        return m_swappedStore.compactSwapFile(maxBytes);
+    }
+
+    /**
+     * \see KisImageConfig::compressHistoryDeltas()
+     */
+    inline bool historyDeltasEnabled() const
+    {
+        return m_swappedStore.historyDeltasEnabled();
+    }
+
+    /**
+     * Called by the Memento Manager on commit. Queues the tile datas
+     * that went down in history for delta-compression against the
+     * following revisions of the same tiles.
+     */
+    inline void addHistoryDeltaCandidates(const QVector<KisSwappedDataStore::DeltaCandidate> &candidates)
+    {
+        m_swappedStore.addDeltaCandidates(candidates);
+    }
+
+    /**
+     * Delta-compresses the queued candidates. Called by the swapper.
+     */
+    void compressHistory();
+
+    /**
+     * \see KisImageConfig::undoRevisionsInMemory()
+     */
+    inline int undoRevisionsInMemory() const
+    {
+        return m_swappedStore.undoRevisionsInMemory();
+    }
+
+    /**
+     * Called by the Memento Manager when a revision gets older
+     * than undoRevisionsInMemory(). Queues its tile datas for
+     * writing to the swap file.
+     */
+    inline void addHistorySpillCandidates(const QVector<KisTileData*> &candidates)
+    {
+        m_swappedStore.addSpillCandidates(candidates);
+    }
+
+    /**
+     * Writes the queued tile datas of old revisions to
+     * the swap file. Called by the swapper. The tile datas
+     * that are busy or shared with a real tile at the moment
+     * are queued again for the next pass.
+     */
+    void spillHistory();
+
+    /**
+     * Asynchronously loads the data of the \p tile from the swap.
+     * Does nothing if the data is already present in memory.
+     */
+    void prefetchTile(KisTileSP tile);
+
     /**
      * \see m_memoryMetric
      */
@@ -154,16 +232,22 @@ private:
     friend class KisLowMemoryTests;
     void debugSwapAll();
     void debugClear();
+    void testingWaitForPrefetcher();
 
     friend class KisTiledDataManagerTest;
     void testingSuspendPooler();
     void testingResumePooler();
 
+    void testingSuspendSwapper();
+    void testingResumeSwapper();
+
     friend class KisLowMemoryBenchmark;
+    friend class KisTilesBenchmark;
     void testingRereadConfig();
 private:
     KisTileDataPooler m_pooler;
     KisTileDataSwapper m_swapper;
+    KisTileDataPrefetcher m_prefetcher;
 
     friend class KisTileDataStoreTest;
     friend class KisTileDataPoolerTest;
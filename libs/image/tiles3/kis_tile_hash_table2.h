@@ -43,6 +43,9 @@
 template <class T>
 class KisTileHashTableIteratorTraits2;
 
+template <class T>
+class KisTileHashTableSnapshotIteratorTraits2;
+
 template <class T>
 class KisTileHashTableTraits2
 {
@@ -112,6 +115,7 @@ public:
     void debugMaxListLength(qint32 &min, qint32 &max);
 
     friend class KisTileHashTableIteratorTraits2<T>;
+    friend class KisTileHashTableSnapshotIteratorTraits2<T>;
 
 private:
     struct MemoryReclaimer {
@@ -257,6 +261,68 @@ private:
     Iterator m_iter;
 };
 
+/**
+ * A read-only iterator that walks over a snapshot of the hash table.
+ *
+ * The iterator lock of the table is held only while the tiles are
+ * being copied into the snapshot, so the other threads may freely
+ * add and remove tiles while the snapshot is being processed.
+ * The tiles added after creation of the iterator are not visited,
+ * the removed ones are still visited (the snapshot keeps them
+ * alive), which is fine for all the read-only users.
+ */
+template <class T>
+class KisTileHashTableSnapshotIteratorTraits2
+{
+public:
+    typedef T TileType;
+    typedef KisSharedPtr<T> TileTypeSP;
+    typedef typename ConcurrentMap<quint32, TileType*>::Iterator Iterator;
+
+    KisTileHashTableSnapshotIteratorTraits2(KisTileHashTableTraits2<T> *ht)
+        : m_index(0)
+    {
+        m_tiles.reserve(ht->numTiles());
+
+        {
+            QWriteLocker locker(&ht->m_iteratorLock);
+
+            // the tiles may be erased concurrently, so protect
+            // the raw pointers until they are referenced
+            ht->m_map.getGC().lockRawPointerAccess();
+
+            Iterator iter(ht->m_map);
+            while (iter.isValid()) {
+                m_tiles.append(TileTypeSP(iter.getValue()));
+                iter.next();
+            }
+
+            ht->m_map.getGC().unlockRawPointerAccess();
+        }
+
+        ht->m_map.getGC().update();
+    }
+
+    void next()
+    {
+        m_index++;
+    }
+
+    TileTypeSP tile() const
+    {
+        return m_index < m_tiles.size() ? m_tiles[m_index] : TileTypeSP();
+    }
+
+    bool isDone() const
+    {
+        return m_index >= m_tiles.size();
+    }
+
+private:
+    QVector<TileTypeSP> m_tiles;
+    int m_index;
+};
+
 template <class T>
 KisTileHashTableTraits2<T>::KisTileHashTableTraits2(KisMementoManager *mm)
     : m_numTiles(0), m_defaultTileData(0), m_mementoManager(mm)
@@ -477,6 +543,6 @@ void KisTileHashTableTraits2<T>::debugMaxListLength(qint32 &/*min*/, qint32 &/*m
 
 typedef KisTileHashTableTraits2<KisTile> KisTileHashTable;
 typedef KisTileHashTableIteratorTraits2<KisTile> KisTileHashTableIterator;
-typedef KisTileHashTableIteratorTraits2<KisTile> KisTileHashTableConstIterator;
+typedef KisTileHashTableSnapshotIteratorTraits2<KisTile> KisTileHashTableConstIterator;
 
 #endif // KIS_TILEHASHTABLE_2_H
@@ -20,6 +20,9 @@
 
 #include <QRect>
 #include <QVector>
+#include <QHash>
+
+#include <limits>
 
 #include "kis_tile.h"
 #include "kis_tiled_data_manager.h"
@@ -51,6 +54,7 @@ KisTiledDataManager::KisTiledDataManager(quint32 pixelSize,
 
     m_pixelSize = pixelSize;
     m_defaultPixel = new quint8[m_pixelSize];
+    m_purgedWriteEpoch.storeRelease(std::numeric_limits<int>::min());
     setDefaultPixel(defaultPixel);
 }
 
@@ -66,6 +70,7 @@ KisTiledDataManager::KisTiledDataManager(const KisTiledDataManager &dm)
 
     m_pixelSize = dm.m_pixelSize;
     m_defaultPixel = new quint8[m_pixelSize];
+    m_purgedWriteEpoch.storeRelease(std::numeric_limits<int>::min());
     /**
      * We won't call setDefaultTileData here, as defaultTileDatas
      * has already been made shared in m_hashTable(dm->m_hashTable)
@@ -103,6 +108,11 @@ void KisTiledDataManager::setDefaultPixelImpl(const quint8 *defaultPixel)
     m_mementoManager->setDefaultTileData(td);
 
     memcpy(m_defaultPixel, defaultPixel, pixelSize());
+
+    /**
+     * The tiles that were not default before may become default now
+     */
+    m_purgedWriteEpoch.storeRelease(std::numeric_limits<int>::min());
 }
 
 bool KisTiledDataManager::write(KisPaintDeviceWriter &store)
@@ -117,7 +127,15 @@ bool KisTiledDataManager::write(KisPaintDeviceWriter &store)
         retval = store.write(str, strlen(str));
     }
     else {
-        retval = writeTilesHeader(store, m_hashTable->numTiles());
+        /**
+         * The tiles are always saved in FILE_TILE_SIZE layout, the
+         * compressor splits our native tiles if they are bigger
+         */
+        const qint32 subtilesPerTile =
+            (KisTileData::WIDTH / KisAbstractTileCompressor::FILE_TILE_SIZE) *
+            (KisTileData::HEIGHT / KisAbstractTileCompressor::FILE_TILE_SIZE);
+
+        retval = writeTilesHeader(store, m_hashTable->numTiles() * subtilesPerTile);
     }
 
 
@@ -156,6 +174,8 @@ bool KisTiledDataManager::read(QIODevice *stream)
 
     quint32 numTiles;
     qint32 tilesVersion = LEGACY_VERSION;
+    qint32 streamTileWidth = KisTileData::WIDTH;
+    qint32 streamTileHeight = KisTileData::HEIGHT;
 
     if (line[0] == 'V') {
         QList<QByteArray> lineItems = line.split(' ');
@@ -165,7 +185,7 @@ bool KisTiledDataManager::read(QIODevice *stream)
 
         tilesVersion = lineItems.takeFirst().toInt();
 
-        if(!processTilesHeader(stream, numTiles))
+        if(!processTilesHeader(stream, numTiles, streamTileWidth, streamTileHeight))
             return false;
     }
     else {
@@ -174,6 +194,7 @@ bool KisTiledDataManager::read(QIODevice *stream)
 
     KisAbstractTileCompressorSP compressor =
         KisTileCompressorFactory::create(tilesVersion);
+    compressor->setStreamTileSize(streamTileWidth, streamTileHeight);
 
     bool readSuccess = true;
     for (quint32 i = 0; i < numTiles; i++) {
@@ -182,6 +203,12 @@ bool KisTiledDataManager::read(QIODevice *stream)
         }
     }
 
+    /**
+     * Backgrounds and fill layers are usually stored as a set
+     * of uniform tiles, let them share the memory
+     */
+    purgeImpl(extent(), false);
+
     m_mementoManager->commit();
     return readSuccess;
 }
@@ -196,8 +223,8 @@ bool KisTiledDataManager::writeTilesHeader(KisPaintDeviceWriter &store, quint32
                      "PIXELSIZE %4\n"
                      "DATA %5\n")
         .arg(CURRENT_VERSION)
-        .arg(KisTileData::WIDTH)
-        .arg(KisTileData::HEIGHT)
+        .arg(KisAbstractTileCompressor::FILE_TILE_SIZE)
+        .arg(KisAbstractTileCompressor::FILE_TILE_SIZE)
         .arg(pixelSize())
         .arg(numTiles);
 
@@ -214,7 +241,8 @@ bool KisTiledDataManager::writeTilesHeader(KisPaintDeviceWriter &store, quint32
     } while(0)                                                  \
 
 
-bool KisTiledDataManager::processTilesHeader(QIODevice *stream, quint32 &numTiles)
+bool KisTiledDataManager::processTilesHeader(QIODevice *stream, quint32 &numTiles,
+                                             qint32 &tileWidth, qint32 &tileHeight)
 {
     /**
      * We assume that there is only one version of this header
@@ -233,13 +261,20 @@ bool KisTiledDataManager::processTilesHeader(QIODevice *stream, quint32 &numTile
     while(!foundDataMark && stream->canReadLine()) {
         takeOneLine(stream, maxLineLength, keyword, value);
 
+        /**
+         * The tile size of the file may differ from ours if the file
+         * has been saved by a build with a different KRITA_TILE_SIZE.
+         * The compressor will rearrange the pixels in such a case.
+         */
         if (keyword == "TILEWIDTH") {
-            if(value != KisTileData::WIDTH)
+            if(!KisAbstractTileCompressor::isValidStreamTileSize(value))
                 goto wrongString;
+            tileWidth = value;
         }
         else if (keyword == "TILEHEIGHT") {
-            if(value != KisTileData::HEIGHT)
+            if(!KisAbstractTileCompressor::isValidStreamTileSize(value))
                 goto wrongString;
+            tileHeight = value;
         }
         else if (keyword == "PIXELSIZE") {
             if((quint32)value != pixelSize())
@@ -269,22 +304,65 @@ wrongString:
 }
 
 void KisTiledDataManager::purge(const QRect& area)
+{
+    purgeImpl(area, true);
+}
+
+void KisTiledDataManager::purgeImpl(const QRect& area, bool removeDefaultTiles)
 {
     QList<KisTileSP> tilesToDelete;
+    QList<KisTileSP> uniformTiles;
+
+    /**
+     * All the uniform tiles of the same color share a single tile
+     * data, so it takes memory only once. The tile data is detached
+     * by the usual copy-on-write mechanism when the tile is written.
+     */
+    QHash<QByteArray, KisTileData*> uniformTileData;
+
+    /**
+     * The tiles that have not been written since the last full purge
+     * have already been checked, so we skip the expensive comparison
+     * of their data. Only the purge that checked all the tiles can
+     * mark them as such.
+     */
+    const int lastPurgedWriteEpoch = m_purgedWriteEpoch.loadAcquire();
+    const int currentWriteEpoch = KisTile::startNewWriteEpoch();
+    const bool isFullPurge = removeDefaultTiles && area.contains(extent());
+
     {
         const qint32 tileDataSize = KisTileData::HEIGHT * KisTileData::WIDTH * pixelSize();
         KisTileData *tileData = m_hashTable->defaultTileData();
         tileData->blockSwapping();
         const quint8 *defaultData = tileData->data();
 
+        tileData->acquire();
+        uniformTileData.insert(QByteArray((const char*)m_defaultPixel, pixelSize()), tileData);
+
         KisTileHashTableConstIterator iter(m_hashTable);
         KisTileSP tile;
 
         while ((tile = iter.tile())) {
             if (tile->extent().intersects(area)) {
+                const bool isChanged = tile->writeEpoch() > lastPurgedWriteEpoch;
+
                 tile->lockForRead();
-                if(memcmp(defaultData, tile->data(), tileDataSize) == 0) {
+                KisTileData *td = tile->tileData();
+
+                if (removeDefaultTiles && isChanged &&
+                    memcmp(defaultData, tile->data(), tileDataSize) == 0) {
+
                     tilesToDelete.push_back(tile);
+
+                } else if (td->isUniform()) {
+                    const QByteArray pixel((const char*)tile->data(), pixelSize());
+
+                    if (!uniformTileData.contains(pixel)) {
+                        td->acquire();
+                        uniformTileData.insert(pixel, td);
+                    }
+                } else if (isChanged && KisTileData::checkUniform(tile->data(), pixelSize())) {
+                    uniformTiles.push_back(tile);
                 }
                 tile->unlockForRead();
             }
@@ -298,6 +376,33 @@ void KisTiledDataManager::purge(const QRect& area)
             m_extentManager.notifyTileRemoved(tile->col(), tile->row());
         }
     }
+    Q_FOREACH (KisTileSP tile, uniformTiles) {
+        tile->lockForRead();
+        const QByteArray pixel((const char*)tile->data(), pixelSize());
+        tile->unlockForRead();
+
+        KisTileData *td = uniformTileData.value(pixel, 0);
+        if (!td) {
+            td = KisTileDataStore::instance()->createDefaultTileData(pixelSize(), (const quint8*)pixel.constData());
+            td->acquire();
+            uniformTileData.insert(pixel, td);
+        }
+
+        /**
+         * The tile data is swapped inside the existing tile, so the
+         * tile never disappears from the hash table. If someone has
+         * locked or changed the tile in the meantime, it is just
+         * skipped.
+         */
+        tile->replaceWithUniformData(td);
+    }
+    Q_FOREACH (KisTileData *td, uniformTileData) {
+        td->release();
+    }
+
+    if (isFullPurge) {
+        m_purgedWriteEpoch.storeRelease(currentWriteEpoch);
+    }
 }
 
 quint8* KisTiledDataManager::duplicatePixel(qint32 num, const quint8 *pixel)
@@ -682,6 +787,23 @@ KisRegion KisTiledDataManager::region() const
     return KisRegion(std::move(rects));
 }
 
+KisRegion KisTiledDataManager::changedRegion(int writeEpoch) const
+{
+    QVector<QRect> rects;
+
+    KisTileHashTableConstIterator iter(m_hashTable);
+    KisTileSP tile;
+
+    while ((tile = iter.tile())) {
+        if (tile->writeEpoch() > writeEpoch) {
+            rects << tile->extent();
+        }
+        iter.next();
+    }
+
+    return KisRegion(std::move(rects));
+}
+
 void KisTiledDataManager::setPixel(qint32 x, qint32 y, const quint8 * data)
 {
     KisTileDataWrapper tw(this, x, y, KisTileDataWrapper::WRITE);
@@ -708,6 +830,37 @@ void KisTiledDataManager::readBytes(quint8 *data,
     readBytesBody(data, x, y, width, height, dataRowStride);
 }
 
+void KisTiledDataManager::prefetchTiles(const QRect &rect)
+{
+    if (rect.isEmpty()) return;
+
+    const qint32 numColumns = xToCol(rect.right()) - xToCol(rect.left()) + 1;
+    const qint32 numRows = yToRow(rect.bottom()) - yToRow(rect.top()) + 1;
+    if (numColumns * numRows < MIN_PREFETCH_TILES) return;
+
+    KisTileDataStore *store = KisTileDataStore::instance();
+    if (!store->hasSwappedTiles()) return;
+
+    QReadLocker locker(&m_lock);
+
+    const QRect prefetchRect = rect & extent();
+    if (prefetchRect.isEmpty()) return;
+
+    const qint32 firstColumn = xToCol(prefetchRect.left());
+    const qint32 lastColumn = xToCol(prefetchRect.right());
+    const qint32 firstRow = yToRow(prefetchRect.top());
+    const qint32 lastRow = yToRow(prefetchRect.bottom());
+
+    for (qint32 row = firstRow; row <= lastRow; ++row) {
+        for (qint32 column = firstColumn; column <= lastColumn; ++column) {
+            KisTileSP tile = m_hashTable->getExistingTile(column, row);
+            if (tile) {
+                store->prefetchTile(tile);
+            }
+        }
+    }
+}
+
 QVector<quint8*>
 KisTiledDataManager::readPlanarBytes(QVector<qint32> channelSizes,
                                      qint32 x, qint32 y,
@@ -21,6 +21,7 @@
 
 #include <QtGlobal>
 #include <QVector>
+#include <QAtomicInt>
 #include <KisRegion.h>
 
 #include <kis_shared.h>
@@ -70,6 +71,12 @@ private:
     static const qint32 LEGACY_VERSION = 1;
     static const qint32 CURRENT_VERSION = 2;
 
+    /**
+     * Prefetching of the rects covering less tiles is not worth
+     * the overhead of the background loading
+     */
+    static const qint32 MIN_PREFETCH_TILES = 16;
+
 protected:
     /*FIXME:*/
 public:
@@ -211,6 +218,14 @@ protected:
     bool write(KisPaintDeviceWriter &store);
     bool read(QIODevice *stream);
 
+    /**
+     * Removes the tiles in \p area that consist of default pixels
+     * only and makes all the uniform tiles of the same color share
+     * a single tile data.
+     *
+     * Only the tiles written after the last purge of the whole
+     * extent are checked.
+     */
     void purge(const QRect& area);
 
     inline quint32 pixelSize() const {
@@ -228,6 +243,12 @@ public:
 
     KisRegion region() const;
 
+    /**
+     * Returns the region of the tiles that have been created or
+     * written to after \p writeEpoch. \see KisTile::writeEpoch()
+     */
+    KisRegion changedRegion(int writeEpoch) const;
+
     void clear(QRect clearRect, quint8 clearValue);
     void clear(QRect clearRect, const quint8 *clearPixel);
     void clear(qint32 x, qint32 y, qint32 w, qint32 h, quint8 clearValue);
@@ -261,6 +282,16 @@ public:
      */
     void bitBltRoughOldData(KisTiledDataManager *srcDM, const QRect &rect);
 
+    /**
+     * Notifies the data manager that the tiles covering \p rect are
+     * going to be accessed soon. The tiles that are swapped out will
+     * be loaded in the background, so the following access would
+     * not have to wait for the swap.
+     *
+     * Small rects (less than MIN_PREFETCH_TILES tiles) are ignored.
+     */
+    void prefetchTiles(const QRect &rect);
+
     /**
      * write the specified data to x, y. There is no checking on pixelSize!
      */
@@ -350,6 +381,13 @@ private:
     qint32 m_pixelSize;
     KisTiledExtentManager m_extentManager;
 
+    /**
+     * The write epoch of the last purge that has checked all the
+     * tiles of the data manager. The tiles that have not been written
+     * since then need not be checked again.
+     */
+    QAtomicInt m_purgedWriteEpoch;
+
     mutable QReadWriteLock m_lock;
 
 private:
@@ -364,12 +402,15 @@ private:
     void setDefaultPixelImpl(const quint8 *defPixel);
 
     bool writeTilesHeader(KisPaintDeviceWriter &store, quint32 numTiles);
-    bool processTilesHeader(QIODevice *stream, quint32 &numTiles);
+    bool processTilesHeader(QIODevice *stream, quint32 &numTiles,
+                            qint32 &tileWidth, qint32 &tileHeight);
 
     qint32 divideRoundDown(qint32 x, const qint32 y) const;
 
     void recalculateExtent();
 
+    void purgeImpl(const QRect& area, bool removeDefaultTiles);
+
     quint8* duplicatePixel(qint32 num, const quint8 *pixel);
 
     template<bool useOldSrcData>
@@ -19,9 +19,24 @@
 #include "kis_abstract_tile_compressor.h"
 
 KisAbstractTileCompressor::KisAbstractTileCompressor()
+    : m_streamTileWidth(FILE_TILE_SIZE),
+      m_streamTileHeight(FILE_TILE_SIZE)
 {
 }
 
 KisAbstractTileCompressor::~KisAbstractTileCompressor()
 {
 }
+
+const qint32 KisAbstractTileCompressor::FILE_TILE_SIZE;
+
+bool KisAbstractTileCompressor::isValidStreamTileSize(qint32 size)
+{
+    return size >= 16 && size <= 256 && !(size & (size - 1));
+}
+
+void KisAbstractTileCompressor::setStreamTileSize(qint32 width, qint32 height)
+{
+    m_streamTileWidth = width;
+    m_streamTileHeight = height;
+}
@@ -90,7 +90,45 @@ public:
      */
     virtual qint32 tileDataBufferSize(KisTileData *tileData) = 0;
 
+    /**
+     * Sets the size of the tiles stored in the stream passed to
+     * readTile(). The file might have been saved by a build of Krita
+     * with a different tile size (see KRITA_TILE_SIZE), in such a case
+     * the tiles are rearranged while reading. By default, the stream
+     * is expected to have tiles of FILE_TILE_SIZE, the same size
+     * writeTile() produces.
+     */
+    void setStreamTileSize(qint32 width, qint32 height);
+
+    /**
+     * The size of the tiles written into .kra files. It is kept at 64
+     * whatever KRITA_TILE_SIZE is, so the files stay readable by the
+     * builds of Krita with the default tile size.
+     */
+    static const qint32 FILE_TILE_SIZE = 64;
+
+    /**
+     * \return true if \p size is a sane tile size for a stream: a power
+     * of two not greater than 256. Bigger values would let a corrupted
+     * file request unbounded allocations.
+     */
+    static bool isValidStreamTileSize(qint32 size);
+
 protected:
+    inline bool streamHasNativeTileSize() const {
+        return m_streamTileWidth == KisTileData::WIDTH &&
+            m_streamTileHeight == KisTileData::HEIGHT;
+    }
+
+    /**
+     * Writes pixel data read from a stream with foreign tile size
+     * into the data manager. The caller (KisTiledDataManager::read())
+     * already holds the lock of the data manager.
+     */
+    inline void writeBytes(KisTiledDataManager *dm, const quint8 *data, const QRect &rect) {
+        dm->writeBytesBody(data, rect.x(), rect.y(), rect.width(), rect.height());
+    }
+
     inline qint32 xToCol(KisTiledDataManager *dm, qint32 x) {
         return dm->xToCol(x);
     }
@@ -102,6 +140,10 @@ protected:
     inline qint32 pixelSize(KisTiledDataManager *dm) {
         return dm->pixelSize();
     }
+
+protected:
+    qint32 m_streamTileWidth;
+    qint32 m_streamTileHeight;
 };
 
 #endif /* __KIS_ABSTRACT_TILE_COMPRESSOR_H */
@@ -36,7 +36,9 @@ KisChunkAllocator::KisChunkAllocator(quint64 slabSize, quint64 storeSize)
     m_storeSlabSize = slabSize;
 
     m_iterator = m_list.begin();
+    m_compactionIterator = m_list.end();
     m_storeSize = m_storeSlabSize;
+    m_allocatedSize = 0;
     INIT_FAIL_COUNTER();
 }
 
@@ -107,6 +109,7 @@ bool KisChunkAllocator::tryInsertChunk(KisChunkDataList &list,
 
     if(GAP_SIZE(lowBound, highBound) >= size) {
         list.insert(iterator, KisChunkData(lowBound + shift, size));
+        m_allocatedSize += size;
         result = true;
     }
 
@@ -115,6 +118,12 @@ bool KisChunkAllocator::tryInsertChunk(KisChunkDataList &list,
 
 void KisChunkAllocator::freeChunk(KisChunk chunk)
 {
+    m_allocatedSize -= chunk.size();
+
+    if(m_compactionIterator != m_list.end() && m_compactionIterator == chunk.position()) {
+        m_compactionIterator++;
+    }
+
     if(m_iterator != m_list.end() && m_iterator == chunk.position()) {
         m_iterator = m_list.erase(m_iterator);
         return;
@@ -124,6 +133,49 @@ void KisChunkAllocator::freeChunk(KisChunk chunk)
     m_list.erase(chunk.position());
 }
 
+qreal KisChunkAllocator::fragmentation() const
+{
+    if(m_list.isEmpty()) return 0.0;
+
+    const quint64 usedSize = m_list.last().m_end + 1;
+    return qreal(usedSize - m_allocatedSize) / usedSize;
+}
+
+void KisChunkAllocator::startCompaction()
+{
+    m_compactionIterator = m_list.begin();
+}
+
+bool KisChunkAllocator::compactNextChunk(KisChunk *chunk, KisChunkData *oldChunk)
+{
+    while(m_compactionIterator != m_list.end()) {
+        const quint64 lowBound =
+            HAS_PREVIOUS(m_list, m_compactionIterator) ?
+            PEEK_PREVIOUS(m_compactionIterator).m_end + 1 : 0;
+
+        KisChunkDataListIterator current = m_compactionIterator++;
+
+        if(current->m_begin > lowBound) {
+            *oldChunk = *current;
+            current->setChunk(lowBound, oldChunk->size());
+            *chunk = KisChunk(current);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+quint64 KisChunkAllocator::shrinkStore()
+{
+    const quint64 usedSize = !m_list.isEmpty() ? m_list.last().m_end + 1 : 0;
+    const quint64 numSlabs = (usedSize + m_storeSlabSize - 1) / m_storeSlabSize;
+
+    m_storeSize = qMax(quint64(1), numSlabs) * m_storeSlabSize;
+
+    return usedSize;
+}
+
 
 
 /**************************************************************/
@@ -62,6 +62,7 @@ class KRITAIMAGE_EXPORT KisChunkData
 {
 public:
     KisChunkData(quint64 begin, quint64 size)
+        : m_checksum(0)
     {
         setChunk(begin, size);
     }
@@ -88,6 +89,13 @@ public:
 
     quint64 m_begin;
     quint64 m_end;
+
+    /**
+     * Checksum of the data stored in the chunk. It is kept
+     * in memory, so corruption of the swap file itself can
+     * be detected on reading.
+     */
+    quint32 m_checksum;
 };
 
 class KRITAIMAGE_EXPORT KisChunk
@@ -112,6 +120,14 @@ public:
         return m_iterator->size();
     }
 
+    inline quint32 checksum() const {
+        return m_iterator->m_checksum;
+    }
+
+    inline void setChecksum(quint32 value) {
+        m_iterator->m_checksum = value;
+    }
+
     inline KisChunkDataListIterator position() {
         return m_iterator;
     }
@@ -139,6 +155,39 @@ public:
     KisChunk getChunk(quint64 size);
     void freeChunk(KisChunk chunk);
 
+    /**
+     * Returns the part of the used space of the store
+     * occupied by the holes between the chunks
+     */
+    qreal fragmentation() const;
+
+    /**
+     * Starts a new compaction sweep from the beginning of the store.
+     * Must be called before the first call to compactNextChunk()
+     * of every sweep.
+     */
+    void startCompaction();
+
+    /**
+     * Online compaction of the store. Finds the next chunk that has
+     * a hole in front of it and moves it to the beginning of the hole.
+     * Only the offsets of the chunk are changed, so all the KisChunk
+     * objects pointing to it stay valid. The caller is responsible
+     * for moving the actual data from \p oldChunk to the new
+     * position of the \p chunk.
+     *
+     * \return false if the end of the store has been reached
+     */
+    bool compactNextChunk(KisChunk *chunk, KisChunkData *oldChunk);
+
+    /**
+     * Shrinks the store to the minimal number of slabs that can
+     * hold all the allocated chunks.
+     *
+     * \return the size of the used part of the store
+     */
+    quint64 shrinkStore();
+
     void debugChunks();
     bool sanityCheck(bool pleaseCrash = true);
     qreal debugFragmentation(bool toStderr = true);
@@ -155,7 +204,9 @@ private:
 
     KisChunkDataList m_list;
     KisChunkDataListIterator m_iterator;
+    KisChunkDataListIterator m_compactionIterator;
     quint64 m_storeSize;
+    quint64 m_allocatedSize;
     DECLARE_FAIL_COUNTER()
 };
 
@@ -19,6 +19,7 @@
 #include "kis_legacy_tile_compressor.h"
 #include "kis_paint_device_writer.h"
 #include <QIODevice>
+#include "kis_debug.h"
 
 #define TILE_DATA_SIZE(pixelSize) ((pixelSize) * KisTileData::WIDTH * KisTileData::HEIGHT)
 
@@ -57,22 +58,37 @@ bool KisLegacyTileCompressor::readTile(QIODevice *stream, KisTiledDataManager *d
     const qint32 tileDataSize = TILE_DATA_SIZE(pixelSize(dm));
 
     const qint32 bufferSize = maxHeaderLength() + 1;
-    quint8 *headerBuffer = new quint8[bufferSize];
+    QScopedArrayPointer<quint8> headerBuffer(new quint8[bufferSize]);
 
     qint32 x, y;
     qint32 width, height;
 
-    stream->readLine((char *)headerBuffer, bufferSize);
-    sscanf((char *) headerBuffer, "%d,%d,%d,%d", &x, &y, &width, &height);
-
-    qint32 row = yToRow(dm, y);
-    qint32 col = xToCol(dm, x);
+    stream->readLine((char *)headerBuffer.data(), bufferSize);
+    if (sscanf((char *) headerBuffer.data(), "%d,%d,%d,%d", &x, &y, &width, &height) != 4 ||
+        !isValidStreamTileSize(width) || !isValidStreamTileSize(height)) {
 
-    KisTileSP tile = dm->getTile(col, row, true);
+        warnTiles << "Wrong tile header:" << (const char*)headerBuffer.data();
+        return false;
+    }
 
-    tile->lockForWrite();
-    stream->read((char *)tile->data(), tileDataSize);
-    tile->unlockForWrite();
+    if (width == KisTileData::WIDTH && height == KisTileData::HEIGHT) {
+        qint32 row = yToRow(dm, y);
+        qint32 col = xToCol(dm, x);
+
+        KisTileSP tile = dm->getTile(col, row, true);
+
+        tile->lockForWrite();
+        stream->read((char *)tile->data(), tileDataSize);
+        tile->unlockForWrite();
+    } else {
+        /**
+         * The tiles in the file have a size different from the
+         * one this build of Krita uses (see KRITA_TILE_SIZE)
+         */
+        QByteArray data(pixelSize(dm) * width * height, 0);
+        stream->read(data.data(), data.size());
+        writeBytes(dm, (const quint8*)data.constData(), QRect(x, y, width, height));
+    }
 
     return true;
 }
@@ -77,6 +77,26 @@ quint8* KisMemoryWindow::getWriteChunkPtr(const KisChunkData &writeChunk)
     return m_writeWindowEx.calculatePointer(writeChunk);
 }
 
+bool KisMemoryWindow::truncate(quint64 size)
+{
+    if (!m_valid || (quint64)m_file.size() <= size) {
+        return true;
+    }
+
+    // the windows may map the part of the file we are going to cut off
+    if (m_readWindowEx.window) {
+        m_file.unmap(m_readWindowEx.window);
+        m_readWindowEx.window = 0;
+    }
+
+    if (m_writeWindowEx.window) {
+        m_file.unmap(m_writeWindowEx.window);
+        m_writeWindowEx.window = 0;
+    }
+
+    return m_file.resize(size);
+}
+
 bool KisMemoryWindow::adjustWindow(const KisChunkData &requestedChunk,
                                    MappingWindow *adjustingWindow,
                                    MappingWindow *otherWindow)
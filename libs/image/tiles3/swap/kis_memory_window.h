@@ -47,6 +47,12 @@ public:
     quint8* getReadChunkPtr(const KisChunkData &readChunk);
     quint8* getWriteChunkPtr(const KisChunkData &writeChunk);
 
+    /**
+     * Truncates the swap file to \p size bytes if it is bigger.
+     * All the pointers returned earlier become invalid.
+     */
+    bool truncate(quint64 size);
+
 private:
     struct MappingWindow {
         MappingWindow(quint64 _defaultSize)
@@ -16,28 +16,55 @@
  *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
  */
 
-//#include "kis_debug.h"
+#include "kis_debug.h"
 #include "kis_swapped_data_store.h"
 #include "kis_memory_window.h"
 #include "kis_image_config.h"
 
 #include "kis_tile_compressor_2.h"
+#include "kis_lzf_compression.h"
+
+#include <config-zstd.h>
+#ifdef HAVE_ZSTD
+#include "kis_zstd_compression.h"
+#endif
 
 //#define COMPRESSOR_VERSION 2
 
 KisSwappedDataStore::KisSwappedDataStore()
-    : m_memoryMetric(0)
+    : m_cacheSize(0),
+      m_deltasSize(0),
+      m_compactionInProgress(false),
+      m_memoryMetric(0)
 {
     KisImageConfig config(true);
     const quint64 maxSwapSize = config.maxSwapSize() * MiB;
     const quint64 swapSlabSize = config.swapSlabSize() * MiB;
     const quint64 swapWindowSize = config.swapWindowSize() * MiB;
 
+    m_cacheLimit = qint64(qMax(0, config.maxCompressedSwapCacheSize())) * MiB;
+    m_historyDeltasEnabled = config.compressHistoryDeltas();
+    m_undoRevisionsInMemory = qMax(0, config.undoRevisionsInMemory());
+
     m_allocator = new KisChunkAllocator(swapSlabSize, maxSwapSize);
     m_swapSpace = new KisMemoryWindow(config.swapDir(), swapWindowSize);
 
+    m_compactionThreshold = 0.01 * qBound(0, config.swapCompactionThreshold(), 100);
+
+    KisAbstractCompression *compression = 0;
+
+#ifdef HAVE_ZSTD
+    if (config.swapCompression() == "zstd") {
+        compression = new KisZstdCompression(config.swapCompressionLevel());
+    }
+#endif
+
+    if (!compression) {
+        compression = new KisLzfCompression();
+    }
+
     // FIXME: use a factory after the patch is committed
-    m_compressor = new KisTileCompressor2();
+    m_compressor = new KisTileCompressor2(compression);
 }
 
 KisSwappedDataStore::~KisSwappedDataStore()
@@ -49,13 +76,11 @@ KisSwappedDataStore::~KisSwappedDataStore()
 
 quint64 KisSwappedDataStore::numTiles() const
 {
-    // We are not acquiring the lock here...
-    // Hope QLinkedList will ensure atomic access to it's size...
-
-    return m_allocator->numChunks();
+    QMutexLocker locker(&m_lock);
+    return m_allocator->numChunks() + m_cacheQueue.size() + m_deltas.size();
 }
 
-bool KisSwappedDataStore::trySwapOutTileData(KisTileData *td)
+bool KisSwappedDataStore::trySwapOutTileData(KisTileData *td, bool bypassCache)
 {
     Q_ASSERT(td->data());
     QMutexLocker locker(&m_lock);
@@ -73,59 +98,392 @@ bool KisSwappedDataStore::trySwapOutTileData(KisTileData *td)
     qint32 bytesWritten;
     m_compressor->compressTileData(td, (quint8*) m_buffer.data(), m_buffer.size(), bytesWritten);
 
-    KisChunk chunk = m_allocator->getChunk(bytesWritten);
-    quint8 *ptr = m_swapSpace->getWriteChunkPtr(chunk);
-    if (!ptr) {
-        qWarning() << "swap out of tile failed";
-        return false;
+    if (!bypassCache && bytesWritten <= m_cacheLimit) {
+        /**
+         * The tile goes to the in-memory tier first. If the tier
+         * overflows, the oldest tiles are spilled to the swap file.
+         * Please note that the spilled tiles are not locked, but it
+         * is safe, because their swap chunk is accessed under
+         * m_lock only.
+         */
+        CachedTileData &cached = m_cache[td];
+        cached.data = QByteArray(m_buffer.constData(), bytesWritten);
+        cached.position = m_cacheQueue.insert(m_cacheQueue.end(), td);
+        m_cacheSize += bytesWritten;
+
+        while (m_cacheSize > m_cacheLimit && m_cacheQueue.first() != td) {
+            if (!spillOldestCachedTileData()) break;
+        }
+    } else {
+        KisChunk chunk = m_allocator->getChunk(bytesWritten);
+        if (!writeChunk(chunk, (const quint8*) m_buffer.constData())) {
+            qWarning() << "swap out of tile failed";
+            m_allocator->freeChunk(chunk);
+            return false;
+        }
+
+        td->setSwapChunk(chunk);
     }
-    memcpy(ptr, m_buffer.data(), bytesWritten);
 
     td->releaseMemory();
-    td->setSwapChunk(chunk);
 
     m_memoryMetric += td->pixelSize();
 
     return true;
 }
 
-void KisSwappedDataStore::swapInTileData(KisTileData *td)
+bool KisSwappedDataStore::spillOldestCachedTileData()
+{
+    KisTileData *td = m_cacheQueue.first();
+    QHash<KisTileData*, CachedTileData>::iterator it = m_cache.find(td);
+    KIS_ASSERT_RECOVER_RETURN_VALUE(it != m_cache.end(), false);
+
+    const QByteArray &data = it->data;
+
+    KisChunk chunk = m_allocator->getChunk(data.size());
+    if (!writeChunk(chunk, (const quint8*) data.constData())) {
+        qWarning() << "spilling of the compressed tile to the swap file failed";
+        m_allocator->freeChunk(chunk);
+        return false;
+    }
+    td->setSwapChunk(chunk);
+
+    forgetCachedTileData(td);
+    return true;
+}
+
+bool KisSwappedDataStore::writeChunk(KisChunk chunk, const quint8 *data)
+{
+    quint8 *ptr = m_swapSpace->getWriteChunkPtr(chunk);
+    if (!ptr) return false;
+
+    memcpy(ptr, data, chunk.size());
+    chunk.setChecksum(qHashBits(data, chunk.size()));
+
+    return true;
+}
+
+void KisSwappedDataStore::forgetCachedTileData(KisTileData *td)
+{
+    QHash<KisTileData*, CachedTileData>::iterator it = m_cache.find(td);
+
+    m_cacheSize -= it->data.size();
+    m_cacheQueue.erase(it->position);
+    m_cache.erase(it);
+}
+
+bool KisSwappedDataStore::swapInTileData(KisTileData *td, KisTileData *loadedDeltaBase)
 {
     Q_ASSERT(!td->data());
     QMutexLocker locker(&m_lock);
 
     // see comment in swapOutTileData()
 
-    KisChunk chunk = td->swapChunk();
+    QHash<KisTileData*, DeltaTileData>::iterator deltaIt = m_deltas.find(td);
+
+    if (deltaIt != m_deltas.end()) {
+        KisTileData *base = deltaIt->base;
+        if (base != loadedDeltaBase) return false;
+
+        KIS_SAFE_ASSERT_RECOVER_RETURN_VALUE(base->data(), false);
+
+        const qint32 dataSize = td->pixelSize() * KisTileData::WIDTH * KisTileData::HEIGHT;
+
+        td->allocateMemory();
+        if (m_compressor->decompressTileData((quint8*) deltaIt->data.data(), deltaIt->data.size(), td)) {
+            quint8 *data = td->data();
+            const quint8 *baseData = base->data();
+            for (qint32 i = 0; i < dataSize; i++) {
+                data[i] ^= baseData[i];
+            }
+
+            if (qHashBits(data, dataSize) != deltaIt->checksum) {
+                recoverLostTileData(td, "checksum mismatch in a delta-compressed tile of the undo history");
+            }
+        } else {
+            recoverLostTileData(td, "failed to decompress a delta-compressed tile of the undo history");
+        }
+
+        m_deltasSize -= deltaIt->data.size();
+        m_deltas.erase(deltaIt);
+
+        // the caller holds one more reference to the base,
+        // so it will not be deleted here
+        base->deref();
+
+        m_memoryMetric -= td->pixelSize();
+        return true;
+    }
 
     td->allocateMemory();
-    td->setSwapChunk(KisChunk());
 
-    quint8 *ptr = m_swapSpace->getReadChunkPtr(chunk);
-    Q_ASSERT(ptr);
-    m_compressor->decompressTileData(ptr, chunk.size(), td);
-    m_allocator->freeChunk(chunk);
+    QHash<KisTileData*, CachedTileData>::iterator it = m_cache.find(td);
+
+    if (it != m_cache.end()) {
+        if (!m_compressor->decompressTileData((quint8*) it->data.data(), it->data.size(), td)) {
+            recoverLostTileData(td, "failed to decompress a cached tile");
+        }
+        forgetCachedTileData(td);
+    } else {
+        KisChunk chunk = td->swapChunk();
+        td->setSwapChunk(KisChunk());
+
+        quint8 *ptr = m_swapSpace->getReadChunkPtr(chunk);
+        Q_ASSERT(ptr);
+
+        if (!ptr || qHashBits(ptr, chunk.size()) != chunk.checksum()) {
+            recoverLostTileData(td, "checksum mismatch when reading a tile from the swap file");
+        } else if (!m_compressor->decompressTileData(ptr, chunk.size(), td)) {
+            recoverLostTileData(td, "failed to decompress a tile from the swap file");
+        }
+
+        m_allocator->freeChunk(chunk);
+    }
 
     m_memoryMetric -= td->pixelSize();
+    return true;
 }
 
-void KisSwappedDataStore::forgetTileData(KisTileData *td)
+void KisSwappedDataStore::recoverLostTileData(KisTileData *td, const char *reason)
+{
+    /**
+     * The content of the tile is lost, we cannot do anything better
+     * than return a tile filled with the default pixel of its device.
+     * The tile data doesn't know its device, so the tile that locks
+     * it next will do the filling, see KisTile::recoverLostData().
+     */
+    qWarning() << "KisSwappedDataStore:" << reason
+               << "- the tile will be reset to the default pixel";
+    memset(td->data(), 0, td->pixelSize() * KisTileData::WIDTH * KisTileData::HEIGHT);
+    td->setLost(true);
+}
+
+KisTileData* KisSwappedDataStore::forgetTileData(KisTileData *td)
 {
     QMutexLocker locker(&m_lock);
 
-    m_allocator->freeChunk(td->swapChunk());
-    td->setSwapChunk(KisChunk());
+    KisTileData *deltaBase = 0;
+    QHash<KisTileData*, DeltaTileData>::iterator deltaIt = m_deltas.find(td);
+
+    if (deltaIt != m_deltas.end()) {
+        deltaBase = deltaIt->base;
+        m_deltasSize -= deltaIt->data.size();
+        m_deltas.erase(deltaIt);
+    } else if (m_cache.contains(td)) {
+        forgetCachedTileData(td);
+    } else {
+        m_allocator->freeChunk(td->swapChunk());
+        td->setSwapChunk(KisChunk());
+    }
 
     m_memoryMetric -= td->pixelSize();
+
+    return deltaBase;
+}
+
+void KisSwappedDataStore::addDeltaCandidates(const QVector<DeltaCandidate> &candidates)
+{
+    Q_FOREACH (const DeltaCandidate &candidate, candidates) {
+        candidate.first->ref();
+        candidate.second->ref();
+    }
+
+    QMutexLocker locker(&m_lock);
+    m_deltaCandidates += candidates;
+}
+
+QVector<KisSwappedDataStore::DeltaCandidate> KisSwappedDataStore::takeDeltaCandidates()
+{
+    QMutexLocker locker(&m_lock);
+
+    QVector<DeltaCandidate> candidates;
+    candidates.swap(m_deltaCandidates);
+    return candidates;
+}
+
+bool KisSwappedDataStore::tryStoreDelta(KisTileData *td, KisTileData *base)
+{
+    Q_ASSERT(td->data());
+    Q_ASSERT(base->data());
+    Q_ASSERT(td->pixelSize() == base->pixelSize());
+
+    QMutexLocker locker(&m_lock);
+
+    const qint32 dataSize = td->pixelSize() * KisTileData::WIDTH * KisTileData::HEIGHT;
+    quint8 *data = td->data();
+    const quint8 *baseData = base->data();
+
+    const uint checksum = qHashBits(data, dataSize);
+
+    /**
+     * The tile data is going to be freed, so we can
+     * calculate the delta right in place
+     */
+    for (qint32 i = 0; i < dataSize; i++) {
+        data[i] ^= baseData[i];
+    }
+
+    const qint32 expectedBufferSize = m_compressor->tileDataBufferSize(td);
+    if(m_buffer.size() < expectedBufferSize)
+        m_buffer.resize(expectedBufferSize);
+
+    qint32 bytesWritten;
+    m_compressor->compressTileData(td, (quint8*) m_buffer.data(), m_buffer.size(), bytesWritten);
+
+    /**
+     * If the revisions differ too much, the usual swapping
+     * will do better, so just restore the data back
+     */
+    if (bytesWritten > dataSize / 4) {
+        for (qint32 i = 0; i < dataSize; i++) {
+            data[i] ^= baseData[i];
+        }
+        return false;
+    }
+
+    DeltaTileData &delta = m_deltas[td];
+    delta.data = QByteArray(m_buffer.constData(), bytesWritten);
+    delta.base = base;
+    delta.checksum = checksum;
+    base->ref();
+
+    m_deltasSize += bytesWritten;
+
+    td->releaseMemory();
+
+    m_memoryMetric += td->pixelSize();
+
+    return true;
+}
+
+void KisSwappedDataStore::addSpillCandidates(const QVector<KisTileData*> &candidates)
+{
+    Q_FOREACH (KisTileData *td, candidates) {
+        td->ref();
+    }
+
+    QMutexLocker locker(&m_lock);
+    m_spillCandidates += candidates;
+}
+
+QVector<KisTileData*> KisSwappedDataStore::takeSpillCandidates()
+{
+    QMutexLocker locker(&m_lock);
+
+    QVector<KisTileData*> candidates;
+    candidates.swap(m_spillCandidates);
+    return candidates;
+}
+
+KisTileData* KisSwappedDataStore::deltaBase(KisTileData *td)
+{
+    QMutexLocker locker(&m_lock);
+
+    QHash<KisTileData*, DeltaTileData>::const_iterator it = m_deltas.constFind(td);
+    if (it == m_deltas.constEnd()) return 0;
+
+    it->base->ref();
+    return it->base;
 }
 
 qint64 KisSwappedDataStore::totalMemoryMetric() const
 {
+    QMutexLocker locker(&m_lock);
     return m_memoryMetric;
 }
 
+qint64 KisSwappedDataStore::compressedCacheSize() const
+{
+    QMutexLocker locker(&m_lock);
+    return m_cacheSize + m_deltasSize;
+}
+
+bool KisSwappedDataStore::compactSwapFile(qint64 maxBytes)
+{
+    qint64 bytesMoved = 0;
+
+    while (bytesMoved < maxBytes) {
+        /**
+         * The mapping windows are remapped by every swap operation,
+         * so the swap file can be accessed under m_lock only. The
+         * lock is taken for every chunk separately, so the compaction
+         * never blocks swapping for longer than a copy of a single
+         * tile. The allocator keeps its compaction position valid
+         * when the chunks are freed in the meantime.
+         */
+        QMutexLocker locker(&m_lock);
+
+        if (!m_compactionInProgress) {
+            if (m_allocator->fragmentation() <= m_compactionThreshold) {
+                return false;
+            }
+            m_allocator->startCompaction();
+            m_compactionInProgress = true;
+        }
+
+        KisChunk chunk;
+        KisChunkData oldChunk(0, 0);
+
+        if (!m_allocator->compactNextChunk(&chunk, &oldChunk)) {
+            const quint64 usedSize = m_allocator->shrinkStore();
+            if (!m_swapSpace->truncate(usedSize)) {
+                qWarning() << "KisSwappedDataStore: failed to truncate the swap file";
+            }
+
+            m_compactionInProgress = false;
+            return false;
+        }
+
+        /**
+         * The new position of the chunk may overlap with the old
+         * one, so we cannot copy the data directly between the
+         * mapping windows
+         */
+        if (m_buffer.size() < (int)chunk.size()) {
+            m_buffer.resize(chunk.size());
+        }
+
+        const quint8 *ptr = m_swapSpace->getReadChunkPtr(oldChunk);
+        if (ptr) {
+            memcpy(m_buffer.data(), ptr, chunk.size());
+        }
+
+        if (!ptr || !writeChunk(chunk, (const quint8*) m_buffer.constData())) {
+            qWarning() << "KisSwappedDataStore: failed to move a chunk during compaction of the swap file";
+            chunk.position()->setChunk(oldChunk.m_begin, oldChunk.size());
+            m_compactionInProgress = false;
+            return false;
+        }
+
+        bytesMoved += chunk.size();
+    }
+
+    return true;
+}
+
 void KisSwappedDataStore::debugStatistics()
 {
+    dbgKrita << "Compressed tiles in memory:" << m_cacheQueue.size()
+             << "(" << m_cacheSize << "bytes )";
+    dbgKrita << "Delta-compressed history tiles:" << m_deltas.size()
+             << "(" << m_deltasSize << "bytes )";
     m_allocator->sanityCheck();
     m_allocator->debugFragmentation();
 }
+
+void KisSwappedDataStore::testingRereadConfig()
+{
+    KisImageConfig config(true);
+    m_historyDeltasEnabled = config.compressHistoryDeltas();
+    m_undoRevisionsInMemory = qMax(0, config.undoRevisionsInMemory());
+}
+
+void KisSwappedDataStore::testingCorruptSwappedTileData(KisTileData *td)
+{
+    QMutexLocker locker(&m_lock);
+
+    quint8 *ptr = m_swapSpace->getWriteChunkPtr(td->swapChunk());
+    KIS_SAFE_ASSERT_RECOVER_RETURN(ptr);
+
+    *ptr ^= 0xff;
+}
@@ -23,16 +23,28 @@
 
 #include <QMutex>
 #include <QByteArray>
+#include <QHash>
+#include <QLinkedList>
+#include <QPair>
+#include <QVector>
 
 
 class QMutex;
 class KisTileData;
 class KisAbstractTileCompressor;
 class KisChunkAllocator;
+class KisChunk;
 class KisMemoryWindow;
 
 class KRITAIMAGE_EXPORT KisSwappedDataStore
 {
+public:
+    /**
+     * A historical tile data and the tile data of the following
+     * revision of the same tile it can be delta-compressed against
+     */
+    typedef QPair<KisTileData*, KisTileData*> DeltaCandidate;
+
 public:
     KisSwappedDataStore();
     ~KisSwappedDataStore();
@@ -43,27 +55,85 @@ public:
     quint64 numTiles() const;
 
     /**
-     * Swap out the data stored in the \a td to the swap file
-     * and free memory occupied by td->data().
+     * Swap out the data stored in the \a td and free memory occupied
+     * by td->data(). The data is compressed and kept in the in-memory
+     * tier first. The oldest tiles of the tier are spilled to the swap
+     * file when the tier exceeds its limit. If \p bypassCache is true,
+     * the data is written to the swap file directly.
      * LOCKING: the lock on the tile data should be taken
      *          by the caller before making a call.
      */
-    bool trySwapOutTileData(KisTileData *td);
+    bool trySwapOutTileData(KisTileData *td, bool bypassCache = false);
 
     /**
      * Restore the data of a \a td basing on information
      * stored in the swap file.
+     *
+     * If \p td is delta-compressed, \p loadedDeltaBase must be
+     * its base returned by deltaBase() and loaded into memory.
+     * Otherwise nothing is done and false is returned.
+     *
      * LOCKING: the lock on the tile data should be taken
      *          by the caller before making a call.
      */
-    void swapInTileData(KisTileData *td);
+    bool swapInTileData(KisTileData *td, KisTileData *loadedDeltaBase = 0);
 
     /**
      * Forget all the information linked with the tile data.
      * This should be done before deleting of the tile data,
      * whose actual data is swapped-out
+     *
+     * \return the base of the delta-compressed tile data or null.
+     *         The caller should deref() it after releasing all
+     *         the locks.
+     */
+    KisTileData* forgetTileData(KisTileData *td);
+
+    /**
+     * Returns true if the tile datas of the undo history should be
+     * delta-compressed (see KisImageConfig::compressHistoryDeltas())
+     */
+    inline bool historyDeltasEnabled() const {
+        return m_historyDeltasEnabled;
+    }
+
+    /**
+     * Queues the pairs of tile datas for delta-compression. The
+     * candidates are ref'ed until they are taken by the caller
+     * of takeDeltaCandidates().
+     */
+    void addDeltaCandidates(const QVector<DeltaCandidate> &candidates);
+    QVector<DeltaCandidate> takeDeltaCandidates();
+
+    /**
+     * \see KisImageConfig::undoRevisionsInMemory()
+     */
+    inline int undoRevisionsInMemory() const {
+        return m_undoRevisionsInMemory;
+    }
+
+    /**
+     * Queues the tile datas of old revisions to be written
+     * to the swap file. The tile datas are ref'ed until they
+     * are taken by the caller of takeSpillCandidates().
+     */
+    void addSpillCandidates(const QVector<KisTileData*> &candidates);
+    QVector<KisTileData*> takeSpillCandidates();
+
+    /**
+     * Stores the data of \a td as a compressed XOR-delta against
+     * the data of \p base and frees memory occupied by td->data().
+     * Fails if the delta does not compress well.
+     * LOCKING: the lock on the tile data should be taken and
+     *          the base should be loaded by the caller.
      */
-    void forgetTileData(KisTileData *td);
+    bool tryStoreDelta(KisTileData *td, KisTileData *base);
+
+    /**
+     * Returns a ref'ed base of the delta-compressed \p td
+     * or null if the tile data is not delta-compressed
+     */
+    KisTileData* deltaBase(KisTileData *td);
 
     /**
      * Retorns the metric of the total memory stored in the swap
@@ -71,19 +141,79 @@ public:
      */
     qint64 totalMemoryMetric() const;
 
+    /**
+     * Returns the number of bytes the compressed tiles of
+     * the in-memory tier and the history deltas occupy in RAM
+     */
+    qint64 compressedCacheSize() const;
+
+    /**
+     * Does one step of the online compaction of the swap file:
+     * moves the chunks to the holes in front of them, until
+     * \p maxBytes bytes have been moved. When a sweep over the
+     * whole file is completed, the file is truncated.
+     *
+     * The sweep is started only when the fragmentation of the
+     * file exceeds the configured threshold.
+     *
+     * \return true if there is more work to do
+     */
+    bool compactSwapFile(qint64 maxBytes);
+
     /**
      * Some debugging output
      */
     void debugStatistics();
 
+    void testingRereadConfig();
+
+    /**
+     * Damages the data of \p td written to the swap file, so the
+     * checksum will not match when the tile data is swapped in
+     */
+    void testingCorruptSwappedTileData(KisTileData *td);
+
 private:
+    bool spillOldestCachedTileData();
+    void forgetCachedTileData(KisTileData *td);
+    bool writeChunk(KisChunk chunk, const quint8 *data);
+    void recoverLostTileData(KisTileData *td, const char *reason);
+
+private:
+    struct CachedTileData {
+        QByteArray data;
+        QLinkedList<KisTileData*>::iterator position;
+    };
+
+    QHash<KisTileData*, CachedTileData> m_cache;
+    QLinkedList<KisTileData*> m_cacheQueue;
+    qint64 m_cacheSize;
+    qint64 m_cacheLimit;
+
+    struct DeltaTileData {
+        QByteArray data;
+        KisTileData *base;
+        uint checksum;
+    };
+
+    QHash<KisTileData*, DeltaTileData> m_deltas;
+    QVector<DeltaCandidate> m_deltaCandidates;
+    qint64 m_deltasSize;
+    bool m_historyDeltasEnabled;
+
+    QVector<KisTileData*> m_spillCandidates;
+    int m_undoRevisionsInMemory;
+
     QByteArray m_buffer;
     KisAbstractTileCompressor *m_compressor;
 
     KisChunkAllocator *m_allocator;
     KisMemoryWindow *m_swapSpace;
 
-    QMutex m_lock;
+    mutable QMutex m_lock;
+
+    qreal m_compactionThreshold;
+    bool m_compactionInProgress;
 
     qint64 m_memoryMetric;
 };
@@ -30,6 +30,11 @@ KisTileCompressor2::KisTileCompressor2()
     m_compression = new KisLzfCompression();
 }
 
+KisTileCompressor2::KisTileCompressor2(KisAbstractCompression *compression)
+    : m_compression(compression)
+{
+}
+
 KisTileCompressor2::~KisTileCompressor2()
 {
     delete m_compression;
@@ -40,14 +45,58 @@ bool KisTileCompressor2::writeTile(KisTileSP tile, KisPaintDeviceWriter &store)
     const qint32 tileDataSize = TILE_DATA_SIZE(tile->pixelSize());
     prepareStreamingBuffer(tileDataSize);
 
-    qint32 bytesWritten;
+    if (KisTileData::WIDTH == FILE_TILE_SIZE && KisTileData::HEIGHT == FILE_TILE_SIZE) {
+        qint32 bytesWritten;
+
+        tile->lockForRead();
+        compressTileData(tile->tileData(), (quint8*)m_streamingBuffer.data(),
+                         m_streamingBuffer.size(), bytesWritten);
+        tile->unlockForRead();
 
-    tile->lockForRead();
-    compressTileData(tile->tileData(), (quint8*)m_streamingBuffer.data(),
-                     m_streamingBuffer.size(), bytesWritten);
-    tile->unlockForRead();
+        return writeTileChunk(tile->extent().topLeft(), bytesWritten, store);
+    }
+
+    /**
+     * Our tiles are bigger than the ones of the file format (see
+     * KRITA_TILE_SIZE), split them into FILE_TILE_SIZE chunks
+     */
+    const qint32 pixelSize = tile->pixelSize();
+    const qint32 chunkDataSize = pixelSize * FILE_TILE_SIZE * FILE_TILE_SIZE;
+    const qint32 tileRowStride = pixelSize * KisTileData::WIDTH;
+    const qint32 chunkRowStride = pixelSize * FILE_TILE_SIZE;
+
+    m_foreignTileBuffer.resize(chunkDataSize);
 
-    QString header = getHeader(tile, bytesWritten);
+    bool retval = true;
+
+    for (qint32 chunkY = 0; retval && chunkY < KisTileData::HEIGHT; chunkY += FILE_TILE_SIZE) {
+        for (qint32 chunkX = 0; retval && chunkX < KisTileData::WIDTH; chunkX += FILE_TILE_SIZE) {
+            quint8 *dstPtr = (quint8*)m_foreignTileBuffer.data();
+
+            tile->lockForRead();
+            const quint8 *srcPtr = tile->data() + chunkY * tileRowStride + chunkX * pixelSize;
+            for (qint32 row = 0; row < FILE_TILE_SIZE; row++) {
+                memcpy(dstPtr, srcPtr, chunkRowStride);
+                dstPtr += chunkRowStride;
+                srcPtr += tileRowStride;
+            }
+            tile->unlockForRead();
+
+            qint32 bytesWritten;
+            compressData((const quint8*)m_foreignTileBuffer.constData(), chunkDataSize, pixelSize,
+                         (quint8*)m_streamingBuffer.data(), bytesWritten);
+
+            retval = writeTileChunk(tile->extent().topLeft() + QPoint(chunkX, chunkY),
+                                    bytesWritten, store);
+        }
+    }
+
+    return retval;
+}
+
+bool KisTileCompressor2::writeTileChunk(const QPoint &pos, qint32 bytesWritten, KisPaintDeviceWriter &store)
+{
+    QString header = getHeader(pos, bytesWritten);
     bool retval = true;
     retval = store.write(header.toLatin1());
     if (!retval) {
@@ -62,8 +111,8 @@ bool KisTileCompressor2::writeTile(KisTileSP tile, KisPaintDeviceWriter &store)
 
 bool KisTileCompressor2::readTile(QIODevice *stream, KisTiledDataManager *dm)
 {
-    const qint32 tileDataSize = TILE_DATA_SIZE(pixelSize(dm));
-    prepareStreamingBuffer(tileDataSize);
+    const qint32 streamTileDataSize = pixelSize(dm) * m_streamTileWidth * m_streamTileHeight;
+    prepareStreamingBuffer(streamTileDataSize);
 
     QByteArray header = stream->readLine(maxHeaderLength());
 
@@ -77,17 +126,40 @@ bool KisTileCompressor2::readTile(QIODevice *stream, KisTiledDataManager *dm)
         Q_ASSERT(headerItems.isEmpty());
         Q_ASSERT(compressionName == m_compressionName);
 
-        qint32 row = yToRow(dm, y);
-        qint32 col = xToCol(dm, x);
-
-        KisTileSP tile = dm->getTile(col, row, true);
+        if (dataSize <= 0 || dataSize > m_streamingBuffer.size()) {
+            warnTiles << "Wrong size of the tile data:" << dataSize;
+            return false;
+        }
 
         stream->read(m_streamingBuffer.data(), dataSize);
 
-        tile->lockForWrite();
-        bool res = decompressTileData((quint8*)m_streamingBuffer.data(), dataSize, tile->tileData());
-        tile->unlockForWrite();
-        return res;
+        if (streamHasNativeTileSize()) {
+            qint32 row = yToRow(dm, y);
+            qint32 col = xToCol(dm, x);
+
+            KisTileSP tile = dm->getTile(col, row, true);
+
+            tile->lockForWrite();
+            bool res = decompressTileData((quint8*)m_streamingBuffer.data(), dataSize, tile->tileData());
+            tile->unlockForWrite();
+            return res;
+        } else {
+            /**
+             * The file has been saved by a build with a different
+             * tile size, so the pixels should be rearranged into
+             * the tiles of our own size
+             */
+            m_foreignTileBuffer.resize(streamTileDataSize);
+
+            bool res = decompressData((quint8*)m_streamingBuffer.data(), dataSize,
+                                      (quint8*)m_foreignTileBuffer.data(),
+                                      streamTileDataSize, pixelSize(dm));
+            if (res) {
+                writeBytes(dm, (const quint8*)m_foreignTileBuffer.constData(),
+                           QRect(x, y, m_streamTileWidth, m_streamTileHeight));
+            }
+            return res;
+        }
     }
     return false;
 }
@@ -116,28 +188,36 @@ void KisTileCompressor2::compressTileData(KisTileData *tileData,
 {
     const qint32 pixelSize = tileData->pixelSize();
     const qint32 tileDataSize = TILE_DATA_SIZE(pixelSize);
-    qint32 compressedBytes;
 
     Q_UNUSED(bufferSize);
     Q_ASSERT(bufferSize >= tileDataSize + 1);
 
-    prepareWorkBuffers(tileDataSize);
+    compressData(tileData->data(), tileDataSize, pixelSize, buffer, bytesWritten);
+}
+
+void KisTileCompressor2::compressData(const quint8 *data, qint32 dataSize,
+                                      qint32 pixelSize,
+                                      quint8 *buffer, qint32 &bytesWritten)
+{
+    qint32 compressedBytes;
+
+    prepareWorkBuffers(dataSize);
 
-    KisAbstractCompression::linearizeColors(tileData->data(), (quint8*)m_linearizationBuffer.data(),
-                                            tileDataSize, pixelSize);
+    KisAbstractCompression::linearizeColors(const_cast<quint8*>(data), (quint8*)m_linearizationBuffer.data(),
+                                            dataSize, pixelSize);
 
-    compressedBytes = m_compression->compress((quint8*)m_linearizationBuffer.data(), tileDataSize,
+    compressedBytes = m_compression->compress((quint8*)m_linearizationBuffer.data(), dataSize,
                                               (quint8*)m_compressionBuffer.data(), m_compressionBuffer.size());
 
-    if(compressedBytes < tileDataSize) {
+    if(compressedBytes > 0 && compressedBytes < dataSize) {
         buffer[0] = COMPRESSED_DATA_FLAG;
         memcpy(buffer + 1, m_compressionBuffer.data(), compressedBytes);
         bytesWritten = compressedBytes + 1;
     }
     else {
         buffer[0] = RAW_DATA_FLAG;
-        memcpy(buffer + 1, tileData->data(), tileDataSize);
-        bytesWritten = tileDataSize + 1;
+        memcpy(buffer + 1, data, dataSize);
+        bytesWritten = dataSize + 1;
     }
 }
 
@@ -148,22 +228,29 @@ bool KisTileCompressor2::decompressTileData(quint8 *buffer,
     const qint32 pixelSize = tileData->pixelSize();
     const qint32 tileDataSize = TILE_DATA_SIZE(pixelSize);
 
+    return decompressData(buffer, bufferSize, tileData->data(), tileDataSize, pixelSize);
+}
+
+bool KisTileCompressor2::decompressData(quint8 *buffer, qint32 bufferSize,
+                                        quint8 *data, qint32 dataSize,
+                                        qint32 pixelSize)
+{
     if(buffer[0] == COMPRESSED_DATA_FLAG) {
-        prepareWorkBuffers(tileDataSize);
+        prepareWorkBuffers(dataSize);
 
         qint32 bytesWritten;
         bytesWritten = m_compression->decompress(buffer + 1, bufferSize - 1,
-                                                 (quint8*)m_linearizationBuffer.data(), tileDataSize);
-        if (bytesWritten == tileDataSize) {
+                                                 (quint8*)m_linearizationBuffer.data(), dataSize);
+        if (bytesWritten == dataSize) {
             KisAbstractCompression::delinearizeColors((quint8*)m_linearizationBuffer.data(),
-                                                      tileData->data(),
-                                                      tileDataSize, pixelSize);
+                                                      data,
+                                                      dataSize, pixelSize);
             return true;
         }
         return false;
     }
     else {
-        memcpy(tileData->data(), buffer + 1, tileDataSize);
+        memcpy(data, buffer + 1, dataSize);
         return true;
     }
     return false;
@@ -184,12 +271,8 @@ inline qint32 KisTileCompressor2::maxHeaderLength()
     return 3 * QINT32_LENGTH + COMPRESSION_NAME_LENGTH + SEPARATORS_LENGTH;
 }
 
-inline QString KisTileCompressor2::getHeader(KisTileSP tile,
+inline QString KisTileCompressor2::getHeader(const QPoint &pos,
                                              qint32 compressedSize)
 {
-    qint32 x, y;
-    qint32 width, height;
-    tile->extent().getRect(&x, &y, &width, &height);
-
-    return QString("%1,%2,%3,%4\n").arg(x).arg(y).arg(m_compressionName).arg(compressedSize);
+    return QString("%1,%2,%3,%4\n").arg(pos.x()).arg(pos.y()).arg(m_compressionName).arg(compressedSize);
 }
@@ -27,6 +27,16 @@ class KRITAIMAGE_EXPORT KisTileCompressor2 : public KisAbstractTileCompressor
 {
 public:
     KisTileCompressor2();
+
+    /**
+     * Creates a compressor that uses \p compression for packing
+     * the tile data. The compressor takes ownership of the object.
+     *
+     * NOTE: the name of the compression is not saved into the
+     * stream, so such compressors should be used for swapping
+     * only, never for writing .kra files.
+     */
+    KisTileCompressor2(KisAbstractCompression *compression);
     ~KisTileCompressor2() override;
 
     bool writeTile(KisTileSP tile, KisPaintDeviceWriter &store) override;
@@ -44,11 +54,21 @@ private:
      */
     qint32 maxHeaderLength();
 
-    QString getHeader(KisTileSP tile, qint32 compressedSize);
+    QString getHeader(const QPoint &pos, qint32 compressedSize);
+
+    bool writeTileChunk(const QPoint &pos, qint32 bytesWritten, KisPaintDeviceWriter &store);
+
+    void compressData(const quint8 *data, qint32 dataSize,
+                      qint32 pixelSize,
+                      quint8 *buffer, qint32 &bytesWritten);
 
     void prepareWorkBuffers(qint32 tileDataSize);
     void prepareStreamingBuffer(qint32 tileDataSize);
 
+    bool decompressData(quint8 *buffer, qint32 bufferSize,
+                        quint8 *data, qint32 dataSize,
+                        qint32 pixelSize);
+
 private:
     static const qint8 RAW_DATA_FLAG = 0;
     static const qint8 COMPRESSED_DATA_FLAG = 1;
@@ -57,6 +77,7 @@ private:
     QByteArray m_linearizationBuffer;
     QByteArray m_compressionBuffer;
     QByteArray m_streamingBuffer;
+    QByteArray m_foreignTileBuffer;
     KisAbstractCompression *m_compression;
     static const QString m_compressionName;
 };
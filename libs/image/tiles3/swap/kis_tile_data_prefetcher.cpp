@@ -0,0 +1,114 @@
+/*
+ *  Copyright (c) 2020 Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "tiles3/swap/kis_tile_data_prefetcher.h"
+
+#include <QMutex>
+#include <QQueue>
+#include <QWaitCondition>
+
+#include "tiles3/kis_tile.h"
+#include "kis_debug.h"
+
+const int KisTileDataPrefetcher::MAX_QUEUE_SIZE = 4096;
+
+
+struct Q_DECL_HIDDEN KisTileDataPrefetcher::Private
+{
+    QMutex lock;
+    QWaitCondition hasWork;
+    QWaitCondition isIdle;
+    QQueue<KisTileSP> queue;
+    bool isProcessing = false;
+    bool shouldExit = false;
+};
+
+KisTileDataPrefetcher::KisTileDataPrefetcher()
+    : QThread(),
+      m_d(new Private())
+{
+}
+
+KisTileDataPrefetcher::~KisTileDataPrefetcher()
+{
+    delete m_d;
+}
+
+void KisTileDataPrefetcher::prefetchTile(KisTileSP tile)
+{
+    QMutexLocker l(&m_d->lock);
+
+    if (m_d->queue.size() >= MAX_QUEUE_SIZE) return;
+
+    m_d->queue.enqueue(tile);
+    m_d->hasWork.wakeOne();
+}
+
+void KisTileDataPrefetcher::terminatePrefetcher()
+{
+    {
+        QMutexLocker l(&m_d->lock);
+        m_d->shouldExit = true;
+        m_d->queue.clear();
+        m_d->hasWork.wakeAll();
+    }
+
+    wait();
+}
+
+void KisTileDataPrefetcher::testingWaitForIdle()
+{
+    QMutexLocker l(&m_d->lock);
+
+    while (!m_d->queue.isEmpty() || m_d->isProcessing) {
+        m_d->isIdle.wait(&m_d->lock);
+    }
+}
+
+void KisTileDataPrefetcher::run()
+{
+    QMutexLocker l(&m_d->lock);
+
+    while (!m_d->shouldExit) {
+        if (m_d->queue.isEmpty()) {
+            m_d->isIdle.wakeAll();
+            m_d->hasWork.wait(&m_d->lock);
+            continue;
+        }
+
+        KisTileSP tile = m_d->queue.dequeue();
+        m_d->isProcessing = true;
+        l.unlock();
+
+        /**
+         * Locking the tile for reading makes the tile data
+         * store load the data from the swap. When the lock is
+         * released, the tile becomes available for swapping
+         * again, but its age is reset, so the swapper will not
+         * pick it up as the first candidate.
+         */
+        tile->lockForRead();
+        tile->unlockForRead();
+        tile.clear();
+
+        l.relock();
+        m_d->isProcessing = false;
+    }
+
+    m_d->isIdle.wakeAll();
+}
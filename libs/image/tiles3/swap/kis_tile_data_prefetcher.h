@@ -0,0 +1,72 @@
+/*
+ *  Copyright (c) 2020 Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#ifndef KIS_TILE_DATA_PREFETCHER_H_
+#define KIS_TILE_DATA_PREFETCHER_H_
+
+#include <QObject>
+#include <QThread>
+
+#include <kis_shared_ptr.h>
+#include "kritaimage_export.h"
+
+class KisTile;
+typedef KisSharedPtr<KisTile> KisTileSP;
+
+
+/**
+ * The prefetcher thread loads the swapped out tiles in the
+ * background. The iterators announce the area they are going
+ * to access beforehand, so the worker threads do not have to
+ * stall on a synchronous read from the swap when they reach
+ * the tiles.
+ */
+class KRITAIMAGE_EXPORT KisTileDataPrefetcher : public QThread
+{
+    Q_OBJECT
+
+public:
+
+    KisTileDataPrefetcher();
+    ~KisTileDataPrefetcher() override;
+
+    /**
+     * Queues \p tile for loading into memory. If the queue is
+     * already full, the request is dropped and the tile will
+     * be loaded synchronously on the first access.
+     */
+    void prefetchTile(KisTileSP tile);
+
+    void terminatePrefetcher();
+
+    /**
+     * Blocks until all the queued tiles are loaded
+     */
+    void testingWaitForIdle();
+
+private:
+    void run() override;
+
+private:
+    static const int MAX_QUEUE_SIZE;
+
+private:
+    struct Private;
+    Private * const m_d;
+};
+
+#endif /* KIS_TILE_DATA_PREFETCHER_H_ */
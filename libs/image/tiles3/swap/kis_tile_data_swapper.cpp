@@ -29,6 +29,7 @@
 
 const qint32 KisTileDataSwapper::TIMEOUT = -1;
 const qint32 KisTileDataSwapper::DELAY = 0.7 * SEC;
+const qint64 KisTileDataSwapper::COMPACTION_STEP = 16 * MiB;
 
 //#define DEBUG_SWAPPER
 
@@ -79,6 +80,9 @@ void KisTileDataSwapper::terminateSwapper()
         m_d->shouldExitFlag = true;
         kick();
     } while(!wait(exitTimeout));
+
+    // let the swapper be started again
+    m_d->shouldExitFlag = false;
 }
 
 void KisTileDataSwapper::waitForWork()
@@ -96,7 +100,22 @@ void KisTileDataSwapper::run()
 
         QThread::msleep(DELAY);
 
+        m_d->store->compressHistory();
+        m_d->store->spillHistory();
         doJob();
+
+        /**
+         * Compact the swap file in small steps, so that the
+         * swapping requests of other threads do not wait for
+         * the swap lock for too long. The compaction is
+         * interrupted as soon as a new job arrives.
+         */
+        while (!m_d->shouldExitFlag &&
+               !m_d->semaphore.available() &&
+               m_d->store->compactSwapFile(COMPACTION_STEP)) {
+
+            QThread::yieldCurrentThread();
+        }
     }
 }
 
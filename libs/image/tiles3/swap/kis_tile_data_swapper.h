@@ -52,6 +52,7 @@ private:
 private:
     static const qint32 TIMEOUT;
     static const qint32 DELAY;
+    static const qint64 COMPACTION_STEP;
 
 private:
     struct Private;
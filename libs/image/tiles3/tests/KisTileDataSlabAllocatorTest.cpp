@@ -0,0 +1,101 @@
+/*
+ *  Copyright (c) 2020 Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "KisTileDataSlabAllocatorTest.h"
+
+#include <QTest>
+
+#include "tiles3/KisTileDataSlabAllocator.h"
+#include "tiles3/kis_tile_data.h"
+#include "tiles_test_utils.h"
+
+
+void KisTileDataSlabAllocatorTest::testAllocateFree()
+{
+    KisTileDataSlabAllocator allocator;
+
+    const QVector<int> pixelSizes({1, 2, 4, 5, 8, 10, 16, 20, 32});
+    QVector<quint8*> chunks;
+
+    Q_FOREACH (int pixelSize, pixelSizes) {
+        const int chunkSize = pixelSize * TILESIZE;
+
+        for (int i = 0; i < 100; i++) {
+            quint8 *ptr = allocator.allocate(pixelSize);
+            QVERIFY(ptr);
+
+            memset(ptr, i, chunkSize);
+            chunks << ptr;
+        }
+    }
+
+    KisTileDataSlabAllocator::Statistics stats = allocator.statistics();
+    QCOMPARE(stats.usedSize, qint64(100 * (1 + 2 + 4 + 5 + 8 + 10 + 16 + 20 + 32) * TILESIZE));
+    QVERIFY(stats.reservedSize >= stats.usedSize);
+    QVERIFY(stats.numArenas >= pixelSizes.size());
+
+    int chunkIndex = 0;
+    Q_FOREACH (int pixelSize, pixelSizes) {
+        for (int i = 0; i < 100; i++) {
+            quint8 *ptr = chunks[chunkIndex++];
+            QVERIFY(memoryIsFilled(i, ptr, pixelSize * TILESIZE));
+            allocator.free(ptr, pixelSize);
+        }
+    }
+
+    stats = allocator.statistics();
+    QCOMPARE(stats.usedSize, qint64(0));
+    QVERIFY(stats.reservedSize > 0);
+
+    allocator.purge();
+
+    stats = allocator.statistics();
+    QCOMPARE(stats.reservedSize, qint64(0));
+    QCOMPARE(stats.numArenas, qint64(0));
+}
+
+void KisTileDataSlabAllocatorTest::testReuse()
+{
+    KisTileDataSlabAllocator allocator;
+
+    quint8 *first = allocator.allocate(4);
+    allocator.free(first, 4);
+
+    quint8 *second = allocator.allocate(4);
+    QCOMPARE(second, first);
+
+    allocator.free(second, 4);
+}
+
+void KisTileDataSlabAllocatorTest::testNonPooledSize()
+{
+    KisTileDataSlabAllocator allocator;
+
+    const int pixelSize = KisTileDataSlabAllocator::MAX_POOLED_PIXEL_SIZE + 1;
+    QVERIFY(!KisTileDataSlabAllocator::isPooled(pixelSize));
+
+    quint8 *ptr = allocator.allocate(pixelSize);
+    QVERIFY(ptr);
+    memset(ptr, 0, pixelSize * TILESIZE);
+
+    QCOMPARE(allocator.statistics().usedSize, qint64(0));
+
+    allocator.free(ptr, pixelSize);
+}
+
+QTEST_MAIN(KisTileDataSlabAllocatorTest)
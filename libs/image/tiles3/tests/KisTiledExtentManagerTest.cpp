@@ -0,0 +1,122 @@
+/*
+ *  Copyright (c) 2020 Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "KisTiledExtentManagerTest.h"
+
+#include <QTest>
+#include <QtConcurrent>
+
+#include "tiles3/KisTiledExtentManager.h"
+#include "tiles3/kis_tile_data.h"
+
+
+inline QRect tilesRect(int col, int row, int numCols, int numRows)
+{
+    return QRect(col * KisTileData::WIDTH, row * KisTileData::HEIGHT,
+                 numCols * KisTileData::WIDTH, numRows * KisTileData::HEIGHT);
+}
+
+void KisTiledExtentManagerTest::testAddRemove()
+{
+    KisTiledExtentManager manager;
+    QCOMPARE(manager.extent(), QRect());
+
+    manager.notifyTileAdded(0, 0);
+    QCOMPARE(manager.extent(), tilesRect(0, 0, 1, 1));
+
+    manager.notifyTileAdded(2, 3);
+    QCOMPARE(manager.extent(), tilesRect(0, 0, 3, 4));
+
+    manager.notifyTileAdded(-1, 0);
+    QCOMPARE(manager.extent(), tilesRect(-1, 0, 4, 4));
+
+    // the column is still occupied by another tile
+    manager.notifyTileAdded(2, 0);
+    manager.notifyTileRemoved(2, 3);
+    QCOMPARE(manager.extent(), tilesRect(-1, 0, 4, 1));
+
+    manager.notifyTileRemoved(-1, 0);
+    QCOMPARE(manager.extent(), tilesRect(0, 0, 3, 1));
+
+    manager.notifyTileRemoved(0, 0);
+    manager.notifyTileRemoved(2, 0);
+    QCOMPARE(manager.extent(), QRect());
+}
+
+void KisTiledExtentManagerTest::testClear()
+{
+    KisTiledExtentManager manager;
+
+    manager.notifyTileAdded(1, 1);
+    manager.notifyTileAdded(300, 300);
+    QCOMPARE(manager.extent(), tilesRect(1, 1, 300, 300));
+
+    manager.clear();
+    QCOMPARE(manager.extent(), QRect());
+
+    manager.notifyTileAdded(-5, 7);
+    QCOMPARE(manager.extent(), tilesRect(-5, 7, 1, 1));
+}
+
+void KisTiledExtentManagerTest::stressTestConcurrentUpdates()
+{
+    KisTiledExtentManager manager;
+
+    // the anchor tiles keep the extent constant
+    manager.notifyTileAdded(0, 0);
+    manager.notifyTileAdded(15, 15);
+
+    const QRect expectedExtent = tilesRect(0, 0, 16, 16);
+    QAtomicInt numBadReads(0);
+
+    auto writer = [&manager] (int seed) {
+        for (int i = 0; i < 20000; i++) {
+            const int col = (seed + i) % 16;
+            const int row = (seed * 7 + i) % 16;
+
+            manager.notifyTileAdded(col, row);
+            manager.notifyTileRemoved(col, row);
+        }
+    };
+
+    auto reader = [&manager, &numBadReads, expectedExtent] (int) {
+        for (int i = 0; i < 20000; i++) {
+            if (manager.extent() != expectedExtent) {
+                numBadReads.ref();
+            }
+        }
+    };
+
+    QVector<QFuture<void>> jobs;
+    for (int i = 0; i < 4; i++) {
+        jobs << QtConcurrent::run(writer, i);
+        jobs << QtConcurrent::run(reader, i);
+    }
+
+    Q_FOREACH (QFuture<void> job, jobs) {
+        job.waitForFinished();
+    }
+
+    QCOMPARE(numBadReads.load(), 0);
+    QCOMPARE(manager.extent(), expectedExtent);
+
+    manager.notifyTileRemoved(15, 15);
+    QCOMPARE(manager.extent(), tilesRect(0, 0, 1, 1));
+}
+
+QTEST_MAIN(KisTiledExtentManagerTest)
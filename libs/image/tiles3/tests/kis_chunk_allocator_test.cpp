@@ -120,6 +120,42 @@ void KisChunkAllocatorTest::testFragmentation()
 
 }
 
+void KisChunkAllocatorTest::testCompaction()
+{
+    KisChunkAllocator allocator;
+
+    KisChunk chunk1 = allocator.getChunk(10);
+    KisChunk chunk2 = allocator.getChunk(15);
+    KisChunk chunk3 = allocator.getChunk(20);
+    KisChunk chunk4 = allocator.getChunk(25);
+    KisChunk chunk5 = allocator.getChunk(30);
+
+    allocator.freeChunk(chunk2);
+    allocator.freeChunk(chunk4);
+
+    QVERIFY(qFuzzyCompare(allocator.fragmentation(), 0.4));
+
+    KisChunk chunk;
+    KisChunkData oldChunk(0, 0);
+
+    allocator.startCompaction();
+    QVERIFY(allocator.compactNextChunk(&chunk, &oldChunk));
+    QCOMPARE(oldChunk.m_begin, 25ULL);
+    QCOMPARE(chunk.begin(), 10ULL);
+    QCOMPARE(chunk3.begin(), 10ULL);
+
+    QVERIFY(allocator.compactNextChunk(&chunk, &oldChunk));
+    QCOMPARE(oldChunk.m_begin, 70ULL);
+    QCOMPARE(chunk5.begin(), 30ULL);
+
+    QVERIFY(!allocator.compactNextChunk(&chunk, &oldChunk));
+
+    QCOMPARE(chunk1.begin(), 0ULL);
+    QCOMPARE(allocator.fragmentation(), 0.0);
+    QCOMPARE(allocator.shrinkStore(), 60ULL);
+    allocator.sanityCheck();
+}
+
 
 QTEST_MAIN(KisChunkAllocatorTest)
 
@@ -54,6 +54,38 @@ void KisMemoryWindowTest::testWindow()
     QVERIFY(!memcmp(ptr, oddBuf, chunkLength));
 }
 
+void KisMemoryWindowTest::testTruncate()
+{
+    QTemporaryDir swapDir;
+    KisMemoryWindow memory(swapDir.path(), 1024);
+
+    quint8 oddValue = 0xee;
+    const quint8 chunkLength = 10;
+
+    quint8 oddBuf[chunkLength];
+    memset(oddBuf, oddValue, chunkLength);
+
+    KisChunkData chunk1(0, chunkLength);
+    KisChunkData chunk2(4096, chunkLength);
+
+    quint8 *ptr;
+
+    // only the write window has ever been mapped
+    ptr = memory.getWriteChunkPtr(chunk1);
+    memcpy(ptr, oddBuf, chunkLength);
+
+    ptr = memory.getWriteChunkPtr(chunk2);
+    memcpy(ptr, oddBuf, chunkLength);
+
+    QVERIFY(memory.truncate(chunkLength));
+
+    // nothing is mapped now
+    QVERIFY(memory.truncate(chunkLength));
+
+    ptr = memory.getReadChunkPtr(chunk1);
+    QVERIFY(!memcmp(ptr, oddBuf, chunkLength));
+}
+
 void KisMemoryWindowTest::testTopReports()
 {
 
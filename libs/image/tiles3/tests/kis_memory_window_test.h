@@ -27,6 +27,7 @@ class KisMemoryWindowTest : public QObject
 
 private Q_SLOTS:
     void testWindow();
+    void testTruncate();
 
 private:
     // disabled since long-running
@@ -27,6 +27,12 @@
 #include "tiles_test_utils.h"
 
 #include "tiles3/kis_tile_data_store.h"
+#include "tiles3/kis_tiled_data_manager.h"
+
+#include <config-zstd.h>
+#ifdef HAVE_ZSTD
+#include "tiles3/swap/kis_zstd_compression.h"
+#endif
 
 
 #define COLUMN2COLOR(col) (col%255)
@@ -41,6 +47,7 @@ void KisSwappedDataStoreTest::testRoundTrip()
     config.setMaxSwapSize(4);
     config.setSwapSlabSize(1);
     config.setSwapWindowSize(1);
+    config.setMaxCompressedSwapCacheSize(0);
 
 
     KisSwappedDataStore store;
@@ -107,6 +114,7 @@ void KisSwappedDataStoreTest::testRandomAccess()
     config.setMaxSwapSize(40);
     config.setSwapSlabSize(1);
     config.setSwapWindowSize(1);
+    config.setMaxCompressedSwapCacheSize(0);
 
 
     KisSwappedDataStore store;
@@ -131,5 +139,201 @@ void KisSwappedDataStoreTest::testRandomAccess()
         delete tileDataList[i];
 }
 
+void KisSwappedDataStoreTest::testCompressedCache()
+{
+    const qint32 pixelSize = 1;
+    const quint8 defaultPixel = 128;
+    const qint32 NUM_TILES = 10000;
+
+    KisImageConfig config(false);
+    config.setMaxSwapSize(64);
+    config.setSwapSlabSize(1);
+    config.setSwapWindowSize(1);
+    config.setMaxCompressedSwapCacheSize(1);
+
+    KisSwappedDataStore store;
+
+    QList<KisTileData*> tileDataList;
+    for(qint32 i = 0; i < NUM_TILES; i++)
+        tileDataList.append(new KisTileData(pixelSize, &defaultPixel, KisTileDataStore::instance()));
+
+    for(qint32 i = 0; i < NUM_TILES; i++) {
+        KisTileData *td = tileDataList[i];
+
+        // make the tiles incompressible so that the tier overflows
+        quint8 *ptr = td->data();
+        for(qint32 j = 0; j < TILESIZE; j++) {
+            ptr[j] = quint8(qrand());
+        }
+        ptr[0] = COLUMN2COLOR(i);
+
+        QVERIFY(store.trySwapOutTileData(td));
+        QVERIFY(store.compressedCacheSize() <= qint64(MiB));
+    }
+
+    QCOMPARE(store.numTiles(), quint64(NUM_TILES));
+    QVERIFY(store.compressedCacheSize() > 0);
+
+    store.debugStatistics();
+
+    for(qint32 i = NUM_TILES - 1; i >= 0; i--) {
+        KisTileData *td = tileDataList[i];
+        QVERIFY(!td->data());
+
+        store.swapInTileData(td);
+        QCOMPARE(td->data()[0], quint8(COLUMN2COLOR(i)));
+    }
+
+    QCOMPARE(store.numTiles(), quint64(0));
+    QCOMPARE(store.compressedCacheSize(), qint64(0));
+
+    for(qint32 i = 0; i < NUM_TILES; i++)
+        delete tileDataList[i];
+
+    config.setMaxCompressedSwapCacheSize(config.maxCompressedSwapCacheSize(true));
+}
+
+void KisSwappedDataStoreTest::testZstdRoundTrip()
+{
+#ifdef HAVE_ZSTD
+    const qint32 dataSize = 4 * TILESIZE;
+
+    QByteArray src(dataSize, 0);
+    for(qint32 i = 0; i < dataSize; i++) {
+        src[i] = char((i / 7) % 13);
+    }
+
+    KisZstdCompression compression;
+
+    QByteArray compressed(compression.outputBufferSize(dataSize), 0);
+    const qint32 compressedSize =
+        compression.compress((const quint8*)src.constData(), dataSize,
+                             (quint8*)compressed.data(), compressed.size());
+
+    QVERIFY(compressedSize > 0);
+    QVERIFY(compressedSize < dataSize);
+
+    QByteArray dst(dataSize, 0);
+    const qint32 decompressedSize =
+        compression.decompress((const quint8*)compressed.constData(), compressedSize,
+                               (quint8*)dst.data(), dst.size());
+
+    QCOMPARE(decompressedSize, dataSize);
+    QCOMPARE(dst, src);
+
+    // the context is reused for the following calls
+    dst.fill(0);
+    QCOMPARE(compression.decompress((const quint8*)compressed.constData(), compressedSize,
+                                    (quint8*)dst.data(), dst.size()), dataSize);
+    QCOMPARE(dst, src);
+#else
+    QSKIP("Krita is built without zstd support");
+#endif
+}
+
+void KisSwappedDataStoreTest::testChecksumRecovery()
+{
+    const qint32 pixelSize = 1;
+    const quint8 defaultPixel = 128;
+    const quint8 oddPixel = 200;
+
+    KisImageConfig config(false);
+    config.setMaxSwapSize(4);
+    config.setSwapSlabSize(1);
+    config.setSwapWindowSize(1);
+
+    KisSwappedDataStore store;
+
+    KisTiledDataManager dm(pixelSize, &defaultPixel);
+    KisTileSP tile = dm.getTile(0, 0, true);
+
+    tile->lockForWrite();
+    memset(tile->data(), oddPixel, TILESIZE);
+    tile->unlockForWrite();
+
+    KisTileData *td = tile->tileData();
+
+    // FIXME: take a lock of the tile data
+    QVERIFY(store.trySwapOutTileData(td, true));
+    QVERIFY(!td->data());
+
+    store.testingCorruptSwappedTileData(td);
+
+    store.swapInTileData(td);
+    QVERIFY(td->isLost());
+    QVERIFY(memoryIsFilled(0, td->data(), TILESIZE));
+
+    // the tile fills the lost data with the default pixel of its data manager
+    tile->lockForRead();
+    QVERIFY(!td->isLost());
+    QVERIFY(memoryIsFilled(defaultPixel, tile->data(), TILESIZE));
+    tile->unlockForRead();
+}
+
+void KisSwappedDataStoreTest::testCompaction()
+{
+    const qint32 pixelSize = 1;
+    const quint8 defaultPixel = 128;
+    const qint32 NUM_TILES = 1000;
+
+    KisImageConfig config(false);
+    config.setMaxSwapSize(16);
+    config.setSwapSlabSize(1);
+    config.setSwapWindowSize(1);
+    config.setSwapCompactionThreshold(10);
+
+    KisSwappedDataStore store;
+
+    QList<KisTileData*> tileDataList;
+    for(qint32 i = 0; i < NUM_TILES; i++)
+        tileDataList.append(new KisTileData(pixelSize, &defaultPixel, KisTileDataStore::instance()));
+
+    for(qint32 i = 0; i < NUM_TILES; i++) {
+        KisTileData *td = tileDataList[i];
+
+        // make the tiles incompressible so that they occupy the file
+        quint8 *ptr = td->data();
+        for(qint32 j = 0; j < TILESIZE; j++) {
+            ptr[j] = quint8(qrand());
+        }
+        ptr[0] = COLUMN2COLOR(i);
+
+        QVERIFY(store.trySwapOutTileData(td, true));
+    }
+
+    // make holes in the swap file
+    for(qint32 i = 0; i < NUM_TILES; i += 2) {
+        store.swapInTileData(tileDataList[i]);
+        QCOMPARE(tileDataList[i]->data()[0], quint8(COLUMN2COLOR(i)));
+    }
+
+    int numSteps = 0;
+    while (store.compactSwapFile(64 * TILESIZE)) {
+        numSteps++;
+    }
+    QVERIFY(numSteps > 0);
+
+    // the file has been compacted, so nothing is left to do
+    QVERIFY(!store.compactSwapFile(64 * TILESIZE));
+
+    store.debugStatistics();
+
+    for(qint32 i = 1; i < NUM_TILES; i += 2) {
+        KisTileData *td = tileDataList[i];
+        QVERIFY(!td->data());
+
+        store.swapInTileData(td);
+        QVERIFY(!td->isLost());
+        QCOMPARE(td->data()[0], quint8(COLUMN2COLOR(i)));
+    }
+
+    QCOMPARE(store.numTiles(), quint64(0));
+
+    for(qint32 i = 0; i < NUM_TILES; i++)
+        delete tileDataList[i];
+
+    config.setSwapCompactionThreshold(config.swapCompactionThreshold(true));
+}
+
 QTEST_MAIN(KisSwappedDataStoreTest)
 
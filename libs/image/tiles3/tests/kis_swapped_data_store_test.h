@@ -33,6 +33,10 @@ private:
 private Q_SLOTS:
     void testRoundTrip();
     void testRandomAccess();
+    void testCompressedCache();
+    void testZstdRoundTrip();
+    void testChecksumRecovery();
+    void testCompaction();
 
 };
 
@@ -188,5 +188,151 @@ void KisTileDataStoreTest::testSwapping()
     }
 }
 
+void KisTileDataStoreTest::testPrefetching()
+{
+    KisTileDataStore *store = KisTileDataStore::instance();
+    store->debugClear();
+
+    const qint32 pixelSize = 1;
+    quint8 defaultPixel = 128;
+    KisTiledDataManager dm(pixelSize, &defaultPixel);
+
+    for(qint32 col = 0; col < 100; col++) {
+        KisTileSP tile = dm.getTile(col, 0, true);
+        tile->lockForWrite();
+        memset(tile->data(), COLUMN2COLOR(col), TILESIZE);
+        tile->unlockForWrite();
+    }
+
+    store->debugSwapAll();
+    QVERIFY(store->hasSwappedTiles());
+
+    for(qint32 col = 0; col < 100; col++) {
+        KisTileSP tile = dm.getTile(col, 0, false);
+        QVERIFY(!tile->tileData()->data());
+    }
+
+    dm.prefetchTiles(QRect(0, 0, 50 * KisTileData::WIDTH, KisTileData::HEIGHT));
+    store->testingWaitForPrefetcher();
+
+    for(qint32 col = 0; col < 100; col++) {
+        KisTileSP tile = dm.getTile(col, 0, false);
+        QCOMPARE(bool(tile->tileData()->data()), col < 50);
+
+        tile->lockForRead();
+        QVERIFY(memoryIsFilled(COLUMN2COLOR(col), tile->data(), TILESIZE));
+        tile->unlockForRead();
+    }
+}
+
+void KisTileDataStoreTest::testHistoryDeltas()
+{
+    KisImageConfig config(false);
+    config.setCompressHistoryDeltas(true);
+
+    KisTileDataStore *store = KisTileDataStore::instance();
+    store->debugClear();
+    store->testingRereadConfig();
+
+    // the swapper would process the history in the background otherwise
+    store->testingSuspendSwapper();
+
+    const qint32 pixelSize = 1;
+    quint8 defaultPixel = 128;
+    KisTiledDataManager dm(pixelSize, &defaultPixel);
+
+    KisMementoSP memento1 = dm.getMemento();
+    KisTileSP tile = dm.getTile(0, 0, true);
+    tile->lockForWrite();
+    memset(tile->data(), 1, TILESIZE);
+    tile->unlockForWrite();
+    dm.commit();
+
+    KisTileData *oldTileData = tile->tileData();
+
+    KisMementoSP memento2 = dm.getMemento();
+    tile->lockForWrite();
+    tile->data()[0] = 2;
+    tile->unlockForWrite();
+    dm.commit();
+
+    QVERIFY(oldTileData != tile->tileData());
+
+    store->compressHistory();
+    QVERIFY(!oldTileData->data());
+    QVERIFY(store->hasSwappedTiles());
+
+    dm.rollback(memento2);
+
+    tile = dm.getTile(0, 0, false);
+    QCOMPARE(tile->tileData(), oldTileData);
+
+    tile->lockForRead();
+    QVERIFY(memoryIsFilled(1, tile->data(), TILESIZE));
+    tile->unlockForRead();
+
+    dm.rollforward(memento2);
+
+    tile = dm.getTile(0, 0, false);
+    tile->lockForRead();
+    QCOMPARE(tile->data()[0], quint8(2));
+    QVERIFY(memoryIsFilled(1, tile->data() + 1, TILESIZE - 1));
+    tile->unlockForRead();
+
+    config.setCompressHistoryDeltas(false);
+    store->testingRereadConfig();
+    store->testingResumeSwapper();
+}
+
+void KisTileDataStoreTest::testHistorySpill()
+{
+    KisImageConfig config(false);
+    config.setUndoRevisionsInMemory(1);
+
+    KisTileDataStore *store = KisTileDataStore::instance();
+    store->debugClear();
+    store->testingRereadConfig();
+
+    // the swapper would process the history in the background otherwise
+    store->testingSuspendSwapper();
+
+    const qint32 pixelSize = 1;
+    quint8 defaultPixel = 128;
+    KisTiledDataManager dm(pixelSize, &defaultPixel);
+
+    KisMementoSP memento1 = dm.getMemento();
+    KisTileSP tile = dm.getTile(0, 0, true);
+    tile->lockForWrite();
+    memset(tile->data(), 1, TILESIZE);
+    tile->unlockForWrite();
+    dm.commit();
+
+    KisTileData *oldTileData = tile->tileData();
+
+    KisMementoSP memento2 = dm.getMemento();
+    tile->lockForWrite();
+    memset(tile->data(), 2, TILESIZE);
+    tile->unlockForWrite();
+    dm.commit();
+
+    store->spillHistory();
+    QVERIFY(!oldTileData->data());
+    QVERIFY(store->hasSwappedTiles());
+
+    // the most recent revision stays in memory
+    QVERIFY(tile->tileData()->data());
+
+    dm.rollback(memento2);
+
+    tile = dm.getTile(0, 0, false);
+    tile->lockForRead();
+    QVERIFY(memoryIsFilled(1, tile->data(), TILESIZE));
+    tile->unlockForRead();
+
+    config.setUndoRevisionsInMemory(0);
+    store->testingRereadConfig();
+    store->testingResumeSwapper();
+}
+
 QTEST_MAIN(KisTileDataStoreTest)
 
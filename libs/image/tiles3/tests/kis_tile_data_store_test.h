@@ -30,6 +30,9 @@ private Q_SLOTS:
     void testClockIterator();
     void testLeaks();
     void testSwapping();
+    void testPrefetching();
+    void testHistoryDeltas();
+    void testHistorySpill();
 };
 
 #endif /* KIS_TILE_DATA_STORE_TEST_H */
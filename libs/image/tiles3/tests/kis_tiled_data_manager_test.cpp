@@ -19,7 +19,10 @@
 #include "kis_tiled_data_manager_test.h"
 #include <QTest>
 
+#include <QBuffer>
+
 #include "tiles3/kis_tiled_data_manager.h"
+#include "kis_datamanager.h"
 
 #include "tiles_test_utils.h"
 #include "config-limit-long-tests.h"
@@ -539,6 +542,71 @@ void KisTiledDataManagerTest::testUndoSetDefaultPixel()
     QVERIFY(memoryIsFilled(oddPixel2, tile10->data(), TILESIZE));
 }
 
+void KisTiledDataManagerTest::testPurgeUniformTiles()
+{
+    quint8 defaultPixel = 0;
+    KisDataManager dm(1, &defaultPixel);
+
+    quint8 oddPixel1 = 128;
+    quint8 oddPixel2 = 129;
+
+    QRect uniformRect(0, 0, 2 * KisTileData::WIDTH, KisTileData::HEIGHT);
+    QRect rect(0, 0, 3 * KisTileData::WIDTH, KisTileData::HEIGHT);
+
+    QByteArray buffer(rect.width() * rect.height(), (char)defaultPixel);
+    dm.writeBytes((quint8*)buffer.data(), rect.x(), rect.y(), rect.width(), rect.height());
+
+    buffer.fill((char)oddPixel1);
+    dm.writeBytes((quint8*)buffer.data(), uniformRect.x(), uniformRect.y(), uniformRect.width(), uniformRect.height());
+
+    dm.setPixel(2 * KisTileData::WIDTH + 1, 1, &oddPixel2);
+
+    KisTileSP tile00 = dm.getTile(0, 0, false);
+    KisTileSP tile10 = dm.getTile(1, 0, false);
+    QVERIFY(tile00->tileData() != tile10->tileData());
+    QVERIFY(!tile00->tileData()->isUniform());
+
+    KisMementoSP memento = dm.getMemento();
+    dm.purge(rect);
+    dm.commit();
+
+    // sharing the tile data doesn't change the pixels, so no undo step is recorded
+    QVERIFY(memento->extent().isEmpty());
+
+    tile00 = dm.getTile(0, 0, false);
+    tile10 = dm.getTile(1, 0, false);
+    KisTileSP tile20 = dm.getTile(2, 0, false);
+
+    QCOMPARE(tile00->tileData(), tile10->tileData());
+    QVERIFY(tile00->tileData()->isUniform());
+    QVERIFY(!tile20->tileData()->isUniform());
+    QVERIFY(memoryIsFilled(oddPixel1, tile00->data(), TILESIZE));
+    QCOMPARE(dm.extent(), rect);
+
+    // writing into a uniform tile detaches it from the shared data
+
+    dm.setPixel(1, 1, &oddPixel2);
+
+    tile00 = dm.getTile(0, 0, false);
+    tile10 = dm.getTile(1, 0, false);
+
+    QVERIFY(tile00->tileData() != tile10->tileData());
+    QVERIFY(!tile00->tileData()->isUniform());
+    QVERIFY(tile10->tileData()->isUniform());
+    QVERIFY(memoryIsFilled(oddPixel1, tile10->data(), TILESIZE));
+    QCOMPARE(tile00->data()[KisTileData::WIDTH + 1], oddPixel2);
+
+    // the tile written after the last purge is checked again
+
+    dm.setPixel(1, 1, &oddPixel1);
+    dm.purge(rect);
+
+    tile00 = dm.getTile(0, 0, false);
+    tile10 = dm.getTile(1, 0, false);
+
+    QCOMPARE(tile00->tileData(), tile10->tileData());
+}
+
 //#include <valgrind/callgrind.h>
 
 void KisTiledDataManagerTest::benchmarkReadOnlyTileLazy()
@@ -994,5 +1062,96 @@ void KisTiledDataManagerTest::benchmaskKisRegion()
     qDebug() << "compression time:" << timer.elapsed() << "ms";
 }
 
+void KisTiledDataManagerTest::testReadForeignTileSize()
+{
+    /**
+     * Emulate a file saved by a build with 32x32 tiles:
+     * a single raw tile at (32, 32) filled with 200
+     */
+    const int foreignTileSize = 32;
+    const quint8 tilePixel = 200;
+
+    QByteArray stream;
+    stream += QString("VERSION 2\n"
+                      "TILEWIDTH %1\n"
+                      "TILEHEIGHT %1\n"
+                      "PIXELSIZE 1\n"
+                      "DATA 1\n").arg(foreignTileSize).toLatin1();
+
+    const int tileDataSize = foreignTileSize * foreignTileSize;
+    stream += QString("%1,%1,LZF,%2\n").arg(foreignTileSize).arg(tileDataSize + 1).toLatin1();
+    stream += char(0); // RAW_DATA_FLAG
+    stream += QByteArray(tileDataSize, char(tilePixel));
+
+    QBuffer buffer(&stream);
+    buffer.open(QIODevice::ReadOnly);
+
+    quint8 defaultPixel = 0;
+    KisDataManager dm(1, &defaultPixel);
+    QVERIFY(dm.read(&buffer));
+
+    const QRect checkRect(0, 0, 3 * foreignTileSize, 3 * foreignTileSize);
+    const QRect tileRect(foreignTileSize, foreignTileSize, foreignTileSize, foreignTileSize);
+
+    QByteArray result(checkRect.width() * checkRect.height(), 0);
+    dm.readBytes((quint8*)result.data(), checkRect.x(), checkRect.y(), checkRect.width(), checkRect.height());
+
+    QVERIFY(checkHole((quint8*)result.data(), tilePixel, tileRect, defaultPixel, checkRect));
+}
+
+void KisTiledDataManagerTest::testRejectWrongTileSize()
+{
+    Q_FOREACH (int tileSize, QVector<int>({0, -64, 100, 512, 65536})) {
+        QByteArray stream;
+        stream += QString("VERSION 2\n"
+                          "TILEWIDTH %1\n"
+                          "TILEHEIGHT 64\n"
+                          "PIXELSIZE 1\n"
+                          "DATA 1\n").arg(tileSize).toLatin1();
+        stream += QString("0,0,LZF,%1\n").arg(64 * 64 + 1).toLatin1();
+        stream += char(0); // RAW_DATA_FLAG
+        stream += QByteArray(64 * 64, char(200));
+
+        QBuffer buffer(&stream);
+        buffer.open(QIODevice::ReadOnly);
+
+        quint8 defaultPixel = 0;
+        KisDataManager dm(1, &defaultPixel);
+        QVERIFY(!dm.read(&buffer));
+    }
+}
+
+void KisTiledDataManagerTest::testWriteFileTileSize()
+{
+    const quint8 defaultPixel = 0;
+    const quint8 fillPixel = 150;
+    const QRect fillRect(10, 20, 300, 200);
+
+    KisDataManager srcDM(1, &defaultPixel);
+    srcDM.clear(fillRect.x(), fillRect.y(), fillRect.width(), fillRect.height(), &fillPixel);
+
+    KoStoreFake fakeStore;
+    KisFakePaintDeviceWriter writer(&fakeStore);
+    QVERIFY(srcDM.write(writer));
+
+    fakeStore.startReading();
+    QByteArray stream = fakeStore.device()->readAll();
+
+    // the files always use 64x64 tiles, whatever KRITA_TILE_SIZE is
+    QVERIFY(stream.contains("TILEWIDTH 64\nTILEHEIGHT 64\n"));
+
+    QBuffer buffer(&stream);
+    buffer.open(QIODevice::ReadOnly);
+
+    KisDataManager dstDM(1, &defaultPixel);
+    QVERIFY(dstDM.read(&buffer));
+
+    const QRect checkRect(0, 0, 400, 300);
+    QByteArray result(checkRect.width() * checkRect.height(), 0);
+    dstDM.readBytes((quint8*)result.data(), checkRect.x(), checkRect.y(), checkRect.width(), checkRect.height());
+
+    QVERIFY(checkHole((quint8*)result.data(), fillPixel, fillRect, defaultPixel, checkRect));
+}
+
 QTEST_MAIN(KisTiledDataManagerTest)
 
@@ -52,6 +52,10 @@ private Q_SLOTS:
     void testTransactions();
     void testPurgeHistory();
     void testUndoSetDefaultPixel();
+    void testReadForeignTileSize();
+    void testRejectWrongTileSize();
+    void testWriteFileTileSize();
+    void testPurgeUniformTiles();
 
     void benchmarkReadOnlyTileLazy();
     void benchmarkSharedPointers();
@@ -22,6 +22,7 @@
 #include <KoStore_p.h>
 #include <kis_paint_device_writer.h>
 #include <kis_debug.h>
+#include "tiles3/kis_tile_data_interface.h"
 
 class KisFakePaintDeviceWriter : public KisPaintDeviceWriter {
 public:
@@ -83,7 +84,7 @@ bool memoryIsFilled(quint8 c, quint8 *mem, qint32 size)
     return true;
 }
 
-#define TILESIZE 64*64
+#define TILESIZE (__TILE_DATA_WIDTH * __TILE_DATA_HEIGHT)
 
 
 #endif /* TILES_TEST_UTILS_H */
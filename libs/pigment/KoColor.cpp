@@ -159,6 +159,109 @@ KoColor KoColor::convertedTo(const KoColorSpace *cs) const
                        KoColorConversionTransformation::internalConversionFlags());
 }
 
+void KoColor::convertAllTo(QVector<KoColor> &colors, const KoColorSpace *cs, KoColorConversionTransformation::Intent renderingIntent, KoColorConversionTransformation::ConversionFlags conversionFlags)
+{
+    const KoColorSpace *dstColorSpace = KoColorSpaceRegistry::instance()->permanentColorspace(cs);
+    const quint32 dstPixelSize = dstColorSpace->pixelSize();
+    Q_ASSERT(dstPixelSize <= MAX_PIXEL_SIZE);
+
+    QVector<quint8> srcBuffer;
+    QVector<quint8> dstBuffer;
+
+    int runStart = 0;
+
+    while (runStart < colors.size()) {
+        const KoColorSpace *srcColorSpace = colors[runStart].m_colorSpace;
+
+        int runEnd = runStart + 1;
+        while (runEnd < colors.size() && colors[runEnd].m_colorSpace == srcColorSpace) {
+            runEnd++;
+        }
+
+        const int numColors = runEnd - runStart;
+
+        if (!(*srcColorSpace == *dstColorSpace)) {
+            const quint32 srcPixelSize = srcColorSpace->pixelSize();
+
+            srcBuffer.resize(numColors * srcPixelSize);
+            dstBuffer.fill(0, numColors * dstPixelSize);
+
+            for (int i = 0; i < numColors; i++) {
+                memcpy(srcBuffer.data() + i * srcPixelSize, colors[runStart + i].m_data, srcPixelSize);
+            }
+
+            srcColorSpace->convertPixelsTo(srcBuffer.constData(), dstBuffer.data(), dstColorSpace, numColors, renderingIntent, conversionFlags);
+
+            for (int i = 0; i < numColors; i++) {
+                KoColor &color = colors[runStart + i];
+                memcpy(color.m_data, dstBuffer.constData() + i * dstPixelSize, dstPixelSize);
+                color.m_size = dstPixelSize;
+                color.m_colorSpace = dstColorSpace;
+            }
+        }
+
+        runStart = runEnd;
+    }
+}
+
+void KoColor::convertAllTo(QVector<KoColor> &colors, const KoColorSpace *cs)
+{
+    convertAllTo(colors, cs,
+                 KoColorConversionTransformation::internalRenderingIntent(),
+                 KoColorConversionTransformation::internalConversionFlags());
+}
+
+QVector<KoColor> KoColor::fromQColors(const QVector<QColor> &colors, const KoColorSpace *colorSpace)
+{
+    const KoColor prototype(colorSpace);
+    QVector<KoColor> result(colors.size(), prototype);
+
+    if (colors.isEmpty()) return result;
+
+    const quint32 pixelSize = prototype.m_size;
+    QVector<quint8> buffer(colors.size() * pixelSize, 0);
+
+    prototype.m_colorSpace->fromQColors(colors.constData(), buffer.data(), colors.size());
+
+    for (int i = 0; i < colors.size(); i++) {
+        memcpy(result[i].m_data, buffer.constData() + i * pixelSize, pixelSize);
+    }
+
+    return result;
+}
+
+QVector<QColor> KoColor::toQColors(const QVector<KoColor> &colors)
+{
+    QVector<QColor> result(colors.size());
+    QVector<quint8> buffer;
+
+    int runStart = 0;
+
+    while (runStart < colors.size()) {
+        const KoColorSpace *colorSpace = colors[runStart].m_colorSpace;
+
+        int runEnd = runStart + 1;
+        while (runEnd < colors.size() && colors[runEnd].m_colorSpace == colorSpace) {
+            runEnd++;
+        }
+
+        const int numColors = runEnd - runStart;
+        const quint32 pixelSize = colorSpace->pixelSize();
+
+        buffer.resize(numColors * pixelSize);
+
+        for (int i = 0; i < numColors; i++) {
+            memcpy(buffer.data() + i * pixelSize, colors[runStart + i].m_data, pixelSize);
+        }
+
+        colorSpace->toQColors(buffer.constData(), result.data() + runStart, numColors);
+
+        runStart = runEnd;
+    }
+
+    return result;
+}
+
 void KoColor::setProfile(const KoColorProfile *profile)
 {
     const KoColorSpace *dstColorSpace =
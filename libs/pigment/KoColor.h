@@ -22,6 +22,7 @@
 
 #include <QColor>
 #include <QMetaType>
+#include <QVector>
 #include <QtGlobal>
 #include "kritapigment_export.h"
 #include "KoColorConversionTransformation.h"
@@ -120,6 +121,29 @@ public:
     /// same as the original colorspace, just returns a copy
     KoColor convertedTo(const KoColorSpace * cs) const;
 
+    /**
+     * Converts all the \p colors to \p cs. The consecutive colors sharing
+     * the same color space are converted with a single call to the color
+     * conversion transformation, which is much faster than converting
+     * them one by one.
+     */
+    static void convertAllTo(QVector<KoColor> &colors,
+                             const KoColorSpace * cs,
+                             KoColorConversionTransformation::Intent renderingIntent,
+                             KoColorConversionTransformation::ConversionFlags conversionFlags);
+
+    static void convertAllTo(QVector<KoColor> &colors, const KoColorSpace * cs);
+
+    /**
+     * Creates the colors in \p colorSpace from a sequence of QColors in one
+     * go, \see KoColor(const QColor &, const KoColorSpace *)
+     */
+    static QVector<KoColor> fromQColors(const QVector<QColor> &colors, const KoColorSpace * colorSpace);
+
+    /**
+     * Converts a sequence of colors into QColors in one go, \see toQColor()
+     */
+    static QVector<QColor> toQColors(const QVector<KoColor> &colors);
 
 
     /// assign new profile without converting pixel data
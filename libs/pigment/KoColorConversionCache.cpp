@@ -19,6 +19,7 @@
 
 #include "KoColorConversionCache.h"
 
+#include <QAtomicInt>
 #include <QHash>
 #include <QList>
 #include <QMutex>
@@ -45,6 +46,16 @@ struct KoColorConversionCacheKey {
                 && (conversionFlags == rhs.conversionFlags);
     }
 
+    /**
+     * Unlike operator==(), doesn't dereference the color spaces,
+     * so it is safe to call when they may have been destroyed
+     */
+    bool hasSamePointers(const KoColorConversionCacheKey& rhs) const {
+        return src == rhs.src && dst == rhs.dst
+                && (renderingIntent == rhs.renderingIntent)
+                && (conversionFlags == rhs.conversionFlags);
+    }
+
     const KoColorSpace* src;
     const KoColorSpace* dst;
     KoColorConversionTransformation::Intent renderingIntent;
@@ -59,7 +70,7 @@ uint qHash(const KoColorConversionCacheKey& key)
 struct KoColorConversionCache::CachedTransformation {
 
     CachedTransformation(KoColorConversionTransformation* _transfo)
-        : transfo(_transfo), use(0)
+        : transfo(_transfo), use(0), inFastCache(false), orphaned(false)
     {}
 
     ~CachedTransformation() {
@@ -72,15 +83,65 @@ struct KoColorConversionCache::CachedTransformation {
 
     KoColorConversionTransformation* transfo;
     int use;
+
+    /**
+     * The transformation is held by the fast path cache of some thread
+     */
+    bool inFastCache;
+
+    /**
+     * The color space of the transformation has been destroyed while
+     * the transformation was in a fast path cache. It is not in the
+     * cache anymore and is deleted when the fast path cache drops it.
+     */
+    bool orphaned;
 };
 
-typedef QPair<KoColorConversionCacheKey, KoCachedColorConversionTransformation> FastPathCacheItem;
+struct FastPathCacheItem {
+    FastPathCacheItem(const KoColorConversionCacheKey &_key,
+                      const KoCachedColorConversionTransformation &_transformation,
+                      KoColorConversionCache::CachedTransformation *_cached)
+        : key(_key), transformation(_transformation), cached(_cached)
+    {}
+
+    KoColorConversionCacheKey key;
+    KoCachedColorConversionTransformation transformation;
+    KoColorConversionCache::CachedTransformation *cached;
+};
+
+/**
+ * Every thread keeps a few most recently used transformations, so the
+ * threads that convert between several color spaces in turn (e.g. the
+ * color selectors converting to and from the display color space) don't
+ * take the global lock on every call. The items are sorted in the
+ * most-recently-used order.
+ *
+ * The transformations stored here are marked as used, so they are never
+ * shared with other threads.
+ *
+ * A color space may be destroyed while its transformations are stored
+ * in the caches of other threads, which cannot be touched from outside.
+ * So every destruction starts a new generation of the caches, and a
+ * thread drops all its items when it finds its cache outdated.
+ */
+struct FastPathCache {
+    static const int maxSize = 8;
+
+    ~FastPathCache() {
+        qDeleteAll(items);
+    }
+
+    int generation = 0;
+    QList<FastPathCacheItem*> items;
+};
 
 struct KoColorConversionCache::Private {
     QMultiHash< KoColorConversionCacheKey, CachedTransformation*> cache;
+    QList<CachedTransformation*> orphans;
     QMutex cacheMutex;
 
-    QThreadStorage<FastPathCacheItem*> fastStorage;
+    QThreadStorage<FastPathCache*> fastStorage;
+    QAtomicInt generation;
 };
 
 
@@ -93,6 +154,7 @@ KoColorConversionCache::~KoColorConversionCache()
     Q_FOREACH (CachedTransformation* transfo, d->cache) {
         delete transfo;
     }
+    qDeleteAll(d->orphans);
     delete d;
 }
 
@@ -103,18 +165,51 @@ KoCachedColorConversionTransformation KoColorConversionCache::cachedConverter(co
 {
     KoColorConversionCacheKey key(src, dst, _renderingIntent, _conversionFlags);
 
-    FastPathCacheItem *cacheItem =
-        d->fastStorage.localData();
+    FastPathCache *fastCache = d->fastStorage.localData();
+
+    if (!fastCache) {
+        fastCache = new FastPathCache();
+        d->fastStorage.setLocalData(fastCache);
+    }
+
+    if (fastCache->generation == d->generation.loadAcquire()) {
+        for (int i = 0; i < fastCache->items.size(); i++) {
+            FastPathCacheItem *item = fastCache->items[i];
 
-    if (cacheItem) {
-        if (cacheItem->first == key) {
-            return cacheItem->second;
+            if (item->key.hasSamePointers(key)) {
+                if (i > 0) {
+                    fastCache->items.move(i, 0);
+                }
+                return item->transformation;
+            }
         }
     }
 
-    cacheItem = 0;
+    FastPathCacheItem *cacheItem = 0;
 
     QMutexLocker lock(&d->cacheMutex);
+
+    /**
+     * Some color space has been destroyed since the last call, our
+     * items may refer to it, so return all of them to the pool
+     */
+    if (fastCache->generation != d->generation.loadAcquire()) {
+        Q_FOREACH (FastPathCacheItem *item, fastCache->items) {
+            CachedTransformation *ct = item->cached;
+            ct->inFastCache = false;
+            delete item;
+
+            if (ct->orphaned) {
+                Q_ASSERT(ct->available());
+                d->orphans.removeOne(ct);
+                delete ct;
+            }
+        }
+
+        fastCache->items.clear();
+        fastCache->generation = d->generation.loadAcquire();
+    }
+
     QList< CachedTransformation* > cachedTransfos = d->cache.values(key);
     if (cachedTransfos.size() != 0) {
         Q_FOREACH (CachedTransformation* ct, cachedTransfos) {
@@ -122,7 +217,7 @@ KoCachedColorConversionTransformation KoColorConversionCache::cachedConverter(co
                 ct->transfo->setSrcColorSpace(src);
                 ct->transfo->setDstColorSpace(dst);
 
-                cacheItem = new FastPathCacheItem(key, KoCachedColorConversionTransformation(this, ct));
+                cacheItem = new FastPathCacheItem(key, KoCachedColorConversionTransformation(this, ct), ct);
                 break;
             }
         }
@@ -131,23 +226,46 @@ KoCachedColorConversionTransformation KoColorConversionCache::cachedConverter(co
         KoColorConversionTransformation* transfo = src->createColorConverter(dst, _renderingIntent, _conversionFlags);
         CachedTransformation* ct = new CachedTransformation(transfo);
         d->cache.insert(key, ct);
-        cacheItem = new FastPathCacheItem(key, KoCachedColorConversionTransformation(this, ct));
+        cacheItem = new FastPathCacheItem(key, KoCachedColorConversionTransformation(this, ct), ct);
+    }
+
+    cacheItem->cached->inFastCache = true;
+    fastCache->items.prepend(cacheItem);
+
+    /**
+     * The evicted transformation is returned to the pool, so
+     * it should be released under the lock
+     */
+    if (fastCache->items.size() > FastPathCache::maxSize) {
+        FastPathCacheItem *evictedItem = fastCache->items.takeLast();
+        evictedItem->cached->inFastCache = false;
+        delete evictedItem;
     }
 
-    d->fastStorage.setLocalData(cacheItem);
-    return cacheItem->second;
+    return cacheItem->transformation;
 }
 
 void KoColorConversionCache::colorSpaceIsDestroyed(const KoColorSpace* cs)
 {
-    d->fastStorage.setLocalData(0);
-
     QMutexLocker lock(&d->cacheMutex);
+
+    // make all the threads drop their fast path caches
+    d->generation.ref();
+
     QMultiHash< KoColorConversionCacheKey, CachedTransformation*>::iterator endIt = d->cache.end();
     for (QMultiHash< KoColorConversionCacheKey, CachedTransformation*>::iterator it = d->cache.begin(); it != endIt;) {
         if (it.key().src == cs || it.key().dst == cs) {
-            Q_ASSERT(it.value()->available()); // That's terribely evil, if that assert fails, that means that someone is using a color transformation with a color space which is currently being deleted
-            delete it.value();
+            CachedTransformation *ct = it.value();
+
+            Q_ASSERT(ct->use == (ct->inFastCache ? 1 : 0)); // That's terribely evil, if that assert fails, that means that someone is using a color transformation with a color space which is currently being deleted
+
+            if (ct->inFastCache) {
+                ct->orphaned = true;
+                d->orphans.append(ct);
+            } else {
+                delete ct;
+            }
+
             it = d->cache.erase(it);
         } else {
             ++it;
@@ -385,6 +385,26 @@ const KoColorConversionTransformation* KoColorSpace::fromRgbA16Converter() const
     return d->transfoFromRGBA16;
 }
 
+void KoColorSpace::fromQColors(const QColor *colors, quint8 *dst, quint32 nPixels, const KoColorProfile *profile) const
+{
+    const quint32 size = pixelSize();
+
+    for (quint32 i = 0; i < nPixels; i++) {
+        fromQColor(colors[i], dst, profile);
+        dst += size;
+    }
+}
+
+void KoColorSpace::toQColors(const quint8 *src, QColor *colors, quint32 nPixels, const KoColorProfile *profile) const
+{
+    const quint32 size = pixelSize();
+
+    for (quint32 i = 0; i < nPixels; i++) {
+        toQColor(src, &colors[i], profile);
+        src += size;
+    }
+}
+
 void KoColorSpace::toLabA16(const quint8 * src, quint8 * dst, quint32 nPixels) const
 {
     toLabA16Converter()->transform(src, dst, nPixels);
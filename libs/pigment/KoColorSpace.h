@@ -302,6 +302,18 @@ public:
      */
     virtual void toQColor(const quint8 *src, QColor *c, const KoColorProfile * profile = 0) const = 0;
 
+    /**
+     * Converts \p nPixels QColors into a row of pixels in this color space.
+     * The default implementation calls fromQColor() for every color, the
+     * color spaces may override it to convert the whole row at once.
+     */
+    virtual void fromQColors(const QColor *colors, quint8 *dst, quint32 nPixels, const KoColorProfile * profile = 0) const;
+
+    /**
+     * Converts a row of \p nPixels pixels into QColors, \see fromQColors()
+     */
+    virtual void toQColors(const quint8 *src, QColor *colors, quint32 nPixels, const KoColorProfile * profile = 0) const;
+
     /**
      * Convert the pixels in data to (8-bit BGRA) QImage using the specified profiles.
      *
@@ -24,6 +24,7 @@
 
 #include <KoColorSpaceTraits.h>
 #include <KoColorSpaceRegistry.h>
+#include <KoCompositeOpRegistry.h>
 
 #include <QTest>
 
@@ -91,6 +92,26 @@ void KoCompositeOpsBenchmark::benchmarkCompositeOver()
     }
 }
 
+void KoCompositeOpsBenchmark::benchmarkCompositeMultiply()
+{
+    KoCompositeOp *compositeOp = KoOptimizedCompositeOpFactory::createBlendOp32(KoColorSpaceRegistry::instance()->rgb8(),
+                                                                                KoOptimizedCompositeOpFactory::BlendMultiply,
+                                                                                COMPOSITE_MULT, "Multiply", KoCompositeOp::categoryArithmetic());
+    QBENCHMARK{
+        COMPOSITE_BENCHMARK
+    }
+}
+
+void KoCompositeOpsBenchmark::benchmarkCompositeSoftLight()
+{
+    KoCompositeOp *compositeOp = KoOptimizedCompositeOpFactory::createBlendOp32(KoColorSpaceRegistry::instance()->rgb8(),
+                                                                                KoOptimizedCompositeOpFactory::BlendSoftLight,
+                                                                                COMPOSITE_SOFT_LIGHT_PHOTOSHOP, "Soft Light", KoCompositeOp::categoryLight());
+    QBENCHMARK{
+        COMPOSITE_BENCHMARK
+    }
+}
+
 void KoCompositeOpsBenchmark::benchmarkCompositeAlphaDarkenHard()
 {
     KoCompositeOp *compositeOp = KoOptimizedCompositeOpFactory::createAlphaDarkenOpHard32(KoColorSpaceRegistry::instance()->rgb8());
@@ -31,6 +31,8 @@ private Q_SLOTS:
     void cleanupTestCase();
     
     void benchmarkCompositeOver();
+    void benchmarkCompositeMultiply();
+    void benchmarkCompositeSoftLight();
     void benchmarkCompositeAlphaDarkenHard();
     void benchmarkCompositeAlphaDarkenCreamy();
 
@@ -49,6 +49,53 @@ struct AddGeneralOps
     static void add(KoColorSpace* cs) { Q_UNUSED(cs); }
 };
 
+/**
+ * Maps the blending function of KoCompositeOpGenericSC to its optimized
+ * version for 4 byte colorspaces. The functions without an optimized
+ * version get null.
+ */
+template<quint8 func(quint8, quint8)>
+struct OptimizedBlendOp32
+{
+    static KoCompositeOp* create(const KoColorSpace *cs, const QString& id, const QString& description, const QString& category) {
+        Q_UNUSED(cs);
+        Q_UNUSED(id);
+        Q_UNUSED(description);
+        Q_UNUSED(category);
+        return 0;
+    }
+};
+
+#define DECLARE_OPTIMIZED_BLEND_OP_32(func, blendFunction)                \
+    template<>                                                            \
+    struct OptimizedBlendOp32<&func<quint8>>                              \
+    {                                                                     \
+        static KoCompositeOp* create(const KoColorSpace *cs, const QString& id, const QString& description, const QString& category) { \
+            return KoOptimizedCompositeOpFactory::createBlendOp32(cs, KoOptimizedCompositeOpFactory::blendFunction, id, description, category); \
+        }                                                                 \
+    }
+
+DECLARE_OPTIMIZED_BLEND_OP_32(cfMultiply, BlendMultiply);
+DECLARE_OPTIMIZED_BLEND_OP_32(cfScreen, BlendScreen);
+DECLARE_OPTIMIZED_BLEND_OP_32(cfOverlay, BlendOverlay);
+DECLARE_OPTIMIZED_BLEND_OP_32(cfHardLight, BlendHardLight);
+DECLARE_OPTIMIZED_BLEND_OP_32(cfSoftLight, BlendSoftLight);
+DECLARE_OPTIMIZED_BLEND_OP_32(cfSoftLightSvg, BlendSoftLightSvg);
+DECLARE_OPTIMIZED_BLEND_OP_32(cfColorDodge, BlendColorDodge);
+DECLARE_OPTIMIZED_BLEND_OP_32(cfColorBurn, BlendColorBurn);
+DECLARE_OPTIMIZED_BLEND_OP_32(cfAddition, BlendAddition);
+DECLARE_OPTIMIZED_BLEND_OP_32(cfSubtract, BlendSubtract);
+DECLARE_OPTIMIZED_BLEND_OP_32(cfLinearBurn, BlendLinearBurn);
+DECLARE_OPTIMIZED_BLEND_OP_32(cfLinearLight, BlendLinearLight);
+DECLARE_OPTIMIZED_BLEND_OP_32(cfLightenOnly, BlendLighten);
+DECLARE_OPTIMIZED_BLEND_OP_32(cfDarkenOnly, BlendDarken);
+DECLARE_OPTIMIZED_BLEND_OP_32(cfDifference, BlendDifference);
+DECLARE_OPTIMIZED_BLEND_OP_32(cfExclusion, BlendExclusion);
+DECLARE_OPTIMIZED_BLEND_OP_32(cfGrainMerge, BlendGrainMerge);
+DECLARE_OPTIMIZED_BLEND_OP_32(cfGrainExtract, BlendGrainExtract);
+
+#undef DECLARE_OPTIMIZED_BLEND_OP_32
+
 template<class Traits>
 struct OptimizedOpsSelector
 {
@@ -62,6 +109,20 @@ struct OptimizedOpsSelector
     static KoCompositeOp* createOverOp(const KoColorSpace *cs) {
         return new KoCompositeOpOver<Traits>(cs);
     }
+    static KoCompositeOp* createCopyOp(const KoColorSpace *cs) {
+        return new KoCompositeOpCopy2<Traits>(cs);
+    }
+    static KoCompositeOp* createBehindOp(const KoColorSpace *cs) {
+        return new KoCompositeOpBehind<Traits>(cs);
+    }
+    template<typename Traits::channels_type func(typename Traits::channels_type, typename Traits::channels_type)>
+    static KoCompositeOp* createBlendOp(const KoColorSpace *cs, const QString& id, const QString& description, const QString& category) {
+        Q_UNUSED(cs);
+        Q_UNUSED(id);
+        Q_UNUSED(description);
+        Q_UNUSED(category);
+        return 0;
+    }
 };
 
 template<>
@@ -75,6 +136,16 @@ struct OptimizedOpsSelector<KoBgrU8Traits>
     static KoCompositeOp* createOverOp(const KoColorSpace *cs) {
         return KoOptimizedCompositeOpFactory::createOverOp32(cs);
     }
+    static KoCompositeOp* createCopyOp(const KoColorSpace *cs) {
+        return new KoCompositeOpCopy2<KoBgrU8Traits>(cs);
+    }
+    static KoCompositeOp* createBehindOp(const KoColorSpace *cs) {
+        return new KoCompositeOpBehind<KoBgrU8Traits>(cs);
+    }
+    template<quint8 func(quint8, quint8)>
+    static KoCompositeOp* createBlendOp(const KoColorSpace *cs, const QString& id, const QString& description, const QString& category) {
+        return OptimizedBlendOp32<func>::create(cs, id, description, category);
+    }
 };
 
 template<>
@@ -88,6 +159,70 @@ struct OptimizedOpsSelector<KoLabU8Traits>
     static KoCompositeOp* createOverOp(const KoColorSpace *cs) {
         return KoOptimizedCompositeOpFactory::createOverOp32(cs);
     }
+    static KoCompositeOp* createCopyOp(const KoColorSpace *cs) {
+        return new KoCompositeOpCopy2<KoLabU8Traits>(cs);
+    }
+    static KoCompositeOp* createBehindOp(const KoColorSpace *cs) {
+        return new KoCompositeOpBehind<KoLabU8Traits>(cs);
+    }
+    template<quint8 func(quint8, quint8)>
+    static KoCompositeOp* createBlendOp(const KoColorSpace *cs, const QString& id, const QString& description, const QString& category) {
+        return OptimizedBlendOp32<func>::create(cs, id, description, category);
+    }
+};
+
+template<>
+struct OptimizedOpsSelector<KoBgrU16Traits>
+{
+    static KoCompositeOp* createAlphaDarkenOp(const KoColorSpace *cs) {
+        return useCreamyAlphaDarken() ?
+            KoOptimizedCompositeOpFactory::createAlphaDarkenOpCreamy64(cs) :
+            KoOptimizedCompositeOpFactory::createAlphaDarkenOpHard64(cs);
+    }
+    static KoCompositeOp* createOverOp(const KoColorSpace *cs) {
+        return KoOptimizedCompositeOpFactory::createOverOp64(cs);
+    }
+    static KoCompositeOp* createCopyOp(const KoColorSpace *cs) {
+        return KoOptimizedCompositeOpFactory::createCopyOp64(cs);
+    }
+    static KoCompositeOp* createBehindOp(const KoColorSpace *cs) {
+        return KoOptimizedCompositeOpFactory::createBehindOp64(cs);
+    }
+    template<quint16 func(quint16, quint16)>
+    static KoCompositeOp* createBlendOp(const KoColorSpace *cs, const QString& id, const QString& description, const QString& category) {
+        Q_UNUSED(cs);
+        Q_UNUSED(id);
+        Q_UNUSED(description);
+        Q_UNUSED(category);
+        return 0;
+    }
+};
+
+template<>
+struct OptimizedOpsSelector<KoLabU16Traits>
+{
+    static KoCompositeOp* createAlphaDarkenOp(const KoColorSpace *cs) {
+        return useCreamyAlphaDarken() ?
+            KoOptimizedCompositeOpFactory::createAlphaDarkenOpCreamy64(cs) :
+            KoOptimizedCompositeOpFactory::createAlphaDarkenOpHard64(cs);
+    }
+    static KoCompositeOp* createOverOp(const KoColorSpace *cs) {
+        return KoOptimizedCompositeOpFactory::createOverOp64(cs);
+    }
+    static KoCompositeOp* createCopyOp(const KoColorSpace *cs) {
+        return KoOptimizedCompositeOpFactory::createCopyOp64(cs);
+    }
+    static KoCompositeOp* createBehindOp(const KoColorSpace *cs) {
+        return KoOptimizedCompositeOpFactory::createBehindOp64(cs);
+    }
+    template<quint16 func(quint16, quint16)>
+    static KoCompositeOp* createBlendOp(const KoColorSpace *cs, const QString& id, const QString& description, const QString& category) {
+        Q_UNUSED(cs);
+        Q_UNUSED(id);
+        Q_UNUSED(description);
+        Q_UNUSED(category);
+        return 0;
+    }
 };
 
 template<>
@@ -112,6 +247,20 @@ struct OptimizedOpsSelector<KoRgbF32Traits>
     static KoCompositeOp* createOverOp(const KoColorSpace *cs) {
         return KoOptimizedCompositeOpFactory::createOverOp128(cs);
     }
+    static KoCompositeOp* createCopyOp(const KoColorSpace *cs) {
+        return new KoCompositeOpCopy2<KoRgbF32Traits>(cs);
+    }
+    static KoCompositeOp* createBehindOp(const KoColorSpace *cs) {
+        return new KoCompositeOpBehind<KoRgbF32Traits>(cs);
+    }
+    template<float func(float, float)>
+    static KoCompositeOp* createBlendOp(const KoColorSpace *cs, const QString& id, const QString& description, const QString& category) {
+        Q_UNUSED(cs);
+        Q_UNUSED(id);
+        Q_UNUSED(description);
+        Q_UNUSED(category);
+        return 0;
+    }
 };
 
 template<class Traits>
@@ -123,15 +272,21 @@ struct AddGeneralOps<Traits, true>
 
      template<CompositeFunc func>
      static void add(KoColorSpace* cs, const QString& id, const QString& description, const QString& category) {
-         cs->addCompositeOp(new KoCompositeOpGenericSC<Traits, func>(cs, id, description, category));
+         KoCompositeOp *op = OptimizedOpsSelector<Traits>::template createBlendOp<func>(cs, id, description, category);
+
+         if (!op) {
+             op = new KoCompositeOpGenericSC<Traits, func>(cs, id, description, category);
+         }
+
+         cs->addCompositeOp(op);
      }
 
      static void add(KoColorSpace* cs) {
          cs->addCompositeOp(OptimizedOpsSelector<Traits>::createOverOp(cs));
          cs->addCompositeOp(OptimizedOpsSelector<Traits>::createAlphaDarkenOp(cs));
-         cs->addCompositeOp(new KoCompositeOpCopy2<Traits>(cs));
+         cs->addCompositeOp(OptimizedOpsSelector<Traits>::createCopyOp(cs));
          cs->addCompositeOp(new KoCompositeOpErase<Traits>(cs));
-         cs->addCompositeOp(new KoCompositeOpBehind<Traits>(cs));
+         cs->addCompositeOp(OptimizedOpsSelector<Traits>::createBehindOp(cs));
          cs->addCompositeOp(new KoCompositeOpDestinationIn<Traits>(cs));
          cs->addCompositeOp(new KoCompositeOpDestinationAtop<Traits>(cs));
          cs->addCompositeOp(new KoCompositeOpGreater<Traits>(cs));
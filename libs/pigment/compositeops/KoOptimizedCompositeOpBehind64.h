@@ -0,0 +1,223 @@
+/*
+ *  Copyright (c) 2020 Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KOOPTIMIZEDCOMPOSITEOPBEHIND64_H
+#define KOOPTIMIZEDCOMPOSITEOPBEHIND64_H
+
+#include "KoCompositeOpBase.h"
+#include "KoCompositeOpRegistry.h"
+#include "KoStreamedMath.h"
+
+
+/**
+ * A vectorized version of KoCompositeOpBehind for 64-bit RGBA pixels.
+ * The source is blended as if it were placed below the destination.
+ */
+template<bool alphaLocked, bool allChannelsFlag>
+struct BehindCompositor64 {
+    struct ParamsWrapper {
+        ParamsWrapper(const KoCompositeOp::ParameterInfo& params)
+            : channelFlags(params.channelFlags)
+        {
+        }
+        const QBitArray &channelFlags;
+    };
+
+    template<bool haveMask, bool src_aligned, Vc::Implementation _impl>
+    static ALWAYS_INLINE void compositeVector(const quint8 *src, quint8 *dst, const quint8 *mask, float opacity, const ParamsWrapper &oparams)
+    {
+        Q_UNUSED(oparams);
+
+        const Vc::float_v uint16Max((float)65535.0);
+        const Vc::float_v uint16MaxRec1((float)1.0 / 65535.0);
+        const Vc::float_v zeroValue(Vc::Zero);
+        const Vc::float_v oneValue(Vc::One);
+
+        Vc::float_v dst_c1;
+        Vc::float_v dst_c2;
+        Vc::float_v dst_c3;
+        Vc::float_v dst_alpha;
+
+        KoStreamedMath<_impl>::fetch_channels_64(dst, dst_c1, dst_c2, dst_c3, dst_alpha);
+        dst_alpha *= uint16MaxRec1;
+
+        // nothing can be seen behind the opaque pixels
+        if ((dst_alpha == oneValue).isFull()) {
+            return;
+        }
+
+        Vc::float_v src_c1;
+        Vc::float_v src_c2;
+        Vc::float_v src_c3;
+        Vc::float_v src_alpha;
+
+        KoStreamedMath<_impl>::fetch_channels_64(src, src_c1, src_c2, src_c3, src_alpha);
+        src_alpha *= Vc::float_v(opacity) * uint16MaxRec1;
+
+        if (haveMask) {
+            const Vc::float_v uint8MaxRec1((float)1.0 / 255.0);
+            src_alpha *= KoStreamedMath<_impl>::fetch_mask_8(mask) * uint8MaxRec1;
+        }
+
+        const Vc::float_m empty_src_pixels_mask = src_alpha == zeroValue;
+
+        if (empty_src_pixels_mask.isFull()) {
+            return;
+        }
+
+        Vc::float_v new_alpha = dst_alpha + src_alpha - dst_alpha * src_alpha;
+
+        Vc::float_v new_alpha_rec = oneValue / new_alpha;
+        new_alpha_rec.setZero(empty_src_pixels_mask);
+
+        const Vc::float_v src_c1_mult = src_c1 * src_alpha;
+        const Vc::float_v src_c2_mult = src_c2 * src_alpha;
+        const Vc::float_v src_c3_mult = src_c3 * src_alpha;
+
+        Vc::float_v c1 = ((dst_c1 - src_c1_mult) * dst_alpha + src_c1_mult) * new_alpha_rec;
+        Vc::float_v c2 = ((dst_c2 - src_c2_mult) * dst_alpha + src_c2_mult) * new_alpha_rec;
+        Vc::float_v c3 = ((dst_c3 - src_c3_mult) * dst_alpha + src_c3_mult) * new_alpha_rec;
+
+        /**
+         * The color of the fully transparent destination is
+         * undefined, so just take the color of the source
+         */
+        const Vc::float_m empty_dst_pixels_mask = dst_alpha == zeroValue;
+        c1(empty_dst_pixels_mask) = src_c1;
+        c2(empty_dst_pixels_mask) = src_c2;
+        c3(empty_dst_pixels_mask) = src_c3;
+
+        c1(empty_src_pixels_mask) = dst_c1;
+        c2(empty_src_pixels_mask) = dst_c2;
+        c3(empty_src_pixels_mask) = dst_c3;
+        new_alpha(empty_src_pixels_mask) = dst_alpha;
+
+        KoStreamedMath<_impl>::write_channels_64(dst, new_alpha * uint16Max,
+                                                 Vc::min(c1, uint16Max),
+                                                 Vc::min(c2, uint16Max),
+                                                 Vc::min(c3, uint16Max));
+    }
+
+    template <bool haveMask, Vc::Implementation _impl>
+    static ALWAYS_INLINE void compositeOnePixelScalar(const quint8 *src, quint8 *dst, const quint8 *mask, float opacity, const ParamsWrapper &oparams)
+    {
+        const qint32 alpha_pos = 3;
+
+        const float uint16Rec1 = 1.0 / 65535.0;
+        const float uint8Rec1 = 1.0 / 255.0;
+
+        const quint16 *s = reinterpret_cast<const quint16*>(src);
+        quint16 *d = reinterpret_cast<quint16*>(dst);
+
+        /**
+         * KoCompositeOpBase resets the color of transparent pixels
+         * when the channel flags are in use, do the same
+         */
+        if ((alphaLocked || !allChannelsFlag) && d[alpha_pos] == 0) {
+            KoStreamedMathFunctions::clearPixel<8>(dst);
+        }
+
+        if (d[alpha_pos] == 65535) return;
+
+        float appliedAlpha = s[alpha_pos] * opacity * uint16Rec1;
+
+        if (haveMask) {
+            appliedAlpha *= float(*mask) * uint8Rec1;
+        }
+
+        if (appliedAlpha == 0.0f) return;
+
+        const float dstAlpha = d[alpha_pos] * uint16Rec1;
+        const float newAlpha = dstAlpha + appliedAlpha - dstAlpha * appliedAlpha;
+        const QBitArray &channelFlags = oparams.channelFlags;
+
+        if (d[alpha_pos] != 0) {
+            const float newAlphaRec = 1.0f / newAlpha;
+
+            for (int i = 0; i < alpha_pos; i++) {
+                if (allChannelsFlag || channelFlags.at(i)) {
+                    const float srcMult = s[i] * appliedAlpha;
+                    const float value = ((d[i] - srcMult) * dstAlpha + srcMult) * newAlphaRec;
+
+                    d[i] = KoStreamedMath<_impl>::round_float_to_u16(qMin(value, 65535.0f));
+                }
+            }
+        } else {
+            for (int i = 0; i < alpha_pos; i++) {
+                if (allChannelsFlag || channelFlags.at(i)) {
+                    d[i] = s[i];
+                }
+            }
+        }
+
+        if (!alphaLocked) {
+            d[alpha_pos] = KoStreamedMath<_impl>::round_float_to_u16(newAlpha * 65535.0f);
+        }
+    }
+};
+
+/**
+ * An optimized version of a composite op for the use in 8 byte
+ * colorspaces with alpha channel placed at the last channel of
+ * the pixel: C1_C2_C3_A, 16 bit per channel.
+ */
+template<Vc::Implementation _impl>
+class KoOptimizedCompositeOpBehind64 : public KoCompositeOp
+{
+public:
+    KoOptimizedCompositeOpBehind64(const KoColorSpace* cs)
+        : KoCompositeOp(cs, COMPOSITE_BEHIND, i18n("Behind"), KoCompositeOp::categoryMix()) {}
+
+    using KoCompositeOp::composite;
+
+    virtual void composite(const KoCompositeOp::ParameterInfo& params) const override
+    {
+        if(params.maskRowStart) {
+            composite<true>(params);
+        } else {
+            composite<false>(params);
+        }
+    }
+
+    template <bool haveMask>
+    inline void composite(const KoCompositeOp::ParameterInfo& params) const {
+        if (params.channelFlags.isEmpty() ||
+            params.channelFlags == QBitArray(4, true)) {
+
+            KoStreamedMath<_impl>::template genericComposite64<haveMask, false, BehindCompositor64<false, true> >(params);
+        } else {
+            const bool allChannelsFlag =
+                params.channelFlags.at(0) &&
+                params.channelFlags.at(1) &&
+                params.channelFlags.at(2);
+
+            const bool alphaLocked =
+                !params.channelFlags.at(3);
+
+            if (allChannelsFlag && alphaLocked) {
+                KoStreamedMath<_impl>::template genericComposite64_novector<haveMask, false, BehindCompositor64<true, true> >(params);
+            } else if (!allChannelsFlag && !alphaLocked) {
+                KoStreamedMath<_impl>::template genericComposite64_novector<haveMask, false, BehindCompositor64<false, false> >(params);
+            } else /*if (!allChannelsFlag && alphaLocked) */{
+                KoStreamedMath<_impl>::template genericComposite64_novector<haveMask, false, BehindCompositor64<true, false> >(params);
+            }
+        }
+    }
+};
+
+#endif // KOOPTIMIZEDCOMPOSITEOPBEHIND64_H
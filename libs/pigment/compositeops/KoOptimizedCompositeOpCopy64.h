@@ -0,0 +1,231 @@
+/*
+ *  Copyright (c) 2020 Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KOOPTIMIZEDCOMPOSITEOPCOPY64_H
+#define KOOPTIMIZEDCOMPOSITEOPCOPY64_H
+
+#include "KoCompositeOpBase.h"
+#include "KoCompositeOpRegistry.h"
+#include "KoStreamedMath.h"
+
+
+/**
+ * A vectorized version of KoCompositeOpCopy2 for 64-bit RGBA pixels.
+ * The colors are blended in the premultiplied form and then divided
+ * by the new alpha, exactly like the generic version does.
+ */
+template<bool alphaLocked, bool allChannelsFlag>
+struct CopyCompositor64 {
+    struct ParamsWrapper {
+        ParamsWrapper(const KoCompositeOp::ParameterInfo& params)
+            : channelFlags(params.channelFlags)
+        {
+        }
+        const QBitArray &channelFlags;
+    };
+
+    template<bool haveMask, bool src_aligned, Vc::Implementation _impl>
+    static ALWAYS_INLINE void compositeVector(const quint8 *src, quint8 *dst, const quint8 *mask, float opacity, const ParamsWrapper &oparams)
+    {
+        Q_UNUSED(oparams);
+
+        const Vc::float_v zeroValue(Vc::Zero);
+        const Vc::float_v oneValue(Vc::One);
+
+        Vc::float_v opacity_vec(opacity);
+
+        if (haveMask) {
+            const Vc::float_v uint8MaxRec1((float)1.0 / 255.0);
+            opacity_vec *= KoStreamedMath<_impl>::fetch_mask_8(mask) * uint8MaxRec1;
+        }
+
+        if ((opacity_vec == zeroValue).isFull()) {
+            return;
+        }
+
+        if ((opacity_vec == oneValue).isFull()) {
+            memcpy(dst, src, Vc::float_v::size() * 8);
+            return;
+        }
+
+        const Vc::float_v uint16Max((float)65535.0);
+        const Vc::float_v uint16MaxRec1((float)1.0 / 65535.0);
+
+        Vc::float_v src_c1;
+        Vc::float_v src_c2;
+        Vc::float_v src_c3;
+        Vc::float_v src_alpha;
+
+        KoStreamedMath<_impl>::fetch_channels_64(src, src_c1, src_c2, src_c3, src_alpha);
+        src_alpha *= uint16MaxRec1;
+
+        Vc::float_v dst_c1;
+        Vc::float_v dst_c2;
+        Vc::float_v dst_c3;
+        Vc::float_v dst_alpha;
+
+        KoStreamedMath<_impl>::fetch_channels_64(dst, dst_c1, dst_c2, dst_c3, dst_alpha);
+        dst_alpha *= uint16MaxRec1;
+
+        Vc::float_v new_alpha = (src_alpha - dst_alpha) * opacity_vec + dst_alpha;
+
+        /**
+         * The pixels that become fully transparent keep their
+         * colors, the fully opaque copy operations take the
+         * colors of the source as they are.
+         */
+        const Vc::float_m keep_dst_mask = (new_alpha == zeroValue) || (opacity_vec == zeroValue);
+        const Vc::float_m copy_src_mask = opacity_vec == oneValue;
+
+        Vc::float_v new_alpha_rec = oneValue / new_alpha;
+        new_alpha_rec.setZero(keep_dst_mask);
+
+        Vc::float_v c1 = ((src_c1 * src_alpha - dst_c1 * dst_alpha) * opacity_vec + dst_c1 * dst_alpha) * new_alpha_rec;
+        Vc::float_v c2 = ((src_c2 * src_alpha - dst_c2 * dst_alpha) * opacity_vec + dst_c2 * dst_alpha) * new_alpha_rec;
+        Vc::float_v c3 = ((src_c3 * src_alpha - dst_c3 * dst_alpha) * opacity_vec + dst_c3 * dst_alpha) * new_alpha_rec;
+
+        c1(keep_dst_mask) = dst_c1;
+        c2(keep_dst_mask) = dst_c2;
+        c3(keep_dst_mask) = dst_c3;
+
+        c1(copy_src_mask) = src_c1;
+        c2(copy_src_mask) = src_c2;
+        c3(copy_src_mask) = src_c3;
+
+        KoStreamedMath<_impl>::write_channels_64(dst, new_alpha * uint16Max,
+                                                 Vc::min(c1, uint16Max),
+                                                 Vc::min(c2, uint16Max),
+                                                 Vc::min(c3, uint16Max));
+    }
+
+    template <bool haveMask, Vc::Implementation _impl>
+    static ALWAYS_INLINE void compositeOnePixelScalar(const quint8 *src, quint8 *dst, const quint8 *mask, float opacity, const ParamsWrapper &oparams)
+    {
+        const qint32 alpha_pos = 3;
+
+        const float uint16Rec1 = 1.0 / 65535.0;
+        const float uint8Rec1 = 1.0 / 255.0;
+
+        const quint16 *s = reinterpret_cast<const quint16*>(src);
+        quint16 *d = reinterpret_cast<quint16*>(dst);
+
+        if (haveMask) {
+            opacity *= float(*mask) * uint8Rec1;
+        }
+
+        const float srcAlpha = s[alpha_pos] * uint16Rec1;
+        const float dstAlpha = d[alpha_pos] * uint16Rec1;
+
+        /**
+         * KoCompositeOpBase resets the color of transparent pixels
+         * when the channel flags are in use, do the same
+         */
+        if ((alphaLocked || !allChannelsFlag) && d[alpha_pos] == 0) {
+            KoStreamedMathFunctions::clearPixel<8>(dst);
+        }
+
+        const QBitArray &channelFlags = oparams.channelFlags;
+        float newAlpha = dstAlpha;
+
+        if (opacity == 1.0f) {
+            if (!alphaLocked || s[alpha_pos] != 0) {
+                for (int i = 0; i < alpha_pos; i++) {
+                    if (allChannelsFlag || channelFlags.at(i)) {
+                        d[i] = s[i];
+                    }
+                }
+            }
+
+            newAlpha = srcAlpha;
+
+        } else if (opacity != 0.0f) {
+            if (alphaLocked && s[alpha_pos] == 0) return;
+
+            newAlpha = (srcAlpha - dstAlpha) * opacity + dstAlpha;
+
+            if (newAlpha != 0.0f) {
+                const float newAlphaRec = 1.0f / newAlpha;
+
+                for (int i = 0; i < alpha_pos; i++) {
+                    if (allChannelsFlag || channelFlags.at(i)) {
+                        const float dstMult = d[i] * dstAlpha;
+                        const float srcMult = s[i] * srcAlpha;
+                        const float value = ((srcMult - dstMult) * opacity + dstMult) * newAlphaRec;
+
+                        d[i] = KoStreamedMath<_impl>::round_float_to_u16(qMin(value, 65535.0f));
+                    }
+                }
+            }
+        }
+
+        if (!alphaLocked) {
+            d[alpha_pos] = KoStreamedMath<_impl>::round_float_to_u16(newAlpha * 65535.0f);
+        }
+    }
+};
+
+/**
+ * An optimized version of a composite op for the use in 8 byte
+ * colorspaces with alpha channel placed at the last channel of
+ * the pixel: C1_C2_C3_A, 16 bit per channel.
+ */
+template<Vc::Implementation _impl>
+class KoOptimizedCompositeOpCopy64 : public KoCompositeOp
+{
+public:
+    KoOptimizedCompositeOpCopy64(const KoColorSpace* cs)
+        : KoCompositeOp(cs, COMPOSITE_COPY, i18n("Copy"), KoCompositeOp::categoryMisc()) {}
+
+    using KoCompositeOp::composite;
+
+    virtual void composite(const KoCompositeOp::ParameterInfo& params) const override
+    {
+        if(params.maskRowStart) {
+            composite<true>(params);
+        } else {
+            composite<false>(params);
+        }
+    }
+
+    template <bool haveMask>
+    inline void composite(const KoCompositeOp::ParameterInfo& params) const {
+        if (params.channelFlags.isEmpty() ||
+            params.channelFlags == QBitArray(4, true)) {
+
+            KoStreamedMath<_impl>::template genericComposite64<haveMask, false, CopyCompositor64<false, true> >(params);
+        } else {
+            const bool allChannelsFlag =
+                params.channelFlags.at(0) &&
+                params.channelFlags.at(1) &&
+                params.channelFlags.at(2);
+
+            const bool alphaLocked =
+                !params.channelFlags.at(3);
+
+            if (allChannelsFlag && alphaLocked) {
+                KoStreamedMath<_impl>::template genericComposite64_novector<haveMask, false, CopyCompositor64<true, true> >(params);
+            } else if (!allChannelsFlag && !alphaLocked) {
+                KoStreamedMath<_impl>::template genericComposite64_novector<haveMask, false, CopyCompositor64<false, false> >(params);
+            } else /*if (!allChannelsFlag && alphaLocked) */{
+                KoStreamedMath<_impl>::template genericComposite64_novector<haveMask, false, CopyCompositor64<true, false> >(params);
+            }
+        }
+    }
+};
+
+#endif // KOOPTIMIZEDCOMPOSITEOPCOPY64_H
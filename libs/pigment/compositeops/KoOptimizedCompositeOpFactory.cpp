@@ -63,3 +63,86 @@ KoCompositeOp* KoOptimizedCompositeOpFactory::createOverOp128(const KoColorSpace
 {
     return createOptimizedClass<KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpOver128> >(cs);
 }
+
+KoCompositeOp* KoOptimizedCompositeOpFactory::createAlphaDarkenOpHard64(const KoColorSpace *cs)
+{
+    return createOptimizedClass<
+        KoOptimizedCompositeOpFactoryPerArch<
+            KoOptimizedCompositeOpAlphaDarkenHard64>>(cs);
+}
+
+KoCompositeOp* KoOptimizedCompositeOpFactory::createAlphaDarkenOpCreamy64(const KoColorSpace *cs)
+{
+    return createOptimizedClass<
+        KoOptimizedCompositeOpFactoryPerArch<
+            KoOptimizedCompositeOpAlphaDarkenCreamy64>>(cs);
+}
+
+KoCompositeOp* KoOptimizedCompositeOpFactory::createOverOp64(const KoColorSpace *cs)
+{
+    return createOptimizedClass<KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpOver64> >(cs);
+}
+
+KoCompositeOp* KoOptimizedCompositeOpFactory::createCopyOp64(const KoColorSpace *cs)
+{
+    return createOptimizedClass<KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpCopy64> >(cs);
+}
+
+KoCompositeOp* KoOptimizedCompositeOpFactory::createBehindOp64(const KoColorSpace *cs)
+{
+    return createOptimizedClass<KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpBehind64> >(cs);
+}
+
+namespace {
+template<class BlendingPolicy>
+KoCompositeOp* createOptimizedBlendOp(const KoOptimizedBlendOpInfo &info)
+{
+    return createOptimizedClass<KoOptimizedBlendOpFactoryPerArch<BlendingPolicy> >(info);
+}
+}
+
+KoCompositeOp* KoOptimizedCompositeOpFactory::createBlendOp32(const KoColorSpace *cs, BlendFunction func, const QString &id, const QString &description, const QString &category)
+{
+    const KoOptimizedBlendOpInfo info = {cs, id, description, category};
+
+    switch (func) {
+    case BlendMultiply:
+        return createOptimizedBlendOp<KoStreamedBlendMultiply>(info);
+    case BlendScreen:
+        return createOptimizedBlendOp<KoStreamedBlendScreen>(info);
+    case BlendOverlay:
+        return createOptimizedBlendOp<KoStreamedBlendOverlay>(info);
+    case BlendHardLight:
+        return createOptimizedBlendOp<KoStreamedBlendHardLight>(info);
+    case BlendSoftLight:
+        return createOptimizedBlendOp<KoStreamedBlendSoftLight>(info);
+    case BlendSoftLightSvg:
+        return createOptimizedBlendOp<KoStreamedBlendSoftLightSvg>(info);
+    case BlendColorDodge:
+        return createOptimizedBlendOp<KoStreamedBlendColorDodge>(info);
+    case BlendColorBurn:
+        return createOptimizedBlendOp<KoStreamedBlendColorBurn>(info);
+    case BlendAddition:
+        return createOptimizedBlendOp<KoStreamedBlendAddition>(info);
+    case BlendSubtract:
+        return createOptimizedBlendOp<KoStreamedBlendSubtract>(info);
+    case BlendLinearBurn:
+        return createOptimizedBlendOp<KoStreamedBlendLinearBurn>(info);
+    case BlendLinearLight:
+        return createOptimizedBlendOp<KoStreamedBlendLinearLight>(info);
+    case BlendLighten:
+        return createOptimizedBlendOp<KoStreamedBlendLighten>(info);
+    case BlendDarken:
+        return createOptimizedBlendOp<KoStreamedBlendDarken>(info);
+    case BlendDifference:
+        return createOptimizedBlendOp<KoStreamedBlendDifference>(info);
+    case BlendExclusion:
+        return createOptimizedBlendOp<KoStreamedBlendExclusion>(info);
+    case BlendGrainMerge:
+        return createOptimizedBlendOp<KoStreamedBlendGrainMerge>(info);
+    case BlendGrainExtract:
+        return createOptimizedBlendOp<KoStreamedBlendGrainExtract>(info);
+    }
+
+    return 0;
+}
@@ -24,6 +24,7 @@
 
 class KoCompositeOp;
 class KoColorSpace;
+class QString;
 
 /**
  * The creation of the optimized composite ops is moved into a separate
@@ -46,6 +47,44 @@ public:
     static KoCompositeOp* createAlphaDarkenOpHard128(const KoColorSpace *cs);
     static KoCompositeOp* createAlphaDarkenOpCreamy128(const KoColorSpace *cs);
     static KoCompositeOp* createOverOp128(const KoColorSpace *cs);
+
+    static KoCompositeOp* createAlphaDarkenOpHard64(const KoColorSpace *cs);
+    static KoCompositeOp* createAlphaDarkenOpCreamy64(const KoColorSpace *cs);
+    static KoCompositeOp* createOverOp64(const KoColorSpace *cs);
+    static KoCompositeOp* createCopyOp64(const KoColorSpace *cs);
+    static KoCompositeOp* createBehindOp64(const KoColorSpace *cs);
+
+    /**
+     * The blending functions of KoCompositeOpGenericSC that have
+     * an optimized version for 4 byte colorspaces
+     */
+    enum BlendFunction {
+        BlendMultiply,
+        BlendScreen,
+        BlendOverlay,
+        BlendHardLight,
+        BlendSoftLight,
+        BlendSoftLightSvg,
+        BlendColorDodge,
+        BlendColorBurn,
+        BlendAddition,
+        BlendSubtract,
+        BlendLinearBurn,
+        BlendLinearLight,
+        BlendLighten,
+        BlendDarken,
+        BlendDifference,
+        BlendExclusion,
+        BlendGrainMerge,
+        BlendGrainExtract
+    };
+
+    /**
+     * Creates an optimized version of the separable blend mode using
+     * the blending function \p func for 4 byte colorspaces. The same
+     * function may be registered under several ids.
+     */
+    static KoCompositeOp* createBlendOp32(const KoColorSpace *cs, BlendFunction func, const QString &id, const QString &description, const QString &category);
 };
 
 #endif /* KOOPTIMIZEDCOMPOSITEOPFACTORY_H */
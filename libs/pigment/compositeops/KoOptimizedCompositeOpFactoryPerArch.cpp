@@ -26,6 +26,11 @@
 #include "KoOptimizedCompositeOpAlphaDarken128.h"
 #include "KoOptimizedCompositeOpOver32.h"
 #include "KoOptimizedCompositeOpOver128.h"
+#include "KoOptimizedCompositeOpAlphaDarken64.h"
+#include "KoOptimizedCompositeOpOver64.h"
+#include "KoOptimizedCompositeOpCopy64.h"
+#include "KoOptimizedCompositeOpBehind64.h"
+#include "KoOptimizedCompositeOpGeneric32.h"
 
 #include <QString>
 #include "DebugPigment.h"
@@ -85,3 +90,71 @@ KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpOver128>::create<Vc::
 {
     return new KoOptimizedCompositeOpOver128<Vc::CurrentImplementation::current()>(param);
 }
+
+template<>
+template<>
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpAlphaDarkenHard64>::ReturnType
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpAlphaDarkenHard64>::create<Vc::CurrentImplementation::current()>(ParamType param)
+{
+    return new KoOptimizedCompositeOpAlphaDarkenHard64<Vc::CurrentImplementation::current()>(param);
+}
+
+template<>
+template<>
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpAlphaDarkenCreamy64>::ReturnType
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpAlphaDarkenCreamy64>::create<Vc::CurrentImplementation::current()>(ParamType param)
+{
+    return new KoOptimizedCompositeOpAlphaDarkenCreamy64<Vc::CurrentImplementation::current()>(param);
+}
+
+template<>
+template<>
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpOver64>::ReturnType
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpOver64>::create<Vc::CurrentImplementation::current()>(ParamType param)
+{
+    return new KoOptimizedCompositeOpOver64<Vc::CurrentImplementation::current()>(param);
+}
+
+template<>
+template<>
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpCopy64>::ReturnType
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpCopy64>::create<Vc::CurrentImplementation::current()>(ParamType param)
+{
+    return new KoOptimizedCompositeOpCopy64<Vc::CurrentImplementation::current()>(param);
+}
+
+template<>
+template<>
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpBehind64>::ReturnType
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpBehind64>::create<Vc::CurrentImplementation::current()>(ParamType param)
+{
+    return new KoOptimizedCompositeOpBehind64<Vc::CurrentImplementation::current()>(param);
+}
+
+#define DEFINE_BLEND_OP_FACTORY(BlendingPolicy) \
+    template<> \
+    template<> \
+    KoOptimizedBlendOpFactoryPerArch<BlendingPolicy>::ReturnType \
+    KoOptimizedBlendOpFactoryPerArch<BlendingPolicy>::create<Vc::CurrentImplementation::current()>(ParamType param) \
+    { \
+        return new KoOptimizedCompositeOpGeneric32<Vc::CurrentImplementation::current(), BlendingPolicy>(param); \
+    }
+
+DEFINE_BLEND_OP_FACTORY(KoStreamedBlendMultiply)
+DEFINE_BLEND_OP_FACTORY(KoStreamedBlendScreen)
+DEFINE_BLEND_OP_FACTORY(KoStreamedBlendOverlay)
+DEFINE_BLEND_OP_FACTORY(KoStreamedBlendHardLight)
+DEFINE_BLEND_OP_FACTORY(KoStreamedBlendSoftLight)
+DEFINE_BLEND_OP_FACTORY(KoStreamedBlendSoftLightSvg)
+DEFINE_BLEND_OP_FACTORY(KoStreamedBlendColorDodge)
+DEFINE_BLEND_OP_FACTORY(KoStreamedBlendColorBurn)
+DEFINE_BLEND_OP_FACTORY(KoStreamedBlendAddition)
+DEFINE_BLEND_OP_FACTORY(KoStreamedBlendSubtract)
+DEFINE_BLEND_OP_FACTORY(KoStreamedBlendLinearBurn)
+DEFINE_BLEND_OP_FACTORY(KoStreamedBlendLinearLight)
+DEFINE_BLEND_OP_FACTORY(KoStreamedBlendLighten)
+DEFINE_BLEND_OP_FACTORY(KoStreamedBlendDarken)
+DEFINE_BLEND_OP_FACTORY(KoStreamedBlendDifference)
+DEFINE_BLEND_OP_FACTORY(KoStreamedBlendExclusion)
+DEFINE_BLEND_OP_FACTORY(KoStreamedBlendGrainMerge)
+DEFINE_BLEND_OP_FACTORY(KoStreamedBlendGrainExtract)
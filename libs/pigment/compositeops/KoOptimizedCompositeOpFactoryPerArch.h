@@ -23,6 +23,7 @@
 
 #include <compositeops/KoVcMultiArchBuildSupport.h>
 
+#include <QString>
 
 class KoCompositeOp;
 class KoColorSpace;
@@ -46,6 +47,21 @@ class KoOptimizedCompositeOpAlphaDarkenCreamy128;
 template<Vc::Implementation _impl>
 class KoOptimizedCompositeOpOver128;
 
+template<Vc::Implementation _impl>
+class KoOptimizedCompositeOpAlphaDarkenHard64;
+
+template<Vc::Implementation _impl>
+class KoOptimizedCompositeOpAlphaDarkenCreamy64;
+
+template<Vc::Implementation _impl>
+class KoOptimizedCompositeOpOver64;
+
+template<Vc::Implementation _impl>
+class KoOptimizedCompositeOpCopy64;
+
+template<Vc::Implementation _impl>
+class KoOptimizedCompositeOpBehind64;
+
 template<template<Vc::Implementation I> class CompositeOp>
 struct KoOptimizedCompositeOpFactoryPerArch
 {
@@ -56,5 +72,49 @@ struct KoOptimizedCompositeOpFactoryPerArch
     static ReturnType create(ParamType param);
 };
 
+/**
+ * The blending functions of the separable blend modes, see
+ * KoOptimizedCompositeOpGeneric32.h
+ */
+struct KoStreamedBlendMultiply;
+struct KoStreamedBlendScreen;
+struct KoStreamedBlendOverlay;
+struct KoStreamedBlendHardLight;
+struct KoStreamedBlendSoftLight;
+struct KoStreamedBlendSoftLightSvg;
+struct KoStreamedBlendColorDodge;
+struct KoStreamedBlendColorBurn;
+struct KoStreamedBlendAddition;
+struct KoStreamedBlendSubtract;
+struct KoStreamedBlendLinearBurn;
+struct KoStreamedBlendLinearLight;
+struct KoStreamedBlendLighten;
+struct KoStreamedBlendDarken;
+struct KoStreamedBlendDifference;
+struct KoStreamedBlendExclusion;
+struct KoStreamedBlendGrainMerge;
+struct KoStreamedBlendGrainExtract;
+
+/**
+ * The same blending function may be registered under several ids,
+ * so the id and the name of the op are passed to the factory
+ */
+struct KoOptimizedBlendOpInfo
+{
+    const KoColorSpace *colorSpace;
+    QString id;
+    QString description;
+    QString category;
+};
+
+template<class BlendingPolicy>
+struct KoOptimizedBlendOpFactoryPerArch
+{
+    typedef const KoOptimizedBlendOpInfo& ParamType;
+    typedef KoCompositeOp* ReturnType;
+
+    template<Vc::Implementation _impl>
+    static ReturnType create(ParamType param);
+};
 
 #endif /* KOOPTIMIZEDCOMPOSITEOPFACTORYPERARCH_H */
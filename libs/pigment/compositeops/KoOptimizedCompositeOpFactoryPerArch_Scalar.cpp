@@ -23,6 +23,10 @@
 #include "KoCompositeOpAlphaDarken.h"
 #include "KoAlphaDarkenParamsWrapper.h"
 #include "KoCompositeOpOver.h"
+#include "KoCompositeOpCopy2.h"
+#include "KoCompositeOpBehind.h"
+#include "KoCompositeOpGeneric.h"
+#include "KoCompositeOpFunctions.h"
 
 template<>
 template<>
@@ -72,3 +76,71 @@ KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpOver128>::create<Vc::
 {
     return new KoCompositeOpOver<KoRgbF32Traits>(param);
 }
+
+template<>
+template<>
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpAlphaDarkenHard64>::ReturnType
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpAlphaDarkenHard64>::create<Vc::ScalarImpl>(ParamType param)
+{
+    return new KoCompositeOpAlphaDarken<KoBgrU16Traits, KoAlphaDarkenParamsWrapperHard>(param);
+}
+
+template<>
+template<>
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpAlphaDarkenCreamy64>::ReturnType
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpAlphaDarkenCreamy64>::create<Vc::ScalarImpl>(ParamType param)
+{
+    return new KoCompositeOpAlphaDarken<KoBgrU16Traits, KoAlphaDarkenParamsWrapperCreamy>(param);
+}
+
+template<>
+template<>
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpOver64>::ReturnType
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpOver64>::create<Vc::ScalarImpl>(ParamType param)
+{
+    return new KoCompositeOpOver<KoBgrU16Traits>(param);
+}
+
+template<>
+template<>
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpCopy64>::ReturnType
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpCopy64>::create<Vc::ScalarImpl>(ParamType param)
+{
+    return new KoCompositeOpCopy2<KoBgrU16Traits>(param);
+}
+
+template<>
+template<>
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpBehind64>::ReturnType
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpBehind64>::create<Vc::ScalarImpl>(ParamType param)
+{
+    return new KoCompositeOpBehind<KoBgrU16Traits>(param);
+}
+
+#define DEFINE_BLEND_OP_FACTORY(BlendingPolicy, compositeFunc) \
+    template<> \
+    template<> \
+    KoOptimizedBlendOpFactoryPerArch<BlendingPolicy>::ReturnType \
+    KoOptimizedBlendOpFactoryPerArch<BlendingPolicy>::create<Vc::ScalarImpl>(ParamType param) \
+    { \
+        return new KoCompositeOpGenericSC<KoBgrU8Traits, &compositeFunc<quint8> >(param.colorSpace, param.id, param.description, param.category); \
+    }
+
+DEFINE_BLEND_OP_FACTORY(KoStreamedBlendMultiply, cfMultiply)
+DEFINE_BLEND_OP_FACTORY(KoStreamedBlendScreen, cfScreen)
+DEFINE_BLEND_OP_FACTORY(KoStreamedBlendOverlay, cfOverlay)
+DEFINE_BLEND_OP_FACTORY(KoStreamedBlendHardLight, cfHardLight)
+DEFINE_BLEND_OP_FACTORY(KoStreamedBlendSoftLight, cfSoftLight)
+DEFINE_BLEND_OP_FACTORY(KoStreamedBlendSoftLightSvg, cfSoftLightSvg)
+DEFINE_BLEND_OP_FACTORY(KoStreamedBlendColorDodge, cfColorDodge)
+DEFINE_BLEND_OP_FACTORY(KoStreamedBlendColorBurn, cfColorBurn)
+DEFINE_BLEND_OP_FACTORY(KoStreamedBlendAddition, cfAddition)
+DEFINE_BLEND_OP_FACTORY(KoStreamedBlendSubtract, cfSubtract)
+DEFINE_BLEND_OP_FACTORY(KoStreamedBlendLinearBurn, cfLinearBurn)
+DEFINE_BLEND_OP_FACTORY(KoStreamedBlendLinearLight, cfLinearLight)
+DEFINE_BLEND_OP_FACTORY(KoStreamedBlendLighten, cfLightenOnly)
+DEFINE_BLEND_OP_FACTORY(KoStreamedBlendDarken, cfDarkenOnly)
+DEFINE_BLEND_OP_FACTORY(KoStreamedBlendDifference, cfDifference)
+DEFINE_BLEND_OP_FACTORY(KoStreamedBlendExclusion, cfExclusion)
+DEFINE_BLEND_OP_FACTORY(KoStreamedBlendGrainMerge, cfGrainMerge)
+DEFINE_BLEND_OP_FACTORY(KoStreamedBlendGrainExtract, cfGrainExtract)
@@ -0,0 +1,447 @@
+/*
+ *  Copyright (c) 2020 Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KOOPTIMIZEDCOMPOSITEOPGENERIC32_H
+#define KOOPTIMIZEDCOMPOSITEOPGENERIC32_H
+
+#include <cmath>
+
+#include "KoCompositeOpBase.h"
+#include "KoStreamedMath.h"
+#include "KoOptimizedCompositeOpFactoryPerArch.h"
+
+/**
+ * The overloads of the basic math functions for scalar and vector
+ * values. They let the blending functions below be written only once
+ * and be used both in the vectorized and the scalar code paths
+ */
+namespace KoStreamedBlendMath {
+
+static ALWAYS_INLINE float select(bool condition, float a, float b) {
+    return condition ? a : b;
+}
+
+static ALWAYS_INLINE float min(float a, float b) {
+    return qMin(a, b);
+}
+
+static ALWAYS_INLINE float max(float a, float b) {
+    return qMax(a, b);
+}
+
+static ALWAYS_INLINE float abs(float a) {
+    return std::abs(a);
+}
+
+static ALWAYS_INLINE float sqrt(float a) {
+    return std::sqrt(a);
+}
+
+static ALWAYS_INLINE Vc::float_v select(Vc::float_m condition, Vc::float_v::AsArg a, Vc::float_v::AsArg b) {
+    return Vc::iif(condition, a, b);
+}
+
+static ALWAYS_INLINE Vc::float_v min(Vc::float_v::AsArg a, Vc::float_v::AsArg b) {
+    return Vc::min(a, b);
+}
+
+static ALWAYS_INLINE Vc::float_v max(Vc::float_v::AsArg a, Vc::float_v::AsArg b) {
+    return Vc::max(a, b);
+}
+
+static ALWAYS_INLINE Vc::float_v abs(Vc::float_v::AsArg a) {
+    return Vc::abs(a);
+}
+
+static ALWAYS_INLINE Vc::float_v sqrt(Vc::float_v::AsArg a) {
+    return Vc::sqrt(a);
+}
+
+template<typename T>
+ALWAYS_INLINE T clampToUnit(const T &a) {
+    return KoStreamedBlendMath::min(KoStreamedBlendMath::max(a, T(0.0f)), T(255.0f));
+}
+
+}
+
+/**
+ * Blending functions for KoOptimizedCompositeOpGeneric32. Every struct
+ * implements the corresponding cfXxx() function from
+ * KoCompositeOpFunctions.h for the channel values in the [0, 255] range.
+ */
+
+struct KoStreamedBlendMultiply {
+    template<typename T>
+    static ALWAYS_INLINE T blend(const T &src, const T &dst) {
+        return src * dst * T(1.0f / 255.0f);
+    }
+};
+
+struct KoStreamedBlendScreen {
+    template<typename T>
+    static ALWAYS_INLINE T blend(const T &src, const T &dst) {
+        return src + dst - src * dst * T(1.0f / 255.0f);
+    }
+};
+
+struct KoStreamedBlendHardLight {
+    template<typename T>
+    static ALWAYS_INLINE T blend(const T &src, const T &dst) {
+        const T src2 = src + src;
+        const T srcScreen = src2 - T(255.0f);
+
+        return KoStreamedBlendMath::select(src > T(127.0f),
+                      srcScreen + dst - srcScreen * dst * T(1.0f / 255.0f),
+                      src2 * dst * T(1.0f / 255.0f));
+    }
+};
+
+struct KoStreamedBlendOverlay {
+    template<typename T>
+    static ALWAYS_INLINE T blend(const T &src, const T &dst) {
+        return KoStreamedBlendHardLight::blend(dst, src);
+    }
+};
+
+struct KoStreamedBlendSoftLight {
+    template<typename T>
+    static ALWAYS_INLINE T blend(const T &src, const T &dst) {
+        const T fsrc = src * T(1.0f / 255.0f);
+        const T fdst = dst * T(1.0f / 255.0f);
+        const T src2 = fsrc + fsrc;
+
+        return T(255.0f) * KoStreamedBlendMath::select(fsrc > T(0.5f),
+                                  fdst + (src2 - T(1.0f)) * (KoStreamedBlendMath::sqrt(fdst) - fdst),
+                                  fdst - (T(1.0f) - src2) * fdst * (T(1.0f) - fdst));
+    }
+};
+
+struct KoStreamedBlendSoftLightSvg {
+    template<typename T>
+    static ALWAYS_INLINE T blend(const T &src, const T &dst) {
+        const T fsrc = src * T(1.0f / 255.0f);
+        const T fdst = dst * T(1.0f / 255.0f);
+        const T src2 = fsrc + fsrc;
+
+        const T D = KoStreamedBlendMath::select(fdst > T(0.25f),
+                           KoStreamedBlendMath::sqrt(fdst),
+                           ((T(16.0f) * fdst - T(12.0f)) * fdst + T(4.0f)) * fdst);
+
+        return T(255.0f) * KoStreamedBlendMath::select(fsrc > T(0.5f),
+                                  fdst + (src2 - T(1.0f)) * (D - fdst),
+                                  fdst - (T(1.0f) - src2) * fdst * (T(1.0f) - fdst));
+    }
+};
+
+struct KoStreamedBlendColorDodge {
+    template<typename T>
+    static ALWAYS_INLINE T blend(const T &src, const T &dst) {
+        // the division by zero is discarded by select()
+        return KoStreamedBlendMath::select(src == T(255.0f),
+                      T(255.0f),
+                      KoStreamedBlendMath::min(dst * T(255.0f) / (T(255.0f) - src), T(255.0f)));
+    }
+};
+
+struct KoStreamedBlendColorBurn {
+    template<typename T>
+    static ALWAYS_INLINE T blend(const T &src, const T &dst) {
+        const T invDst = T(255.0f) - dst;
+
+        // the division by zero is discarded by select()
+        return KoStreamedBlendMath::select(dst == T(255.0f),
+                      T(255.0f),
+                      KoStreamedBlendMath::select(src < invDst,
+                             T(0.0f),
+                             T(255.0f) - KoStreamedBlendMath::min(invDst * T(255.0f) / src, T(255.0f))));
+    }
+};
+
+struct KoStreamedBlendAddition {
+    template<typename T>
+    static ALWAYS_INLINE T blend(const T &src, const T &dst) {
+        return KoStreamedBlendMath::min(src + dst, T(255.0f));
+    }
+};
+
+struct KoStreamedBlendSubtract {
+    template<typename T>
+    static ALWAYS_INLINE T blend(const T &src, const T &dst) {
+        return KoStreamedBlendMath::max(dst - src, T(0.0f));
+    }
+};
+
+struct KoStreamedBlendLinearBurn {
+    template<typename T>
+    static ALWAYS_INLINE T blend(const T &src, const T &dst) {
+        return KoStreamedBlendMath::max(src + dst - T(255.0f), T(0.0f));
+    }
+};
+
+struct KoStreamedBlendLinearLight {
+    template<typename T>
+    static ALWAYS_INLINE T blend(const T &src, const T &dst) {
+        return KoStreamedBlendMath::clampToUnit(src + src + dst - T(255.0f));
+    }
+};
+
+struct KoStreamedBlendLighten {
+    template<typename T>
+    static ALWAYS_INLINE T blend(const T &src, const T &dst) {
+        return KoStreamedBlendMath::max(src, dst);
+    }
+};
+
+struct KoStreamedBlendDarken {
+    template<typename T>
+    static ALWAYS_INLINE T blend(const T &src, const T &dst) {
+        return KoStreamedBlendMath::min(src, dst);
+    }
+};
+
+struct KoStreamedBlendDifference {
+    template<typename T>
+    static ALWAYS_INLINE T blend(const T &src, const T &dst) {
+        return KoStreamedBlendMath::abs(src - dst);
+    }
+};
+
+struct KoStreamedBlendExclusion {
+    template<typename T>
+    static ALWAYS_INLINE T blend(const T &src, const T &dst) {
+        const T x = src * dst * T(1.0f / 255.0f);
+        return KoStreamedBlendMath::clampToUnit(dst + src - (x + x));
+    }
+};
+
+struct KoStreamedBlendGrainMerge {
+    template<typename T>
+    static ALWAYS_INLINE T blend(const T &src, const T &dst) {
+        return KoStreamedBlendMath::clampToUnit(dst + src - T(127.0f));
+    }
+};
+
+struct KoStreamedBlendGrainExtract {
+    template<typename T>
+    static ALWAYS_INLINE T blend(const T &src, const T &dst) {
+        return KoStreamedBlendMath::clampToUnit(dst - src + T(127.0f));
+    }
+};
+
+
+/**
+ * A vectorized version of KoCompositeOpGenericSC for 4 byte colorspaces
+ * with alpha channel placed at the last byte of the pixel: C1_C2_C3_A.
+ * The color channels are blended with BlendingPolicy::blend() in the
+ * floating point domain, so the result may differ from the one of
+ * KoCompositeOpGenericSC by one step of quantization.
+ */
+template<class BlendingPolicy, bool alphaLocked, bool allChannelsFlag>
+struct GenericCompositor32 {
+    struct ParamsWrapper {
+        ParamsWrapper(const KoCompositeOp::ParameterInfo& params)
+            : channelFlags(params.channelFlags)
+        {
+        }
+        const QBitArray &channelFlags;
+    };
+
+    template<bool haveMask, bool src_aligned, Vc::Implementation _impl>
+    static ALWAYS_INLINE void compositeVector(const quint8 *src, quint8 *dst, const quint8 *mask, float opacity, const ParamsWrapper &oparams)
+    {
+        Q_UNUSED(oparams);
+
+        const Vc::float_v uint8Max((float)255.0);
+        const Vc::float_v uint8MaxRec1((float)1.0 / 255.0);
+        const Vc::float_v zeroValue(Vc::Zero);
+        const Vc::float_v oneValue(Vc::One);
+
+        Vc::float_v src_alpha = KoStreamedMath<_impl>::template fetch_alpha_32<src_aligned>(src);
+        src_alpha *= Vc::float_v(opacity) * uint8MaxRec1;
+
+        if (haveMask) {
+            Vc::float_v mask_vec = KoStreamedMath<_impl>::fetch_mask_8(mask);
+            src_alpha *= mask_vec * uint8MaxRec1;
+        }
+
+        /**
+         * The source is fully transparent, nothing to blend. With locked
+         * alpha we should still reset the transparent pixels (see below)
+         */
+        if (!alphaLocked && (src_alpha == zeroValue).isFull()) {
+            return;
+        }
+
+        const Vc::float_v dst_alpha = KoStreamedMath<_impl>::template fetch_alpha_32<true>(dst) * uint8MaxRec1;
+
+        Vc::float_v src_c1;
+        Vc::float_v src_c2;
+        Vc::float_v src_c3;
+
+        Vc::float_v dst_c1;
+        Vc::float_v dst_c2;
+        Vc::float_v dst_c3;
+
+        KoStreamedMath<_impl>::template fetch_colors_32<src_aligned>(src, src_c1, src_c2, src_c3);
+        KoStreamedMath<_impl>::template fetch_colors_32<true>(dst, dst_c1, dst_c2, dst_c3);
+
+        const Vc::float_v result_c1 = BlendingPolicy::blend(src_c1, dst_c1);
+        const Vc::float_v result_c2 = BlendingPolicy::blend(src_c2, dst_c2);
+        const Vc::float_v result_c3 = BlendingPolicy::blend(src_c3, dst_c3);
+
+        Vc::float_v new_alpha;
+
+        if (alphaLocked) {
+            /**
+             * KoCompositeOpBase resets the fully transparent pixels
+             * when the alpha channel is locked, so do the same
+             */
+            const Vc::float_m transparentDst = dst_alpha == zeroValue;
+
+            dst_c1 = Vc::iif(transparentDst, zeroValue, dst_c1 + (result_c1 - dst_c1) * src_alpha);
+            dst_c2 = Vc::iif(transparentDst, zeroValue, dst_c2 + (result_c2 - dst_c2) * src_alpha);
+            dst_c3 = Vc::iif(transparentDst, zeroValue, dst_c3 + (result_c3 - dst_c3) * src_alpha);
+
+            new_alpha = dst_alpha;
+        } else {
+            new_alpha = src_alpha + dst_alpha - src_alpha * dst_alpha;
+
+            const Vc::float_v dst_weight = (oneValue - src_alpha) * dst_alpha;
+            const Vc::float_v src_weight = (oneValue - dst_alpha) * src_alpha;
+            const Vc::float_v result_weight = src_alpha * dst_alpha;
+
+            /**
+             * new_alpha is null only when both the pixels are
+             * transparent, the destination color is kept then
+             */
+            const Vc::float_m transparentResult = new_alpha == zeroValue;
+            const Vc::float_v new_alpha_rec = oneValue / new_alpha;
+
+            dst_c1 = Vc::iif(transparentResult, dst_c1, (dst_weight * dst_c1 + src_weight * src_c1 + result_weight * result_c1) * new_alpha_rec);
+            dst_c2 = Vc::iif(transparentResult, dst_c2, (dst_weight * dst_c2 + src_weight * src_c2 + result_weight * result_c2) * new_alpha_rec);
+            dst_c3 = Vc::iif(transparentResult, dst_c3, (dst_weight * dst_c3 + src_weight * src_c3 + result_weight * result_c3) * new_alpha_rec);
+        }
+
+        KoStreamedMath<_impl>::write_channels_32(dst, new_alpha * uint8Max, dst_c1, dst_c2, dst_c3);
+    }
+
+    template <bool haveMask, Vc::Implementation _impl>
+    static ALWAYS_INLINE void compositeOnePixelScalar(const quint8 *src, quint8 *dst, const quint8 *mask, float opacity, const ParamsWrapper &oparams)
+    {
+        const qint32 alpha_pos = 3;
+        const float uint8Rec1 = 1.0 / 255.0;
+
+        const float dstAlpha = dst[alpha_pos] * uint8Rec1;
+
+        // \see the reset of the pixel in KoCompositeOpBase
+        if ((alphaLocked || !allChannelsFlag) && dstAlpha == 0.0) {
+            *reinterpret_cast<quint32*>(dst) = 0;
+            if (alphaLocked) return;
+        }
+
+        float srcAlpha = src[alpha_pos] * opacity * uint8Rec1;
+
+        if (haveMask) {
+            srcAlpha *= float(*mask) * uint8Rec1;
+        }
+
+        if (srcAlpha == 0.0) return;
+
+        const QBitArray &channelFlags = oparams.channelFlags;
+
+        if (alphaLocked) {
+            for (int i = 0; i < alpha_pos; i++) {
+                if (allChannelsFlag || channelFlags.at(i)) {
+                    const float d = dst[i];
+                    const float result = BlendingPolicy::blend(float(src[i]), d);
+                    dst[i] = KoStreamedMath<_impl>::round_float_to_uint(d + (result - d) * srcAlpha);
+                }
+            }
+        } else {
+            const float newAlpha = srcAlpha + dstAlpha - srcAlpha * dstAlpha;
+
+            const float dstWeight = (1.0f - srcAlpha) * dstAlpha;
+            const float srcWeight = (1.0f - dstAlpha) * srcAlpha;
+            const float resultWeight = srcAlpha * dstAlpha;
+            const float newAlphaRec = 1.0f / newAlpha;
+
+            for (int i = 0; i < alpha_pos; i++) {
+                if (allChannelsFlag || channelFlags.at(i)) {
+                    const float s = src[i];
+                    const float d = dst[i];
+                    const float result = BlendingPolicy::blend(s, d);
+                    dst[i] = KoStreamedMath<_impl>::round_float_to_uint(
+                        KoStreamedBlendMath::clampToUnit((dstWeight * d + srcWeight * s + resultWeight * result) * newAlphaRec));
+                }
+            }
+
+            dst[alpha_pos] = KoStreamedMath<_impl>::round_float_to_uint(newAlpha * 255.0f);
+        }
+    }
+};
+
+/**
+ * An optimized version of KoCompositeOpGenericSC for the use in 4 byte
+ * colorspaces with alpha channel placed at the last byte of the pixel:
+ * C1_C2_C3_A.
+ */
+template<Vc::Implementation _impl, class BlendingPolicy>
+class KoOptimizedCompositeOpGeneric32 : public KoCompositeOp
+{
+public:
+    KoOptimizedCompositeOpGeneric32(const KoOptimizedBlendOpInfo &info)
+        : KoCompositeOp(info.colorSpace, info.id, info.description, info.category) {}
+
+    using KoCompositeOp::composite;
+
+    virtual void composite(const KoCompositeOp::ParameterInfo& params) const
+    {
+        if(params.maskRowStart) {
+            composite<true>(params);
+        } else {
+            composite<false>(params);
+        }
+    }
+
+    template <bool haveMask>
+    inline void composite(const KoCompositeOp::ParameterInfo& params) const {
+        if (params.channelFlags.isEmpty() ||
+            params.channelFlags == QBitArray(4, true)) {
+
+            KoStreamedMath<_impl>::template genericComposite32<haveMask, false, GenericCompositor32<BlendingPolicy, false, true> >(params);
+        } else {
+            const bool allChannelsFlag =
+                params.channelFlags.at(0) &&
+                params.channelFlags.at(1) &&
+                params.channelFlags.at(2);
+
+            const bool alphaLocked =
+                !params.channelFlags.at(3);
+
+            if (allChannelsFlag && alphaLocked) {
+                KoStreamedMath<_impl>::template genericComposite32<haveMask, false, GenericCompositor32<BlendingPolicy, true, true> >(params);
+            } else if (!allChannelsFlag && !alphaLocked) {
+                KoStreamedMath<_impl>::template genericComposite32_novector<haveMask, false, GenericCompositor32<BlendingPolicy, false, false> >(params);
+            } else /*if (!allChannelsFlag && alphaLocked) */{
+                KoStreamedMath<_impl>::template genericComposite32_novector<haveMask, false, GenericCompositor32<BlendingPolicy, true, false> >(params);
+            }
+        }
+    }
+};
+
+#endif // KOOPTIMIZEDCOMPOSITEOPGENERIC32_H
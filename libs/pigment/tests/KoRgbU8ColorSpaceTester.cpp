@@ -22,6 +22,7 @@
 #include "KoColorModelStandardIds.h"
 
 #include <QTest>
+#include <QScopedPointer>
 #include <DebugPigment.h>
 #include <string.h>
 
@@ -31,6 +32,11 @@
 #include "KoCompositeOp.h"
 #include "KoMixColorsOp.h"
 #include <KoCompositeOpRegistry.h>
+#include <KoColorSpaceTraits.h>
+#include <compositeops/KoCompositeOpGeneric.h>
+#include <compositeops/KoCompositeOpFunctions.h>
+#include <compositeops/KoOptimizedCompositeOpFactory.h>
+#include <compositeops/KoCompositeOps.h>
 
 
 #define NUM_CHANNELS 4
@@ -305,4 +311,115 @@ void KoRgbU8ColorSpaceTester::testCompositeOpsWithChannelFlags()
     }
 }
 
+template<quint8 compositeFunc(quint8, quint8)>
+void checkOptimizedBlendOp(const QString &id)
+{
+    const KoColorSpace* cs = KoColorSpaceRegistry::instance()->rgb8();
+
+    // the optimized op is selected by the blending function, not by id
+    QScopedPointer<KoCompositeOp> optimizedOp(
+        _Private::OptimizedBlendOp32<compositeFunc>::create(cs, id, id, KoCompositeOp::categoryMisc()));
+    QVERIFY(optimizedOp);
+    QCOMPARE(optimizedOp->id(), id);
+
+    KoCompositeOpGenericSC<KoBgrU8Traits, compositeFunc> scalarOp(cs, id, id, KoCompositeOp::categoryMisc());
+
+    // the width is not a multiple of the vector size, so that
+    // the unaligned pixels were processed by the scalar code
+    const int width = 37;
+    const int height = 3;
+    const int numBytes = width * height * 4;
+
+    QVector<quint8> src(numBytes);
+    QVector<quint8> dst(numBytes);
+    QVector<quint8> mask(width * height);
+
+    qsrand(42);
+
+    for (int i = 0; i < numBytes; i++) {
+        src[i] = qrand() & 0xFF;
+        dst[i] = qrand() & 0xFF;
+    }
+
+    // check the fully transparent and opaque pixels as well
+    for (int i = 0; i < width; i += 3) {
+        src[4 * i + 3] = 255;
+        dst[4 * i + 3] = (i & 1) ? 0 : 255;
+    }
+
+    for (int i = 0; i < mask.size(); i++) {
+        mask[i] = qrand() & 0xFF;
+    }
+
+    QBitArray alphaLockedFlags(4, true);
+    alphaLockedFlags.clearBit(3);
+
+    QBitArray noBlueFlags(4, true);
+    noBlueFlags.clearBit(0);
+
+    QList<QBitArray> channelFlagsList;
+    channelFlagsList << QBitArray() << alphaLockedFlags << noBlueFlags;
+
+    Q_FOREACH (const QBitArray &channelFlags, channelFlagsList) {
+        for (int useMask = 0; useMask <= 1; useMask++) {
+            QVector<quint8> optimizedDst = dst;
+            QVector<quint8> scalarDst = dst;
+
+            KoCompositeOp::ParameterInfo params;
+            params.srcRowStart   = src.data();
+            params.srcRowStride  = width * 4;
+            params.maskRowStart  = useMask ? mask.data() : 0;
+            params.maskRowStride = width;
+            params.dstRowStride  = width * 4;
+            params.rows          = height;
+            params.cols          = width;
+            params.opacity       = 0.7f;
+            params.flow          = 1.0f;
+            params.channelFlags  = channelFlags;
+
+            params.dstRowStart = optimizedDst.data();
+            optimizedOp->composite(params);
+
+            params.dstRowStart = scalarDst.data();
+            scalarOp.composite(params);
+
+            for (int i = 0; i < numBytes; i++) {
+                if (qAbs(optimizedDst[i] - scalarDst[i]) > 2) {
+                    qDebug() << "Optimized op differs from the scalar one:" << id
+                             << "byte" << i << "mask" << useMask << "flags" << channelFlags
+                             << "src" << src[i] << "dst" << dst[i]
+                             << "optimized" << optimizedDst[i] << "scalar" << scalarDst[i];
+                    QFAIL("Optimized blend op has failed");
+                }
+            }
+        }
+    }
+}
+
+void KoRgbU8ColorSpaceTester::testOptimizedBlendOps()
+{
+    checkOptimizedBlendOp<&cfMultiply<quint8>>(COMPOSITE_MULT);
+    checkOptimizedBlendOp<&cfScreen<quint8>>(COMPOSITE_SCREEN);
+    checkOptimizedBlendOp<&cfOverlay<quint8>>(COMPOSITE_OVERLAY);
+    checkOptimizedBlendOp<&cfHardLight<quint8>>(COMPOSITE_HARD_LIGHT);
+    checkOptimizedBlendOp<&cfSoftLight<quint8>>(COMPOSITE_SOFT_LIGHT_PHOTOSHOP);
+    checkOptimizedBlendOp<&cfSoftLightSvg<quint8>>(COMPOSITE_SOFT_LIGHT_SVG);
+    checkOptimizedBlendOp<&cfColorDodge<quint8>>(COMPOSITE_DODGE);
+    checkOptimizedBlendOp<&cfColorBurn<quint8>>(COMPOSITE_BURN);
+    checkOptimizedBlendOp<&cfAddition<quint8>>(COMPOSITE_ADD);
+    checkOptimizedBlendOp<&cfAddition<quint8>>(COMPOSITE_LINEAR_DODGE);
+    checkOptimizedBlendOp<&cfSubtract<quint8>>(COMPOSITE_SUBTRACT);
+    checkOptimizedBlendOp<&cfLinearBurn<quint8>>(COMPOSITE_LINEAR_BURN);
+    checkOptimizedBlendOp<&cfLinearLight<quint8>>(COMPOSITE_LINEAR_LIGHT);
+    checkOptimizedBlendOp<&cfLightenOnly<quint8>>(COMPOSITE_LIGHTEN);
+    checkOptimizedBlendOp<&cfDarkenOnly<quint8>>(COMPOSITE_DARKEN);
+    checkOptimizedBlendOp<&cfDifference<quint8>>(COMPOSITE_DIFF);
+    checkOptimizedBlendOp<&cfExclusion<quint8>>(COMPOSITE_EXCLUSION);
+    checkOptimizedBlendOp<&cfGrainMerge<quint8>>(COMPOSITE_GRAIN_MERGE);
+    checkOptimizedBlendOp<&cfGrainExtract<quint8>>(COMPOSITE_GRAIN_EXTRACT);
+
+    const KoColorSpace* cs = KoColorSpaceRegistry::instance()->rgb8();
+    QVERIFY(!_Private::OptimizedBlendOp32<&cfHardMix<quint8>>::create(cs, COMPOSITE_HARD_MIX, "", ""));
+}
+
 QTEST_GUILESS_MAIN(KoRgbU8ColorSpaceTester)
@@ -87,6 +87,55 @@ void TestKoColor::testConversion()
     kc.convertTo(csDst);
 }
 
+void TestKoColor::testBatchConversion()
+{
+    const KoColorSpace *rgb8 = KoColorSpaceRegistry::instance()->rgb8();
+    const KoColorSpace *lab16 = KoColorSpaceRegistry::instance()->lab16();
+    const KoColorSpace *cmyk = KoColorSpaceRegistry::instance()->colorSpace(CMYKAColorModelID.id(), Integer8BitsColorDepthID.id(), "");
+    QVERIFY(cmyk);
+
+    QVector<QColor> qcolors;
+    for (int i = 0; i < 36; i++) {
+        qcolors.append(QColor::fromHsv(i * 10, 255 - i * 3, 128 + i * 3, 255 - i));
+    }
+
+    QVector<KoColor> colors = KoColor::fromQColors(qcolors, rgb8);
+    QCOMPARE(colors.size(), qcolors.size());
+
+    // mix several color spaces to check that every run is converted separately
+    for (int i = 0; i < colors.size(); i++) {
+        QVERIFY(*colors[i].colorSpace() == *rgb8);
+        QVERIFY(rgb8->difference(colors[i].data(), KoColor(qcolors[i], rgb8).data()) <= 1);
+
+        if (i % 3 == 1) {
+            colors[i].convertTo(lab16);
+        }
+    }
+
+    QVector<KoColor> expected = colors;
+    for (int i = 0; i < expected.size(); i++) {
+        expected[i].convertTo(cmyk);
+    }
+
+    KoColor::convertAllTo(colors, cmyk);
+
+    for (int i = 0; i < colors.size(); i++) {
+        QVERIFY(*colors[i].colorSpace() == *cmyk);
+        QVERIFY(cmyk->difference(colors[i].data(), expected[i].data()) <= 1);
+    }
+
+    const QVector<QColor> result = KoColor::toQColors(colors);
+    QCOMPARE(result.size(), colors.size());
+
+    for (int i = 0; i < colors.size(); i++) {
+        const QColor c = colors[i].toQColor();
+        QVERIFY(nearEqualValue(result[i].red(), c.red()));
+        QVERIFY(nearEqualValue(result[i].green(), c.green()));
+        QVERIFY(nearEqualValue(result[i].blue(), c.blue()));
+        QCOMPARE(result[i].alpha(), c.alpha());
+    }
+}
+
 void TestKoColor::testSimpleSerialization()
 {
     QColor c = Qt::green;
@@ -78,6 +78,7 @@
 #include <kis_meta_data_io_backend.h>
 #include "kisexiv2/kis_exiv2.h"
 #include "KisApplicationArguments.h"
+#include "KisBatchExporter.h"
 #include <kis_debug.h>
 #include "kis_action_registry.h"
 #include <KoResourceServer.h>
@@ -440,11 +441,12 @@ bool KisApplication::start(const KisApplicationArguments &args)
     const bool exportAs = args.exportAs();
     const bool exportSequence = args.exportSequence();
     const QString exportFileName = args.exportFileName();
+    const bool exportBatch = args.exportBatch();
 
-    d->batchRun = (exportAs || exportSequence || !exportFileName.isEmpty());
-    const bool needsMainWindow = (!exportAs && !exportSequence);
+    d->batchRun = (exportAs || exportSequence || exportBatch || !exportFileName.isEmpty());
+    const bool needsMainWindow = (!exportAs && !exportSequence && !exportBatch);
     // only show the mainWindow when no command-line mode option is passed
-    bool showmainWindow = (!exportAs && !exportSequence); // would be !batchRun;
+    bool showmainWindow = (!exportAs && !exportSequence && !exportBatch); // would be !batchRun;
 
     const bool showSplashScreen = !d->batchRun && qEnvironmentVariableIsEmpty("NOSPLASH");
     if (showSplashScreen && d->splashScreen) {
@@ -476,6 +478,31 @@ bool KisApplication::start(const KisApplicationArguments &args)
     // Load the gui plugins
     loadGuiPlugins();
 
+    if (exportBatch) {
+        // the plugins and resources are loaded only once for the whole batch
+        KisBatchExporter *exporter = new KisBatchExporter(args.exportBatchJobs(), this);
+        connect(exporter, &KisBatchExporter::sigFinished, this, [exporter] () {
+            KisApplication::exit(exporter->numFailedJobs() > 0 ? 1 : 0);
+        });
+
+        if (!args.exportBatchManifest().isEmpty() &&
+            !exporter->addManifest(args.exportBatchManifest())) {
+
+            errKrita << "Could not read the export manifest" << args.exportBatchManifest();
+            QTimer::singleShot(0, this, SLOT(quit()));
+            return false;
+        }
+
+        if (!args.exportBatchServer().isEmpty() &&
+            !exporter->listen(args.exportBatchServer())) {
+
+            QTimer::singleShot(0, this, SLOT(quit()));
+            return false;
+        }
+
+        return true;
+    }
+
     KisPart *kisPart = KisPart::instance();
     if (needsMainWindow) {
         // show a mainWindow asap, if we want that
@@ -45,6 +45,9 @@ struct Q_DECL_HIDDEN KisApplicationArguments::Private
     bool exportAs {false};
     bool exportSequence {false};
     QString exportFileName;
+    QString exportBatchManifest;
+    QString exportBatchServer;
+    int exportBatchJobs {0};
     QString workspace;
     QString windowLayout;
     QString session;
@@ -101,6 +104,11 @@ KisApplicationArguments::KisApplicationArguments(const QApplication &app)
     parser.addOption(QCommandLineOption(QStringList() << QLatin1String("export"), i18n("Export to the given filename and exit")));
     parser.addOption(QCommandLineOption(QStringList() << QLatin1String("export-sequence"), i18n("Export animation to the given filename and exit")));
     parser.addOption(QCommandLineOption(QStringList() << QLatin1String("export-filename"), i18n("Filename for export"), QLatin1String("filename")));
+    parser.addOption(QCommandLineOption(QStringList() << QLatin1String("export-batch"), i18n("Export all the files listed in the manifest and exit.\n"
+                                                                                             "Every line of the manifest has the form:\n"
+                                                                                             "    input<TAB>output[<TAB>mimetype]"), QLatin1String("manifest")));
+    parser.addOption(QCommandLineOption(QStringList() << QLatin1String("export-batch-server"), i18n("Listen on the given local socket for the export jobs in the manifest format"), QLatin1String("name")));
+    parser.addOption(QCommandLineOption(QStringList() << QLatin1String("export-batch-jobs"), i18n("The number of batch export jobs processed concurrently"), QLatin1String("count")));
     parser.addPositionalArgument(QLatin1String("[file(s)]"), i18n("File(s) or URL(s) to open"));
     parser.process(app);
 
@@ -143,6 +151,13 @@ KisApplicationArguments::KisApplicationArguments(const QApplication &app)
     d->doTemplate = parser.isSet("template");
     d->exportAs = parser.isSet("export");
     d->exportSequence = parser.isSet("export-sequence");
+    d->exportBatchManifest = parser.value("export-batch");
+    d->exportBatchServer = parser.value("export-batch-server");
+    d->exportBatchJobs = parser.value("export-batch-jobs").toInt();
+
+    if (!d->exportBatchManifest.isEmpty()) {
+        d->exportBatchManifest = QDir::current().absoluteFilePath(d->exportBatchManifest);
+    }
     d->canvasOnly = parser.isSet("canvasonly");
     d->noSplash = parser.isSet("nosplash");
     d->fullScreen = parser.isSet("fullscreen");
@@ -162,6 +177,9 @@ KisApplicationArguments::KisApplicationArguments(const KisApplicationArguments &
     d->doTemplate = rhs.doTemplate();
     d->exportAs = rhs.exportAs();
     d->exportFileName = rhs.exportFileName();
+    d->exportBatchManifest = rhs.exportBatchManifest();
+    d->exportBatchServer = rhs.exportBatchServer();
+    d->exportBatchJobs = rhs.exportBatchJobs();
     d->canvasOnly = rhs.canvasOnly();
     d->workspace = rhs.workspace();
     d->windowLayout = rhs.windowLayout();
@@ -178,6 +196,9 @@ void KisApplicationArguments::operator=(const KisApplicationArguments &rhs)
     d->doTemplate = rhs.doTemplate();
     d->exportAs = rhs.exportAs();
     d->exportFileName = rhs.exportFileName();
+    d->exportBatchManifest = rhs.exportBatchManifest();
+    d->exportBatchServer = rhs.exportBatchServer();
+    d->exportBatchJobs = rhs.exportBatchJobs();
     d->canvasOnly = rhs.canvasOnly();
     d->workspace = rhs.workspace();
     d->windowLayout = rhs.windowLayout();
@@ -295,6 +316,26 @@ QString KisApplicationArguments::exportFileName() const
     return d->exportFileName;
 }
 
+QString KisApplicationArguments::exportBatchManifest() const
+{
+    return d->exportBatchManifest;
+}
+
+QString KisApplicationArguments::exportBatchServer() const
+{
+    return d->exportBatchServer;
+}
+
+int KisApplicationArguments::exportBatchJobs() const
+{
+    return d->exportBatchJobs;
+}
+
+bool KisApplicationArguments::exportBatch() const
+{
+    return !d->exportBatchManifest.isEmpty() || !d->exportBatchServer.isEmpty();
+}
+
 QString KisApplicationArguments::workspace() const
 {
     return d->workspace;
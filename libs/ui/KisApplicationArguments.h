@@ -48,6 +48,10 @@ public:
     bool exportAs() const;
     bool exportSequence() const;
     QString exportFileName() const;
+    QString exportBatchManifest() const;
+    QString exportBatchServer() const;
+    int exportBatchJobs() const;
+    bool exportBatch() const;
     QString workspace() const;
     QString windowLayout() const;
     QString session() const;
@@ -0,0 +1,339 @@
+/*
+ *  Copyright (c) 2020 Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "KisBatchExporter.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QPointer>
+#include <QQueue>
+#include <QTextStream>
+#include <QThread>
+#include <QTimer>
+#include <QUrl>
+
+#include <klocalizedstring.h>
+
+#include <KisMimeDatabase.h>
+#include <KisUsageLogger.h>
+#include <kis_debug.h>
+#include <kis_image.h>
+
+#include "KisDocument.h"
+#include "KisImportExportErrorCode.h"
+#include "KisImportExportUtils.h"
+#include "KisPart.h"
+
+
+struct KisBatchExporter::QueuedJob
+{
+    Job job;
+
+    /**
+     * The socket the job has come from, null for
+     * the jobs read from the manifest
+     */
+    QPointer<QLocalSocket> client;
+};
+
+struct KisBatchExporter::Private
+{
+    int maxRunningJobs = 1;
+    int numFailedJobs = 0;
+    bool processingScheduled = false;
+    bool startingJob = false;
+    bool finished = false;
+
+    QQueue<QueuedJob> queue;
+    QHash<KisDocument*, QueuedJob> runningJobs;
+
+    QLocalServer *server = 0;
+};
+
+KisBatchExporter::KisBatchExporter(int maxRunningJobs, QObject *parent)
+    : QObject(parent),
+      m_d(new Private)
+{
+    m_d->maxRunningJobs =
+        maxRunningJobs > 0 ? maxRunningJobs : qMax(1, QThread::idealThreadCount() / 2);
+}
+
+KisBatchExporter::~KisBatchExporter()
+{
+}
+
+bool KisBatchExporter::parseJob(const QString &line, const QString &baseDir, Job *job)
+{
+    const QStringList fields = line.split('\t', QString::SkipEmptyParts);
+    if (fields.size() < 2 || fields.size() > 3) return false;
+
+    const QDir dir(baseDir);
+
+    job->inputFile = dir.absoluteFilePath(fields[0].trimmed());
+    job->outputFile = dir.absoluteFilePath(fields[1].trimmed());
+    job->mimeType = fields.size() > 2 ? fields[2].trimmed().toLatin1() : QByteArray();
+
+    return true;
+}
+
+bool KisBatchExporter::addManifest(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return false;
+    }
+
+    const QString baseDir = QFileInfo(fileName).absolutePath();
+
+    QTextStream stream(&file);
+    int lineNumber = 0;
+
+    while (!stream.atEnd()) {
+        const QString line = stream.readLine().trimmed();
+        lineNumber++;
+
+        if (line.isEmpty() || line.startsWith('#')) continue;
+
+        Job job;
+        if (!parseJob(line, baseDir, &job)) {
+            errKrita << "Invalid export job at" << fileName << "line" << lineNumber;
+            m_d->numFailedJobs++;
+            continue;
+        }
+
+        addJob(job);
+    }
+
+    scheduleProcessing();
+    return true;
+}
+
+void KisBatchExporter::addJob(const Job &job)
+{
+    QueuedJob queuedJob;
+    queuedJob.job = job;
+
+    m_d->queue.enqueue(queuedJob);
+    scheduleProcessing();
+}
+
+bool KisBatchExporter::listen(const QString &serverName)
+{
+    KIS_SAFE_ASSERT_RECOVER_RETURN_VALUE(!m_d->server, false);
+
+    // remove the socket left by the previous instance that has crashed
+    QLocalServer::removeServer(serverName);
+
+    m_d->server = new QLocalServer(this);
+    connect(m_d->server, SIGNAL(newConnection()), SLOT(slotNewConnection()));
+
+    if (!m_d->server->listen(serverName)) {
+        errKrita << "Could not listen on" << serverName << ":" << m_d->server->errorString();
+        delete m_d->server;
+        m_d->server = 0;
+        return false;
+    }
+
+    return true;
+}
+
+int KisBatchExporter::numFailedJobs() const
+{
+    return m_d->numFailedJobs;
+}
+
+void KisBatchExporter::slotNewConnection()
+{
+    while (QLocalSocket *client = m_d->server->nextPendingConnection()) {
+        // the client may wait for its jobs after the server is stopped
+        client->setParent(this);
+
+        connect(client, SIGNAL(readyRead()), SLOT(slotReadClient()));
+        connect(client, SIGNAL(disconnected()), client, SLOT(deleteLater()));
+    }
+}
+
+void KisBatchExporter::slotReadClient()
+{
+    QLocalSocket *client = qobject_cast<QLocalSocket*>(sender());
+    KIS_SAFE_ASSERT_RECOVER_RETURN(client);
+
+    while (client->canReadLine()) {
+        const QString line = QString::fromUtf8(client->readLine()).trimmed();
+
+        if (line.isEmpty()) continue;
+
+        if (line == QLatin1String("quit")) {
+            if (m_d->server) {
+                m_d->server->close();
+                m_d->server->deleteLater();
+                m_d->server = 0;
+            }
+            scheduleProcessing();
+            continue;
+        }
+
+        QueuedJob queuedJob;
+        queuedJob.client = client;
+
+        // the client's directory is unknown, see listen()
+        if (!parseJob(line, QDir::currentPath(), &queuedJob.job)) {
+            const QStringList fields = line.split('\t');
+            const QString reply =
+                QString("FAILED\t%1\t%2\t%3\n")
+                    .arg(fields.value(0))
+                    .arg(fields.value(1))
+                    .arg("invalid export job");
+
+            client->write(reply.toUtf8());
+            m_d->numFailedJobs++;
+            continue;
+        }
+
+        m_d->queue.enqueue(queuedJob);
+        scheduleProcessing();
+    }
+}
+
+void KisBatchExporter::scheduleProcessing()
+{
+    if (m_d->processingScheduled) return;
+
+    m_d->processingScheduled = true;
+    QTimer::singleShot(0, this, SLOT(slotProcessQueue()));
+}
+
+void KisBatchExporter::slotProcessQueue()
+{
+    m_d->processingScheduled = false;
+
+    /**
+     * Loading and exporting of the document may spin the event
+     * loop, the queue will be processed when the job is started
+     */
+    if (m_d->startingJob) return;
+
+    if (!m_d->queue.isEmpty() &&
+        m_d->runningJobs.size() < m_d->maxRunningJobs) {
+
+        m_d->startingJob = true;
+        startJob(m_d->queue.dequeue());
+        m_d->startingJob = false;
+
+        /**
+         * Return to the event loop to let the completed exports
+         * report their results before loading the next document
+         */
+        scheduleProcessing();
+        return;
+    }
+
+    if (m_d->queue.isEmpty() && m_d->runningJobs.isEmpty() &&
+        !m_d->server && !m_d->finished) {
+
+        m_d->finished = true;
+        emit sigFinished();
+    }
+}
+
+void KisBatchExporter::startJob(const QueuedJob &queuedJob)
+{
+    const Job &job = queuedJob.job;
+
+    const QByteArray mimeType = !job.mimeType.isEmpty() ?
+        job.mimeType :
+        KisMimeDatabase::mimeTypeForFile(job.outputFile, false).toLatin1();
+
+    if (mimeType == "application/octetstream") {
+        reportResult(queuedJob, false, i18n("Mimetype not found, try specifying the mimetype explicitly"));
+        return;
+    }
+
+    KisDocument *doc = KisPart::instance()->createDocument();
+    doc->setFileBatchMode(true);
+
+    if (!doc->openUrl(QUrl::fromLocalFile(job.inputFile))) {
+        reportResult(queuedJob, false, doc->errorMessage());
+        delete doc;
+        return;
+    }
+
+    // let the layers with delayed updates regenerate their projections
+    doc->image()->waitForDone();
+
+    m_d->runningJobs.insert(doc, queuedJob);
+
+    connect(doc, &KisDocument::sigCompleteBackgroundSaving,
+            this, [this, doc] (const KritaUtils::ExportFileJob &, KisImportExportErrorCode status, const QString &errorMessage) {
+                completeJob(doc, status, errorMessage);
+            });
+
+    if (!doc->exportDocument(QUrl::fromLocalFile(job.outputFile), mimeType)) {
+        /**
+         * The export may fail after the completion has already
+         * been reported, so check if the job is still running
+         */
+        if (m_d->runningJobs.remove(doc)) {
+            reportResult(queuedJob, false, doc->errorMessage());
+            doc->deleteLater();
+        }
+    }
+}
+
+void KisBatchExporter::completeJob(KisDocument *document, KisImportExportErrorCode status, const QString &errorMessage)
+{
+    auto it = m_d->runningJobs.find(document);
+    KIS_SAFE_ASSERT_RECOVER_RETURN(it != m_d->runningJobs.end());
+
+    const QueuedJob queuedJob = *it;
+    m_d->runningJobs.erase(it);
+
+    reportResult(queuedJob, status.isOk(), !errorMessage.isEmpty() ? errorMessage : status.errorMessage());
+
+    // we are still inside the signal emitted by the document
+    document->deleteLater();
+
+    scheduleProcessing();
+}
+
+void KisBatchExporter::reportResult(const QueuedJob &queuedJob, bool success, const QString &errorMessage)
+{
+    const Job &job = queuedJob.job;
+
+    if (!success) {
+        m_d->numFailedJobs++;
+        errKrita << "Could not export" << job.inputFile << "to" << job.outputFile << ":" << errorMessage;
+    }
+
+    KisUsageLogger::log(QString("Batch export of %1 to %2: %3")
+                        .arg(job.inputFile)
+                        .arg(job.outputFile)
+                        .arg(success ? "OK" : errorMessage));
+
+    if (queuedJob.client) {
+        const QString reply = success ?
+            QString("OK\t%1\t%2\n").arg(job.inputFile).arg(job.outputFile) :
+            QString("FAILED\t%1\t%2\t%3\n").arg(job.inputFile).arg(job.outputFile).arg(QString(errorMessage).replace('\n', ' '));
+
+        queuedJob.client->write(reply.toUtf8());
+    }
+}
@@ -0,0 +1,121 @@
+/*
+ *  Copyright (c) 2020 Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KISBATCHEXPORTER_H
+#define KISBATCHEXPORTER_H
+
+#include <QObject>
+#include <QScopedPointer>
+
+#include "kritaui_export.h"
+
+class KisDocument;
+class KisImportExportErrorCode;
+
+/**
+ * KisBatchExporter converts a queue of documents into the requested
+ * formats within a single running instance of Krita, so that the plugins
+ * and resources are loaded only once for the whole batch.
+ *
+ * Every job is described by a line of the form:
+ *
+ *     input<TAB>output[<TAB>mimetype]
+ *
+ * The jobs are read either from a manifest file or from the clients of
+ * a local socket (see listen()). The socket clients get a line for every
+ * completed job:
+ *
+ *     OK<TAB>input<TAB>output
+ *     FAILED<TAB>input<TAB>output<TAB>message
+ *
+ * A client may send "quit" to stop the server. The exporter finishes
+ * when the server is stopped and all the queued jobs are completed.
+ *
+ * The documents are loaded one by one in the GUI thread, but up to
+ * maxRunningJobs of them are being rendered and saved in the background
+ * at the same time.
+ */
+class KRITAUI_EXPORT KisBatchExporter : public QObject
+{
+    Q_OBJECT
+public:
+    struct Job {
+        QString inputFile;
+        QString outputFile;
+        QByteArray mimeType;
+    };
+
+public:
+    /**
+     * \p maxRunningJobs is the number of documents being exported
+     * concurrently. If it is not positive, half of the number of
+     * the cores is used.
+     */
+    KisBatchExporter(int maxRunningJobs, QObject *parent = 0);
+    ~KisBatchExporter() override;
+
+    /**
+     * Parses one line of the manifest. The relative paths are
+     * resolved against \p baseDir.
+     *
+     * \return false if the line is not a valid job description
+     */
+    static bool parseJob(const QString &line, const QString &baseDir, Job *job);
+
+    /**
+     * Adds all the jobs listed in the manifest file
+     */
+    bool addManifest(const QString &fileName);
+
+    void addJob(const Job &job);
+
+    /**
+     * Starts listening for jobs on the local socket \p serverName.
+     * The relative paths in the jobs sent by the clients are resolved
+     * against the current directory of the server, not the client's.
+     */
+    bool listen(const QString &serverName);
+
+    int numFailedJobs() const;
+
+Q_SIGNALS:
+    /**
+     * Emitted when all the jobs are completed and there is
+     * no server waiting for new jobs
+     */
+    void sigFinished();
+
+private Q_SLOTS:
+    void slotProcessQueue();
+    void slotNewConnection();
+    void slotReadClient();
+
+private:
+    struct QueuedJob;
+
+    void scheduleProcessing();
+    void startJob(const QueuedJob &job);
+    void completeJob(KisDocument *document, KisImportExportErrorCode status, const QString &errorMessage);
+    void reportResult(const QueuedJob &job, bool success, const QString &errorMessage = QString());
+
+private:
+    struct Private;
+    const QScopedPointer<Private> m_d;
+};
+
+#endif // KISBATCHEXPORTER_H
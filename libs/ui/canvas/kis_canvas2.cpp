@@ -971,6 +971,17 @@ void KisCanvas2::slotUpdateRegionOfInterest()
     if (m_d->regionOfInterest != oldRegionOfInterest) {
         emit sigRegionOfInterestChanged(m_d->regionOfInterest);
     }
+
+    /**
+     * Let the image update the visible area first. If there are several
+     * views on the image, the one that has been moved last wins.
+     */
+    KisImageSP image = this->image();
+    if (image) {
+        const QRect visibleRect =
+            m_d->coordinatesConverter->widgetRectInImagePixels().toAlignedRect() & imageRect;
+        image->setUpdatePriorityRect(visibleRect);
+    }
 }
 
 void KisCanvas2::slotReferenceImagesChanged()
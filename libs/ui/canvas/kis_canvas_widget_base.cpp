@@ -40,6 +40,7 @@
 #include "kis_selection_manager.h"
 #include "KisDocument.h"
 #include "kis_update_info.h"
+#include "kis_update_time_monitor.h"
 #include "KisQPainterStateSaver.h"
 
 
@@ -250,6 +251,11 @@ QVector<QRect> KisCanvasWidgetBase::updateCanvasProjection(const QVector<KisUpda
     QVector<QRect> dirtyViewRects;
 
     Q_FOREACH (KisUpdateInfoSP info, infoObjects) {
+        KisUpdateTimeMonitor::TraceScope trace(KisUpdateTimeMonitor::CanvasUpload);
+        if (trace.isActive()) {
+            trace.setDetails("Canvas upload", QString(), info->dirtyImageRect());
+        }
+
         dirtyViewRects << this->updateCanvasProjection(info);
     }
 
@@ -421,6 +421,7 @@ KisDisplayColorConverter::conversionFlags()
 
     if (cfg.useBlackPointCompensation()) conversionFlags |= KoColorConversionTransformation::BlackpointCompensation;
     if (!cfg.allowLCMSOptimization()) conversionFlags |= KoColorConversionTransformation::NoOptimization;
+    if (cfg.useLookupTableForDisplayConversion()) conversionFlags |= KoColorConversionTransformation::LookupTable;
 
     return conversionFlags;
 }
@@ -476,6 +477,78 @@ QColor KisDisplayColorConverter::toQColor(const KoColor &srcColor) const
     return QColor(p[2], p[1], p[0], p[3]);
 }
 
+QVector<QColor> KisDisplayColorConverter::toQColors(const QVector<KoColor> &srcColors) const
+{
+    QVector<KoColor> colors(srcColors);
+
+    if (m_d->useOcio()) {
+        const KoColorSpace *ocioInputColorSpace = m_d->ocioInputColorSpace();
+
+        KIS_ASSERT_RECOVER(ocioInputColorSpace->pixelSize() == 16) {
+            return QVector<QColor>(colors.size(), QColor(Qt::green));
+        }
+
+        KoColor::convertAllTo(colors, ocioInputColorSpace);
+
+        QVector<quint8> buffer(colors.size() * 16);
+        for (int i = 0; i < colors.size(); i++) {
+            memcpy(buffer.data() + i * 16, colors[i].data(), 16);
+        }
+
+        m_d->displayFilter->filter(buffer.data(), colors.size());
+
+        const KoColorSpace *ocioOutputColorSpace = m_d->ocioOutputColorSpace();
+        for (int i = 0; i < colors.size(); i++) {
+            colors[i].setColor(buffer.constData() + i * 16, ocioOutputColorSpace);
+        }
+    }
+
+    // we expect the display profile is rgb8, which is BGRA here
+    const KoColorSpace *qtWidgetsColorSpace = m_d->qtWidgetsColorSpace();
+
+    KIS_ASSERT_RECOVER(qtWidgetsColorSpace->pixelSize() == 4) {
+        return QVector<QColor>(colors.size(), QColor(Qt::red));
+    }
+
+    KoColor::convertAllTo(colors, qtWidgetsColorSpace, m_d->renderingIntent, m_d->conversionFlags);
+
+    QVector<QColor> result;
+    result.reserve(colors.size());
+
+    Q_FOREACH (const KoColor &c, colors) {
+        const quint8 *p = c.data();
+        result.append(QColor(p[2], p[1], p[0], p[3]));
+    }
+
+    return result;
+}
+
+QVector<KoColor> KisDisplayColorConverter::approximateFromRenderedQColors(const QVector<QColor> &qcolors) const
+{
+    if (!m_d->useOcio()) {
+        return KoColor::fromQColors(qcolors, m_d->paintingColorSpace);
+    }
+
+    const KoColorSpace *intermediateColorSpace = m_d->intermediateColorSpace();
+    const int pixelSize = intermediateColorSpace->pixelSize();
+
+    QVector<KoColor> colors = KoColor::fromQColors(qcolors, intermediateColorSpace);
+
+    QVector<quint8> buffer(colors.size() * pixelSize);
+    for (int i = 0; i < colors.size(); i++) {
+        memcpy(buffer.data() + i * pixelSize, colors[i].data(), pixelSize);
+    }
+
+    m_d->displayFilter->approximateInverseTransformation(buffer.data(), colors.size());
+
+    for (int i = 0; i < colors.size(); i++) {
+        colors[i].setColor(buffer.constData() + i * pixelSize, intermediateColorSpace);
+    }
+
+    KoColor::convertAllTo(colors, m_d->paintingColorSpace);
+    return colors;
+}
+
 KoColor KisDisplayColorConverter::applyDisplayFiltering(const KoColor &srcColor,
                                                         const KoID &bitDepthId) const
 {
@@ -67,6 +67,15 @@ public:
     QColor toQColor(const KoColor &c) const;
     KoColor approximateFromRenderedQColor(const QColor &c) const;
 
+    /**
+     * Batch versions of toQColor() and approximateFromRenderedQColor().
+     * All the colors are converted with a single call to the color
+     * conversion transformation, so they should be preferred when
+     * building caches of many colors, e.g. in the color selectors.
+     */
+    QVector<QColor> toQColors(const QVector<KoColor> &colors) const;
+    QVector<KoColor> approximateFromRenderedQColors(const QVector<QColor> &colors) const;
+
     bool canSkipDisplayConversion(const KoColorSpace *cs) const;
     KoColor applyDisplayFiltering(const KoColor &srcColor, const KoID &bitDepthId) const;
     void applyDisplayFilteringF32(KisFixedPaintDeviceSP device, const KoID &bitDepthId) const;
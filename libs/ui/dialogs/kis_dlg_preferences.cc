@@ -834,6 +834,7 @@ void TabletSettingsTab::slotResolutionSettings()
 
 //---------------------------------------------------------------------------------------------------
 #include "kis_acyclic_signal_connector.h"
+#include "kis_update_time_monitor.h"
 
 int getTotalRAM()
 {
@@ -915,6 +916,7 @@ PerformanceTab::PerformanceTab(QWidget *parent, const char *name)
 
     lblSwapFileLocation->setText(cfg.swapDir());
     connect(bnSwapFile, SIGNAL(clicked()), SLOT(selectSwapDir()));
+    connect(bnExportUpdateTrace, SIGNAL(clicked()), SLOT(slotExportUpdateTrace()));
 
     sliderThreadsLimit->setRange(1, QThread::idealThreadCount());
     sliderFrameClonesLimit->setRange(1, QThread::idealThreadCount());
@@ -959,6 +961,7 @@ void PerformanceTab::load(bool requestDefault)
     sliderUndoLimit->setValue(cfg.memorySoftLimitPercent(requestDefault));
 
     chkPerformanceLogging->setChecked(cfg.enablePerfLog(requestDefault));
+    chkUpdateTracing->setChecked(cfg.enableUpdateTracing(requestDefault));
     chkProgressReporting->setChecked(cfg.enableProgressReporting(requestDefault));
 
     sliderSwapSize->setValue(cfg.maxSwapSize(requestDefault) / 1024);
@@ -1007,6 +1010,8 @@ void PerformanceTab::save()
     cfg.setMemoryPoolLimitPercent(sliderPoolLimit->value());
 
     cfg.setEnablePerfLog(chkPerformanceLogging->isChecked());
+    cfg.setEnableUpdateTracing(chkUpdateTracing->isChecked());
+    KisUpdateTimeMonitor::instance()->setTracingEnabled(chkUpdateTracing->isChecked());
     cfg.setEnableProgressReporting(chkProgressReporting->isChecked());
 
     cfg.setMaxSwapSize(sliderSwapSize->value() * 1024);
@@ -1049,6 +1054,23 @@ void PerformanceTab::selectSwapDir()
     lblSwapFileLocation->setText(swapDir);
 }
 
+void PerformanceTab::slotExportUpdateTrace()
+{
+    KoFileDialog dialog(this, KoFileDialog::SaveFile, "ExportUpdateTrace");
+    dialog.setCaption(i18n("Export Update Trace"));
+    dialog.setDefaultDir(QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation));
+    dialog.setMimeTypeFilters(QStringList() << "application/json");
+
+    QString fileName = dialog.filename();
+    if (fileName.isEmpty()) {
+        return;
+    }
+
+    if (!KisUpdateTimeMonitor::instance()->exportChromeTrace(fileName)) {
+        QMessageBox::warning(this, i18nc("@title:window", "Krita"), i18n("Could not save the update trace to %1", fileName));
+    }
+}
+
 void PerformanceTab::slotThreadsLimitChanged(int value)
 {
     KisSignalsBlocker b(sliderFrameClonesLimit);
@@ -239,6 +239,7 @@ public:
 private Q_SLOTS:
 
     void selectSwapDir();
+    void slotExportUpdateTrace();
 
     void slotThreadsLimitChanged(int value);
     void slotFrameClonesLimitChanged(int value);
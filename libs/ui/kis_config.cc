@@ -629,6 +629,16 @@ void KisConfig::setAllowLCMSOptimization(bool allowLCMSOptimization)
     m_cfg.writeEntry("allowLCMSOptimization", allowLCMSOptimization);
 }
 
+bool KisConfig::useLookupTableForDisplayConversion(bool defaultValue) const
+{
+    return (defaultValue ? false : m_cfg.readEntry("useLookupTableForDisplayConversion", false));
+}
+
+void KisConfig::setUseLookupTableForDisplayConversion(bool value)
+{
+    m_cfg.writeEntry("useLookupTableForDisplayConversion", value);
+}
+
 bool KisConfig::forcePaletteColors(bool defaultValue) const
 {
     return (defaultValue ? false : m_cfg.readEntry("colorsettings/forcepalettecolors", false));
@@ -163,6 +163,15 @@ public:
     bool allowLCMSOptimization(bool defaultValue = false) const;
     void setAllowLCMSOptimization(bool allowLCMSOptimization);
 
+    /**
+     * Use precomputed lookup tables for the conversion of integer
+     * images into the display color space. The tables are used only
+     * when their error stays within the bound defined by the
+     * "lcmsLookupTableMaxError" option.
+     */
+    bool useLookupTableForDisplayConversion(bool defaultValue = false) const;
+    void setUseLookupTableForDisplayConversion(bool value);
+
     bool forcePaletteColors(bool defaultValue = false) const;
     void setForcePaletteColors(bool forcePaletteColors);
 
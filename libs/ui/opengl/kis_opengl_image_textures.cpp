@@ -79,6 +79,7 @@ KisOpenGLImageTextures::KisOpenGLImageTextures()
     m_conversionFlags = KoColorConversionTransformation::HighQuality;
     if (cfg.useBlackPointCompensation()) m_conversionFlags |= KoColorConversionTransformation::BlackpointCompensation;
     if (!cfg.allowLCMSOptimization()) m_conversionFlags |= KoColorConversionTransformation::NoOptimization;
+    if (cfg.useLookupTableForDisplayConversion()) m_conversionFlags |= KoColorConversionTransformation::LookupTable;
     m_useOcio = cfg.useOcio();
 }
 
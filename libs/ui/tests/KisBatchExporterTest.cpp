@@ -0,0 +1,174 @@
+/*
+ *  Copyright (c) 2020 Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "KisBatchExporterTest.h"
+
+#include <QTemporaryDir>
+#include <QSignalSpy>
+#include <QLocalSocket>
+#include <QImage>
+#include <QUrl>
+
+#include <KisBatchExporter.h>
+#include <KisDocument.h>
+#include <KisPart.h>
+#include <kis_image.h>
+#include <sdk/tests/kistest.h>
+
+namespace {
+
+QString testDocumentPath()
+{
+    return QString(FILES_DATA_DIR) + QDir::separator() + "load_test.kra";
+}
+
+QSize testDocumentSize()
+{
+    QScopedPointer<KisDocument> doc(KisPart::instance()->createDocument());
+    if (!doc->openUrl(QUrl::fromLocalFile(testDocumentPath()))) return QSize();
+
+    return doc->image()->size();
+}
+
+}
+
+
+void KisBatchExporterTest::testParseJob()
+{
+    KisBatchExporter::Job job;
+
+    QVERIFY(KisBatchExporter::parseJob("in.kra\tout.png", "/data", &job));
+    QCOMPARE(job.inputFile, QString("/data/in.kra"));
+    QCOMPARE(job.outputFile, QString("/data/out.png"));
+    QVERIFY(job.mimeType.isEmpty());
+
+    QVERIFY(KisBatchExporter::parseJob("/images/in.kra\tout.jpg\timage/jpeg", "/data", &job));
+    QCOMPARE(job.inputFile, QString("/images/in.kra"));
+    QCOMPARE(job.outputFile, QString("/data/out.jpg"));
+    QCOMPARE(job.mimeType, QByteArray("image/jpeg"));
+
+    QVERIFY(!KisBatchExporter::parseJob("in.kra", "/data", &job));
+    QVERIFY(!KisBatchExporter::parseJob("a\tb\tc\td", "/data", &job));
+}
+
+void KisBatchExporterTest::testFailedJobs()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    const QString manifestPath = dir.filePath("manifest.txt");
+
+    {
+        QFile manifest(manifestPath);
+        QVERIFY(manifest.open(QIODevice::WriteOnly | QIODevice::Text));
+        manifest.write("# the jobs that cannot be completed\n"
+                       "\n"
+                       "missing1.kra\tout1.png\n"
+                       "invalid line\n"
+                       "missing2.kra\tout2.png\n");
+    }
+
+    KisBatchExporter exporter(2);
+    QSignalSpy finishedSpy(&exporter, SIGNAL(sigFinished()));
+
+    QVERIFY(exporter.addManifest(manifestPath));
+    QVERIFY(finishedSpy.wait(5000));
+
+    QCOMPARE(finishedSpy.count(), 1);
+    QCOMPARE(exporter.numFailedJobs(), 3);
+
+    QVERIFY(!exporter.addManifest(dir.filePath("nonexistent.txt")));
+}
+
+void KisBatchExporterTest::testExportDocument()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    const QString manifestPath = dir.filePath("manifest.txt");
+
+    {
+        QFile manifest(manifestPath);
+        QVERIFY(manifest.open(QIODevice::WriteOnly | QIODevice::Text));
+        manifest.write(QString("%1\tout.png\n").arg(testDocumentPath()).toUtf8());
+    }
+
+    KisBatchExporter exporter(1);
+    QSignalSpy finishedSpy(&exporter, SIGNAL(sigFinished()));
+
+    QVERIFY(exporter.addManifest(manifestPath));
+    QVERIFY(finishedSpy.wait(30000));
+
+    QCOMPARE(exporter.numFailedJobs(), 0);
+
+    // the relative output path is resolved against the manifest's directory
+    const QString outputPath = dir.filePath("out.png");
+    QVERIFY(QFileInfo(outputPath).exists());
+
+    QImage exported;
+    QVERIFY(exported.load(outputPath));
+    QCOMPARE(exported.size(), testDocumentSize());
+}
+
+void KisBatchExporterTest::testServerProtocol()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    const QString serverName =
+        QString("krita-batch-exporter-test-%1").arg(QCoreApplication::applicationPid());
+    const QString outputPath = dir.filePath("out.png");
+
+    KisBatchExporter exporter(1);
+    QSignalSpy finishedSpy(&exporter, SIGNAL(sigFinished()));
+
+    QVERIFY(exporter.listen(serverName));
+
+    QLocalSocket client;
+    client.connectToServer(serverName);
+    QVERIFY(client.waitForConnected(5000));
+
+    client.write(QString("%1\t%2\n").arg(testDocumentPath()).arg(outputPath).toUtf8());
+    client.write("in.kra\tout.png\timage/png\textra\n");
+    client.write("quit\n");
+    client.flush();
+
+    QVERIFY(finishedSpy.wait(30000));
+
+    QStringList replies;
+    auto readReplies = [&client, &replies] () {
+        while (client.canReadLine()) {
+            replies << QString::fromUtf8(client.readLine()).remove('\n');
+        }
+        return replies.size();
+    };
+
+    QTRY_COMPARE_WITH_TIMEOUT(readReplies(), 2, 5000);
+
+    // the invalid job is rejected right away
+    QCOMPARE(replies[0], QString("FAILED\tin.kra\tout.png\tinvalid export job"));
+    QCOMPARE(replies[1], QString("OK\t%1\t%2").arg(testDocumentPath()).arg(outputPath));
+
+    QCOMPARE(exporter.numFailedJobs(), 1);
+
+    QImage exported;
+    QVERIFY(exported.load(outputPath));
+    QCOMPARE(exported.size(), testDocumentSize());
+}
+
+KISTEST_MAIN(KisBatchExporterTest)
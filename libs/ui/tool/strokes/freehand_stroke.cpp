@@ -128,6 +128,15 @@ void FreehandStrokeStrategy::init()
         setBalancingRatioOverride(0.01); // set priority to updates
     }
 
+    /**
+     * The clone brush reads the projection or its source node, and the
+     * color smudge brush reads the projection in the overlay mode, so
+     * they may not run concurrently with a stroke on another layer
+     */
+    KisPaintOpPresetSP preset = m_d->resources->currentPaintOpPreset();
+    const QString paintOpId = preset ? preset->paintOp().id() : QString();
+    declareAccessedNodes(paintOpId == "duplicate" || paintOpId == "colorsmudge");
+
     KisUpdateTimeMonitor::instance()->startStrokeMeasure();
     m_d->efficiencyMeasurer.setEnabled(KisStrokeSpeedMonitor::instance()->haveStrokeSpeedMeasurement());
 }
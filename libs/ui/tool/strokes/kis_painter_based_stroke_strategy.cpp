@@ -26,6 +26,7 @@
 #include "kis_paint_layer.h"
 #include "kis_transaction.h"
 #include "kis_image.h"
+#include "kis_selection.h"
 #include <kis_distance_information.h>
 #include "kis_undo_stores.h"
 #include "KisFreehandStrokeInfo.h"
@@ -80,6 +81,28 @@ void KisPainterBasedStrokeStrategy::init()
     enableJob(KisSimpleStrokeStrategy::JOB_RESUME);
 }
 
+void KisPainterBasedStrokeStrategy::declareAccessedNodes(bool readsImage)
+{
+    if (!m_resources->currentNode()) return;
+
+    KisNodeList readNodes;
+
+    if (readsImage) {
+        KisImageSP image = m_resources->image();
+        if (!image) return;
+
+        readNodes << image->root();
+    } else {
+        KisSelectionSP selection = m_resources->activeSelection();
+        KisNodeSP selectionNode = selection ? selection->parentNode().toStrongRef() : KisNodeSP();
+        if (selectionNode) {
+            readNodes << selectionNode;
+        }
+    }
+
+    setAccessedNodes({m_resources->currentNode()}, readNodes);
+}
+
 KisPainterBasedStrokeStrategy::KisPainterBasedStrokeStrategy(const KisPainterBasedStrokeStrategy &rhs, int levelOfDetail)
     : KisRunnableBasedStrokeStrategy(rhs),
       m_resources(rhs.m_resources),
@@ -105,6 +105,18 @@ protected:
     void setSupportsIndirectPainting(bool value);
     bool supportsIndirectPainting() const;
 
+    /**
+     * Lets the strokes queue start this stroke while the previous one
+     * is still being finished (see KisStrokeStrategy::setAccessedNodes()).
+     * The stroke is declared to modify the current node and to read
+     * the node of the active selection. A stroke that reads anything
+     * else (the projection, a clone source) must pass \p readsImage,
+     * then the whole image is declared as read.
+     *
+     * The strokes that don't call this method keep the strict ordering.
+     */
+    void declareAccessedNodes(bool readsImage);
+
 protected:
     KisPainterBasedStrokeStrategy(const KisPainterBasedStrokeStrategy &rhs, int levelOfDetail);
 
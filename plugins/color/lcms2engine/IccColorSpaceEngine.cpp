@@ -23,9 +23,194 @@
 #include "KoColorModelStandardIds.h"
 
 #include <klocalizedstring.h>
+#include <ksharedconfig.h>
+#include <kconfiggroup.h>
+
+#include <KoChannelInfo.h>
 
 #include "LcmsColorSpace.h"
 
+// -- lookup table support --
+
+namespace {
+
+struct LookupTableConfig
+{
+    LookupTableConfig()
+    {
+        KConfigGroup cfg = KSharedConfig::openConfig()->group("");
+        maxError = cfg.readEntry("lcmsLookupTableMaxError", 1.0);
+        gridPoints3D = qBound(2, cfg.readEntry("lcmsLookupTableGridPoints3D", 33), 255);
+        gridPoints4D = qBound(2, cfg.readEntry("lcmsLookupTableGridPoints4D", 23), 255);
+    }
+
+    /// the maximum allowed deviation from the exact conversion,
+    /// measured in 8-bit units of the destination color channels
+    qreal maxError;
+
+    int gridPoints3D;
+    int gridPoints4D;
+};
+
+
+bool isIntegerColorSpace(const KoColorSpace *cs)
+{
+    return cs->colorDepthId() == Integer8BitsColorDepthID ||
+        cs->colorDepthId() == Integer16BitsColorDepthID;
+}
+
+/**
+ * Generates a set of pixels placed in the centres of the cells of the
+ * interpolation grid with \p gridPoints nodes per channel, where the
+ * error of the table is the highest. If the grid is too dense, only
+ * a subset of the cells along every channel is probed.
+ */
+QVector<quint8> generateProbePixels(const KoColorSpace *cs, int gridPoints, int *numPixels)
+{
+    const int numColorChannels = cs->colorChannelCount();
+    const int maxStepsPerChannel[] = {4096, 256, 64, 24};
+    const int numCells = gridPoints - 1;
+    const int steps = qMin(numCells, maxStepsPerChannel[numColorChannels - 1]);
+
+    *numPixels = 1;
+    for (int i = 0; i < numColorChannels; i++) {
+        *numPixels *= steps;
+    }
+
+    const int pixelSize = cs->pixelSize();
+    QVector<quint8> buffer(*numPixels * pixelSize, 0);
+    const QList<KoChannelInfo*> channels = cs->channels();
+
+    for (int pixel = 0; pixel < *numPixels; pixel++) {
+        quint8 *ptr = buffer.data() + pixel * pixelSize;
+        int index = pixel;
+
+        Q_FOREACH (const KoChannelInfo *channel, channels) {
+            qreal value = 1.0;
+
+            if (channel->channelType() == KoChannelInfo::COLOR) {
+                const int cell = (index % steps) * numCells / steps;
+                value = (cell + 0.5) / numCells;
+                index /= steps;
+            }
+
+            if (channel->channelValueType() == KoChannelInfo::UINT8) {
+                ptr[channel->pos()] = qRound(value * 255.0);
+            } else {
+                *reinterpret_cast<quint16*>(ptr + channel->pos()) = qRound(value * 65535.0);
+            }
+        }
+    }
+
+    return buffer;
+}
+
+/**
+ * \return the maximum difference between the color channels of the two
+ * buffers, measured in 8-bit units
+ */
+qreal maxChannelDifference(const KoColorSpace *cs, const quint8 *buf1, const quint8 *buf2, int numPixels)
+{
+    const int pixelSize = cs->pixelSize();
+    const QList<KoChannelInfo*> channels = cs->channels();
+
+    qreal maxDifference = 0.0;
+
+    for (int pixel = 0; pixel < numPixels; pixel++) {
+        const quint8 *ptr1 = buf1 + pixel * pixelSize;
+        const quint8 *ptr2 = buf2 + pixel * pixelSize;
+
+        Q_FOREACH (const KoChannelInfo *channel, channels) {
+            if (channel->channelType() != KoChannelInfo::COLOR) continue;
+
+            qreal difference = 0.0;
+
+            if (channel->channelValueType() == KoChannelInfo::UINT8) {
+                difference = qAbs(int(ptr1[channel->pos()]) - int(ptr2[channel->pos()]));
+            } else {
+                difference = qAbs(int(*reinterpret_cast<const quint16*>(ptr1 + channel->pos())) -
+                                  int(*reinterpret_cast<const quint16*>(ptr2 + channel->pos()))) / 257.0;
+            }
+
+            maxDifference = qMax(maxDifference, difference);
+        }
+    }
+
+    return maxDifference;
+}
+
+/**
+ * Creates a transformation that evaluates the conversion with a
+ * precomputed multidimensional table. LCMS samples the full pipeline
+ * into the table and interpolates it tetrahedrally. The table is
+ * verified against the exact conversion and discarded if its error
+ * exceeds the configured bound.
+ *
+ * \return the transform or null if the table is not accurate enough
+ */
+cmsHTRANSFORM createLookupTableTransform(const KoColorSpace *srcCs, quint32 srcColorSpaceType, LcmsColorProfileContainer *srcProfile,
+                                         const KoColorSpace *dstCs, quint32 dstColorSpaceType, LcmsColorProfileContainer *dstProfile,
+                                         KoColorConversionTransformation::Intent renderingIntent,
+                                         KoColorConversionTransformation::ConversionFlags conversionFlags)
+{
+    if (!isIntegerColorSpace(srcCs) || !isIntegerColorSpace(dstCs)) return 0;
+
+    const int numInputChannels = srcCs->colorChannelCount();
+    if (numInputChannels < 1 || numInputChannels > 4) return 0;
+
+    /**
+     * The transforms are cached by the color conversion cache, so
+     * the config is read only when a new table is built
+     */
+    const LookupTableConfig config;
+    const int gridPoints = numInputChannels < 4 ? config.gridPoints3D : config.gridPoints4D;
+
+    conversionFlags &= ~KoColorConversionTransformation::NoOptimization;
+
+    cmsHTRANSFORM lutTransform =
+        cmsCreateTransform(srcProfile->lcmsProfile(), srcColorSpaceType,
+                           dstProfile->lcmsProfile(), dstColorSpaceType,
+                           renderingIntent,
+                           quint32(conversionFlags) | cmsFLAGS_FORCE_CLUT | cmsFLAGS_GRIDPOINTS(gridPoints));
+
+    cmsHTRANSFORM exactTransform =
+        cmsCreateTransform(srcProfile->lcmsProfile(), srcColorSpaceType,
+                           dstProfile->lcmsProfile(), dstColorSpaceType,
+                           renderingIntent,
+                           conversionFlags | KoColorConversionTransformation::NoOptimization);
+
+    if (!lutTransform || !exactTransform) {
+        if (lutTransform) cmsDeleteTransform(lutTransform);
+        if (exactTransform) cmsDeleteTransform(exactTransform);
+        return 0;
+    }
+
+    int numPixels = 0;
+    const QVector<quint8> probe = generateProbePixels(srcCs, gridPoints, &numPixels);
+
+    QVector<quint8> lutResult(numPixels * dstCs->pixelSize(), 0);
+    QVector<quint8> exactResult(numPixels * dstCs->pixelSize(), 0);
+
+    cmsDoTransform(lutTransform, const_cast<quint8*>(probe.constData()), lutResult.data(), numPixels);
+    cmsDoTransform(exactTransform, const_cast<quint8*>(probe.constData()), exactResult.data(), numPixels);
+
+    cmsDeleteTransform(exactTransform);
+
+    const qreal error = maxChannelDifference(dstCs, lutResult.constData(), exactResult.constData(), numPixels);
+
+    if (error > config.maxError) {
+        dbgPigment << "Lookup table for" << srcCs->name() << "->" << dstCs->name()
+                   << "is not accurate enough:" << error << "max:" << config.maxError;
+
+        cmsDeleteTransform(lutTransform);
+        lutTransform = 0;
+    }
+
+    return lutTransform;
+}
+
+}
+
 // -- KoLcmsColorConversionTransformation --
 
 class KoLcmsColorConversionTransformation : public KoColorConversionTransformation
@@ -42,23 +227,38 @@ public:
         Q_ASSERT(dstCs);
         Q_ASSERT(renderingIntent < 4);
 
-        if (srcCs->colorDepthId() == Integer8BitsColorDepthID
-                || srcCs->colorDepthId() == Integer16BitsColorDepthID) {
+        const bool useLookupTable = conversionFlags.testFlag(KoColorConversionTransformation::LookupTable);
+        conversionFlags &= ~KoColorConversionTransformation::LookupTable;
+        conversionFlags |= KoColorConversionTransformation::CopyAlpha;
 
-            if ((srcProfile->name().contains(QLatin1String("linear"), Qt::CaseInsensitive) ||
-                 dstProfile->name().contains(QLatin1String("linear"), Qt::CaseInsensitive)) &&
-                    !conversionFlags.testFlag(KoColorConversionTransformation::NoOptimization)) {
-                conversionFlags |= KoColorConversionTransformation::NoOptimization;
-            }
+        if (useLookupTable) {
+            /**
+             * The table is verified against the exact conversion, so
+             * it is safe to use even for the linear profiles
+             */
+            m_transform = createLookupTableTransform(srcCs, srcColorSpaceType, srcProfile,
+                                                     dstCs, dstColorSpaceType, dstProfile,
+                                                     renderingIntent, conversionFlags);
         }
-        conversionFlags |= KoColorConversionTransformation::CopyAlpha;
 
-        m_transform = cmsCreateTransform(srcProfile->lcmsProfile(),
-                                         srcColorSpaceType,
-                                         dstProfile->lcmsProfile(),
-                                         dstColorSpaceType,
-                                         renderingIntent,
-                                         conversionFlags);
+        if (!m_transform) {
+            if (srcCs->colorDepthId() == Integer8BitsColorDepthID
+                    || srcCs->colorDepthId() == Integer16BitsColorDepthID) {
+
+                if ((srcProfile->name().contains(QLatin1String("linear"), Qt::CaseInsensitive) ||
+                     dstProfile->name().contains(QLatin1String("linear"), Qt::CaseInsensitive)) &&
+                        !conversionFlags.testFlag(KoColorConversionTransformation::NoOptimization)) {
+                    conversionFlags |= KoColorConversionTransformation::NoOptimization;
+                }
+            }
+
+            m_transform = cmsCreateTransform(srcProfile->lcmsProfile(),
+                                             srcColorSpaceType,
+                                             dstProfile->lcmsProfile(),
+                                             dstColorSpaceType,
+                                             renderingIntent,
+                                             conversionFlags);
+        }
 
         Q_ASSERT(m_transform);
     }
@@ -109,6 +309,7 @@ public:
                 conversionFlags |= KoColorConversionTransformation::NoOptimization;
             }
         }
+        conversionFlags &= ~KoColorConversionTransformation::LookupTable;
         conversionFlags |= KoColorConversionTransformation::CopyAlpha;
 
         quint16 alarm[cmsMAXCHANNELS];//this seems to be bgr???
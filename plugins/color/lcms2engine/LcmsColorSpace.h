@@ -26,6 +26,7 @@
 #include <KoColorSpaceAbstract.h>
 #include <QMutex>
 #include <QMutexLocker>
+#include <QVector>
 
 #include "kis_assert.h"
 
@@ -303,6 +304,79 @@ public:
         c->setAlpha(this->opacityU8(src));
     }
 
+    void fromQColors(const QColor *colors, quint8 *dst, quint32 nPixels, const KoColorProfile *koprofile = 0) const override
+    {
+        // a local buffer lets us avoid locking for the default transform
+        QVector<quint8> rgbData(3 * nPixels);
+        quint8 *rgb = rgbData.data();
+
+        for (quint32 i = 0; i < nPixels; i++) {
+            rgb[3 * i + 2] = colors[i].red();
+            rgb[3 * i + 1] = colors[i].green();
+            rgb[3 * i + 0] = colors[i].blue();
+        }
+
+        LcmsColorProfileContainer *profile = asLcmsProfile(koprofile);
+        if (profile == 0) {
+            // Default sRGB
+            KIS_ASSERT(d->defaultTransformations && d->defaultTransformations->fromRGB);
+
+            cmsDoTransform(d->defaultTransformations->fromRGB, rgb, dst, nPixels);
+        } else {
+            QMutexLocker locker(&d->mutex);
+
+            if (d->lastFromRGB == 0 || (d->lastFromRGB != 0 && d->lastRGBProfile != profile->lcmsProfile())) {
+                d->lastFromRGB = cmsCreateTransform(profile->lcmsProfile(),
+                                                    TYPE_BGR_8,
+                                                    d->profile->lcmsProfile(),
+                                                    this->colorSpaceType(),
+                                                    KoColorConversionTransformation::internalRenderingIntent(),
+                                                    KoColorConversionTransformation::internalConversionFlags());
+                d->lastRGBProfile = profile->lcmsProfile();
+
+            }
+            KIS_ASSERT(d->lastFromRGB);
+            cmsDoTransform(d->lastFromRGB, rgb, dst, nPixels);
+        }
+
+        const quint32 pixelSize = this->pixelSize();
+
+        for (quint32 i = 0; i < nPixels; i++) {
+            this->setOpacity(dst + i * pixelSize, (quint8)(colors[i].alpha()), 1);
+        }
+    }
+
+    void toQColors(const quint8 *src, QColor *colors, quint32 nPixels, const KoColorProfile *koprofile = 0) const override
+    {
+        QVector<quint8> rgbData(3 * nPixels);
+        quint8 *rgb = rgbData.data();
+
+        LcmsColorProfileContainer *profile = asLcmsProfile(koprofile);
+        if (profile == 0) {
+            // Default sRGB transform
+            Q_ASSERT(d->defaultTransformations && d->defaultTransformations->toRGB);
+            cmsDoTransform(d->defaultTransformations->toRGB, const_cast <quint8 *>(src), rgb, nPixels);
+        } else {
+            QMutexLocker locker(&d->mutex);
+
+            if (d->lastToRGB == 0 || (d->lastToRGB != 0 && d->lastRGBProfile != profile->lcmsProfile())) {
+                d->lastToRGB = cmsCreateTransform(d->profile->lcmsProfile(), this->colorSpaceType(),
+                                                  profile->lcmsProfile(), TYPE_BGR_8,
+                                                  KoColorConversionTransformation::internalRenderingIntent(),
+                                                  KoColorConversionTransformation::internalConversionFlags());
+                d->lastRGBProfile = profile->lcmsProfile();
+            }
+            cmsDoTransform(d->lastToRGB, const_cast <quint8 *>(src), rgb, nPixels);
+        }
+
+        const quint32 pixelSize = this->pixelSize();
+
+        for (quint32 i = 0; i < nPixels; i++) {
+            colors[i].setRgb(rgb[3 * i + 2], rgb[3 * i + 1], rgb[3 * i + 0]);
+            colors[i].setAlpha(this->opacityU8(src + i * pixelSize));
+        }
+    }
+
     KoColorTransformation *createBrightnessContrastAdjustment(const quint16 *transferValues) const override
     {
         if (!d->profile) {
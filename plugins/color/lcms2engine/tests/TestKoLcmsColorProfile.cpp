@@ -5,9 +5,13 @@
 #include <LcmsColorProfileContainer.h>
 
 #include <KoColor.h>
+#include <KoColorModelStandardIds.h>
 
 #include <QTest>
 
+#include <KSharedConfig>
+#include <KConfigGroup>
+
 #include <lcms2.h>
 #include <cmath>
 
@@ -101,4 +105,75 @@ void TestKoLcmsColorProfile::testProofingConversion()
     Q_ASSERT((dst[0] == alarm[0]) && (dst[1] == alarm[1]) && (dst[2] == alarm[2]));
 
 }
+
+void TestKoLcmsColorProfile::testLookupTableConversion()
+{
+    const KoColorSpace *cmyk = KoColorSpaceRegistry::instance()->colorSpace(CMYKAColorModelID.id(), Integer8BitsColorDepthID.id(), "");
+    QVERIFY(cmyk);
+    const KoColorSpace *sRgb = KoColorSpaceRegistry::instance()->rgb8();
+    QVERIFY(sRgb);
+
+    const int numPixels = 1024;
+
+    QVector<quint8> src(numPixels * cmyk->pixelSize());
+    for (int i = 0; i < src.size(); i++) {
+        src[i] = (i * 97 + (i >> 3) * 31) & 0xff;
+    }
+
+    QVector<quint8> exact(numPixels * sRgb->pixelSize());
+    QVector<quint8> table(numPixels * sRgb->pixelSize());
+
+    cmyk->convertPixelsTo(src.constData(), exact.data(), sRgb, numPixels,
+                          KoColorConversionTransformation::IntentPerceptual,
+                          KoColorConversionTransformation::NoOptimization);
+
+    cmyk->convertPixelsTo(src.constData(), table.data(), sRgb, numPixels,
+                          KoColorConversionTransformation::IntentPerceptual,
+                          KoColorConversionTransformation::LookupTable);
+
+    // the table is either accurate enough or is not used at all
+    for (int i = 0; i < exact.size(); i++) {
+        QVERIFY2(qAbs(int(exact[i]) - int(table[i])) <= 2,
+                 QString("pixel %1: %2 vs %3").arg(i / 4).arg(exact[i]).arg(table[i]).toLatin1());
+    }
+}
+
+void TestKoLcmsColorProfile::testLookupTableRejectsCoarseGrid()
+{
+    const KoColorSpace *sRgb = KoColorSpaceRegistry::instance()->rgb8();
+    QVERIFY(sRgb);
+    const KoColorSpace *linearRgb = KoColorSpaceRegistry::instance()->rgb16("scRGB (linear)");
+    QVERIFY(linearRgb);
+
+    /**
+     * A table with 3 nodes per channel cannot follow the sRGB
+     * tone curve, so it must fail the verification and the
+     * conversion must fall back to the usual transform
+     */
+    KConfigGroup cfg = KSharedConfig::openConfig()->group("");
+    cfg.writeEntry("lcmsLookupTableGridPoints3D", 3);
+
+    const int numPixels = 1024;
+
+    QVector<quint8> src(numPixels * sRgb->pixelSize());
+    for (int i = 0; i < src.size(); i++) {
+        src[i] = (i * 97 + (i >> 3) * 31) & 0xff;
+    }
+
+    QVector<quint8> regular(numPixels * linearRgb->pixelSize());
+    QVector<quint8> table(numPixels * linearRgb->pixelSize());
+
+    sRgb->convertPixelsTo(src.constData(), regular.data(), linearRgb, numPixels,
+                          KoColorConversionTransformation::IntentPerceptual,
+                          KoColorConversionTransformation::Empty);
+
+    sRgb->convertPixelsTo(src.constData(), table.data(), linearRgb, numPixels,
+                          KoColorConversionTransformation::IntentPerceptual,
+                          KoColorConversionTransformation::LookupTable);
+
+    cfg.deleteEntry("lcmsLookupTableGridPoints3D");
+
+    QCOMPARE(table, regular);
+}
+
 QTEST_MAIN(TestKoLcmsColorProfile)
@@ -77,6 +77,8 @@ void KisColorPatches::paintEvent(QPaintEvent* e)
     int widgetHeight = height();
     int numPatchesInACol = qMax(widgetHeight/m_patchHeight, 1);
 
+    const QVector<QColor> qcolors = converter()->toQColors(m_colors.toVector());
+
     for(int i = m_buttonList.size(); i < qMin(fieldCount(), m_colors.size() + m_buttonList.size()); i++) {
         int row;
         int col;
@@ -89,7 +91,7 @@ void KisColorPatches::paintEvent(QPaintEvent* e)
             col = i / numPatchesInACol;
         }
 
-        QColor qcolor = converter()->toQColor(m_colors.at(i - m_buttonList.size()));
+        const QColor &qcolor = qcolors.at(i - m_buttonList.size());
 
         painter.fillRect(col*m_patchWidth,
                          row*m_patchHeight,
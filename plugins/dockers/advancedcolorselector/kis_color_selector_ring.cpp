@@ -197,11 +197,19 @@ void KisColorSelectorRing::colorCache()
 {
     Q_ASSERT(m_cachedColorSpace);
     m_cachedColors.clear();
-    KoColor koColor;
-    QColor qColor;
+
+    QVector<QColor> hsvColors;
+    hsvColors.reserve(360);
     for(int i=0; i<360; i++) {
-        koColor = m_parent->converter()->fromHsvF(1.0 * i / 360.0, 1.0, 1.0);
-        qColor = m_parent->converter()->toQColor(koColor);
+        // generate HSV from sRGB, like KisDisplayColorConverter::fromHsvF() does
+        hsvColors.append(QColor::fromHsvF(1.0 * i / 360.0, 1.0, 1.0));
+    }
+
+    // convert all the colors in one go, per-color conversion is slow in CMYK and Lab
+    KisDisplayColorConverter *converter = m_parent->converter();
+    const QVector<QColor> colors = converter->toQColors(converter->approximateFromRenderedQColors(hsvColors));
+
+    Q_FOREACH (const QColor &qColor, colors) {
         m_cachedColors.append(qColor.rgb());
     }
 }